@@ -0,0 +1,109 @@
+/**
+ * @file float_format.c
+ * @brief Benchmark and round-trip check of FormatDouble().
+ *
+ * Formats random doubles with FormatDouble(), sprintf("%g"),
+ * sprintf("%a") and sprintf("%.17g") and prints the throughput.
+ * Then checks that strtod() reads every FormatDouble() text back
+ * to the same bits.
+ *
+ * usage: dev/scripts/bench_floats [N]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../src/hexfloat.h"
+
+/** Xorshift generator, deterministic across runs. */
+static uint64_t state = 0x9e3779b97f4a7c15ULL;
+static uint64_t Random()
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/** Random double from random bits, nan excluded. */
+static double RandomDouble()
+{
+  double d;
+  do {
+    uint64_t bits = Random();
+    memcpy(&d, &bits, sizeof(d));
+  } while(d != d);
+  return d;
+}
+
+static double Seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile size_t sink = 0;
+
+static void Measure(const char * name, const double * values, size_t n, const char * fmt)
+{
+  char buf[64];
+  double start = Seconds();
+  for(size_t i = 0; i < n; i++)
+  {
+    if(fmt == NULL) sink += FormatDouble(buf, values[i]);
+    else sink += sprintf(buf, fmt, values[i]);
+  }
+  double elapsed = Seconds() - start;
+  printf("%-16s %8.1f ns/value %8.2f Mvalues/s\n", name, elapsed * 1e9 / n, n / elapsed * 1e-6);
+}
+
+int main(int argc, char * argv[])
+{
+  size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  double * random = malloc(n * sizeof(double));
+  double * integral = malloc(n * sizeof(double));
+  if(random == NULL || integral == NULL) return 1;
+
+  for(size_t i = 0; i < n; i++)
+  {
+    random[i] = RandomDouble();
+    integral[i] = (double)(int32_t)Random();
+  }
+
+  printf("random doubles (%zu):\n", n);
+  Measure("FormatDouble", random, n, NULL);
+  Measure("sprintf %g", random, n, "%g");
+  Measure("sprintf %a", random, n, "%a");
+  Measure("sprintf %.17g", random, n, "%.17g");
+
+  printf("integral doubles (%zu):\n", n);
+  Measure("FormatDouble", integral, n, NULL);
+  Measure("sprintf %g", integral, n, "%g");
+  Measure("sprintf %a", integral, n, "%a");
+
+  // round-trip check (random bits, integral values and special cases)
+  static const double special[] = {0.0, -0.0, 1.0, -1.0, 0.1, 1e300, -1e-300,
+    4.9406564584124654e-324, 2.2250738585072009e-308, 1.7976931348623157e308,
+    9007199254740992.0, -9007199254740993.0, 1.0/0.0, -1.0/0.0};
+  size_t failed = 0;
+  char buf[HEXFLOAT_MAXLEN];
+  for(size_t i = 0; i < 2*n + sizeof(special)/sizeof(double); i++)
+  {
+    double d = (i < n) ? random[i] : (i < 2*n) ? integral[i - n] : special[i - 2*n];
+    size_t len = FormatDouble(buf, d);
+    double back = strtod(buf, NULL);
+    if(len >= HEXFLOAT_MAXLEN || memcmp(&d, &back, sizeof(d)) != 0)
+    {
+      if(failed++ < 10) fprintf(stderr, "round-trip failed: %a -> %s -> %a\n", d, buf, back);
+    }
+  }
+  printf("round-trip: %zu failures\n", failed);
+
+  free(random);
+  free(integral);
+  return failed != 0;
+}
@@ -0,0 +1,83 @@
+/'
+  file:     native.bas
+  date:     19th october 2026
+  Benchmark of the C backend (recursion, arithmetic loops, strings).
+  Reads the size of the work from stdin.
+'/
+
+function fib(n as integer) as integer
+  dim a as integer
+  dim b as integer
+  if n < 2 then
+    return n
+  else
+    a = fib(n - 1)
+    b = fib(n - 2)
+    return a + b
+  end if
+end function
+
+function primes(n as integer) as integer
+  dim i as integer
+  dim d as integer
+  dim count as integer
+  dim prime as integer
+  i = 2
+  do while i < n
+    prime = 1
+    d = 2
+    do while d * d <= i
+      if i = (i \ d) * d then
+        prime = 0
+        d = i
+      else
+      end if
+      d = d + 1
+    loop
+    if prime = 1 then
+      count = count + 1
+    else
+    end if
+    i = i + 1
+  loop
+  return count
+end function
+
+function digits(n as integer) as string
+  dim s as string
+  dim i as integer
+  dim c as integer
+  dim digit as string
+  do while i < n
+    c = 48 + i - (i \ 10) * 10
+    digit = chr(c)
+    s = s + digit
+    i = i + 1
+  loop
+  return s
+end function
+
+scope
+  dim n as integer
+  dim i as integer
+  dim s as integer
+  dim d as double
+  dim t as string
+  dim c as integer
+  input n
+  s = fib(n)
+  print s;
+  do while i < n * 100000
+    s = s + (i * 7) \ 3 - i
+    d = d + i / 2
+    i = i + 1
+  loop
+  print s;
+  print d;
+  s = primes(n * 10000)
+  print s;
+  t = digits(n * 2000)
+  s = length(t)
+  c = asc(t, s)
+  print s; c;
+end scope
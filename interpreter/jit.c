@@ -0,0 +1,908 @@
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+  #define JIT_SUPPORTED
+  #include <sys/mman.h>
+#endif
+
+/** @brief Size of the machine stack of the compiled code. */
+#define JIT_STACK (256u << 20)
+/** @brief Part of the machine stack reserved for the helpers. */
+#define JIT_STACK_RESERVE (1u << 20)
+/** @brief Bytes of the machine stack taken by a call. */
+#define JIT_CALL_FRAME 16
+
+/**
+ * @brief   Compiled program.
+ */
+struct JitCode
+{
+  unsigned char * code;     /**< Executable memory, the entry is at its start. */
+  size_t size;              /**< Bytes of the code. */
+  size_t mapped;            /**< Bytes of the mapping. */
+  unsigned char * stack;    /**< Machine stack. */
+  Instr * instructions;     /**< Instructions passed to the helpers. */
+  JitHelper * helpers;      /**< Helpers by opcode, the error helper is the last one. */
+};
+
+#ifdef JIT_SUPPORTED
+
+/*------------------------------ ASSEMBLER ------------------------------------*/
+
+/**
+ * @brief   Code being assembled.
+ */
+typedef struct
+{
+  unsigned char * data;
+  size_t count, capacity;
+  bool failed;              /**< Allocation failed. */
+} Buffer;
+
+/**
+ * @brief   Jump, whose displacement is set after the code is assembled.
+ */
+typedef struct
+{
+  size_t at;                /**< Position of the 32-bit displacement. */
+  size_t target;            /**< Index of the instruction, or one of the targets below. */
+} Patch;
+
+/**
+ * @brief   State of the compilation.
+ */
+typedef struct
+{
+  Buffer b;
+  Program * p;
+  const JitRuntime * rt;
+  size_t * offsets;         /**< Offsets of the instructions and the targets below. */
+  Patch * patches;
+  size_t patches_count, patches_capacity;
+  bool inline_code;         /**< The layout of values allows the inline code. */
+  bool failed;              /**< Allocation failed. */
+} Compiler;
+
+/** @brief Target of the exit of the code, after the instructions. */
+#define TARGET_EXIT(C) ((C)->p->count)
+/** @brief Target failing at the instruction in rsi, after the instructions. */
+#define TARGET_ERROR(C) ((C)->p->count + 1)
+
+/*
+ Registers of the compiled code (all preserved by the helpers):
+   rbx   machine
+   r12   depth of the calls
+   r13   instructions (the instruction of a helper is r13 + displacement)
+   r14   helpers
+   r15   stack pointer of the caller
+ The stack pointer is aligned to 16 bytes between instructions, a call
+ of the code takes 16 bytes (the return address and the padding).
+*/
+
+/** @brief Appends the bytes. */
+static void Emit(Buffer * b, const void * bytes, size_t count)
+{
+  if(b->count + count > b->capacity)
+  {
+    size_t capacity = (b->capacity == 0) ? 4096 : 2 * b->capacity;
+    while(capacity < b->count + count) capacity *= 2;
+    unsigned char * grown = realloc(b->data, capacity);
+    if(grown == NULL)
+    {
+      b->failed = true;
+      return;
+    }
+    b->data = grown;
+    b->capacity = capacity;
+  }
+  memcpy(b->data + b->count, bytes, count);
+  b->count += count;
+}
+
+/** @brief Appends the byte. */
+static void Byte(Buffer * b, unsigned char byte) { Emit(b, &byte, 1); }
+
+/** @brief Appends the 32-bit little endian value. */
+static void U32(Buffer * b, uint32_t value)
+{
+  unsigned char bytes[4] = {value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, (value >> 24) & 0xff};
+  Emit(b, bytes, 4);
+}
+
+/** @brief Appends the bytes of the string literal. */
+#define BYTES(b, s) Emit(b, s, sizeof(s) - 1)
+
+/** @brief Registers. */
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+/** @brief Condition codes of jcc and setcc. */
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_L = 0xc, CC_G = 0xf };
+
+/**
+ * @brief   Instruction with the register and the memory operand [base + displacement].
+ *
+ * @param prefix  Mandatory prefix (0x66, 0xf2, 0xf3), or 0.
+ * @param wide    64-bit operand (REX.W).
+ * @param opcode  Opcode, two bytes ones are 0x0fXX.
+ * @param reg     Register, or the extension of the opcode.
+ */
+static void Memory(Buffer * b, unsigned char prefix, bool wide, unsigned opcode, int reg, int base, int32_t displacement)
+{
+  if(prefix != 0) Byte(b, prefix);
+  unsigned char rex = 0x40 | (wide << 3) | ((reg & 8) >> 1) | ((base & 8) >> 3);
+  if(rex != 0x40) Byte(b, rex);
+  if(opcode > 0xff) Byte(b, opcode >> 8);
+  Byte(b, opcode & 0xff);
+  Byte(b, 0x80 | ((reg & 7) << 3) | (base & 7));
+  if((base & 7) == RSP) Byte(b, 0x24);
+  U32(b, (uint32_t)displacement);
+}
+
+/** @brief Instruction with two register operands, see Memory(). */
+static void Registers(Buffer * b, unsigned char prefix, bool wide, unsigned opcode, int reg, int rm)
+{
+  if(prefix != 0) Byte(b, prefix);
+  unsigned char rex = 0x40 | (wide << 3) | ((reg & 8) >> 1) | ((rm & 8) >> 3);
+  if(rex != 0x40) Byte(b, rex);
+  if(opcode > 0xff) Byte(b, opcode >> 8);
+  Byte(b, opcode & 0xff);
+  Byte(b, 0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+/** @brief jcc, or jmp if cc is negative, to a position bound later; returns its displacement. */
+static size_t Forward(Buffer * b, int cc)
+{
+  if(cc < 0) Byte(b, 0xe9);
+  else
+  {
+    Byte(b, 0x0f);
+    Byte(b, 0x80 | cc);
+  }
+  U32(b, 0);
+  return b->count - 4;
+}
+
+/** @brief Binds the forward jump to the current position. */
+static void Bind(Buffer * b, size_t at)
+{
+  if(b->failed) return;
+  uint32_t value = (uint32_t)(b->count - (at + 4));
+  for(int k = 0; k < 4; k++) b->data[at + k] = (value >> (8 * k)) & 0xff;
+}
+
+/** @brief Appends the 32-bit displacement to the target. */
+static void Displacement(Compiler * C, size_t target)
+{
+  if(C->patches_count == C->patches_capacity)
+  {
+    size_t capacity = (C->patches_capacity == 0) ? 256 : 2 * C->patches_capacity;
+    Patch * grown = realloc(C->patches, capacity * sizeof(Patch));
+    if(grown == NULL)
+    {
+      C->failed = true;
+      return;
+    }
+    C->patches = grown;
+    C->patches_capacity = capacity;
+  }
+  C->patches[C->patches_count++] = (Patch){C->b.count, target};
+  U32(&C->b, 0);
+}
+
+/** @brief jmp target */
+static void Jump(Compiler * C, size_t target)
+{
+  Byte(&C->b, 0xe9);
+  Displacement(C, target);
+}
+
+/** @brief jcc target, cc is the low nibble of the opcode (4 e, 5 ne, 2 b, 7 a). */
+static void JumpIf(Compiler * C, unsigned char cc, size_t target)
+{
+  unsigned char bytes[] = {0x0f, 0x80 | cc};
+  Emit(&C->b, bytes, 2);
+  Displacement(C, target);
+}
+
+/** @brief lea rsi, [r13 + instruction] */
+static void LoadInstruction(Compiler * C, size_t i)
+{
+  BYTES(&C->b, "\x49\x8d\xb5");
+  U32(&C->b, (uint32_t)(i * sizeof(Instr)));
+}
+
+/** @brief Fails at the instruction by the error helper. */
+static void Error(Compiler * C, size_t i)
+{
+  LoadInstruction(C, i);
+  Jump(C, TARGET_ERROR(C));
+}
+
+/**
+ * @brief   Calls the helper of the instruction.
+ *
+ * The code exits, if the helper fails.
+ * @param i       Index of the instruction.
+ * @param slot    Index of the helper.
+ */
+static void Helper(Compiler * C, size_t i, size_t slot)
+{
+  BYTES(&C->b, "\x48\x89\xdf");         // mov rdi, rbx
+  LoadInstruction(C, i);
+  BYTES(&C->b, "\x41\xff\x96");         // call [r14 + slot]
+  U32(&C->b, (uint32_t)(slot * sizeof(JitHelper)));
+  BYTES(&C->b, "\x83\xf8\x01");         // cmp eax, Jit_Taken
+  JumpIf(C, 0x7, TARGET_EXIT(C));       // ja exit
+}
+
+/*------------------------------ COMPILER ------------------------------------*/
+
+/** @brief Target of the label operand, NO_TARGET if not defined. */
+static size_t LabelTarget(const Instr * ins)
+{
+  return ins->arg[0].d.label.target;
+}
+
+/** @brief Compiles the jump to the label of the instruction, or the error. */
+static void JumpToLabel(Compiler * C, size_t i)
+{
+  size_t target = LabelTarget(&C->p->code[i]);
+  if(target == NO_TARGET) Error(C, i);
+  else Jump(C, target);
+}
+
+/*------------------------------ INLINE CODE ------------------------------------*/
+/*
+ The inline code handles the common cases of the hot instructions: integer
+ (and float) operands in the cached slots of the variables, or on the data
+ stack. Anything else (strings, other types, errors, the first lookup of
+ a variable) jumps to the slow path, which calls the helper.
+ Registers: rax, rcx, rdx and xmm0, xmm1 are scratch, r8-r10 point to slots.
+*/
+
+/** @brief Maximum of the jumps to the slow path of an instruction. */
+#define SLOW_JUMPS 32
+
+/**
+ * @brief   Jumps to the slow path of the instruction.
+ */
+typedef struct
+{
+  size_t at[SLOW_JUMPS];
+  size_t count;
+} Slow;
+
+/** @brief Offset of the value in the slot. */
+#define SLOT_VALUE(C) ((int32_t)(C)->rt->layout.slot_value)
+/** @brief Offset of the type in the value. */
+#define VALUE_TYPE ((int32_t)offsetof(Value, type))
+/** @brief Offset of the data in the value. */
+#define VALUE_DATA ((int32_t)offsetof(Value, d))
+
+/** @brief Jumps to the slow path, if the condition holds. */
+static void ToSlow(Compiler * C, Slow * slow, int cc)
+{
+  if(slow->count == SLOW_JUMPS) C->failed = true;
+  else slow->at[slow->count++] = Forward(&C->b, cc);
+}
+
+/** @brief Operand is a variable. */
+static bool IsVariable(const Arg * a)
+{
+  return a->kind == Arg_Global || a->kind == Arg_Local || a->kind == Arg_Temporary;
+}
+
+/** @brief Operand is a constant of the type. */
+static bool IsConstant(const Arg * a, ValueType type)
+{
+  return a->kind == Arg_Constant && a->d.constant.type == type;
+}
+
+/** @brief Operand is a constant, which is not a string. */
+static bool IsScalar(const Arg * a)
+{
+  return a->kind == Arg_Constant && a->d.constant.type != Type_String && a->d.constant.type != Type_Undefined;
+}
+
+/** @brief Displacement of the cached slot of the operand from r13. */
+static int32_t CachedSlot(size_t i, int k)
+{
+  return (int32_t)(i * sizeof(Instr) + offsetof(Instr, arg) + k * sizeof(Arg) + offsetof(Arg, d.var.slot));
+}
+
+/** @brief cmp dword [base + displacement], value */
+static void CompareMemory(Buffer * b, int base, int32_t displacement, uint32_t value)
+{
+  Memory(b, 0, false, 0x81, 7, base, displacement);
+  U32(b, value);
+}
+
+/** @brief mov dword [base + displacement], value */
+static void StoreMemory(Buffer * b, int base, int32_t displacement, uint32_t value)
+{
+  Memory(b, 0, false, 0xc7, 0, base, displacement);
+  U32(b, value);
+}
+
+/** @brief mov rax, constant data */
+static void LoadConstant(Buffer * b, const Value * v)
+{
+  uint64_t data = 0;
+  memcpy(&data, &v->d, sizeof(v->d) < sizeof(data) ? sizeof(v->d) : sizeof(data));
+  BYTES(b, "\x48\xb8");
+  U32(b, (uint32_t)data);
+  U32(b, (uint32_t)(data >> 32));
+}
+
+/**
+ * @brief   Loads the address of the slot of the variable.
+ *
+ * The slot cached in the operand is used, if it still holds the variable.
+ * @param i       Index of the instruction.
+ * @param k       Index of the operand.
+ * @param r       Register of the address.
+ */
+static void SlotAddress(Compiler * C, size_t i, int k, int r, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const JitLayout * L = &C->rt->layout;
+  const Arg * a = &C->p->code[i].arg[k];
+  size_t frame = (a->kind == Arg_Global) ? L->global : (a->kind == Arg_Local) ? L->local : L->temporary;
+
+  Memory(b, 0, true, 0x8b, r, RBX, (int32_t)frame);               // mov r, [machine + frame]
+  Registers(b, 0, true, 0x85, r, r);                                // test r, r
+  ToSlow(C, slow, CC_E);
+  Memory(b, 0, false, 0x8b, RAX, R13, CachedSlot(i, k));           // mov eax, [cached slot]
+  Memory(b, 0, false, 0x3b, RAX, r, (int32_t)L->frame_count);      // cmp eax, [r + count]
+  ToSlow(C, slow, CC_AE);
+  Memory(b, 0, true, 0x8b, r, r, (int32_t)L->frame_slots);         // mov r, [r + slots]
+  Registers(b, 0, true, 0x69, RAX, RAX);                            // imul rax, rax, size
+  U32(b, (uint32_t)L->slot_size);
+  Registers(b, 0, true, 0x01, RAX, r);                              // add r, rax
+  CompareMemory(b, r, (int32_t)L->slot_name, a->d.var.name);
+  ToSlow(C, slow, CC_NE);
+}
+
+/** @brief Loads the integer operand to ecx or edx, r is the register of its slot. */
+static void IntOperand(Compiler * C, size_t i, int k, int reg, int r, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const Arg * a = &C->p->code[i].arg[k];
+  if(a->kind == Arg_Constant)
+  {
+    Byte(b, 0xb8 + reg);                                            // mov reg, constant
+    U32(b, (uint32_t)a->d.constant.d.i);
+    return;
+  }
+  SlotAddress(C, i, k, r, slow);
+  CompareMemory(b, r, SLOT_VALUE(C) + VALUE_TYPE, Type_Int);
+  ToSlow(C, slow, CC_NE);
+  Memory(b, 0, false, 0x8b, reg, r, SLOT_VALUE(C) + VALUE_DATA);   // mov reg, [value]
+}
+
+/** @brief Loads the address of the destination slot to r10, which does not hold a string. */
+static void Destination(Compiler * C, size_t i, Slow * slow)
+{
+  SlotAddress(C, i, 0, R10, slow);
+  CompareMemory(&C->b, R10, SLOT_VALUE(C) + VALUE_TYPE, Type_String);
+  ToSlow(C, slow, CC_E);
+}
+
+/** @brief Loads the end of the data stack to rdx, which has at least count values. */
+static void StackTop(Compiler * C, unsigned char count, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const JitLayout * L = &C->rt->layout;
+  Memory(b, 0, true, 0x8b, RAX, RBX, (int32_t)L->stack_count);     // mov rax, [count]
+  Registers(b, 0, true, 0x83, 7, RAX);                              // cmp rax, count
+  Byte(b, count);
+  ToSlow(C, slow, CC_B);
+  Memory(b, 0, true, 0x8b, RDX, RBX, (int32_t)L->stack);           // mov rdx, [stack]
+  Registers(b, 0, true, 0xc1, 4, RAX);                              // shl rax, 4
+  Byte(b, 4);
+  Registers(b, 0, true, 0x01, RAX, RDX);                            // add rdx, rax
+}
+
+/** @brief Adds the value to the count of the data stack (inc or dec). */
+static void StackCount(Compiler * C, int delta)
+{
+  Memory(&C->b, 0, true, 0xff, (delta > 0) ? 0 : 1, RBX, (int32_t)C->rt->layout.stack_count);
+}
+
+/** @brief Stores the result of the comparison in al to the destination as bool. */
+static void StoreFlag(Buffer * b, int cc, int base, int32_t value)
+{
+  Registers(b, 0, false, 0x0f90 | cc, 0, RAX);                      // setcc al
+  Registers(b, 0, false, 0x0fb6, RAX, RAX);                         // movzx eax, al
+  StoreMemory(b, base, value + VALUE_TYPE, Type_Bool);
+  Memory(b, 0, false, 0x89, RAX, base, value + VALUE_DATA);        // mov [data], eax
+}
+
+/** @brief Condition code of the relation. */
+static int RelationCondition(Op op)
+{
+  return (op == Op_Lt || op == Op_Lts) ? CC_L : (op == Op_Gt || op == Op_Gts) ? CC_G : CC_E;
+}
+
+/** @brief MOVE of a scalar. */
+static bool InlineMove(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const Arg * a = &C->p->code[i].arg[1];
+  if(!IsVariable(&C->p->code[i].arg[0]) || !(IsVariable(a) || IsScalar(a))) return false;
+
+  if(IsVariable(a))
+  {
+    SlotAddress(C, i, 1, R8, slow);
+    Memory(b, 0, false, 0x8b, RCX, R8, SLOT_VALUE(C) + VALUE_TYPE); // mov ecx, [type]
+    Registers(b, 0, false, 0x81, 7, RCX);                           // cmp ecx, string
+    U32(b, Type_String);
+    ToSlow(C, slow, CC_E);
+    Registers(b, 0, false, 0x81, 7, RCX);                           // cmp ecx, undefined
+    U32(b, Type_Undefined);
+    ToSlow(C, slow, CC_E);
+  }
+  Destination(C, i, slow);
+  if(IsVariable(a))
+  {
+    Memory(b, 0, true, 0x8b, RAX, R8, SLOT_VALUE(C));              // copy of the value
+    Memory(b, 0, true, 0x89, RAX, R10, SLOT_VALUE(C));
+    Memory(b, 0, true, 0x8b, RAX, R8, SLOT_VALUE(C) + 8);
+    Memory(b, 0, true, 0x89, RAX, R10, SLOT_VALUE(C) + 8);
+    return true;
+  }
+  StoreMemory(b, R10, SLOT_VALUE(C) + VALUE_TYPE, a->d.constant.type);
+  LoadConstant(b, &a->d.constant);
+  Memory(b, 0, true, 0x89, RAX, R10, SLOT_VALUE(C) + VALUE_DATA);  // mov [data], rax
+  return true;
+}
+
+/** @brief ADD, SUB, MUL, LT, GT, EQ of integers. */
+static bool InlineBinary(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const Instr * ins = &C->p->code[i];
+  for(int k = 1; k <= 2; k++)
+    if(!IsVariable(&ins->arg[k]) && !IsConstant(&ins->arg[k], Type_Int)) return false;
+  if(!IsVariable(&ins->arg[0]) || ins->op == Op_Div) return false;
+
+  IntOperand(C, i, 1, RCX, R8, slow);
+  IntOperand(C, i, 2, RDX, R9, slow);
+  Destination(C, i, slow);
+  switch(ins->op)
+  {
+    case Op_Add: Registers(b, 0, false, 0x01, RDX, RCX); break;    // add ecx, edx
+    case Op_Sub: Registers(b, 0, false, 0x29, RDX, RCX); break;    // sub ecx, edx
+    case Op_Mul: Registers(b, 0, false, 0x0faf, RCX, RDX); break;  // imul ecx, edx
+    default:
+      Registers(b, 0, false, 0x39, RDX, RCX);                       // cmp ecx, edx
+      StoreFlag(b, RelationCondition(ins->op), R10, SLOT_VALUE(C));
+      return true;
+  }
+  StoreMemory(b, R10, SLOT_VALUE(C) + VALUE_TYPE, Type_Int);
+  Memory(b, 0, false, 0x89, RCX, R10, SLOT_VALUE(C) + VALUE_DATA); // mov [data], ecx
+  return true;
+}
+
+/** @brief PUSHS of a scalar. */
+static bool InlinePushs(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const JitLayout * L = &C->rt->layout;
+  const Arg * a = &C->p->code[i].arg[0];
+  if(!IsVariable(a) && !IsScalar(a)) return false;
+
+  if(IsVariable(a))
+  {
+    SlotAddress(C, i, 0, R8, slow);
+    Memory(b, 0, false, 0x8b, RCX, R8, SLOT_VALUE(C) + VALUE_TYPE); // mov ecx, [type]
+    Registers(b, 0, false, 0x81, 7, RCX);                           // cmp ecx, string
+    U32(b, Type_String);
+    ToSlow(C, slow, CC_E);
+    Registers(b, 0, false, 0x81, 7, RCX);                           // cmp ecx, undefined
+    U32(b, Type_Undefined);
+    ToSlow(C, slow, CC_E);
+  }
+  Memory(b, 0, true, 0x8b, RAX, RBX, (int32_t)L->stack_count);     // mov rax, [count]
+  Memory(b, 0, true, 0x3b, RAX, RBX, (int32_t)L->stack_capacity);  // cmp rax, [capacity]
+  ToSlow(C, slow, CC_AE);
+  Memory(b, 0, true, 0x8b, RDX, RBX, (int32_t)L->stack);           // mov rdx, [stack]
+  Registers(b, 0, true, 0xc1, 4, RAX);                              // shl rax, 4
+  Byte(b, 4);
+  Registers(b, 0, true, 0x01, RAX, RDX);                            // add rdx, rax
+  if(IsVariable(a))
+  {
+    Memory(b, 0, true, 0x8b, RAX, R8, SLOT_VALUE(C));              // copy of the value
+    Memory(b, 0, true, 0x89, RAX, RDX, 0);
+    Memory(b, 0, true, 0x8b, RAX, R8, SLOT_VALUE(C) + 8);
+    Memory(b, 0, true, 0x89, RAX, RDX, 8);
+  }
+  else
+  {
+    StoreMemory(b, RDX, VALUE_TYPE, a->d.constant.type);
+    LoadConstant(b, &a->d.constant);
+    Memory(b, 0, true, 0x89, RAX, RDX, VALUE_DATA);                // mov [data], rax
+  }
+  StackCount(C, 1);
+  return true;
+}
+
+/** @brief POPS to a variable, which does not hold a string. */
+static bool InlinePops(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const JitLayout * L = &C->rt->layout;
+  if(!IsVariable(&C->p->code[i].arg[0])) return false;
+
+  Destination(C, i, slow);
+  StackTop(C, 1, slow);
+  StackCount(C, -1);
+  Memory(b, 0, true, 0x8b, RAX, RDX, -16);                          // move of the value
+  Memory(b, 0, true, 0x89, RAX, R10, SLOT_VALUE(C));
+  Memory(b, 0, true, 0x8b, RAX, RDX, -8);
+  Memory(b, 0, true, 0x89, RAX, R10, SLOT_VALUE(C) + 8);
+  (void)L;
+  return true;
+}
+
+/** @brief ADDS, SUBS, MULS of integers or floats, DIVS of floats. */
+static bool InlineArithmetics(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  Op op = C->p->code[i].op;
+  static const unsigned integer[] = {0x03, 0x2b, 0x0faf};          // add, sub, imul r32, m32
+  static const unsigned real[] = {0x0f58, 0x0f5c, 0x0f59, 0x0f5e}; // addsd, subsd, mulsd, divsd
+  int index = (op == Op_Adds) ? 0 : (op == Op_Subs) ? 1 : (op == Op_Muls) ? 2 : 3;
+
+  StackTop(C, 2, slow);
+  Memory(b, 0, false, 0x8b, RCX, RDX, -32 + VALUE_TYPE);           // mov ecx, [x type]
+  Memory(b, 0, false, 0x3b, RCX, RDX, -16 + VALUE_TYPE);           // cmp ecx, [y type]
+  ToSlow(C, slow, CC_NE);
+  size_t floats = 0;
+  if(op != Op_Divs)
+  {
+    Registers(b, 0, false, 0x81, 7, RCX);                           // cmp ecx, int
+    U32(b, Type_Int);
+    floats = Forward(b, CC_NE);
+    Memory(b, 0, false, 0x8b, RAX, RDX, -32 + VALUE_DATA);         // mov eax, [x]
+    Memory(b, 0, false, integer[index], RAX, RDX, -16 + VALUE_DATA); // op eax, [y]
+    Memory(b, 0, false, 0x89, RAX, RDX, -32 + VALUE_DATA);         // mov [x], eax
+    StackCount(C, -1);
+    size_t done = Forward(b, -1);
+    Bind(b, floats);
+    floats = done;
+  }
+  Registers(b, 0, false, 0x81, 7, RCX);                             // cmp ecx, float
+  U32(b, Type_Float);
+  ToSlow(C, slow, CC_NE);
+  Memory(b, 0xf2, false, 0x0f10, 1, RDX, -16 + VALUE_DATA);        // movsd xmm1, [y]
+  if(op == Op_Divs)
+  {
+    BYTES(b, "\x0f\x57\xc0");                                       // xorps xmm0, xmm0
+    Registers(b, 0x66, false, 0x0f2e, 1, 0);                        // ucomisd xmm1, xmm0
+    ToSlow(C, slow, CC_E);                                          // zero or NaN
+  }
+  Memory(b, 0xf2, false, 0x0f10, 0, RDX, -32 + VALUE_DATA);        // movsd xmm0, [x]
+  Registers(b, 0xf2, false, real[index], 0, 1);                     // op xmm0, xmm1
+  Memory(b, 0xf2, false, 0x0f11, 0, RDX, -32 + VALUE_DATA);        // movsd [x], xmm0
+  StackCount(C, -1);
+  if(op != Op_Divs) Bind(b, floats);
+  return true;
+}
+
+/** @brief LTS, GTS, EQS of integers. */
+static bool InlineRelations(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  StackTop(C, 2, slow);
+  CompareMemory(b, RDX, -32 + VALUE_TYPE, Type_Int);
+  ToSlow(C, slow, CC_NE);
+  CompareMemory(b, RDX, -16 + VALUE_TYPE, Type_Int);
+  ToSlow(C, slow, CC_NE);
+  Memory(b, 0, false, 0x8b, RCX, RDX, -32 + VALUE_DATA);           // mov ecx, [x]
+  Memory(b, 0, false, 0x3b, RCX, RDX, -16 + VALUE_DATA);           // cmp ecx, [y]
+  StoreFlag(b, RelationCondition(C->p->code[i].op), RDX, -32);
+  StackCount(C, -1);
+  return true;
+}
+
+/** @brief INT2FLOATS, FLOAT2INTS, FLOAT2R2EINTS. */
+static bool InlineConverts(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  Op op = C->p->code[i].op;
+  StackTop(C, 1, slow);
+  CompareMemory(b, RDX, -16 + VALUE_TYPE, (op == Op_Int2Floats) ? Type_Int : Type_Float);
+  ToSlow(C, slow, CC_NE);
+  if(op == Op_Int2Floats)
+  {
+    Memory(b, 0xf2, false, 0x0f2a, 0, RDX, -16 + VALUE_DATA);      // cvtsi2sd xmm0, [x]
+    Memory(b, 0xf2, false, 0x0f11, 0, RDX, -16 + VALUE_DATA);      // movsd [x], xmm0
+    StoreMemory(b, RDX, -16 + VALUE_TYPE, Type_Float);
+    return true;
+  }
+  // out of range is 0x80000000 (INT_MIN), the rounding of SSE is to even
+  Memory(b, 0xf2, false, (op == Op_Float2Ints) ? 0x0f2c : 0x0f2d, RAX, RDX, -16 + VALUE_DATA);
+  Memory(b, 0, false, 0x89, RAX, RDX, -16 + VALUE_DATA);           // mov [x], eax
+  StoreMemory(b, RDX, -16 + VALUE_TYPE, Type_Int);
+  return true;
+}
+
+/** @brief JUMPIFEQS, JUMPIFNEQS of integers or bools. */
+static bool InlineJumpIfs(Compiler * C, size_t i, Slow * slow)
+{
+  Buffer * b = &C->b;
+  const Instr * ins = &C->p->code[i];
+  if(LabelTarget(ins) == NO_TARGET) return false;
+
+  StackTop(C, 2, slow);
+  Memory(b, 0, false, 0x8b, RAX, RDX, -32 + VALUE_TYPE);           // mov eax, [x type]
+  Memory(b, 0, false, 0x3b, RAX, RDX, -16 + VALUE_TYPE);           // cmp eax, [y type]
+  ToSlow(C, slow, CC_NE);
+  Registers(b, 0, false, 0x81, 7, RAX);                             // cmp eax, int
+  U32(b, Type_Int);
+  size_t bools = Forward(b, CC_NE);
+  Memory(b, 0, false, 0x8b, RCX, RDX, -32 + VALUE_DATA);           // mov ecx, [x]
+  Memory(b, 0, false, 0x3b, RCX, RDX, -16 + VALUE_DATA);           // cmp ecx, [y]
+  size_t compared = Forward(b, -1);
+  Bind(b, bools);
+  Registers(b, 0, false, 0x81, 7, RAX);                             // cmp eax, bool
+  U32(b, Type_Bool);
+  ToSlow(C, slow, CC_NE);
+  Memory(b, 0, false, 0x0fb6, RCX, RDX, -32 + VALUE_DATA);         // movzx ecx, byte [x]
+  Memory(b, 0, false, 0x3a, RCX, RDX, -16 + VALUE_DATA);           // cmp cl, [y]
+  Bind(b, compared);
+  BYTES(b, "\x0f\x94\xc1");                                         // sete cl
+  Memory(b, 0, true, 0x83, 5, RBX, (int32_t)C->rt->layout.stack_count); // sub qword [count], 2
+  Byte(b, 2);
+  BYTES(b, "\x84\xc9");                                             // test cl, cl
+  JumpIf(C, (ins->op == Op_JumpIfEqs) ? CC_NE : CC_E, LabelTarget(ins));
+  return true;
+}
+
+/**
+ * @brief   Compiles the inline code of the instruction with the slow path.
+ *
+ * @returns True, if compiled. False, if the instruction has no inline code.
+ */
+static bool InlineInstruction(Compiler * C, size_t i)
+{
+  Buffer * b = &C->b;
+  const Instr * ins = &C->p->code[i];
+  Slow slow = {.count = 0};
+  bool inlined;
+  switch(ins->op)
+  {
+    case Op_Move: inlined = InlineMove(C, i, &slow); break;
+    case Op_Add: case Op_Sub: case Op_Mul: case Op_Lt: case Op_Gt: case Op_Eq:
+      inlined = InlineBinary(C, i, &slow);
+      break;
+    case Op_Pushs: inlined = InlinePushs(C, i, &slow); break;
+    case Op_Pops: inlined = InlinePops(C, i, &slow); break;
+    case Op_Adds: case Op_Subs: case Op_Muls: case Op_Divs: inlined = InlineArithmetics(C, i, &slow); break;
+    case Op_Lts: case Op_Gts: case Op_Eqs: inlined = InlineRelations(C, i, &slow); break;
+    case Op_Int2Floats: case Op_Float2Ints: case Op_Float2R2EInts: inlined = InlineConverts(C, i, &slow); break;
+    case Op_JumpIfEqs: case Op_JumpIfNeqs: inlined = InlineJumpIfs(C, i, &slow); break;
+    default: inlined = false; break;
+  }
+  if(!inlined) return false;
+
+  size_t done = Forward(b, -1);
+  for(size_t k = 0; k < slow.count; k++) Bind(b, slow.at[k]);
+  Helper(C, i, ins->op);
+  if(ins->op == Op_JumpIfEqs || ins->op == Op_JumpIfNeqs) JumpIf(C, CC_E, LabelTarget(ins));
+  Bind(b, done);
+  return true;
+}
+
+/** @brief Compiles the instruction. */
+static bool CompileInstruction(Compiler * C, size_t i)
+{
+  Instr * ins = &C->p->code[i];
+  if(C->inline_code && InlineInstruction(C, i)) return true;
+  switch(ins->op)
+  {
+    case Op_Label:
+      return true;
+    case Op_Break:
+      // only in the silent mode, see RunCompiled()
+      return true;
+    case Op_End:
+      BYTES(&C->b, "\x31\xc0");         // xor eax, eax
+      Jump(C, TARGET_EXIT(C));
+      return true;
+
+    case Op_Jump:
+      JumpToLabel(C, i);
+      return true;
+    case Op_JumpIfEq: case Op_JumpIfNeq: case Op_JumpIfEqs: case Op_JumpIfNeqs:
+      if(C->rt->helpers[ins->op] == NULL) return false;
+      Helper(C, i, ins->op);
+      if(LabelTarget(ins) != NO_TARGET)
+      {
+        JumpIf(C, 0x4, LabelTarget(ins));   // je label
+        return true;
+      }
+      BYTES(&C->b, "\x75\x0c");         // jne over the error
+      Error(C, i);
+      return true;
+
+    case Op_Call:
+      if(LabelTarget(ins) == NO_TARGET)
+      {
+        Error(C, i);
+        return true;
+      }
+      BYTES(&C->b, "\x49\x81\xfc");     // cmp r12, limit
+      U32(&C->b, (JIT_STACK - JIT_STACK_RESERVE) / JIT_CALL_FRAME);
+      BYTES(&C->b, "\x72\x0c");         // jb over the error
+      Error(C, i);
+      BYTES(&C->b, "\x49\xff\xc4");     // inc r12
+      BYTES(&C->b, "\x48\x83\xec\x08"); // sub rsp, 8
+      Byte(&C->b, 0xe8);                // call label
+      Displacement(C, LabelTarget(ins));
+      BYTES(&C->b, "\x48\x83\xc4\x08"); // add rsp, 8
+      return true;
+    case Op_Return:
+      BYTES(&C->b, "\x4d\x85\xe4");     // test r12, r12
+      BYTES(&C->b, "\x75\x0c");         // jnz over the error
+      Error(C, i);
+      BYTES(&C->b, "\x49\xff\xcc");     // dec r12
+      Byte(&C->b, 0xc3);                // ret
+      return true;
+
+    default:
+      if(C->rt->helpers[ins->op] == NULL) return false;
+      Helper(C, i, ins->op);
+      return true;
+  }
+}
+
+/** @brief Compiles the entry, the instructions and the exit. */
+static bool CompileProgram(Compiler * C)
+{
+  // entry(machine, instructions, helpers, stack)
+  BYTES(&C->b, "\x55\x53\x41\x54\x41\x55\x41\x56\x41\x57"); // push rbp, rbx, r12-r15
+  BYTES(&C->b, "\x48\x83\xec\x08");     // sub rsp, 8
+  BYTES(&C->b, "\x48\x89\xfb");         // mov rbx, rdi
+  BYTES(&C->b, "\x49\x89\xf5");         // mov r13, rsi
+  BYTES(&C->b, "\x49\x89\xd6");         // mov r14, rdx
+  BYTES(&C->b, "\x49\x89\xe7");         // mov r15, rsp
+  BYTES(&C->b, "\x48\x89\xcc");         // mov rsp, rcx
+  BYTES(&C->b, "\x45\x31\xe4");         // xor r12d, r12d
+
+  for(size_t i = 0; i < C->p->count; i++)
+  {
+    C->offsets[i] = C->b.count;
+    if(!CompileInstruction(C, i)) return false;
+  }
+
+  // error: fails at the instruction in rsi
+  C->offsets[TARGET_ERROR(C)] = C->b.count;
+  BYTES(&C->b, "\x48\x89\xdf");         // mov rdi, rbx
+  BYTES(&C->b, "\x41\xff\x96");         // call [r14 + error]
+  U32(&C->b, (uint32_t)(Op_Count * sizeof(JitHelper)));
+
+  // exit: returns eax
+  C->offsets[TARGET_EXIT(C)] = C->b.count;
+  BYTES(&C->b, "\x4c\x89\xfc");         // mov rsp, r15
+  BYTES(&C->b, "\x48\x83\xc4\x08");     // add rsp, 8
+  BYTES(&C->b, "\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5b\x5d"); // pop r15-r12, rbx, rbp
+  Byte(&C->b, 0xc3);                    // ret
+
+  if(C->b.failed || C->failed) return false;
+  for(size_t i = 0; i < C->patches_count; i++)
+  {
+    int64_t displacement = (int64_t)C->offsets[C->patches[i].target] - (int64_t)(C->patches[i].at + 4);
+    uint32_t value = (uint32_t)(int32_t)displacement;
+    for(int k = 0; k < 4; k++) C->b.data[C->patches[i].at + k] = (value >> (8 * k)) & 0xff;
+  }
+  return true;
+}
+
+/*------------------------------ INTERFACE ------------------------------------*/
+
+JitCode * JitCompile(Program * p, const JitRuntime * rt)
+{
+  // displacements of the instructions are 32-bit
+  if(p->count * sizeof(Instr) > INT32_MAX) return NULL;
+
+  Compiler C = {.p = p, .rt = rt};
+  // the inline code moves values as two quadwords
+  C.inline_code = sizeof(Value) == 16 && offsetof(Value, type) == 0 && offsetof(Value, d) == 8;
+  JitCode * code = calloc(1, sizeof(JitCode));
+  C.offsets = calloc(p->count + 2, sizeof(size_t));
+  bool ok = code != NULL && C.offsets != NULL && CompileProgram(&C);
+
+  if(ok)
+  {
+    code->instructions = p->code;
+    code->helpers = malloc((Op_Count + 1) * sizeof(JitHelper));
+    ok = code->helpers != NULL;
+  }
+  if(ok)
+  {
+    memcpy(code->helpers, rt->helpers, Op_Count * sizeof(JitHelper));
+    code->helpers[Op_Count] = rt->error;
+
+    // written, then made executable
+    code->size = C.b.count;
+    code->mapped = C.b.count;
+    code->code = mmap(NULL, code->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(code->code == MAP_FAILED) code->code = NULL;
+    ok = code->code != NULL;
+  }
+  if(ok)
+  {
+    memcpy(code->code, C.b.data, C.b.count);
+    ok = mprotect(code->code, code->mapped, PROT_READ | PROT_EXEC) == 0;
+  }
+  if(ok)
+  {
+    code->stack = mmap(NULL, JIT_STACK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(code->stack == MAP_FAILED) code->stack = NULL;
+    ok = code->stack != NULL;
+  }
+
+  free(C.b.data);
+  free(C.offsets);
+  free(C.patches);
+  if(!ok)
+  {
+    JitFree(code);
+    return NULL;
+  }
+  return code;
+}
+
+JitResult JitRun(JitCode * code, void * machine)
+{
+  typedef JitResult (*Entry)(void * machine, Instr * instructions, JitHelper * helpers, void * stack);
+  Entry entry;
+  // the code is data for ISO C, POSIX allows the conversion
+  memcpy(&entry, &(void *){code->code}, sizeof(entry));
+  return entry(machine, code->instructions, code->helpers, code->stack + JIT_STACK);
+}
+
+void JitFree(JitCode * code)
+{
+  if(code == NULL) return;
+  if(code->code != NULL) munmap(code->code, code->mapped);
+  if(code->stack != NULL) munmap(code->stack, JIT_STACK);
+  free(code->helpers);
+  free(code);
+}
+
+#else // JIT_SUPPORTED
+
+JitCode * JitCompile(Program * p, const JitRuntime * rt)
+{
+  (void)p;
+  (void)rt;
+  return NULL;
+}
+
+JitResult JitRun(JitCode * code, void * machine)
+{
+  (void)code;
+  (void)machine;
+  return Jit_Failed;
+}
+
+void JitFree(JitCode * code)
+{
+  free(code);
+}
+
+#endif // JIT_SUPPORTED
+
+size_t JitSize(const JitCode * code)
+{
+  return code->size;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file jit.h
+ * @interface jit
+ * @date 19th october 2026
+ * @brief Native code interface.
+ *
+ * This interface declares translation of a loaded IFJcode17 program
+ * to x86-64 machine code, which is executed in-process.
+ *
+ * The control flow (jumps, calls and returns) is compiled to native
+ * jumps, calls and returns, with the machine stack of its own.
+ * Other instructions call helpers of the machine, which execute them
+ * as the interpreter does; the common integer cases of the arithmetic,
+ * relations and the data stack are compiled inline and call the helper
+ * only for other types. Programs, which cannot be compiled, are refused
+ * and the machine interprets them.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "program.h"
+
+/**
+ * @brief   Results of the helpers.
+ */
+typedef enum
+{
+  Jit_Continue = 0,   /**< Executed, continues with the next instruction. */
+  Jit_Taken = 1,      /**< The conditional jump is taken. */
+  Jit_Failed = 2      /**< Runtime error. */
+} JitResult;
+
+/**
+ * @brief   Helper executing the instruction.
+ *
+ * @param machine     Machine.
+ * @param ip          Instruction.
+ * @returns Result of the execution.
+ */
+typedef JitResult (*JitHelper)(void * machine, Instr * ip);
+
+/**
+ * @brief   Layout of the machine, read by the inline code.
+ *
+ * Offsets are in bytes.
+ */
+typedef struct
+{
+  size_t local;           /**< Frame * of LF in the machine. */
+  size_t global;          /**< Frame * of GF in the machine. */
+  size_t temporary;       /**< Frame * of TF in the machine. */
+  size_t stack;           /**< Value * of the data stack in the machine. */
+  size_t stack_count;     /**< size_t count of the data stack in the machine. */
+  size_t stack_capacity;  /**< size_t capacity of the data stack in the machine. */
+  size_t frame_slots;     /**< Slot * in the frame. */
+  size_t frame_count;     /**< unsigned count of the slots in the frame. */
+  size_t slot_size;       /**< Size of the slot. */
+  size_t slot_name;       /**< unsigned name in the slot. */
+  size_t slot_value;      /**< Value in the slot. */
+} JitLayout;
+
+/**
+ * @brief   Runtime of the compiled code.
+ */
+typedef struct
+{
+  JitHelper helpers[Op_Count];  /**< Helpers by opcode, NULL if not supported. */
+  JitHelper error;              /**< Fails at the refused instruction (empty call stack, missing label). */
+  JitLayout layout;             /**< Layout of the machine. */
+} JitRuntime;
+
+/**
+ * @brief   Compiled program.
+ */
+typedef struct JitCode JitCode;
+
+/**
+ * @brief   Compiles the program.
+ *
+ * @param p       Program, its instructions are passed to the helpers.
+ * @param rt      Runtime.
+ * @returns Compiled code, or NULL if the program or the host is not supported.
+ */
+JitCode * JitCompile(Program * p, const JitRuntime * rt);
+
+/**
+ * @brief   Executes the compiled code.
+ *
+ * @param code    Compiled code.
+ * @param machine Machine passed to the helpers.
+ * @returns Jit_Continue, if the program ended. Jit_Failed otherwise.
+ */
+JitResult JitRun(JitCode * code, void * machine);
+
+/**
+ * @brief   Size of the compiled code.
+ *
+ * @param code    Compiled code.
+ * @returns Number of bytes of the machine code.
+ */
+size_t JitSize(const JitCode * code);
+
+/**
+ * @brief   Destroys the compiled code.
+ *
+ * @param code    Compiled code, or NULL.
+ */
+void JitFree(JitCode * code);
+
+#endif // JIT_H
@@ -0,0 +1,1267 @@
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "jit.h"
+#include "machine.h"
+
+/** @brief Number of variables of a frame searched without index. */
+#define FRAME_LINEAR 8
+
+/**
+ * @brief   Variable in a frame.
+ */
+typedef struct
+{
+  unsigned name;        /**< Interned name. */
+  Value value;
+} Slot;
+
+/**
+ * @brief   Frame of variables.
+ */
+typedef struct Frame
+{
+  Slot * slots;         /**< Variables in order of definition. */
+  unsigned count, capacity;
+  unsigned * index;     /**< Open addressing by name, slots + 1 (0 is empty). */
+  unsigned index_capacity;
+  struct Frame * next;  /**< Frame below in the stack, or next free frame. */
+} Frame;
+
+/**
+ * @brief   State of the machine.
+ */
+typedef struct
+{
+  Program * p;
+  Frame * global;           /**< GF */
+  Frame * local;            /**< LF, top of the stack of frames. */
+  Frame * temporary;        /**< TF */
+  Frame * free_frames;      /**< Frames to reuse. */
+  Value * stack;            /**< Data stack. */
+  size_t stack_count, stack_capacity;
+  size_t * calls;           /**< Return addresses. */
+  size_t calls_count, calls_capacity;
+  String * chars[256];      /**< Strings of a single character. */
+  String * types[5];        /**< Results of TYPE by ValueType. */
+  bool silent;              /**< DPRINT and BREAK are ignored. */
+  const Instr * at;         /**< Instruction of the runtime error in the compiled code. */
+  const char * message;     /**< Message of the runtime error. */
+  int code;                 /**< Code of the runtime error. */
+  bool unresolved;          /**< The error occurred in an operand. */
+} Machine;
+
+/*------------------------------ FRAMES ------------------------------------*/
+
+/** @brief Slot of the index for the name. */
+static inline unsigned IndexHash(unsigned name, unsigned capacity)
+{
+  return (name * 2654435761u) & (capacity - 1);
+}
+
+/** @brief Rebuilds the index of the frame, grows it if needed. */
+static bool Reindex(Frame * f)
+{
+  unsigned capacity = (f->index_capacity == 0) ? 4 * FRAME_LINEAR : f->index_capacity;
+  while(capacity < 2 * f->count) capacity *= 2;
+  unsigned * index = (capacity == f->index_capacity) ? f->index : calloc(capacity, sizeof(unsigned));
+  if(index == NULL) return false;
+  if(index == f->index) memset(index, 0, capacity * sizeof(unsigned));
+  for(unsigned s = 0; s < f->count; s++)
+  {
+    unsigned h = IndexHash(f->slots[s].name, capacity);
+    while(index[h] != 0) h = (h + 1) & (capacity - 1);
+    index[h] = s + 1;
+  }
+  if(index != f->index) free(f->index);
+  f->index = index;
+  f->index_capacity = capacity;
+  return true;
+}
+
+/** @brief Finds the slot of the name, NULL if not defined. */
+static Slot * FindSlot(Frame * f, unsigned name)
+{
+  if(f->count <= FRAME_LINEAR)
+  {
+    for(unsigned s = 0; s < f->count; s++)
+      if(f->slots[s].name == name) return &f->slots[s];
+    return NULL;
+  }
+  for(unsigned h = IndexHash(name, f->index_capacity); f->index[h] != 0; h = (h + 1) & (f->index_capacity - 1))
+    if(f->slots[f->index[h] - 1].name == name) return &f->slots[f->index[h] - 1];
+  return NULL;
+}
+
+/**
+ * @brief   Defines the variable.
+ *
+ * @param f       Frame.
+ * @param name    Interned name.
+ * @returns 0 if success, 52 if already defined, 99 otherwise.
+ */
+static int DefineSlot(Frame * f, unsigned name)
+{
+  if(FindSlot(f, name) != NULL) return 52;
+  if(f->count == f->capacity)
+  {
+    unsigned capacity = (f->capacity == 0) ? FRAME_LINEAR : 2 * f->capacity;
+    Slot * grown = realloc(f->slots, capacity * sizeof(Slot));
+    if(grown == NULL) return 99;
+    f->slots = grown;
+    f->capacity = capacity;
+  }
+  f->slots[f->count++] = (Slot){name, {.type = Type_Undefined}};
+
+  // a reused frame keeps its index, which is filled again
+  if(f->count <= FRAME_LINEAR) return 0;
+  if(f->count == FRAME_LINEAR + 1 || 2 * f->count > f->index_capacity) return Reindex(f) ? 0 : 99;
+  unsigned h = IndexHash(name, f->index_capacity);
+  while(f->index[h] != 0) h = (h + 1) & (f->index_capacity - 1);
+  f->index[h] = f->count;
+  return 0;
+}
+
+/** @brief Creates an empty frame, reusing a released one. */
+static Frame * NewFrame(Machine * M)
+{
+  Frame * f = M->free_frames;
+  if(f != NULL) M->free_frames = f->next;
+  else f = calloc(1, sizeof(Frame));
+  if(f != NULL) f->next = NULL;
+  return f;
+}
+
+/** @brief Releases the frame for reuse. */
+static void ReleaseFrame(Machine * M, Frame * f)
+{
+  if(f == NULL) return;
+  for(unsigned s = 0; s < f->count; s++) ValueRelease(&f->slots[s].value);
+  f->count = 0;
+  f->next = M->free_frames;
+  M->free_frames = f;
+}
+
+/** @brief Frees the frames of the list. */
+static void FreeFrames(Frame * f)
+{
+  while(f != NULL)
+  {
+    Frame * next = f->next;
+    for(unsigned s = 0; s < f->count; s++) ValueRelease(&f->slots[s].value);
+    free(f->slots);
+    free(f->index);
+    free(f);
+    f = next;
+  }
+}
+
+/*------------------------------ OPERANDS ------------------------------------*/
+
+/** @brief Sets the runtime error, returns NULL. */
+static void * Fail(Machine * M, int code, const char * message)
+{
+  M->code = code;
+  M->message = message;
+  return NULL;
+}
+
+/** @brief Frame of the variable, NULL if it does not exist. */
+static inline Frame * FrameOf(Machine * M, const Arg * a)
+{
+  switch(a->kind)
+  {
+    case Arg_Global: return M->global;
+    case Arg_Local: return M->local;
+    default: return M->temporary;
+  }
+}
+
+/** @brief Prefix of the frame of the variable. */
+static const char * FrameName(ArgKind kind)
+{
+  return (kind == Arg_Global) ? "GF" : (kind == Arg_Local) ? "LF" : "TF";
+}
+
+/**
+ * @brief   Slot of the variable.
+ *
+ * The slot found is cached in the operand, so that following executions
+ * look it up in the same place first.
+ * @param a       Variable.
+ * @returns Slot, or NULL if an error occurred.
+ */
+static inline Slot * Variable(Machine * M, Arg * a)
+{
+  Frame * f = FrameOf(M, a);
+  if(f == NULL)
+  {
+    M->unresolved = true;
+    return Fail(M, 55, (a->kind == Arg_Local) ? "Local frame does not exist!" : "Temporary frame does not exist!");
+  }
+
+  unsigned s = a->d.var.slot;
+  if(s < f->count && f->slots[s].name == a->d.var.name) return &f->slots[s];
+
+  Slot * slot = FindSlot(f, a->d.var.name);
+  if(slot == NULL)
+  {
+    fprintf(stderr, "Symbol %s@%s not found!\n", FrameName(a->kind), M->p->names[a->d.var.name]);
+    M->unresolved = true;
+    return Fail(M, 54, "Symbol is undefined!");
+  }
+  a->d.var.slot = (unsigned)(slot - f->slots);
+  return slot;
+}
+
+/**
+ * @brief   Value of the symbol, which may be uninitialized.
+ *
+ * @param a       Constant or variable.
+ * @returns Value, or NULL if an error occurred.
+ */
+static inline const Value * Any(Machine * M, Arg * a)
+{
+  if(a->kind == Arg_Constant) return &a->d.constant;
+  Slot * slot = Variable(M, a);
+  return (slot != NULL) ? &slot->value : NULL;
+}
+
+/**
+ * @brief   Value of the symbol.
+ *
+ * @param a       Constant or variable.
+ * @returns Initialized value, or NULL if an error occurred.
+ */
+static inline const Value * Symbol(Machine * M, Arg * a)
+{
+  const Value * v = Any(M, a);
+  if(v != NULL && v->type == Type_Undefined) return Fail(M, 56, "Symbol has not been initilized!");
+  return v;
+}
+
+/** @brief Sets the value of the slot, the value is moved. */
+static inline void Assign(Slot * slot, Value v)
+{
+  ValueRelease(&slot->value);
+  slot->value = v;
+}
+
+/** @brief Copy of the value with a reference. */
+static inline Value Copy(const Value * v)
+{
+  if(v->type == Type_String) StringRetain(v->d.s);
+  return *v;
+}
+
+/** @brief Pushes the value to the data stack, the value is moved. */
+static inline bool Push(Machine * M, Value v)
+{
+  if(M->stack_count == M->stack_capacity)
+  {
+    size_t capacity = (M->stack_capacity == 0) ? 64 : 2 * M->stack_capacity;
+    Value * grown = realloc(M->stack, capacity * sizeof(Value));
+    if(grown == NULL)
+    {
+      ValueRelease(&v);
+      Fail(M, 99, "Out of memory!");
+      return false;
+    }
+    M->stack = grown;
+    M->stack_capacity = capacity;
+  }
+  M->stack[M->stack_count++] = v;
+  return true;
+}
+
+/** @brief Pops the value from the data stack, its reference is moved. */
+static inline bool Pop(Machine * M, Value * v)
+{
+  if(M->stack_count == 0)
+  {
+    M->unresolved = true;
+    Fail(M, 56, "Operand stack is empty");
+    return false;
+  }
+  *v = M->stack[--M->stack_count];
+  return true;
+}
+
+/*------------------------------ OPERATIONS ------------------------------------*/
+
+/** @brief Integer of the float, INT_MIN if out of range. */
+static inline int ToInt(double f)
+{
+  return (f >= -2147483648.0 && f < 2147483648.0) ? (int)f : INT_MIN;
+}
+
+/** @brief Rounds the float, halves to the odd integer. */
+static double RoundOdd(double f)
+{
+  double r = floor(f), fraction = f - r;
+  if(fraction > 0.5 || (fraction == 0.5 && fmod(r, 2.0) == 0.0)) r += 1.0;
+  return r;
+}
+
+/** @brief Compares two strings like memcmp() with lengths. */
+static int CompareStrings(const String * a, const String * b)
+{
+  size_t length = (a->length < b->length) ? a->length : b->length;
+  int c = memcmp(a->data, b->data, length);
+  if(c != 0) return c;
+  return (a->length > b->length) - (a->length < b->length);
+}
+
+/**
+ * @brief   Arithmetic operation.
+ *
+ * @param op      Add, Sub, Mul or Div (stack variants included).
+ * @param a       Left operand.
+ * @param b       Right operand.
+ * @param r       Returned result.
+ * @returns True, if success. False otherwise.
+ */
+static inline bool Arithmetic(Machine * M, Op op, const Value * a, const Value * b, Value * r)
+{
+  if(a->type != b->type) return Fail(M, 53, "Wrong operand type!") != NULL;
+  if(op == Op_Div || op == Op_Divs)
+  {
+    if(a->type != Type_Float) return Fail(M, 53, "Wrong operand type!") != NULL;
+    if(b->d.f == 0.0) return Fail(M, 57, "Division by zero!") != NULL;
+    *r = (Value){.type = Type_Float, .d.f = a->d.f / b->d.f};
+    return true;
+  }
+  if(a->type == Type_Int)
+  {
+    unsigned x = (unsigned)a->d.i, y = (unsigned)b->d.i;
+    unsigned z = (op == Op_Add || op == Op_Adds) ? x + y : (op == Op_Sub || op == Op_Subs) ? x - y : x * y;
+    *r = (Value){.type = Type_Int, .d.i = (int)z};
+    return true;
+  }
+  if(a->type == Type_Float)
+  {
+    double x = a->d.f, y = b->d.f;
+    double z = (op == Op_Add || op == Op_Adds) ? x + y : (op == Op_Sub || op == Op_Subs) ? x - y : x * y;
+    *r = (Value){.type = Type_Float, .d.f = z};
+    return true;
+  }
+  return Fail(M, 53, "Wrong operand type!") != NULL;
+}
+
+/**
+ * @brief   Relational operation.
+ *
+ * @param op      Lt, Gt or Eq (stack variants included).
+ * @param a       Left operand.
+ * @param b       Right operand.
+ * @param r       Returned result.
+ * @returns True, if success. False otherwise.
+ */
+static inline bool Relation(Machine * M, Op op, const Value * a, const Value * b, bool * r)
+{
+  if(a->type != b->type) return Fail(M, 53, "Wrong operand type!") != NULL;
+  int c;
+  switch(a->type)
+  {
+    case Type_Int: c = (a->d.i > b->d.i) - (a->d.i < b->d.i); break;
+    case Type_Float: c = (a->d.f > b->d.f) - (a->d.f < b->d.f); break;
+    case Type_Bool: c = (int)a->d.b - (int)b->d.b; break;
+    default: c = (a->d.s == b->d.s) ? 0 : CompareStrings(a->d.s, b->d.s); break;
+  }
+  if(op == Op_Lt || op == Op_Lts) *r = c < 0;
+  else if(op == Op_Gt || op == Op_Gts) *r = c > 0;
+  else *r = (a->type == Type_Float) ? a->d.f == b->d.f : c == 0;
+  return true;
+}
+
+/**
+ * @brief   Conversion.
+ *
+ * @param op      Int2Float, Float2Int, Float2R2EInt, Float2R2OInt or Int2Char (stack variants included).
+ * @param a       Operand.
+ * @param r       Returned result.
+ * @returns True, if success. False otherwise.
+ */
+static inline bool Convert(Machine * M, Op op, const Value * a, Value * r)
+{
+  switch(op)
+  {
+    case Op_Int2Float: case Op_Int2Floats:
+      if(a->type != Type_Int) break;
+      *r = (Value){.type = Type_Float, .d.f = (double)a->d.i};
+      return true;
+    case Op_Int2Char: case Op_Int2Chars:
+      if(a->type != Type_Int) break;
+      if(a->d.i < 0 || a->d.i > 255) return Fail(M, 58, "Escape sequence not in the 0-255 range!") != NULL;
+      *r = (Value){.type = Type_String, .d.s = M->chars[a->d.i]};
+      StringRetain(r->d.s);
+      return true;
+    default:
+      if(a->type != Type_Float) break;
+      double f = a->d.f;
+      if(op == Op_Float2R2EInt || op == Op_Float2R2EInts) f = nearbyint(f);
+      else if(op == Op_Float2R2OInt || op == Op_Float2R2OInts) f = RoundOdd(f);
+      *r = (Value){.type = Type_Int, .d.i = ToInt(f)};
+      return true;
+  }
+  return Fail(M, 53, "Wrong operand type!") != NULL;
+}
+
+/** @brief Ordinal value of the character of the string. */
+static inline bool Ordinal(Machine * M, const Value * s, const Value * i, Value * r)
+{
+  if(s->type != Type_String || i->type != Type_Int) return Fail(M, 53, "Wrong operand type!") != NULL;
+  if(i->d.i < 0 || (size_t)i->d.i >= s->d.s->length) return Fail(M, 58, "String index out of bounds!") != NULL;
+  *r = (Value){.type = Type_Int, .d.i = (unsigned char)s->d.s->data[i->d.i]};
+  return true;
+}
+
+/**
+ * @brief   Reads the value from stdin.
+ *
+ * A line is read, the ending newline is stripped.
+ * A missing or invalid input is zero, an empty string or false.
+ */
+static Value ReadValue(Machine * M, ValueType type)
+{
+  static char * line = NULL;
+  static size_t size = 0;
+  if(type == Type_Undefined)
+  {
+    free(line);
+    line = NULL;
+    return (Value){.type = Type_Undefined};
+  }
+
+  ssize_t length = getline(&line, &size, stdin);
+  if(length < 0) length = 0;
+  else if(length > 0 && line[length-1] == '\n') length--;
+  if(line != NULL) line[length] = '\0';
+
+  switch(type)
+  {
+    case Type_Int: return (Value){.type = Type_Int, .d.i = (length > 0) ? ToInt(strtod(line, NULL)) : 0};
+    case Type_Float: return (Value){.type = Type_Float, .d.f = (length > 0) ? strtod(line, NULL) : 0.0};
+    case Type_Bool: return (Value){.type = Type_Bool, .d.b = length > 0 && strcasecmp(line, "true") == 0};
+    default:
+    {
+      String * s = StringNew(line, length);
+      if(s != NULL) return (Value){.type = Type_String, .d.s = s};
+      Fail(M, 99, "Out of memory!");
+      return (Value){.type = Type_Undefined};
+    }
+  }
+}
+
+/** @brief Writes the value to stdout. */
+static inline void WriteValue(const Value * v)
+{
+  switch(v->type)
+  {
+    case Type_Int: printf("% d", v->d.i); break;
+    case Type_Float: printf("% g", v->d.f); break;
+    case Type_Bool: fputs(v->d.b ? "true" : "false", stdout); break;
+    default: fwrite(v->d.s->data, 1, v->d.s->length, stdout); break;
+  }
+}
+
+/*------------------------------ DEBUG ------------------------------------*/
+
+/** @brief Writes the value for debugging, as ic17int does. */
+static void DebugValue(const char * prefix, const char * name, const Value * v)
+{
+  fprintf(stderr, "%s@%s", prefix, name);
+  switch(v->type)
+  {
+    case Type_Undefined: fprintf(stderr, "()\n"); return;
+    case Type_Int: fprintf(stderr, "=%d(int)\n", v->d.i); return;
+    case Type_Bool: fprintf(stderr, "=%s(bool)\n", v->d.b ? "true" : "false"); return;
+    case Type_String:
+      fprintf(stderr, "=");
+      fwrite(v->d.s->data, 1, v->d.s->length, stderr);
+      fprintf(stderr, "(string)\n");
+      return;
+    case Type_Float:
+    {
+      // the shortest representation, which reads back
+      char buff[64];
+      for(int precision = 6; precision <= 17; precision++)
+      {
+        snprintf(buff, sizeof(buff), "%.*g", precision, v->d.f);
+        if(strtod(buff, NULL) == v->d.f) break;
+      }
+      fprintf(stderr, "=%s(double)\n", buff);
+      return;
+    }
+  }
+}
+
+/** @brief Writes variables of the frame, the last defined first. */
+static void DebugFrame(Machine * M, const char * title, const char * prefix, const Frame * f)
+{
+  fprintf(stderr, "\n%s:\n", title);
+  for(unsigned s = (f != NULL) ? f->count : 0; s > 0; s--)
+    DebugValue(prefix, M->p->names[f->slots[s-1].name], &f->slots[s-1].value);
+}
+
+/** @brief Writes the state of the machine. */
+static void DebugState(Machine * M, const Instr * ins, const Counters * c)
+{
+  unsigned long long executed = 0;
+  for(int op = 0; op < Op_End; op++) executed += c->opcodes[op];
+  fflush(stdout);
+  fprintf(stderr, "Current line: %u\nNumber of executed instructions: %llu\n", ins->line, executed - 1);
+  DebugFrame(M, "Global Frame", "GF", M->global);
+  DebugFrame(M, "Local Frame", "LF", M->local);
+  DebugFrame(M, "Temporary Frame", "TF", M->temporary);
+  fprintf(stderr, "\nStack:\n");
+  for(size_t i = 0; i < M->stack_count; i++) DebugValue("Stack", "", &M->stack[i]);
+}
+
+/** @brief Writes the symbol for debugging. */
+static void DebugSymbol(Machine * M, const Arg * a, const Value * v)
+{
+  if(a->kind == Arg_Constant) DebugValue("Const", "", v);
+  else DebugValue(FrameName(a->kind), M->p->names[a->d.var.name], v);
+}
+
+/*------------------------------ INSTRUCTIONS ------------------------------------*/
+/*
+ Instructions, which do not change the control flow, are executed by the
+ functions below. The interpreter inlines them into its handlers, the compiled
+ code (jit.h) calls them through the helpers. Each returns false on the runtime
+ error, which is set in the machine.
+*/
+
+/** @brief Fails with the wrong type of operands, returns false. */
+static inline bool WrongType(Machine * M)
+{
+  Fail(M, 53, "Wrong operand type!");
+  return false;
+}
+
+/** @brief Pops the right and then the left operand. */
+static inline bool PopOperands(Machine * M, Value * x, Value * y)
+{
+  if(!Pop(M, y)) return false;
+  if(!Pop(M, x))
+  {
+    ValueRelease(y);
+    return false;
+  }
+  return true;
+}
+
+/** @brief Destination and two symbols of the instruction. */
+static inline bool Operands(Machine * M, Instr * ip, Slot ** dest, const Value ** a, const Value ** b)
+{
+  return (*dest = Variable(M, &ip->arg[0])) != NULL
+      && (*a = Symbol(M, &ip->arg[1])) != NULL
+      && (b == NULL || (*b = Symbol(M, &ip->arg[2])) != NULL);
+}
+
+/** @brief MOVE */
+static inline bool ExecMove(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a;
+  if(!Operands(M, ip, &dest, &a, NULL)) return false;
+  if(dest->value.type == Type_String || a->type == Type_String) Assign(dest, Copy(a));
+  else dest->value = *a;
+  return true;
+}
+
+/** @brief CREATEFRAME */
+static inline bool ExecCreateFrame(Machine * M)
+{
+  ReleaseFrame(M, M->temporary);
+  if((M->temporary = NewFrame(M)) != NULL) return true;
+  Fail(M, 99, "Out of memory!");
+  return false;
+}
+
+/** @brief PUSHFRAME */
+static inline bool ExecPushFrame(Machine * M)
+{
+  if(M->temporary == NULL) return Fail(M, 55, "Temporary frame does not exist!") != NULL;
+  M->temporary->next = M->local;
+  M->local = M->temporary;
+  M->temporary = NULL;
+  return true;
+}
+
+/** @brief POPFRAME */
+static inline bool ExecPopFrame(Machine * M)
+{
+  if(M->local == NULL) return Fail(M, 55, "Local frame does not exist!") != NULL;
+  ReleaseFrame(M, M->temporary);
+  M->temporary = M->local;
+  M->local = M->local->next;
+  M->temporary->next = NULL;
+  return true;
+}
+
+/** @brief DEFVAR */
+static inline bool ExecDefvar(Machine * M, Instr * ip)
+{
+  Frame * f = FrameOf(M, &ip->arg[0]);
+  if(f == NULL) return Fail(M, 55, "Frame does not exist!") != NULL;
+  int result = DefineSlot(f, ip->arg[0].d.var.name);
+  if(result != 0) return Fail(M, result, (result == 52) ? "Symbol already exists!" : "Out of memory!") != NULL;
+  ip->arg[0].d.var.slot = f->count - 1;
+  return true;
+}
+
+/** @brief PUSHS */
+static inline bool ExecPushs(Machine * M, Instr * ip)
+{
+  const Value * a = Symbol(M, &ip->arg[0]);
+  return a != NULL && Push(M, Copy(a));
+}
+
+/** @brief POPS */
+static inline bool ExecPops(Machine * M, Instr * ip)
+{
+  Value x;
+  Slot * dest;
+  if(!Pop(M, &x)) return false;
+  if((dest = Variable(M, &ip->arg[0])) == NULL)
+  {
+    ValueRelease(&x);
+    return false;
+  }
+  Assign(dest, x);
+  return true;
+}
+
+/** @brief CLEARS */
+static inline bool ExecClears(Machine * M)
+{
+  while(M->stack_count > 0) ValueRelease(&M->stack[--M->stack_count]);
+  return true;
+}
+
+/** @brief ADD, SUB, MUL, DIV */
+static inline bool ExecArithmetic(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  Value r;
+  if(!Operands(M, ip, &dest, &a, &b) || !Arithmetic(M, ip->op, a, b, &r)) return false;
+  Assign(dest, r);
+  return true;
+}
+
+/** @brief ADDS, SUBS, MULS, DIVS */
+static inline bool ExecArithmetics(Machine * M, Instr * ip)
+{
+  Value x, y, r;
+  if(!PopOperands(M, &x, &y)) return false;
+  bool ok = Arithmetic(M, ip->op, &x, &y, &r);
+  ValueRelease(&x);
+  ValueRelease(&y);
+  return ok && Push(M, r);
+}
+
+/** @brief LT, GT, EQ */
+static inline bool ExecRelation(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  bool flag;
+  if(!Operands(M, ip, &dest, &a, &b) || !Relation(M, ip->op, a, b, &flag)) return false;
+  Assign(dest, (Value){.type = Type_Bool, .d.b = flag});
+  return true;
+}
+
+/** @brief LTS, GTS, EQS */
+static inline bool ExecRelations(Machine * M, Instr * ip)
+{
+  Value x, y;
+  bool flag;
+  if(!PopOperands(M, &x, &y)) return false;
+  bool ok = Relation(M, ip->op, &x, &y, &flag);
+  ValueRelease(&x);
+  ValueRelease(&y);
+  return ok && Push(M, (Value){.type = Type_Bool, .d.b = flag});
+}
+
+/** @brief AND, OR */
+static inline bool ExecLogic(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  if(!Operands(M, ip, &dest, &a, &b)) return false;
+  if(a->type != Type_Bool || b->type != Type_Bool) return WrongType(M);
+  bool flag = (ip->op == Op_And) ? (a->d.b && b->d.b) : (a->d.b || b->d.b);
+  Assign(dest, (Value){.type = Type_Bool, .d.b = flag});
+  return true;
+}
+
+/** @brief NOT */
+static inline bool ExecNot(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a;
+  if(!Operands(M, ip, &dest, &a, NULL)) return false;
+  if(a->type != Type_Bool) return WrongType(M);
+  Assign(dest, (Value){.type = Type_Bool, .d.b = !a->d.b});
+  return true;
+}
+
+/** @brief ANDS, ORS */
+static inline bool ExecLogics(Machine * M, Instr * ip)
+{
+  Value x, y;
+  if(!PopOperands(M, &x, &y)) return false;
+  if(x.type != Type_Bool || y.type != Type_Bool)
+  {
+    ValueRelease(&x);
+    ValueRelease(&y);
+    return WrongType(M);
+  }
+  bool flag = (ip->op == Op_Ands) ? (x.d.b && y.d.b) : (x.d.b || y.d.b);
+  return Push(M, (Value){.type = Type_Bool, .d.b = flag});
+}
+
+/** @brief NOTS */
+static inline bool ExecNots(Machine * M)
+{
+  Value x;
+  if(!Pop(M, &x)) return false;
+  if(x.type != Type_Bool)
+  {
+    ValueRelease(&x);
+    return WrongType(M);
+  }
+  return Push(M, (Value){.type = Type_Bool, .d.b = !x.d.b});
+}
+
+/** @brief INT2FLOAT, FLOAT2INT, FLOAT2R2EINT, FLOAT2R2OINT, INT2CHAR */
+static inline bool ExecConvert(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a;
+  Value r;
+  if(!Operands(M, ip, &dest, &a, NULL) || !Convert(M, ip->op, a, &r)) return false;
+  Assign(dest, r);
+  return true;
+}
+
+/** @brief INT2FLOATS, FLOAT2INTS, FLOAT2R2EINTS, FLOAT2R2OINTS, INT2CHARS */
+static inline bool ExecConverts(Machine * M, Instr * ip)
+{
+  Value x, r;
+  if(!Pop(M, &x)) return false;
+  bool ok = Convert(M, ip->op, &x, &r);
+  ValueRelease(&x);
+  return ok && Push(M, r);
+}
+
+/** @brief STRI2INT */
+static inline bool ExecStri2Int(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  Value r;
+  if(!Operands(M, ip, &dest, &a, &b) || !Ordinal(M, a, b, &r)) return false;
+  Assign(dest, r);
+  return true;
+}
+
+/** @brief STRI2INTS */
+static inline bool ExecStri2Ints(Machine * M)
+{
+  Value x, y, r;
+  if(!PopOperands(M, &x, &y)) return false;
+  bool ok = Ordinal(M, &x, &y, &r);
+  ValueRelease(&x);
+  ValueRelease(&y);
+  return ok && Push(M, r);
+}
+
+/** @brief READ */
+static inline bool ExecRead(Machine * M, Instr * ip)
+{
+  Slot * dest = Variable(M, &ip->arg[0]);
+  if(dest == NULL) return false;
+  fflush(stdout);
+  Value r = ReadValue(M, ip->arg[1].d.type);
+  if(r.type == Type_Undefined) return false;
+  Assign(dest, r);
+  return true;
+}
+
+/** @brief WRITE */
+static inline bool ExecWrite(Machine * M, Instr * ip)
+{
+  const Value * a = Symbol(M, &ip->arg[0]);
+  if(a == NULL) return false;
+  WriteValue(a);
+  return true;
+}
+
+/** @brief CONCAT */
+static inline bool ExecConcat(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  if(!Operands(M, ip, &dest, &a, &b)) return false;
+  if(a->type != Type_String || b->type != Type_String) return WrongType(M);
+  String * s1 = a->d.s, * s2 = b->d.s;
+  if(a == &dest->value && s1->refs == 1 && s1 != s2)
+  {
+    // the only reference is overwritten, so the string grows in place
+    String * grown = realloc(s1, sizeof(String) + s1->length + s2->length + 1);
+    if(grown == NULL) return Fail(M, 99, "Out of memory!") != NULL;
+    memcpy(grown->data + grown->length, s2->data, s2->length + 1);
+    grown->length += s2->length;
+    dest->value.d.s = grown;
+    return true;
+  }
+  String * joined = StringNew(NULL, s1->length + s2->length);
+  if(joined == NULL) return Fail(M, 99, "Out of memory!") != NULL;
+  memcpy(joined->data, s1->data, s1->length);
+  memcpy(joined->data + s1->length, s2->data, s2->length + 1);
+  Assign(dest, (Value){.type = Type_String, .d.s = joined});
+  return true;
+}
+
+/** @brief STRLEN */
+static inline bool ExecStrlen(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a;
+  if(!Operands(M, ip, &dest, &a, NULL)) return false;
+  if(a->type != Type_String) return WrongType(M);
+  Assign(dest, (Value){.type = Type_Int, .d.i = (int)a->d.s->length});
+  return true;
+}
+
+/** @brief GETCHAR */
+static inline bool ExecGetchar(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  Value r;
+  if(!Operands(M, ip, &dest, &a, &b) || !Ordinal(M, a, b, &r)) return false;
+  StringRetain(M->chars[r.d.i]);
+  Assign(dest, (Value){.type = Type_String, .d.s = M->chars[r.d.i]});
+  return true;
+}
+
+/** @brief SETCHAR */
+static inline bool ExecSetchar(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a, * b;
+  if(!Operands(M, ip, &dest, &a, &b)) return false;
+  if(dest->value.type == Type_Undefined) return Fail(M, 56, "Symbol has not been initilized!") != NULL;
+  if(dest->value.type != Type_String || a->type != Type_Int || b->type != Type_String) return WrongType(M);
+  String * s = dest->value.d.s;
+  if(a->d.i < 0 || (size_t)a->d.i >= s->length) return Fail(M, 58, "String index out of bounds!") != NULL;
+  if(b->d.s->length == 0) return Fail(M, 58, "Using empty string as an substitution!") != NULL;
+  char ch = b->d.s->data[0];
+  if(s->refs > 1)
+  {
+    // copy on write
+    String * copy = StringNew(s->data, s->length);
+    if(copy == NULL) return Fail(M, 99, "Out of memory!") != NULL;
+    StringRelease(s);
+    dest->value.d.s = s = copy;
+  }
+  s->data[a->d.i] = ch;
+  return true;
+}
+
+/** @brief TYPE */
+static inline bool ExecType(Machine * M, Instr * ip)
+{
+  Slot * dest;
+  const Value * a;
+  if((dest = Variable(M, &ip->arg[0])) == NULL || (a = Any(M, &ip->arg[1])) == NULL) return false;
+  StringRetain(M->types[a->type]);
+  Assign(dest, (Value){.type = Type_String, .d.s = M->types[a->type]});
+  return true;
+}
+
+/** @brief JUMPIFEQ, JUMPIFNEQ; returns whether the jump is taken. */
+static inline bool ExecJumpIf(Machine * M, Instr * ip, bool * taken)
+{
+  const Value * a, * b;
+  bool flag;
+  if((a = Symbol(M, &ip->arg[1])) == NULL || (b = Symbol(M, &ip->arg[2])) == NULL) return false;
+  if(!Relation(M, Op_Eq, a, b, &flag)) return false;
+  *taken = (flag == (ip->op == Op_JumpIfEq));
+  return true;
+}
+
+/** @brief JUMPIFEQS, JUMPIFNEQS; returns whether the jump is taken. */
+static inline bool ExecJumpIfs(Machine * M, Instr * ip, bool * taken)
+{
+  Value x, y;
+  bool flag;
+  if(!PopOperands(M, &x, &y)) return false;
+  bool ok = Relation(M, Op_Eq, &x, &y, &flag);
+  ValueRelease(&x);
+  ValueRelease(&y);
+  if(ok) *taken = (flag == (ip->op == Op_JumpIfEqs));
+  return ok;
+}
+
+/** @brief DPRINT */
+static inline bool ExecDprint(Machine * M, Instr * ip)
+{
+  const Value * a = Any(M, &ip->arg[0]);
+  if(a == NULL) return false;
+  if(!M->silent) DebugSymbol(M, &ip->arg[0], a);
+  return true;
+}
+
+/*------------------------------ MACHINE ------------------------------------*/
+
+/** @brief Creates constant strings of the machine. */
+static bool Init(Machine * M, Program * p, bool silent)
+{
+  static const char * typeNames[] = {"", "int", "float", "bool", "string"};
+  memset(M, 0, sizeof(Machine));
+  M->p = p;
+  M->silent = silent;
+  M->global = calloc(1, sizeof(Frame));
+  if(M->global == NULL) return false;
+  for(int c = 0; c < 256; c++)
+  {
+    char ch = (char)c;
+    if((M->chars[c] = StringNew(&ch, 1)) == NULL) return false;
+  }
+  for(int t = 0; t < 5; t++)
+    if((M->types[t] = StringNew(typeNames[t], strlen(typeNames[t]))) == NULL) return false;
+  return true;
+}
+
+/** @brief Frees the machine. */
+static void Destroy(Machine * M)
+{
+  FreeFrames(M->global);
+  FreeFrames(M->local);
+  FreeFrames(M->temporary);
+  FreeFrames(M->free_frames);
+  for(size_t i = 0; i < M->stack_count; i++) ValueRelease(&M->stack[i]);
+  free(M->stack);
+  free(M->calls);
+  for(int c = 0; c < 256; c++) if(M->chars[c] != NULL) StringRelease(M->chars[c]);
+  for(int t = 0; t < 5; t++) if(M->types[t] != NULL) StringRelease(M->types[t]);
+  ReadValue(M, Type_Undefined);
+}
+
+/*
+ The dispatch loop jumps from the end of each handler straight to the next
+ one through a table of label addresses (threaded code), if the compiler
+ supports it, so every handler has its own indirect branch to predict.
+ Other compilers use a switch.
+*/
+#if defined(__GNUC__) && !defined(NO_THREADED_DISPATCH)
+  #define THREADED_DISPATCH
+#endif
+
+#ifdef THREADED_DISPATCH
+  #define OPCODE_HANDLER(id, name, operands) &&L_##id,
+  #define CASE(id) L_##id
+  #define DISPATCH() do { opcodes[ip->op]++; goto *handlers[ip->op]; } while(0)
+#else
+  #define CASE(id) case Op_##id
+  #define DISPATCH() goto dispatch
+#endif
+
+/** @brief Continues with the next instruction. */
+#define NEXT() do { ip++; DISPATCH(); } while(0)
+/** @brief Jumps to the label of the operand. */
+#define JUMP(a) do { \
+    if((a).d.label.target == NO_TARGET) { Fail(M, 52, "Label does not exist!"); goto error; } \
+    ip = code + (a).d.label.target; DISPATCH(); \
+  } while(0)
+/** @brief Evaluates the expression, exits on the runtime error. */
+#define CHECK(e) do { if(!(e)) goto error; } while(0)
+
+int RunProgram(Program * p, bool silent, Counters * c)
+{
+  Machine machine;
+  Machine * M = &machine;
+  memset(c, 0, sizeof(Counters));
+  if(!Init(M, p, silent))
+  {
+    Destroy(M);
+    return 99;
+  }
+
+  Instr * code = p->code;
+  Instr * ip = code;
+  unsigned long long * opcodes = c->opcodes;
+  bool taken;
+
+  #ifdef THREADED_DISPATCH
+    static void * handlers[] = { OPCODES(OPCODE_HANDLER) };
+    DISPATCH();
+  #else
+  dispatch:
+    opcodes[ip->op]++;
+    switch(ip->op)
+    {
+  #endif
+
+  /* frames and calls */
+  CASE(Move): CHECK(ExecMove(M, ip)); NEXT();
+  CASE(CreateFrame): CHECK(ExecCreateFrame(M)); NEXT();
+  CASE(PushFrame): CHECK(ExecPushFrame(M)); NEXT();
+  CASE(PopFrame): CHECK(ExecPopFrame(M)); NEXT();
+  CASE(Defvar): CHECK(ExecDefvar(M, ip)); NEXT();
+  CASE(Call):
+    if(M->calls_count == M->calls_capacity)
+    {
+      size_t capacity = (M->calls_capacity == 0) ? 64 : 2 * M->calls_capacity;
+      size_t * grown = realloc(M->calls, capacity * sizeof(size_t));
+      if(grown == NULL) { Fail(M, 99, "Out of memory!"); goto error; }
+      M->calls = grown;
+      M->calls_capacity = capacity;
+    }
+    M->calls[M->calls_count++] = (size_t)(ip - code) + 1;
+    JUMP(ip->arg[0]);
+  CASE(Return):
+    if(M->calls_count == 0) { Fail(M, 52, "Call stack is empty!"); goto error; }
+    ip = code + M->calls[--M->calls_count];
+    DISPATCH();
+
+  /* data stack */
+  CASE(Pushs): CHECK(ExecPushs(M, ip)); NEXT();
+  CASE(Pops): CHECK(ExecPops(M, ip)); NEXT();
+  CASE(Clears): CHECK(ExecClears(M)); NEXT();
+
+  /* arithmetic */
+  CASE(Add): CASE(Sub): CASE(Mul): CASE(Div): CHECK(ExecArithmetic(M, ip)); NEXT();
+  CASE(Adds): CASE(Subs): CASE(Muls): CASE(Divs): CHECK(ExecArithmetics(M, ip)); NEXT();
+
+  /* relations and logic */
+  CASE(Lt): CASE(Gt): CASE(Eq): CHECK(ExecRelation(M, ip)); NEXT();
+  CASE(Lts): CASE(Gts): CASE(Eqs): CHECK(ExecRelations(M, ip)); NEXT();
+  CASE(And): CASE(Or): CHECK(ExecLogic(M, ip)); NEXT();
+  CASE(Not): CHECK(ExecNot(M, ip)); NEXT();
+  CASE(Ands): CASE(Ors): CHECK(ExecLogics(M, ip)); NEXT();
+  CASE(Nots): CHECK(ExecNots(M)); NEXT();
+
+  /* conversions */
+  CASE(Int2Float): CASE(Float2Int): CASE(Float2R2EInt): CASE(Float2R2OInt): CASE(Int2Char):
+    CHECK(ExecConvert(M, ip));
+    NEXT();
+  CASE(Int2Floats): CASE(Float2Ints): CASE(Float2R2EInts): CASE(Float2R2OInts): CASE(Int2Chars):
+    CHECK(ExecConverts(M, ip));
+    NEXT();
+  CASE(Stri2Int): CHECK(ExecStri2Int(M, ip)); NEXT();
+  CASE(Stri2Ints): CHECK(ExecStri2Ints(M)); NEXT();
+
+  /* input and output */
+  CASE(Read): CHECK(ExecRead(M, ip)); NEXT();
+  CASE(Write): CHECK(ExecWrite(M, ip)); NEXT();
+
+  /* strings */
+  CASE(Concat): CHECK(ExecConcat(M, ip)); NEXT();
+  CASE(Strlen): CHECK(ExecStrlen(M, ip)); NEXT();
+  CASE(Getchar): CHECK(ExecGetchar(M, ip)); NEXT();
+  CASE(Setchar): CHECK(ExecSetchar(M, ip)); NEXT();
+  CASE(Type): CHECK(ExecType(M, ip)); NEXT();
+
+  /* control flow */
+  CASE(Label):
+    NEXT();
+  CASE(Jump):
+    JUMP(ip->arg[0]);
+  CASE(JumpIfEq): CASE(JumpIfNeq):
+    CHECK(ExecJumpIf(M, ip, &taken));
+    if(taken) JUMP(ip->arg[0]);
+    NEXT();
+  CASE(JumpIfEqs): CASE(JumpIfNeqs):
+    CHECK(ExecJumpIfs(M, ip, &taken));
+    if(taken) JUMP(ip->arg[0]);
+    NEXT();
+
+  /* debugging */
+  CASE(Break):
+    if(!silent) DebugState(M, ip, c);
+    NEXT();
+  CASE(Dprint): CHECK(ExecDprint(M, ip)); NEXT();
+
+  CASE(End):
+    goto finish;
+
+  #ifndef THREADED_DISPATCH
+    default:
+      goto finish;
+    }
+  #endif
+
+error:
+  // the instruction with an unresolved operand was not executed
+  if(M->unresolved) opcodes[ip->op]--;
+  fflush(stdout);
+  fprintf(stderr, "Error at line: %u\n%s\n", ip->line, M->message);
+
+finish:
+  for(int op = 0; op < Op_End; op++) c->executed += opcodes[op];
+  fflush(stdout);
+  Destroy(M);
+  return M->code;
+}
+
+/*------------------------------ COMPILED CODE ------------------------------------*/
+
+/** @brief Records the instruction of the runtime error. */
+static JitResult Failed(Machine * M, const Instr * ip)
+{
+  M->at = ip;
+  return Jit_Failed;
+}
+
+/** @brief Defines the helper executing the instruction by the expression. */
+#define JIT_HELPER(name, e) \
+  static JitResult Jit##name(void * machine, Instr * ip) \
+  { \
+    Machine * M = machine; \
+    (void)ip; \
+    return (e) ? Jit_Continue : Failed(M, ip); \
+  }
+
+JIT_HELPER(Move, ExecMove(M, ip))
+JIT_HELPER(CreateFrame, ExecCreateFrame(M))
+JIT_HELPER(PushFrame, ExecPushFrame(M))
+JIT_HELPER(PopFrame, ExecPopFrame(M))
+JIT_HELPER(Defvar, ExecDefvar(M, ip))
+JIT_HELPER(Pushs, ExecPushs(M, ip))
+JIT_HELPER(Pops, ExecPops(M, ip))
+JIT_HELPER(Clears, ExecClears(M))
+JIT_HELPER(Arithmetic, ExecArithmetic(M, ip))
+JIT_HELPER(Arithmetics, ExecArithmetics(M, ip))
+JIT_HELPER(Relation, ExecRelation(M, ip))
+JIT_HELPER(Relations, ExecRelations(M, ip))
+JIT_HELPER(Logic, ExecLogic(M, ip))
+JIT_HELPER(Not, ExecNot(M, ip))
+JIT_HELPER(Logics, ExecLogics(M, ip))
+JIT_HELPER(Nots, ExecNots(M))
+JIT_HELPER(Convert, ExecConvert(M, ip))
+JIT_HELPER(Converts, ExecConverts(M, ip))
+JIT_HELPER(Stri2Int, ExecStri2Int(M, ip))
+JIT_HELPER(Stri2Ints, ExecStri2Ints(M))
+JIT_HELPER(Read, ExecRead(M, ip))
+JIT_HELPER(Write, ExecWrite(M, ip))
+JIT_HELPER(Concat, ExecConcat(M, ip))
+JIT_HELPER(Strlen, ExecStrlen(M, ip))
+JIT_HELPER(Getchar, ExecGetchar(M, ip))
+JIT_HELPER(Setchar, ExecSetchar(M, ip))
+JIT_HELPER(Type, ExecType(M, ip))
+JIT_HELPER(Dprint, ExecDprint(M, ip))
+
+/** @brief JUMPIFEQ, JUMPIFNEQ */
+static JitResult JitJumpIf(void * machine, Instr * ip)
+{
+  bool taken;
+  if(!ExecJumpIf(machine, ip, &taken)) return Failed(machine, ip);
+  return taken ? Jit_Taken : Jit_Continue;
+}
+
+/** @brief JUMPIFEQS, JUMPIFNEQS */
+static JitResult JitJumpIfs(void * machine, Instr * ip)
+{
+  bool taken;
+  if(!ExecJumpIfs(machine, ip, &taken)) return Failed(machine, ip);
+  return taken ? Jit_Taken : Jit_Continue;
+}
+
+/** @brief Fails at the instruction refused by the compiled code. */
+static JitResult JitError(void * machine, Instr * ip)
+{
+  Machine * M = machine;
+  if(ip->op == Op_Return) Fail(M, 52, "Call stack is empty!");
+  else if(ip->arg[0].d.label.target == NO_TARGET) Fail(M, 52, "Label does not exist!");
+  else Fail(M, 99, "Call stack is too deep!");
+  return Failed(M, ip);
+}
+
+/** @brief Fills the runtime of the compiled code. */
+static void InitRuntime(JitRuntime * rt)
+{
+  static const struct { Op op; JitHelper helper; } helpers[] = {
+    {Op_Move, JitMove}, {Op_CreateFrame, JitCreateFrame}, {Op_PushFrame, JitPushFrame},
+    {Op_PopFrame, JitPopFrame}, {Op_Defvar, JitDefvar},
+    {Op_Pushs, JitPushs}, {Op_Pops, JitPops}, {Op_Clears, JitClears},
+    {Op_Add, JitArithmetic}, {Op_Sub, JitArithmetic}, {Op_Mul, JitArithmetic}, {Op_Div, JitArithmetic},
+    {Op_Adds, JitArithmetics}, {Op_Subs, JitArithmetics}, {Op_Muls, JitArithmetics}, {Op_Divs, JitArithmetics},
+    {Op_Lt, JitRelation}, {Op_Gt, JitRelation}, {Op_Eq, JitRelation},
+    {Op_Lts, JitRelations}, {Op_Gts, JitRelations}, {Op_Eqs, JitRelations},
+    {Op_And, JitLogic}, {Op_Or, JitLogic}, {Op_Not, JitNot},
+    {Op_Ands, JitLogics}, {Op_Ors, JitLogics}, {Op_Nots, JitNots},
+    {Op_Int2Float, JitConvert}, {Op_Float2Int, JitConvert}, {Op_Float2R2EInt, JitConvert},
+    {Op_Float2R2OInt, JitConvert}, {Op_Int2Char, JitConvert},
+    {Op_Int2Floats, JitConverts}, {Op_Float2Ints, JitConverts}, {Op_Float2R2EInts, JitConverts},
+    {Op_Float2R2OInts, JitConverts}, {Op_Int2Chars, JitConverts},
+    {Op_Stri2Int, JitStri2Int}, {Op_Stri2Ints, JitStri2Ints},
+    {Op_Read, JitRead}, {Op_Write, JitWrite},
+    {Op_Concat, JitConcat}, {Op_Strlen, JitStrlen}, {Op_Getchar, JitGetchar}, {Op_Setchar, JitSetchar},
+    {Op_Type, JitType},
+    {Op_JumpIfEq, JitJumpIf}, {Op_JumpIfNeq, JitJumpIf}, {Op_JumpIfEqs, JitJumpIfs}, {Op_JumpIfNeqs, JitJumpIfs},
+    {Op_Dprint, JitDprint}
+  };
+
+  memset(rt, 0, sizeof(JitRuntime));
+  for(size_t h = 0; h < sizeof(helpers) / sizeof(helpers[0]); h++) rt->helpers[helpers[h].op] = helpers[h].helper;
+  rt->error = JitError;
+  rt->layout = (JitLayout){
+    .local = offsetof(Machine, local),
+    .global = offsetof(Machine, global),
+    .temporary = offsetof(Machine, temporary),
+    .stack = offsetof(Machine, stack),
+    .stack_count = offsetof(Machine, stack_count),
+    .stack_capacity = offsetof(Machine, stack_capacity),
+    .frame_slots = offsetof(Frame, slots),
+    .frame_count = offsetof(Frame, count),
+    .slot_size = sizeof(Slot),
+    .slot_name = offsetof(Slot, name),
+    .slot_value = offsetof(Slot, value)
+  };
+}
+
+int RunCompiled(Program * p, bool silent, Counters * c)
+{
+  // BREAK writes the executed instructions, which the compiled code does not count
+  for(size_t i = 0; i < p->count; i++)
+    if(p->code[i].op == Op_Break && !silent) return RunProgram(p, silent, c);
+
+  JitRuntime rt;
+  InitRuntime(&rt);
+  JitCode * code = JitCompile(p, &rt);
+  if(code == NULL) return RunProgram(p, silent, c);
+
+  Machine machine;
+  Machine * M = &machine;
+  memset(c, 0, sizeof(Counters));
+  c->compiled = JitSize(code);
+  if(!Init(M, p, silent))
+  {
+    Destroy(M);
+    JitFree(code);
+    return 99;
+  }
+
+  if(JitRun(code, M) != Jit_Continue)
+  {
+    fflush(stdout);
+    fprintf(stderr, "Error at line: %u\n%s\n", (M->at != NULL) ? M->at->line : 0, M->message);
+  }
+  fflush(stdout);
+  Destroy(M);
+  JitFree(code);
+  return M->code;
+}
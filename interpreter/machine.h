@@ -0,0 +1,50 @@
+/**
+ * @file machine.h
+ * @interface machine
+ * @date 19th october 2026
+ * @brief IFJcode17 machine interface.
+ *
+ * This interface declares execution of a loaded IFJcode17 program.
+ */
+
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <stdbool.h>
+
+#include "program.h"
+
+/**
+ * @brief   Counters of the execution.
+ */
+typedef struct
+{
+  unsigned long long executed;            /**< Executed instructions. */
+  unsigned long long opcodes[Op_Count];   /**< Executed instructions by opcode. */
+  size_t compiled;                        /**< Bytes of the native code, 0 if interpreted. */
+} Counters;
+
+/**
+ * @brief   Executes the program.
+ *
+ * Runtime errors are written to stderr in the format of ic17int.
+ * @param p       Program, its operands cache slots of the variables.
+ * @param silent  DPRINT and BREAK are ignored.
+ * @param c       Returned counters.
+ * @returns 0 if success, the error code of IFJcode17 otherwise.
+ */
+int RunProgram(Program * p, bool silent, Counters * c);
+
+/**
+ * @brief   Compiles the program to native code and executes it.
+ *
+ * Instructions are not counted. The program is interpreted
+ * (see RunProgram()), if it cannot be compiled (see jit.h).
+ * @param p       Program, its operands cache slots of the variables.
+ * @param silent  DPRINT and BREAK are ignored.
+ * @param c       Returned counters.
+ * @returns 0 if success, the error code of IFJcode17 otherwise.
+ */
+int RunCompiled(Program * p, bool silent, Counters * c);
+
+#endif // MACHINE_H
@@ -0,0 +1,216 @@
+/**
+ * @file main.c
+ * @date 19th october 2026
+ * @brief Main module of the interpreter.
+ *
+ * This module contains the function main() of the IFJcode17 interpreter.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "machine.h"
+#include "program.h"
+
+/*------------------------------------------------------*/
+/** @addtogroup main
+ * Main() function and tools.
+ * @{
+ */
+
+/**
+ * @brief 	Options of the interpreter.
+ */
+typedef struct
+{
+	const char * file;		/**< Interpreted file. */
+	bool help;						/**< Prints help. */
+	bool silent;					/**< Ignores DPRINT and BREAK. */
+	bool stats;						/**< Prints counters and time. */
+	bool disassemble;			/**< Prints the program as text instead of running it. */
+	bool jit;							/**< Compiles the program to native code. */
+} Options;
+
+/**
+ * @brief 	Prints help.
+ *
+ * This function prints help to standard output.
+ */
+void printHelp();
+
+/**
+ * @brief 	Processes the arguments.
+ *
+ * @param argc 		Number of arguments.
+ * @param argv 		Argument pointer.
+ * @param o 			Returned options.
+ * @returns 			True, if success, false otherwise.
+ */
+bool processArguments(int argc, char *argv[], Options * o);
+
+/**
+ * @brief 	Prints counters of the execution and times to stderr.
+ *
+ * @param c 			Counters.
+ * @param load 		Time of loading in seconds.
+ * @param run 		Time of execution in seconds.
+ */
+void printStats(const Counters * c, double load, double run);
+
+/** @brief Monotonic time in seconds. */
+static double now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*-----------------------------------------------------*/
+
+/**
+ * @brief 	Main function.
+ *
+ * @param argc 		Number of arguments (from shell).
+ * @param argv 		Argument pointer.
+ * @returns 			Return code of the interpreted program.
+ */
+int main(int argc, char *argv[])
+{
+	Options o;
+	if(!processArguments(argc, argv, &o)) return 99;
+	if(o.help) { printHelp(); return 0; }
+
+	FILE * f = fopen(o.file, "r");
+	if(f == NULL)
+	{
+		fprintf(stderr, "Cannot open file %s!\n", o.file);
+		return 99;
+	}
+
+	Program p;
+	double start = now();
+	int code = LoadProgram(f, &p);
+	fclose(f);
+	if(code != 0) return code;
+	double loaded = now();
+
+	if(o.disassemble)
+	{
+		PrintProgram(&p, stdout);
+		if(o.stats) fprintf(stderr, "Load time: %.3f ms\n", (loaded - start) * 1000);
+		FreeProgram(&p);
+		return 0;
+	}
+
+	Counters c;
+	static char buffer[1 << 16];
+	setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+	code = o.jit ? RunCompiled(&p, o.silent, &c) : RunProgram(&p, o.silent, &c);
+	double finished = now();
+
+	if(o.stats) printStats(&c, loaded - start, finished - loaded);
+	FreeProgram(&p);
+	return code;
+}
+
+/** @}*/
+/*-----------------------------------------------------*/
+
+bool processArguments(int argc, char *argv[], Options * o)
+{
+	memset(o, 0, sizeof(Options));
+	for(int i = 1; i < argc; i++)
+	{
+		// help
+		if( !strcmp(argv[i], "-h") || !strcmp(argv[i], "--help") )
+		{
+			o->help = true;
+			return true;
+		}
+
+		// silent
+		else if( !strcmp(argv[i], "-s") || !strcmp(argv[i], "--silent") )
+			o->silent = true;
+
+		// statistics
+		else if( !strcmp(argv[i], "--stats") )
+			o->stats = true;
+
+		// disassembler
+		else if( !strcmp(argv[i], "-d") || !strcmp(argv[i], "--disassemble") )
+			o->disassemble = true;
+
+		// native code
+		else if( !strcmp(argv[i], "-j") || !strcmp(argv[i], "--jit") )
+			o->jit = true;
+
+		// file
+		else if( argv[i][0] != '-' && o->file == NULL )
+			o->file = argv[i];
+
+		// unknown
+		else
+		{
+			fprintf(stderr, "Unknown parameter %s!\n", argv[i]);
+			return false;
+		}
+	}
+	if(o->file == NULL)
+	{
+		fprintf(stderr, "Missing file!\n");
+		return false;
+	}
+	return true;
+}
+
+/** @brief Counters, by which the opcodes are sorted. */
+static const Counters * sorted;
+
+/** @brief Orders opcodes by descending number of executions. */
+static int compareOpcodes(const void * a, const void * b)
+{
+	unsigned long long x = sorted->opcodes[*(const Op *)a], y = sorted->opcodes[*(const Op *)b];
+	if(x != y) return (x < y) - (x > y);
+	return (int)*(const Op *)a - (int)*(const Op *)b;
+}
+
+void printStats(const Counters * c, double load, double run)
+{
+	Op order[Op_End];
+	for(int op = 0; op < Op_End; op++) order[op] = op;
+	sorted = c;
+	qsort(order, Op_End, sizeof(Op), compareOpcodes);
+
+	if(c->compiled > 0)
+	{
+		// the native code does not count instructions
+		fprintf(stderr, "Native code: %zu bytes\n", c->compiled);
+		fprintf(stderr, "Load time: %.3f ms\n", load * 1000);
+		fprintf(stderr, "Run time: %.3f ms\n", run * 1000);
+		return;
+	}
+	fprintf(stderr, "Executed instructions: %llu\n", c->executed);
+	fprintf(stderr, "Load time: %.3f ms\n", load * 1000);
+	fprintf(stderr, "Run time: %.3f ms\n", run * 1000);
+	if(run > 0) fprintf(stderr, "Instructions per second: %.0f\n", c->executed / run);
+	fprintf(stderr, "Executed instructions by opcode:\n");
+	for(int i = 0; i < Op_End && c->opcodes[order[i]] > 0; i++)
+		fprintf(stderr, "  %-14s %llu\n", OpName(order[i]), c->opcodes[order[i]]);
+}
+
+void printHelp()
+{
+	printf("IFJcode17 interpreter.\n"
+				 "2017/2018\n\n"
+				 "Usage: ifjint [options] file\n"
+				 "-h, --help\tPrints this help.\n"
+				 "-s, --silent\tIgnores DPRINT and BREAK instructions.\n"
+				 "-d, --disassemble\tPrints the program (text or binary) as IFJcode17 text.\n"
+				 "-j, --jit\tCompiles the program to x86-64 code and runs it natively,\n"
+				 "\t\tinterprets it if the host or the program is not supported.\n"
+				 "--stats\tPrints executed instructions and times to stderr.\n"
+	);
+}
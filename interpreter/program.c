@@ -0,0 +1,787 @@
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "program.h"
+
+#define OPCODE_NAME(id, name, operands) name,
+#define OPCODE_OPERANDS(id, name, operands) operands,
+
+/*----------- DATA ------------*/
+/** @brief Names of the opcodes. */
+static const char * opNames[] = { OPCODES(OPCODE_NAME) };
+/** @brief Operands of the opcodes. */
+static const char * opOperands[] = { OPCODES(OPCODE_OPERANDS) };
+
+/**
+ * @brief   Table of interned names.
+ */
+typedef struct
+{
+  char ** names;          /**< Names by their ids. */
+  size_t count, capacity;
+  unsigned * index;       /**< Open addressing, ids + 1 (0 is empty). */
+  size_t index_capacity;
+} Names;
+
+/**
+ * @brief   State of the loader.
+ */
+typedef struct
+{
+  Program * p;
+  size_t capacity;        /**< Allocated instructions. */
+  Names vars;             /**< Names of the variables. */
+  Names labels;           /**< Names of the labels. */
+  size_t * positions;     /**< Instruction of the label by its id. */
+  size_t positions_capacity;
+  unsigned line;          /**< Current line. */
+} Loader;
+
+const char * OpName(Op op)
+{
+  return (op < Op_Count) ? opNames[op] : "";
+}
+
+/*------------------------------ STRINGS ------------------------------------*/
+
+String * StringNew(const char * data, size_t length)
+{
+  String * s = malloc(sizeof(String) + length + 1);
+  if(s == NULL) return NULL;
+  s->refs = 1;
+  s->length = length;
+  if(data != NULL && length > 0) memcpy(s->data, data, length);
+  s->data[length] = '\0';
+  return s;
+}
+
+/*------------------------------ NAMES ------------------------------------*/
+
+/** @brief FNV-1a hash of the name. */
+static size_t Hash(const char * name)
+{
+  uint32_t h = 2166136261u;
+  for(; *name != '\0'; name++) h = (h ^ (unsigned char)*name) * 16777619u;
+  return h;
+}
+
+/** @brief Rebuilds the index of the table twice as big. */
+static bool Rehash(Names * t)
+{
+  size_t capacity = (t->index_capacity == 0) ? 64 : 2 * t->index_capacity;
+  unsigned * index = calloc(capacity, sizeof(unsigned));
+  if(index == NULL) return false;
+  for(size_t id = 0; id < t->count; id++)
+  {
+    size_t h = Hash(t->names[id]) & (capacity - 1);
+    while(index[h] != 0) h = (h + 1) & (capacity - 1);
+    index[h] = id + 1;
+  }
+  free(t->index);
+  t->index = index;
+  t->index_capacity = capacity;
+  return true;
+}
+
+/**
+ * @brief   Interns the name.
+ *
+ * @param t       Table.
+ * @param name    Name.
+ * @param id      Returned id.
+ * @param added   Set, if the name was not in the table.
+ * @returns True, if success. False otherwise.
+ */
+static bool Intern(Names * t, const char * name, unsigned * id, bool * added)
+{
+  if(2 * (t->count + 1) > t->index_capacity && !Rehash(t)) return false;
+
+  size_t h = Hash(name) & (t->index_capacity - 1);
+  for(; t->index[h] != 0; h = (h + 1) & (t->index_capacity - 1))
+  {
+    if(strcmp(t->names[t->index[h] - 1], name) == 0)
+    {
+      *id = t->index[h] - 1;
+      if(added != NULL) *added = false;
+      return true;
+    }
+  }
+
+  if(t->count == t->capacity)
+  {
+    size_t capacity = (t->capacity == 0) ? 64 : 2 * t->capacity;
+    char ** grown = realloc(t->names, capacity * sizeof(char *));
+    if(grown == NULL) return false;
+    t->names = grown;
+    t->capacity = capacity;
+  }
+  char * copy = malloc(strlen(name) + 1);
+  if(copy == NULL) return false;
+  strcpy(copy, name);
+
+  t->names[t->count] = copy;
+  t->index[h] = t->count + 1;
+  *id = t->count++;
+  if(added != NULL) *added = true;
+  return true;
+}
+
+/** @brief Frees the table, the names are kept if asked. */
+static void FreeNames(Names * t, bool keep)
+{
+  if(!keep)
+  {
+    for(size_t i = 0; i < t->count; i++) free(t->names[i]);
+    free(t->names);
+  }
+  free(t->index);
+}
+
+/*------------------------------ OPERANDS ------------------------------------*/
+
+/** @brief Reports an error of the source. */
+static int LoadError(Loader * L, int code, const char * msg)
+{
+  fprintf(stderr, "Error at line: %u\n%s\n", L->line, msg);
+  return code;
+}
+
+/**
+ * @brief   Decodes escape sequences of the string constant.
+ *
+ * @param text    Constant after the @.
+ * @param v       Returned value.
+ * @param memory  Set, if allocation failed.
+ * @returns True, if the constant is valid. False otherwise.
+ */
+static bool DecodeString(const char * text, Value * v, bool * memory)
+{
+  size_t length = strlen(text), out = 0;
+  char * buff = malloc(length + 1);
+  if(buff == NULL)
+  {
+    *memory = true;
+    return false;
+  }
+  for(size_t i = 0; i < length; i++)
+  {
+    if(text[i] != '\\')
+    {
+      buff[out++] = text[i];
+      continue;
+    }
+    if(i + 3 >= length || !isdigit((unsigned char)text[i+1])
+       || !isdigit((unsigned char)text[i+2]) || !isdigit((unsigned char)text[i+3]))
+    {
+      free(buff);
+      return false;
+    }
+    int code = (text[i+1] - '0') * 100 + (text[i+2] - '0') * 10 + (text[i+3] - '0');
+    if(code > 255)
+    {
+      free(buff);
+      return false;
+    }
+    buff[out++] = (char)code;
+    i += 3;
+  }
+  v->type = Type_String;
+  v->d.s = StringNew(buff, out);
+  free(buff);
+  if(v->d.s == NULL) *memory = true;
+  return v->d.s != NULL;
+}
+
+/**
+ * @brief   Decodes the constant.
+ *
+ * @param type    Type before the @.
+ * @param text    Value after the @.
+ * @param v       Returned value.
+ * @param memory  Set, if allocation failed.
+ * @returns True, if the constant is valid. False otherwise.
+ */
+static bool DecodeConstant(const char * type, const char * text, Value * v, bool * memory)
+{
+  char * end;
+  if(strcasecmp(type, "int") == 0)
+  {
+    long i = strtol(text, &end, 10);
+    if(*text == '\0' || *end != '\0') return false;
+    *v = (Value){.type = Type_Int, .d.i = (int)i};
+  }
+  else if(strcasecmp(type, "float") == 0)
+  {
+    // infinities and NaNs are not constants
+    double f = strtod(text, &end);
+    if(*text == '\0' || *end != '\0' || strpbrk(text, "iInN") != NULL) return false;
+    *v = (Value){.type = Type_Float, .d.f = f};
+  }
+  else if(strcasecmp(type, "bool") == 0)
+  {
+    if(strcasecmp(text, "true") == 0) *v = (Value){.type = Type_Bool, .d.b = true};
+    else if(strcasecmp(text, "false") == 0) *v = (Value){.type = Type_Bool, .d.b = false};
+    else return false;
+  }
+  else if(strcasecmp(type, "string") == 0) return DecodeString(text, v, memory);
+  else return false;
+  return true;
+}
+
+/**
+ * @brief   Decodes the operand.
+ *
+ * @param kind    Expected kind (v variable, s symbol, l label, t type).
+ * @param token   Operand in the source.
+ * @param a       Returned operand.
+ * @returns 0 if success, 51 (syntax) or 99 (internal) otherwise.
+ */
+static int DecodeOperand(Loader * L, char kind, char * token, Arg * a)
+{
+  if(kind == 'l')
+  {
+    unsigned id;
+    if(strchr(token, '@') != NULL) return LoadError(L, 51, "Invalid label!");
+    if(!Intern(&L->labels, token, &id, NULL)) return 99;
+    *a = (Arg){.kind = Arg_Label, .d.label = {id, id}};
+    return 0;
+  }
+  if(kind == 't')
+  {
+    ValueType type;
+    if(strcasecmp(token, "int") == 0) type = Type_Int;
+    else if(strcasecmp(token, "float") == 0) type = Type_Float;
+    else if(strcasecmp(token, "bool") == 0) type = Type_Bool;
+    else if(strcasecmp(token, "string") == 0) type = Type_String;
+    else return LoadError(L, 51, "Invalid type!");
+    *a = (Arg){.kind = Arg_Type, .d.type = type};
+    return 0;
+  }
+
+  char * at = strchr(token, '@');
+  if(at == NULL) return LoadError(L, 51, "Invalid operand!");
+  *at = '\0';
+  char * text = at + 1;
+
+  ArgKind frame = Arg_None;
+  if(strcasecmp(token, "GF") == 0) frame = Arg_Global;
+  else if(strcasecmp(token, "LF") == 0) frame = Arg_Local;
+  else if(strcasecmp(token, "TF") == 0) frame = Arg_Temporary;
+
+  if(frame != Arg_None)
+  {
+    unsigned id;
+    if(*text == '\0') return LoadError(L, 51, "Invalid variable!");
+    if(!Intern(&L->vars, text, &id, NULL)) return 99;
+    *a = (Arg){.kind = frame, .d.var = {id, 0}};
+    return 0;
+  }
+  if(kind == 'v') return LoadError(L, 51, "Invalid variable!");
+
+  bool memory = false;
+  a->kind = Arg_Constant;
+  if(!DecodeConstant(token, text, &a->d.constant, &memory))
+    return memory ? 99 : LoadError(L, 51, "Invalid constant!");
+  return 0;
+}
+
+/*------------------------------ INSTRUCTIONS ------------------------------------*/
+
+/** @brief Appends the instruction to the program. */
+static Instr * Append(Loader * L)
+{
+  Program * p = L->p;
+  if(p->count == L->capacity)
+  {
+    size_t capacity = (L->capacity == 0) ? 256 : 2 * L->capacity;
+    Instr * grown = realloc(p->code, capacity * sizeof(Instr));
+    if(grown == NULL) return NULL;
+    p->code = grown;
+    L->capacity = capacity;
+  }
+  Instr * ins = &p->code[p->count++];
+  memset(ins, 0, sizeof(Instr));
+  ins->line = L->line;
+  return ins;
+}
+
+/** @brief Records the position of the defined label. */
+static int DefineLabel(Loader * L, unsigned id, size_t position)
+{
+  if(id >= L->positions_capacity)
+  {
+    size_t capacity = (L->positions_capacity == 0) ? 64 : L->positions_capacity;
+    while(capacity <= id) capacity *= 2;
+    size_t * grown = realloc(L->positions, capacity * sizeof(size_t));
+    if(grown == NULL) return 99;
+    for(size_t i = L->positions_capacity; i < capacity; i++) grown[i] = NO_TARGET;
+    L->positions = grown;
+    L->positions_capacity = capacity;
+  }
+  if(L->positions[id] != NO_TARGET)
+  {
+    fprintf(stderr, "Label already exists!\n");
+    return 52;
+  }
+  L->positions[id] = position;
+  return 0;
+}
+
+/**
+ * @brief   Decodes the line of the source.
+ *
+ * @param line    Line without comment.
+ * @returns 0 if success, 51, 52 or 99 otherwise.
+ */
+static int DecodeLine(Loader * L, char * line)
+{
+  static const char * blanks = " \t\r\v\f";
+  char * tokens[5];
+  size_t count = 0;
+  for(char * t = strtok(line, blanks); t != NULL; t = strtok(NULL, blanks))
+  {
+    if(count == 5) return LoadError(L, 51, "Too many operands!");
+    tokens[count++] = t;
+  }
+  if(count == 0) return 0;
+
+  Op op = Op_End;
+  for(Op o = 0; o < Op_End; o++)
+    if(strcasecmp(tokens[0], opNames[o]) == 0) op = o;
+  if(op == Op_End) return LoadError(L, 51, "Unknown instruction!");
+  if(strlen(opOperands[op]) != count - 1) return LoadError(L, 51, "Wrong number of operands!");
+
+  Instr * ins = Append(L);
+  if(ins == NULL) return 99;
+  ins->op = op;
+  for(size_t i = 1; i < count; i++)
+  {
+    int code = DecodeOperand(L, opOperands[op][i-1], tokens[i], &ins->arg[i-1]);
+    if(code != 0) return code;
+  }
+  if(op == Op_Label) return DefineLabel(L, ins->arg[0].d.label.name, L->p->count - 1);
+  return 0;
+}
+
+/** @brief Reads the whole file, terminated by zero. */
+static char * ReadAll(FILE * f, size_t * read)
+{
+  size_t length = 0, capacity = 4096;
+  char * data = malloc(capacity);
+  while(data != NULL)
+  {
+    length += fread(data + length, 1, capacity - length - 1, f);
+    if(length + 1 < capacity) break;
+    capacity *= 2;
+    char * grown = realloc(data, capacity);
+    if(grown == NULL) free(data);
+    data = grown;
+  }
+  if(data != NULL) data[length] = '\0';
+  *read = length;
+  return data;
+}
+
+/*------------------------------ TEXT ------------------------------------*/
+
+/**
+ * @brief   Loads the program from IFJcode17 text.
+ *
+ * @param source  Text, it is modified.
+ * @returns 0 if success, 51, 52 or 99 otherwise.
+ */
+static int LoadText(Loader * L, char * source)
+{
+  Program * p = L->p;
+  int code = 0;
+  bool header = false;
+  for(char * line = source; code == 0 && line != NULL; )
+  {
+    char * next = strchr(line, '\n');
+    if(next != NULL) *next++ = '\0';
+    L->line++;
+
+    char * comment = strchr(line, '#');
+    if(comment != NULL) *comment = '\0';
+    if(header) code = DecodeLine(L, line);
+    else
+    {
+      char * t = strtok(line, " \t\r\v\f");
+      if(t != NULL)
+      {
+        if(strcasecmp(t, ".IFJcode17") != 0 || strtok(NULL, " \t\r\v\f") != NULL)
+          code = LoadError(L, 51, "Missing header!");
+        header = true;
+      }
+    }
+    line = next;
+  }
+  if(code == 0 && !header) code = LoadError(L, 51, "Missing header!");
+
+  // terminating instruction and targets of the jumps
+  Instr * end = (code == 0) ? Append(L) : NULL;
+  if(code == 0 && end == NULL) code = 99;
+  if(end != NULL) end->op = Op_End;
+  for(size_t i = 0; code == 0 && i < p->count; i++)
+  {
+    for(unsigned a = 0; a < 3; a++)
+    {
+      Arg * arg = &p->code[i].arg[a];
+      if(arg->kind != Arg_Label) continue;
+      size_t id = arg->d.label.name;
+      arg->d.label.target = (id < L->positions_capacity) ? L->positions[id] : NO_TARGET;
+    }
+  }
+
+  p->names = L->vars.names;
+  p->names_count = L->vars.count;
+  p->labels = L->labels.names;
+  p->labels_count = L->labels.count;
+  FreeNames(&L->vars, true);
+  FreeNames(&L->labels, true);
+  free(L->positions);
+  return code;
+}
+
+/*------------------------------ BINARY ------------------------------------*/
+
+/**
+ * @brief   Reader of the binary code.
+ */
+typedef struct
+{
+  const unsigned char * data;
+  size_t length, position;
+  bool ok;                  /**< Data were not shorter than read. */
+} Reader;
+
+/** @brief Reads the byte. */
+static unsigned GetU8(Reader * R)
+{
+  if(R->position >= R->length)
+  {
+    R->ok = false;
+    return 0;
+  }
+  return R->data[R->position++];
+}
+
+/** @brief Reads the 32-bit number, 7 bits per byte (the highest bit continues). */
+static uint32_t GetU32(Reader * R)
+{
+  uint32_t value = 0;
+  for(unsigned shift = 0; shift < 35; shift += 7)
+  {
+    unsigned byte = GetU8(R);
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if((byte & 0x80) == 0) return value;
+  }
+  R->ok = false;
+  return 0;
+}
+
+/** @brief Reads the 64-bit number. */
+static uint64_t GetU64(Reader * R)
+{
+  uint64_t value = 0;
+  for(unsigned i = 0; i < 8; i++) value |= (uint64_t)GetU8(R) << (8 * i);
+  return value;
+}
+
+/** @brief Reads the length, returns the bytes in the data. */
+static const char * GetBytes(Reader * R, size_t * length)
+{
+  *length = GetU32(R);
+  if(!R->ok || *length > R->length - R->position)
+  {
+    R->ok = false;
+    return NULL;
+  }
+  const char * bytes = (const char *)R->data + R->position;
+  R->position += *length;
+  return bytes;
+}
+
+/** @brief Reads the name into a new string. */
+static char * GetName(Reader * R, bool * memory)
+{
+  size_t length;
+  const char * bytes = GetBytes(R, &length);
+  if(bytes == NULL) return NULL;
+  char * name = malloc(length + 1);
+  if(name == NULL)
+  {
+    *memory = true;
+    return NULL;
+  }
+  memcpy(name, bytes, length);
+  name[length] = '\0';
+  return name;
+}
+
+/** @brief Reads the constant of the pool. */
+static bool GetConstant(Reader * R, Value * v, bool * memory)
+{
+  switch(GetU8(R))
+  {
+    case Type_Int:
+      *v = (Value){.type = Type_Int, .d.i = (int)GetU32(R)};
+      return R->ok;
+    case Type_Float:
+    {
+      uint64_t bits = GetU64(R);
+      *v = (Value){.type = Type_Float};
+      memcpy(&v->d.f, &bits, sizeof(double));
+      return R->ok;
+    }
+    case Type_String:
+    {
+      size_t length;
+      const char * bytes = GetBytes(R, &length);
+      String * s = (bytes != NULL) ? StringNew(bytes, length) : NULL;
+      if(s == NULL)
+      {
+        *memory = (bytes != NULL);
+        return false;
+      }
+      *v = (Value){.type = Type_String, .d.s = s};
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief   Reads the operand.
+ *
+ * @param kind    Expected kind (v variable, s symbol, l label, t type).
+ * @param pool    Constants.
+ * @param constants Number of constants.
+ * @param targets Instruction of each label.
+ * @param a       Returned operand.
+ * @returns True, if valid. False otherwise.
+ */
+static bool GetOperand(Reader * R, Program * p, char kind, const Value * pool, size_t constants,
+                       const size_t * targets, Arg * a)
+{
+  if(kind == 'l')
+  {
+    uint32_t label = GetU32(R);
+    if(label >= p->labels_count) return false;
+    *a = (Arg){.kind = Arg_Label, .d.label = {targets[label], label}};
+    return R->ok;
+  }
+  if(kind == 't')
+  {
+    unsigned type = GetU8(R);
+    if(type < Type_Int || type > Type_String) return false;
+    *a = (Arg){.kind = Arg_Type, .d.type = (ValueType)type};
+    return R->ok;
+  }
+
+  unsigned operand = GetU8(R);
+  if(operand <= 2)
+  {
+    static const ArgKind frames[] = {Arg_Global, Arg_Local, Arg_Temporary};
+    uint32_t name = GetU32(R);
+    if(name >= p->names_count) return false;
+    *a = (Arg){.kind = frames[operand], .d.var = {name, 0}};
+    return R->ok;
+  }
+  if(kind == 'v') return false;
+  if(operand == 3)
+  {
+    uint32_t index = GetU32(R);
+    if(!R->ok || index >= constants) return false;
+    *a = (Arg){.kind = Arg_Constant, .d.constant = pool[index]};
+    ValueRetain(&a->d.constant);
+    return true;
+  }
+  if(operand == 4 || operand == 5)
+  {
+    *a = (Arg){.kind = Arg_Constant, .d.constant = {.type = Type_Bool, .d.b = (operand == 5)}};
+    return R->ok;
+  }
+  return false;
+}
+
+/**
+ * @brief   Reads the constants, the names and the labels of the binary code.
+ *
+ * @param pool      Returned constants.
+ * @param constants Number of constants.
+ * @param targets   Returned instruction of each label.
+ * @returns 0 if success, 51 or 99 otherwise.
+ */
+static int GetTables(Reader * R, Program * p, Value * pool, size_t constants, size_t * targets)
+{
+  bool memory = false;
+  for(size_t c = 0; c < constants; c++)
+    if(!GetConstant(R, &pool[c], &memory)) return memory ? 99 : 51;
+  for(size_t n = 0; n < p->names_count; n++)
+    if((p->names[n] = GetName(R, &memory)) == NULL) return memory ? 99 : 51;
+  for(size_t l = 0; l < p->labels_count; l++)
+  {
+    targets[l] = GetU32(R);
+    if((p->labels[l] = GetName(R, &memory)) == NULL) return memory ? 99 : 51;
+  }
+  return 0;
+}
+
+/**
+ * @brief   Loads the program from the binary code.
+ *
+ * @param data    Binary code.
+ * @param length  Number of bytes.
+ * @returns 0 if success, 51 or 99 otherwise.
+ */
+static int LoadBinary(Program * p, const unsigned char * data, size_t length)
+{
+  Reader R = {data, length, 4, true};
+  unsigned version = GetU8(&R) | GetU8(&R) << 8;
+  GetU8(&R);
+  GetU8(&R);
+  if(version != BINARY_VERSION)
+  {
+    fprintf(stderr, "Unsupported version %u of binary code!\n", version);
+    return 51;
+  }
+  uint32_t constants = GetU32(&R);
+  uint32_t names = GetU32(&R);
+  uint32_t labels = GetU32(&R);
+  uint32_t instructions = GetU32(&R);
+  // every entry takes a byte at least
+  if(!R.ok || (uint64_t)constants + names + labels + instructions > length)
+  {
+    fprintf(stderr, "Invalid binary code!\n");
+    return 51;
+  }
+
+  Value * pool = calloc(constants + 1, sizeof(Value));
+  size_t * targets = calloc(labels + 1, sizeof(size_t));
+  p->names = calloc(names + 1, sizeof(char *));
+  p->labels = calloc(labels + 1, sizeof(char *));
+  p->code = calloc(instructions + 1, sizeof(Instr));
+  int code = (pool == NULL || targets == NULL || p->names == NULL || p->labels == NULL || p->code == NULL) ? 99 : 0;
+  p->names_count = (p->names != NULL) ? names : 0;
+  p->labels_count = (p->labels != NULL) ? labels : 0;
+  if(code == 0) code = GetTables(&R, p, pool, constants, targets);
+
+  for(size_t l = 0; code == 0 && l < labels; l++)
+    if(targets[l] >= instructions) targets[l] = NO_TARGET;
+  for(size_t i = 0; code == 0 && i < instructions; i++)
+  {
+    Instr * ins = &p->code[p->count++];
+    unsigned op = GetU8(&R);
+    ins->line = (unsigned)i + 2;
+    if(!R.ok || op >= Op_End) code = 51;
+    else ins->op = (Op)op;
+    for(const char * kind = opOperands[ins->op], * a = kind; code == 0 && *a != '\0'; a++)
+      if(!GetOperand(&R, p, *a, pool, constants, targets, &ins->arg[a - kind])) code = 51;
+  }
+  if(code == 0) p->code[p->count++].op = Op_End;
+  if(code == 51) fprintf(stderr, "Invalid binary code!\n");
+
+  // operands hold their own references
+  for(size_t c = 0; pool != NULL && c < constants; c++) ValueRelease(&pool[c]);
+  free(pool);
+  free(targets);
+  return code;
+}
+
+/*------------------------------ TEXT OUTPUT ------------------------------------*/
+
+/** @brief Writes the operand in IFJcode17. */
+static void PrintArg(const Program * p, const Arg * a, FILE * f)
+{
+  static const char * types[] = {"", "int", "float", "bool", "string"};
+  switch(a->kind)
+  {
+    case Arg_Global: case Arg_Local: case Arg_Temporary:
+      fprintf(f, "%s@%s", (a->kind == Arg_Global) ? "GF" : (a->kind == Arg_Local) ? "LF" : "TF", p->names[a->d.var.name]);
+      return;
+    case Arg_Label:
+      fputs(p->labels[a->d.label.name], f);
+      return;
+    case Arg_Type:
+      fputs(types[a->d.type], f);
+      return;
+    case Arg_Constant:
+      break;
+    default:
+      return;
+  }
+
+  const Value * v = &a->d.constant;
+  switch(v->type)
+  {
+    case Type_Int: fprintf(f, "int@%d", v->d.i); break;
+    case Type_Float: fprintf(f, "float@%a", v->d.f); break;
+    case Type_Bool: fprintf(f, "bool@%s", v->d.b ? "true" : "false"); break;
+    default:
+      fputs("string@", f);
+      for(size_t i = 0; i < v->d.s->length; i++)
+      {
+        unsigned char c = (unsigned char)v->d.s->data[i];
+        if(c <= 32 || c == '#' || c == '\\') fprintf(f, "\\%03u", c);
+        else fputc(c, f);
+      }
+      break;
+  }
+}
+
+void PrintProgram(const Program * p, FILE * f)
+{
+  fputs(".IFJcode17\n", f);
+  for(size_t i = 0; i < p->count && p->code[i].op != Op_End; i++)
+  {
+    const Instr * ins = &p->code[i];
+    fputs(opNames[ins->op], f);
+    for(size_t a = 0; a < strlen(opOperands[ins->op]); a++)
+    {
+      fputc(' ', f);
+      PrintArg(p, &ins->arg[a], f);
+    }
+    fputc('\n', f);
+  }
+}
+
+/*------------------------------ MAIN ------------------------------------*/
+
+int LoadProgram(FILE * f, Program * p)
+{
+  memset(p, 0, sizeof(Program));
+  size_t length;
+  char * source = ReadAll(f, &length);
+  if(source == NULL) return 99;
+
+  int code;
+  if(length >= 4 && memcmp(source, BINARY_MAGIC, 4) == 0) code = LoadBinary(p, (unsigned char *)source, length);
+  else
+  {
+    Loader L = {.p = p};
+    code = LoadText(&L, source);
+  }
+  free(source);
+  if(code != 0) FreeProgram(p);
+  return code;
+}
+
+void FreeProgram(Program * p)
+{
+  for(size_t i = 0; i < p->count; i++)
+    for(unsigned a = 0; a < 3; a++)
+      if(p->code[i].arg[a].kind == Arg_Constant) ValueRelease(&p->code[i].arg[a].d.constant);
+  for(size_t i = 0; i < p->names_count; i++) free(p->names[i]);
+  free(p->names);
+  for(size_t i = 0; i < p->labels_count; i++) free(p->labels[i]);
+  free(p->labels);
+  free(p->code);
+  memset(p, 0, sizeof(Program));
+}
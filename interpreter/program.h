@@ -0,0 +1,232 @@
+/**
+ * @file program.h
+ * @interface program
+ * @date 19th october 2026
+ * @brief IFJcode17 program interface.
+ *
+ * This interface declares the loaded form of an IFJcode17 program:
+ * an array of decoded instructions with resolved jump targets,
+ * constant values and interned names of variables.
+ */
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*-----------------------------------------------------------*/
+/** @addtogroup Program_types
+ * Types of the loaded program.
+ * @{
+ */
+
+/**
+ * @brief   Instructions.
+ *
+ * Identifier, name and operands (v variable, s symbol, l label, t type).
+ */
+#define OPCODES(X) \
+  X(Move, "MOVE", "vs") X(CreateFrame, "CREATEFRAME", "") X(PushFrame, "PUSHFRAME", "") \
+  X(PopFrame, "POPFRAME", "") X(Defvar, "DEFVAR", "v") X(Call, "CALL", "l") X(Return, "RETURN", "") \
+  X(Pushs, "PUSHS", "s") X(Pops, "POPS", "v") X(Clears, "CLEARS", "") \
+  X(Add, "ADD", "vss") X(Sub, "SUB", "vss") X(Mul, "MUL", "vss") X(Div, "DIV", "vss") \
+  X(Adds, "ADDS", "") X(Subs, "SUBS", "") X(Muls, "MULS", "") X(Divs, "DIVS", "") \
+  X(Lt, "LT", "vss") X(Gt, "GT", "vss") X(Eq, "EQ", "vss") X(Lts, "LTS", "") X(Gts, "GTS", "") X(Eqs, "EQS", "") \
+  X(And, "AND", "vss") X(Or, "OR", "vss") X(Not, "NOT", "vs") X(Ands, "ANDS", "") X(Ors, "ORS", "") X(Nots, "NOTS", "") \
+  X(Int2Float, "INT2FLOAT", "vs") X(Float2Int, "FLOAT2INT", "vs") X(Float2R2EInt, "FLOAT2R2EINT", "vs") \
+  X(Float2R2OInt, "FLOAT2R2OINT", "vs") X(Int2Char, "INT2CHAR", "vs") X(Stri2Int, "STRI2INT", "vss") \
+  X(Int2Floats, "INT2FLOATS", "") X(Float2Ints, "FLOAT2INTS", "") X(Float2R2EInts, "FLOAT2R2EINTS", "") \
+  X(Float2R2OInts, "FLOAT2R2OINTS", "") X(Int2Chars, "INT2CHARS", "") X(Stri2Ints, "STRI2INTS", "") \
+  X(Read, "READ", "vt") X(Write, "WRITE", "s") \
+  X(Concat, "CONCAT", "vss") X(Strlen, "STRLEN", "vs") X(Getchar, "GETCHAR", "vss") X(Setchar, "SETCHAR", "vss") \
+  X(Type, "TYPE", "vs") \
+  X(Label, "LABEL", "l") X(Jump, "JUMP", "l") X(JumpIfEq, "JUMPIFEQ", "lss") X(JumpIfNeq, "JUMPIFNEQ", "lss") \
+  X(JumpIfEqs, "JUMPIFEQS", "l") X(JumpIfNeqs, "JUMPIFNEQS", "l") \
+  X(Break, "BREAK", "") X(Dprint, "DPRINT", "s") \
+  X(End, "", "")
+
+#define OPCODE_ENUM(id, name, operands) Op_##id,
+
+/**
+ * @brief   Opcodes.
+ *
+ * Op_End terminates the program, it follows the last instruction.
+ * Other opcodes are in the order of the compiler (Opcode in src/code.h),
+ * which the binary code uses.
+ */
+typedef enum
+{
+  OPCODES(OPCODE_ENUM)
+  Op_Count        /**< Number of opcodes. */
+} Op;
+
+/**
+ * @brief   Types of values.
+ */
+typedef enum
+{
+  Type_Undefined,   /**< Variable was not initialized. */
+  Type_Int,         /**< int */
+  Type_Float,       /**< float */
+  Type_Bool,        /**< bool */
+  Type_String       /**< string */
+} ValueType;
+
+/**
+ * @brief   Reference counted string.
+ */
+typedef struct
+{
+  size_t refs;      /**< Number of references. */
+  size_t length;    /**< Length in bytes. */
+  char data[];      /**< Bytes, terminated by zero. */
+} String;
+
+/**
+ * @brief   Value.
+ */
+typedef struct
+{
+  ValueType type;
+  union {
+    int i;
+    double f;
+    bool b;
+    String * s;
+  } d;
+} Value;
+
+/**
+ * @brief   Kinds of operands.
+ */
+typedef enum
+{
+  Arg_None,
+  Arg_Constant,     /**< int@, float@, bool@, string@ */
+  Arg_Global,       /**< GF@ */
+  Arg_Local,        /**< LF@ */
+  Arg_Temporary,    /**< TF@ */
+  Arg_Label,        /**< Label. */
+  Arg_Type          /**< Type of READ. */
+} ArgKind;
+
+/** @brief Magic number of the binary code (src/binary.h). */
+#define BINARY_MAGIC "IFJB"
+/** @brief Supported version of the binary code. */
+#define BINARY_VERSION 1
+
+/** @brief Label not defined in the program. */
+#define NO_TARGET ((size_t)-1)
+
+/**
+ * @brief   Decoded operand.
+ */
+typedef struct
+{
+  ArgKind kind;
+  union {
+    Value constant;         /**< Constant. */
+    struct {
+      unsigned name;        /**< Interned name. */
+      unsigned slot;        /**< Slot in the frame where it was found last time. */
+    } var;                  /**< Variable. */
+    struct {
+      size_t target;        /**< Index of the label instruction, or NO_TARGET. */
+      unsigned name;        /**< Interned name. */
+    } label;                /**< Label. */
+    ValueType type;         /**< Type. */
+  } d;
+} Arg;
+
+/**
+ * @brief   Decoded instruction.
+ */
+typedef struct
+{
+  Op op;
+  unsigned line;    /**< Line in the source. */
+  Arg arg[3];
+} Instr;
+
+/**
+ * @brief   Loaded program.
+ */
+typedef struct
+{
+  Instr * code;         /**< Instructions, the last one is Op_End. */
+  size_t count;         /**< Number of instructions with Op_End. */
+  char ** names;        /**< Interned names of variables (without frame). */
+  size_t names_count;
+  char ** labels;       /**< Interned names of labels. */
+  size_t labels_count;
+} Program;
+
+/** @} */
+/*-----------------------------------------------------------*/
+/** @addtogroup Program_main
+ * Functions of the loaded program.
+ * @{
+ */
+
+/**
+ * @brief   Creates string.
+ *
+ * @param data    Bytes, or NULL to leave them uninitialized.
+ * @param length  Number of bytes.
+ * @returns String with one reference, or NULL.
+ */
+String * StringNew(const char * data, size_t length);
+
+/** @brief Adds a reference to the string. */
+static inline void StringRetain(String * s) { s->refs++; }
+
+/** @brief Removes a reference of the string. */
+static inline void StringRelease(String * s) { if(--s->refs == 0) free(s); }
+
+/** @brief Removes a reference of the string value. */
+static inline void ValueRelease(Value * v) { if(v->type == Type_String) StringRelease(v->d.s); }
+
+/** @brief Adds a reference of the string value. */
+static inline void ValueRetain(Value * v) { if(v->type == Type_String) StringRetain(v->d.s); }
+
+/**
+ * @brief   Name of the instruction.
+ *
+ * @param op      Opcode.
+ * @returns Name in IFJcode17.
+ */
+const char * OpName(Op op);
+
+/**
+ * @brief   Loads the program.
+ *
+ * The source is either IFJcode17 text, or the binary format
+ * of the compiler (--emit=binary). Errors are written to stderr.
+ * @param f       Source.
+ * @param p       Program to fill.
+ * @returns 0 if success, 51 (syntax), 52 (semantics) or 99 (internal) otherwise.
+ */
+int LoadProgram(FILE * f, Program * p);
+
+/**
+ * @brief   Writes the program as IFJcode17 text.
+ *
+ * @param p       Program.
+ * @param f       Output.
+ */
+void PrintProgram(const Program * p, FILE * f);
+
+/**
+ * @brief   Destroys the program.
+ *
+ * @param p       Program.
+ */
+void FreeProgram(Program * p);
+
+/** @} */
+/*-----------------------------------------------------------*/
+
+#endif // PROGRAM_H
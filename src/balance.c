@@ -0,0 +1,226 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "balance.h"
+#include "cfg.h"
+#include "code.h"
+#include "config.h"
+#include "io.h"
+
+/*----------- DATA ------------*/
+static unsigned removedClears = 0;    /**< Number of removed CLEARS. */
+
+/** @brief Depth of a block not reached yet. */
+#define UNKNOWN SIZE_MAX
+
+/** @brief Unit is a function (it returns a value). */
+static bool IsFunction(const CodeUnit * u)
+{
+  return u->name != NULL && strcmp(u->name, "scope") != 0;
+}
+
+/** @brief Name of the unit for messages. */
+static const char * UnitName(const CodeUnit * u)
+{
+  return (u->name != NULL) ? u->name : "prologue";
+}
+
+/**
+ * @brief   Reports a violation.
+ *
+ * @param u       Unit.
+ * @param i       Index of the instruction.
+ * @param msg     Description.
+ * @returns False.
+ */
+static bool Violation(const CodeUnit * u, size_t i, const char * msg)
+{
+  const char * op = (i < u->count) ? Opcode2Str(u->code[i].op) : "end";
+  err("balance: %s: instruction %zu (%s): %s", UnitName(u), i, op, msg);
+  return false;
+}
+
+/**
+ * @brief   Enters the block with the depth.
+ *
+ * @param depth   Depths of the blocks.
+ * @param work    Blocks to process.
+ * @param work_count  Number of blocks to process.
+ * @param b       Entered block.
+ * @param d       Depth.
+ * @returns True, if the same as from other predecessors. False otherwise.
+ */
+static bool Enter(size_t * depth, size_t * work, size_t * work_count, size_t b, size_t d)
+{
+  if(depth[b] == UNKNOWN)
+  {
+    depth[b] = d;
+    work[(*work_count)++] = b;
+    return true;
+  }
+  return depth[b] == d;
+}
+
+/**
+ * @brief   Leaves the unit with the depth.
+ *
+ * @returns True, if the depth is the one expected at an exit. False otherwise.
+ */
+static bool Exit(const CodeUnit * u, size_t i, size_t d)
+{
+  if(u->code[i].op == Opcode_Return)
+  {
+    if(!IsFunction(u)) return Violation(u, i, "return outside of a function");
+    if(d != 1) return Violation(u, i, "function does not return exactly one value");
+    return true;
+  }
+  if(d != 0) return Violation(u, i, "values left on the data stack");
+  return true;
+}
+
+/**
+ * @brief   Verifies the unit.
+ *
+ * @param u       Unit.
+ * @param clears  Flags of the instructions to remove.
+ * @returns True, if balanced. False otherwise.
+ */
+static bool VerifyBlocks(CodeUnit * u, const Cfg * cfg, size_t * depth, size_t * work, bool * clears)
+{
+  size_t work_count = 0;
+  depth[0] = 0;
+  work[work_count++] = 0;
+
+  while(work_count > 0)
+  {
+    const BasicBlock * block = &cfg->blocks[work[--work_count]];
+    size_t d = depth[block - cfg->blocks];
+
+    for(size_t i = block->start; i < block->end; i++)
+    {
+      const Instruction * ins = &u->code[i];
+      if(ins->op == Opcode_Clears)
+      {
+        clears[i] = (d == 0);
+        d = 0;
+        continue;
+      }
+
+      unsigned pops = OpcodeStackPops(ins->op);
+      if(d < pops) return Violation(u, i, "data stack underflow");
+      d += (size_t)OpcodeStackPushes(ins->op) + (ins->op == Opcode_Call) - pops;
+      if(d > u->stack_depth) u->stack_depth = d;
+    }
+
+    // successors
+    size_t last = block->end - 1;
+    Opcode op = u->code[last].op;
+    if(op == Opcode_Return)
+    {
+      if(!Exit(u, last, d)) return false;
+      continue;
+    }
+    if(OpcodeIsJump(op))
+    {
+      if(block->target == CFG_NONE)
+      {
+        if(!Exit(u, last, d)) return false;
+      }
+      else if(!Enter(depth, work, &work_count, block->target, d))
+        return Violation(u, last, "different depths of the data stack at a join");
+    }
+    if(block->next != CFG_NONE)
+    {
+      if(!Enter(depth, work, &work_count, block->next, d))
+        return Violation(u, block->end, "different depths of the data stack at a join");
+    }
+    else if(op != Opcode_Jump)
+    {
+      // end of the unit
+      if(IsFunction(u)) return Violation(u, u->count, "function ends without return");
+      if(!Exit(u, last, d)) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief   Verifies the unit and removes CLEARS of an empty stack.
+ *
+ * @param u       Unit.
+ * @param ok      Returned balance.
+ * @returns True, if success. False otherwise.
+ */
+static bool VerifyUnit(CodeUnit * u, bool * ok)
+{
+  Cfg cfg;
+  u->stack_depth = 0;
+  if(!CfgBuild(&cfg, u)) return false;
+  if(cfg.count == 0)
+  {
+    CfgFree(&cfg);
+    return true;
+  }
+
+  size_t * depth = malloc(cfg.count * sizeof(size_t));
+  size_t * work = malloc(cfg.count * sizeof(size_t));
+  bool * clears = calloc(u->count, sizeof(bool));
+  if(depth == NULL || work == NULL || clears == NULL)
+  {
+    free(depth);
+    free(work);
+    free(clears);
+    CfgFree(&cfg);
+    return false;
+  }
+  for(size_t b = 0; b < cfg.count; b++) depth[b] = UNKNOWN;
+
+  *ok = VerifyBlocks(u, &cfg, depth, work, clears);
+  if(*ok)
+  {
+    size_t n = 0;
+    for(size_t i = 0; i < u->count; i++)
+    {
+      if(clears[i])
+      {
+        removedClears++;
+        continue;
+      }
+      u->code[n++] = u->code[i];
+    }
+    u->count = n;
+  }
+  #ifdef OPTIMIZER_DEBUG
+    debug("Unit %s uses %zu values of the data stack.", UnitName(u), u->stack_depth);
+  #endif
+
+  free(depth);
+  free(work);
+  free(clears);
+  CfgFree(&cfg);
+  return true;
+}
+
+bool VerifyStackBalance()
+{
+  unsigned removed = removedClears;
+  size_t maximum = 0;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    CodeUnit * u = CodeGetUnit(i);
+    bool ok = true;
+    if(!VerifyUnit(u, &ok) || !ok) return false;
+    if(u->stack_depth > maximum) maximum = u->stack_depth;
+  }
+
+  if(report())
+  {
+    fprintf(stderr, "Removed stack clears: %u\n", removedClears - removed);
+    fprintf(stderr, "Maximal data stack depth: %zu\n", maximum);
+  }
+  return true;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file balance.h
+ * @interface balance
+ * @date 19th october 2026
+ * @brief Data stack verifier interface.
+ *
+ * This interface declares static analysis of the depth of the data stack
+ * in the generated code.
+ */
+
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Verifies balance of the data stack.
+ *
+ * Depth of the data stack is computed before every instruction of each
+ * unit. A unit starts with an empty stack, every call leaves its returned
+ * value on it. Blocks must be entered with the same depth from all their
+ * predecessors, a function must return with its value only, other units
+ * must leave the stack empty. The maximal depth is recorded in the unit,
+ * CLEARS of an empty stack is removed.
+ * A violation is written to stderr with the unit and the instruction.
+ * @returns True, if balanced. False otherwise.
+ */
+bool VerifyStackBalance();
+
+#endif // BALANCE_H
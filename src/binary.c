@@ -0,0 +1,299 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary.h"
+#include "code.h"
+#include "fold.h"
+#include "io.h"
+#include "tables.h"
+
+/** @brief Label without the LABEL instruction. */
+#define NO_TARGET 0xFFFFFFFFu
+
+/**
+ * @brief   Sorted set of keys.
+ *
+ * Keys are atoms (names, labels) or indices of constants.
+ */
+typedef struct
+{
+  uintptr_t * keys;
+  size_t count, capacity;
+} Set;
+
+/**
+ * @brief   State of the output.
+ */
+typedef struct
+{
+  Set constants;          /**< Indices into the table of constants. */
+  Set names;              /**< Names of variables (atoms without frame). */
+  Set labels;             /**< Labels (atoms). */
+  uint32_t * targets;     /**< Instruction of each label. */
+  uint32_t instructions;  /**< Number of instructions. */
+  bool ok;                /**< No allocation failed. */
+} Binary;
+
+/*------------------------------ SETS ------------------------------------*/
+
+/** @brief Compares keys. */
+static int CompareKeys(const void * a, const void * b)
+{
+  uintptr_t x = *(const uintptr_t *)a, y = *(const uintptr_t *)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Adds the key (duplicates are removed by SetSort()). */
+static void SetAdd(Binary * B, Set * s, uintptr_t key)
+{
+  if(s->count == s->capacity)
+  {
+    size_t capacity = (s->capacity == 0) ? 64 : 2 * s->capacity;
+    uintptr_t * grown = realloc(s->keys, capacity * sizeof(uintptr_t));
+    if(grown == NULL)
+    {
+      B->ok = false;
+      return;
+    }
+    s->keys = grown;
+    s->capacity = capacity;
+  }
+  s->keys[s->count++] = key;
+}
+
+/** @brief Sorts the keys and removes duplicates. */
+static void SetSort(Set * s)
+{
+  if(s->count == 0) return;
+  qsort(s->keys, s->count, sizeof(uintptr_t), CompareKeys);
+  size_t n = 1;
+  for(size_t i = 1; i < s->count; i++)
+    if(s->keys[i] != s->keys[n-1]) s->keys[n++] = s->keys[i];
+  s->count = n;
+}
+
+/** @brief Index of the key in the sorted set. */
+static uint32_t SetIndex(const Set * s, uintptr_t key)
+{
+  const uintptr_t * found = bsearch(&key, s->keys, s->count, sizeof(uintptr_t), CompareKeys);
+  return (found != NULL) ? (uint32_t)(found - s->keys) : 0;
+}
+
+/** @brief Name of the variable without frame (atom). */
+static uintptr_t VariableName(Binary * B, const Operand * o)
+{
+  const char * atom = atomInsert(o->d.var.name + 3);
+  if(atom == NULL) B->ok = false;
+  return (uintptr_t)atom;
+}
+
+/*------------------------------ OUTPUT ------------------------------------*/
+
+/** @brief Writes the byte. */
+static void PutU8(unsigned value)
+{
+  putchar((int)(value & 0xFF));
+}
+
+/** @brief Writes the 32-bit number, 7 bits per byte (the highest bit continues). */
+static void PutU32(uint32_t value)
+{
+  while(value >= 0x80)
+  {
+    PutU8((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  PutU8(value);
+}
+
+/** @brief Writes the 64-bit number. */
+static void PutU64(uint64_t value)
+{
+  for(unsigned i = 0; i < 8; i++) PutU8((unsigned)(value >> (8 * i)));
+}
+
+/** @brief Writes the length and the bytes. */
+static void PutBytes(const char * data, size_t length)
+{
+  PutU32((uint32_t)length);
+  fwrite(data, 1, length, stdout);
+}
+
+/** @brief Writes the constant of the table. */
+static void PutConstant(Binary * B, size_t index)
+{
+  switch(findConstType(index))
+  {
+    case DataType_Integer:
+      PutU8(1);
+      PutU32((uint32_t)getIntConstValue(index));
+      break;
+    case DataType_Double:
+    {
+      double d = getDoubleConstValue(index);
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      PutU8(2);
+      PutU64(bits);
+      break;
+    }
+    default:
+    {
+      const char * escaped = getStringConstValue(index);
+      size_t length = DecodeString(escaped, NULL);
+      char * decoded = malloc(length + 1);
+      if(decoded == NULL)
+      {
+        B->ok = false;
+        return;
+      }
+      DecodeString(escaped, decoded);
+      PutU8(4);
+      PutBytes(decoded, length);
+      free(decoded);
+      break;
+    }
+  }
+}
+
+/** @brief Writes the operand. */
+static void PutOperand(Binary * B, const Operand * o)
+{
+  switch(o->type)
+  {
+    case Operand_Variable:
+      PutU8((unsigned)o->d.var.frame);
+      PutU32(SetIndex(&B->names, VariableName(B, o)));
+      break;
+    case Operand_Constant:
+      PutU8(3);
+      PutU32(SetIndex(&B->constants, o->d.index));
+      break;
+    case Operand_Bool:
+      PutU8(o->d.b ? 5 : 4);
+      break;
+    case Operand_Label:
+      PutU32(SetIndex(&B->labels, (uintptr_t)o->d.label));
+      break;
+    case Operand_Type:
+      PutU8((o->d.dt == DataType_Integer) ? 1 : (o->d.dt == DataType_Double) ? 2 : 4);
+      break;
+    default:
+      break;
+  }
+}
+
+/*------------------------------ MAIN ------------------------------------*/
+
+/** @brief Collects constants, names and labels of the reachable code. */
+static void Collect(Binary * B)
+{
+  for(size_t u = 0; B->ok && u < CodeUnitCount(); u++)
+  {
+    const CodeUnit * unit = CodeGetUnit(u);
+    if(!unit->reachable) continue;
+    for(size_t i = 0; i < unit->count; i++)
+    {
+      const Instruction * ins = &unit->code[i];
+      if(ins->op == Opcode_Comment) continue;
+      B->instructions++;
+      for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+      {
+        const Operand * o = &ins->arg[a];
+        if(o->type == Operand_Constant) SetAdd(B, &B->constants, o->d.index);
+        else if(o->type == Operand_Variable) SetAdd(B, &B->names, VariableName(B, o));
+        else if(o->type == Operand_Label) SetAdd(B, &B->labels, (uintptr_t)o->d.label);
+      }
+    }
+  }
+  SetSort(&B->constants);
+  SetSort(&B->names);
+  SetSort(&B->labels);
+}
+
+/** @brief Finds the instruction of each label. */
+static void ResolveLabels(Binary * B)
+{
+  B->targets = malloc((B->labels.count + 1) * sizeof(uint32_t));
+  if(B->targets == NULL)
+  {
+    B->ok = false;
+    return;
+  }
+  for(size_t l = 0; l < B->labels.count; l++) B->targets[l] = NO_TARGET;
+
+  uint32_t position = 0;
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+  {
+    const CodeUnit * unit = CodeGetUnit(u);
+    if(!unit->reachable) continue;
+    for(size_t i = 0; i < unit->count; i++)
+    {
+      const Instruction * ins = &unit->code[i];
+      if(ins->op == Opcode_Comment) continue;
+      if(ins->op == Opcode_Label) B->targets[SetIndex(&B->labels, (uintptr_t)ins->arg[0].d.label)] = position;
+      position++;
+    }
+  }
+}
+
+/** @brief Writes the header, the tables and the instructions. */
+static void Write(Binary * B)
+{
+  fwrite(BINARY_MAGIC, 1, 4, stdout);
+  PutU8(BINARY_VERSION & 0xFF);
+  PutU8(BINARY_VERSION >> 8);
+  PutU8(0);
+  PutU8(0);
+  PutU32((uint32_t)B->constants.count);
+  PutU32((uint32_t)B->names.count);
+  PutU32((uint32_t)B->labels.count);
+  PutU32(B->instructions);
+
+  for(size_t c = 0; B->ok && c < B->constants.count; c++) PutConstant(B, (size_t)B->constants.keys[c]);
+  for(size_t n = 0; n < B->names.count; n++)
+  {
+    const char * name = (const char *)B->names.keys[n];
+    PutBytes(name, strlen(name));
+  }
+  for(size_t l = 0; l < B->labels.count; l++)
+  {
+    const char * label = (const char *)B->labels.keys[l];
+    PutU32(B->targets[l]);
+    PutBytes(label, strlen(label));
+  }
+
+  for(size_t u = 0; B->ok && u < CodeUnitCount(); u++)
+  {
+    const CodeUnit * unit = CodeGetUnit(u);
+    if(!unit->reachable) continue;
+    for(size_t i = 0; i < unit->count; i++)
+    {
+      const Instruction * ins = &unit->code[i];
+      if(ins->op == Opcode_Comment) continue;
+      PutU8((unsigned)ins->op);
+      for(unsigned a = 0; a < OpcodeArity(ins->op); a++) PutOperand(B, &ins->arg[a]);
+    }
+  }
+}
+
+bool PrintBinaryCode()
+{
+  Binary B = {.ok = true};
+  Collect(&B);
+  if(B.ok) ResolveLabels(&B);
+  if(B.ok) Write(&B);
+  fflush(stdout);
+
+  #ifdef GENERATOR_DEBUG
+    debug("Binary code: %zu constants, %zu names, %zu labels.", B.constants.count, B.names.count, B.labels.count);
+  #endif
+  free(B.constants.keys);
+  free(B.names.keys);
+  free(B.labels.keys);
+  free(B.targets);
+  return B.ok;
+}
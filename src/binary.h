@@ -0,0 +1,46 @@
+/**
+ * @file binary.h
+ * @interface binary
+ * @date 19th october 2026
+ * @brief Binary code interface.
+ *
+ * This interface declares output of the generated code in the binary
+ * format of IFJcode17, which the interpreter loads without tokenizing.
+ *
+ * Numbers u32 and i32 take 7 bits per byte, the lowest first, the highest bit
+ * of the byte is set if another follows. Other numbers are little endian.
+ * @code
+ *   "IFJB" u16 version u16 0
+ *   u32 constants u32 names u32 labels u32 instructions
+ *   constants:     u8 type (1 int: i32, 2 float: f64, 4 string: u32 length, bytes)
+ *   names:         u32 length, bytes (variables without frame)
+ *   labels:        u32 index of the LABEL instruction (or ~0), u32 length, bytes
+ *   instructions:  u8 opcode (order of Opcode), operands:
+ *                    variable, symbol: u8 kind (0 GF, 1 LF, 2 TF: u32 name,
+ *                                      3 constant: u32 index, 4 false, 5 true)
+ *                    label:            u32 index of the label
+ *                    type:             u8 type (1 int, 2 float, 4 string)
+ * @endcode
+ * Strings are decoded, jumps are resolved through the table of labels.
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <stdbool.h>
+
+/** @brief Magic number of the binary code. */
+#define BINARY_MAGIC "IFJB"
+/** @brief Version of the binary format, raised with any change of it (opcodes included). */
+#define BINARY_VERSION 1
+
+/**
+ * @brief   Prints the reachable code in the binary format.
+ *
+ * Only the constants, names and labels used by the printed code
+ * are written. It is called by PrintCode() instead of the text.
+ * @returns True, if success. False otherwise.
+ */
+bool PrintBinaryCode();
+
+#endif // BINARY_H
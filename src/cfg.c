@@ -0,0 +1,286 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "dataflow.h"
+#include "io.h"
+
+/**
+ * @brief   Compares labels by their addresses.
+ */
+static int CompareLabels(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)((const struct CfgLabel *)a)->label;
+  uintptr_t y = (uintptr_t)((const struct CfgLabel *)b)->label;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief   Instruction ends a block.
+ *
+ * @param op      Opcode.
+ * @returns True, if jump or return. False otherwise.
+ */
+static bool EndsBlock(Opcode op) { return OpcodeIsJump(op) || op == Opcode_Return; }
+
+size_t CfgLabelBlock(const Cfg * cfg, const char * label)
+{
+  struct CfgLabel key = {.label = label};
+  const struct CfgLabel * found = bsearch(&key, cfg->labels, cfg->labels_count, sizeof(key), CompareLabels);
+  return (found != NULL) ? found->block : CFG_NONE;
+}
+
+const char * CfgBlockLabel(const Cfg * cfg, size_t b)
+{
+  const BasicBlock * block = &cfg->blocks[b];
+  for(size_t i = block->start; i < block->end; i++)
+  {
+    const Instruction * ins = &cfg->unit->code[i];
+    if(ins->op == Opcode_Label) return ins->arg[0].d.label;
+    if(ins->op != Opcode_Comment) break;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Adds predecessor to the block.
+ */
+static void AddPredecessor(Cfg * cfg, size_t b, size_t pred)
+{
+  if(b == CFG_NONE) return;
+  BasicBlock * block = &cfg->blocks[b];
+  for(size_t i = 0; i < block->preds_count; i++)
+    if(block->preds[i] == pred) return;
+  block->preds[block->preds_count++] = pred;
+}
+
+bool CfgBuild(Cfg * cfg, CodeUnit * u)
+{
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->unit = u;
+  if(u->count == 0) return true;
+
+  // leaders: the first instruction, labels and instructions after jumps
+  size_t count = 0, labels = 0;
+  for(size_t i = 0; i < u->count; i++)
+  {
+    Opcode op = u->code[i].op;
+    if(i == 0 || op == Opcode_Label || EndsBlock(u->code[i-1].op)) count++;
+    if(op == Opcode_Label) labels++;
+  }
+
+  cfg->blocks = malloc(count * sizeof(BasicBlock));
+  cfg->pool = malloc(2 * count * sizeof(size_t));
+  cfg->labels = malloc((labels > 0 ? labels : 1) * sizeof(struct CfgLabel));
+  if(cfg->blocks == NULL || cfg->pool == NULL || cfg->labels == NULL)
+  {
+    CfgFree(cfg);
+    return false;
+  }
+
+  for(size_t i = 0; i < u->count; i++)
+  {
+    Opcode op = u->code[i].op;
+    if(i == 0 || op == Opcode_Label || EndsBlock(u->code[i-1].op))
+    {
+      if(cfg->count > 0) cfg->blocks[cfg->count - 1].end = i;
+      cfg->blocks[cfg->count++] = (BasicBlock){.start = i, .next = CFG_NONE, .target = CFG_NONE};
+    }
+    if(op == Opcode_Label)
+      cfg->labels[cfg->labels_count++] = (struct CfgLabel){u->code[i].arg[0].d.label, cfg->count - 1};
+  }
+  cfg->blocks[cfg->count - 1].end = u->count;
+  qsort(cfg->labels, cfg->labels_count, sizeof(struct CfgLabel), CompareLabels);
+
+  // successors
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    BasicBlock * block = &cfg->blocks[b];
+    const Instruction * last = &u->code[block->end - 1];
+    if(OpcodeIsJump(last->op)) block->target = CfgLabelBlock(cfg, last->arg[0].d.label);
+    if(last->op != Opcode_Jump && last->op != Opcode_Return && b + 1 < cfg->count) block->next = b + 1;
+  }
+
+  // predecessors, at most two edges per block
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    BasicBlock * block = &cfg->blocks[b];
+    if(block->next != CFG_NONE) cfg->blocks[block->next].preds_count++;
+    if(block->target != CFG_NONE && block->target != block->next) cfg->blocks[block->target].preds_count++;
+  }
+  size_t * pool = cfg->pool;
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    cfg->blocks[b].preds = pool;
+    pool += cfg->blocks[b].preds_count;
+    cfg->blocks[b].preds_count = 0;
+  }
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    AddPredecessor(cfg, cfg->blocks[b].next, b);
+    AddPredecessor(cfg, cfg->blocks[b].target, b);
+  }
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Control flow graph of %s: %zu blocks.", (u->name != NULL) ? u->name : "prologue", cfg->count);
+  #endif
+
+  return true;
+}
+
+void CfgFree(Cfg * cfg)
+{
+  free(cfg->blocks);
+  free(cfg->pool);
+  free(cfg->labels);
+  memset(cfg, 0, sizeof(*cfg));
+}
+
+/*------------------------------ DUMP ------------------------------------*/
+
+/**
+ * @brief   Writes text escaped for Graphviz.
+ */
+static void DumpText(FILE * f, const char * text)
+{
+  for(; *text != '\0'; text++)
+  {
+    if(*text == '"' || *text == '\\' || *text == '{' || *text == '}' || *text == '<' || *text == '>' || *text == '|')
+      fputc('\\', f);
+    fputc(*text, f);
+  }
+}
+
+/**
+ * @brief   Writes graph of the unit.
+ *
+ * @param f       File.
+ * @param u       Unit.
+ * @param n       Index of the unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool DumpUnit(FILE * f, CodeUnit * u, size_t n)
+{
+  Cfg cfg;
+  Variables vars;
+  Dataflow live, reach, avail;
+  Facts defs, exprs;
+  if(!CfgBuild(&cfg, u)) return false;
+  if(!VariablesCollect(&vars, u))
+  {
+    CfgFree(&cfg);
+    return false;
+  }
+  bool ok = Liveness(&live, &cfg, &vars);
+  if(ok && !ReachingDefinitions(&reach, &cfg, &vars, &defs))
+  {
+    DataflowFree(&live);
+    ok = false;
+  }
+  if(ok && !AvailableExpressions(&avail, &cfg, &vars, &exprs))
+  {
+    DataflowFree(&live);
+    DataflowFree(&reach);
+    FactsFree(&defs);
+    ok = false;
+  }
+  if(!ok)
+  {
+    VariablesFree(&vars);
+    CfgFree(&cfg);
+    return false;
+  }
+
+  fprintf(f, "  subgraph cluster_%zu {\n    label=\"", n);
+  DumpText(f, (u->name != NULL) ? u->name : "prologue");
+  fputs("\";\n", f);
+
+  for(size_t b = 0; b < cfg.count; b++)
+  {
+    fprintf(f, "    u%zub%zu [label=\"", n, b);
+    for(size_t i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++)
+    {
+      const Instruction * ins = &u->code[i];
+      DumpText(f, Opcode2Str(ins->op));
+      for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+      {
+        fputc(' ', f);
+        DumpText(f, Operand2Str(&ins->arg[a]));
+      }
+      fputs("\\l", f);
+    }
+    if(live.solved)
+    {
+      fputs("live out:", f);
+      const uint64_t * out = DataflowSet(&live, live.out, b);
+      for(size_t v = 0; v < vars.count; v++)
+        if(BitTest(out, v))
+        {
+          fputc(' ', f);
+          DumpText(f, vars.names[v]);
+        }
+      fputs("\\l", f);
+    }
+    if(reach.solved)
+    {
+      size_t count = 0;
+      for(size_t d = 0; d < defs.count; d++) count += BitTest(DataflowSet(&reach, reach.in, b), d);
+      fprintf(f, "reaching definitions: %zu\\l", count);
+    }
+    if(avail.solved)
+    {
+      fputs("available:", f);
+      for(size_t e = 0; e < exprs.count; e++)
+        if(BitTest(DataflowSet(&avail, avail.in, b), e))
+        {
+          const Instruction * ins = &u->code[exprs.sites[e]];
+          fputc(' ', f);
+          DumpText(f, Opcode2Str(ins->op));
+          for(unsigned a = 1; a < OpcodeArity(ins->op); a++)
+          {
+            fputc(a == 1 ? '(' : ',', f);
+            DumpText(f, Operand2Str(&ins->arg[a]));
+          }
+          fputc(')', f);
+        }
+      fputs("\\l", f);
+    }
+    fputs("\"];\n", f);
+
+    if(cfg.blocks[b].next != CFG_NONE) fprintf(f, "    u%zub%zu -> u%zub%zu;\n", n, b, n, cfg.blocks[b].next);
+    if(cfg.blocks[b].target != CFG_NONE)
+      fprintf(f, "    u%zub%zu -> u%zub%zu [style=dashed];\n", n, b, n, cfg.blocks[b].target);
+  }
+  fputs("  }\n", f);
+
+  DataflowFree(&live);
+  DataflowFree(&reach);
+  DataflowFree(&avail);
+  FactsFree(&defs);
+  FactsFree(&exprs);
+  VariablesFree(&vars);
+  CfgFree(&cfg);
+  return true;
+}
+
+bool CfgDumpCode(const char * path)
+{
+  FILE * f = fopen(path, "w");
+  if(f == NULL) return false;
+
+  bool ok = true;
+  fputs("digraph code {\n  node [shape=box, fontname=\"monospace\"];\n", f);
+  for(size_t i = 0; ok && i < CodeUnitCount(); i++)
+  {
+    CodeUnit * u = CodeGetUnit(i);
+    if(u->reachable && u->count > 0) ok = DumpUnit(f, u, i);
+  }
+  fputs("}\n", f);
+
+  if(fclose(f) != 0) ok = false;
+  return ok;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file cfg.h
+ * @interface cfg
+ * @date 18th october 2026
+ * @brief Control flow graph interface.
+ *
+ * This interface declares basic blocks of a unit of code
+ * and the control flow graph over them.
+ */
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "code.h"
+
+/*-----------------------------------------------------------*/
+/** @addtogroup Cfg_types
+ * Types of the control flow graph.
+ * @{
+ */
+
+/** @brief No block. */
+#define CFG_NONE ((size_t)-1)
+
+/**
+ * @brief   Basic block.
+ *
+ * Block starts at a label or after a jump and ends with a jump,
+ * a return, or before a label.
+ */
+typedef struct
+{
+  size_t start;           /**< First instruction. */
+  size_t end;             /**< Instruction after the last one. */
+  size_t next;            /**< Fall-through successor, or CFG_NONE. */
+  size_t target;          /**< Jump successor, or CFG_NONE. */
+  size_t * preds;         /**< Predecessors. */
+  size_t preds_count;     /**< Number of predecessors. */
+} BasicBlock;
+
+/**
+ * @brief   Control flow graph of a unit.
+ */
+typedef struct
+{
+  CodeUnit * unit;            /**< Unit of code. */
+  BasicBlock * blocks;        /**< Blocks in order of the code. */
+  size_t count;               /**< Number of blocks. */
+  size_t * pool;              /**< Storage of predecessors. */
+  struct CfgLabel {
+    const char * label;       /**< Label (atom). */
+    size_t block;             /**< Block of the label. */
+  } * labels;                 /**< Labels sorted by address. */
+  size_t labels_count;        /**< Number of labels. */
+} Cfg;
+
+/** @} */
+/*-----------------------------------------------------------*/
+/** @addtogroup Cfg_main
+ * Functions of the control flow graph.
+ * @{
+ */
+
+/**
+ * @brief   Builds control flow graph of the unit.
+ *
+ * Jumps to labels outside of the unit have no successor.
+ * @param cfg     Graph to fill.
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+bool CfgBuild(Cfg * cfg, CodeUnit * u);
+
+/**
+ * @brief   Block of the label.
+ *
+ * @param cfg     Graph.
+ * @param label   Label (atom).
+ * @returns Index of the block, or CFG_NONE, if not in the unit.
+ */
+size_t CfgLabelBlock(const Cfg * cfg, const char * label);
+
+/**
+ * @brief   Label of the block.
+ *
+ * @param cfg     Graph.
+ * @param b       Index of the block.
+ * @returns First label of the block, or NULL.
+ */
+const char * CfgBlockLabel(const Cfg * cfg, size_t b);
+
+/**
+ * @brief   Destroys control flow graph.
+ *
+ * @param cfg     Graph.
+ */
+void CfgFree(Cfg * cfg);
+
+/**
+ * @brief   Writes control flow graphs of the code.
+ *
+ * Graphs of the reachable units are written in Graphviz format,
+ * one cluster per unit. Blocks are annotated with the live variables.
+ * @param path    Path of the file.
+ * @returns True, if success. False otherwise.
+ */
+bool CfgDumpCode(const char * path);
+
+/** @} */
+/*-----------------------------------------------------------*/
+
+#endif // CFG_H
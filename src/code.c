@@ -0,0 +1,637 @@
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary.h"
+#include "code.h"
+#include "config.h"
+#include "csource.h"
+#include "err.h"
+#include "io.h"
+#include "tables.h"
+
+#define STARTING_CHUNK_CODE 64      //size of initialised array of instructions
+#define STARTING_CHUNK_CALLS 4      //size of initialised array of calls
+#define STARTING_CHUNK_UNITS 16     //size of initialised array of units, power of two
+
+/*---------------------------- OPCODES ---------------------------------*/
+
+/**
+ * @brief   Table of instructions.
+ *
+ * Name, number of operands, whether the first operand is written,
+ * and number of values popped from and pushed onto the data stack.
+ */
+static const struct {
+  const char * name;
+  unsigned arity;
+  bool writes;
+  unsigned pops, pushes;
+} opcodes[Opcode_Count] = {
+  [Opcode_Move] = {"MOVE", 2, true, 0, 0}, [Opcode_CreateFrame] = {"CREATEFRAME", 0, false, 0, 0},
+  [Opcode_PushFrame] = {"PUSHFRAME", 0, false, 0, 0}, [Opcode_PopFrame] = {"POPFRAME", 0, false, 0, 0},
+  [Opcode_Defvar] = {"DEFVAR", 1, true, 0, 0}, [Opcode_Call] = {"CALL", 1, false, 0, 0},
+  [Opcode_Return] = {"RETURN", 0, false, 0, 0},
+
+  [Opcode_Pushs] = {"PUSHS", 1, false, 0, 1}, [Opcode_Pops] = {"POPS", 1, true, 1, 0},
+  [Opcode_Clears] = {"CLEARS", 0, false, 0, 0},
+
+  [Opcode_Add] = {"ADD", 3, true, 0, 0}, [Opcode_Sub] = {"SUB", 3, true, 0, 0},
+  [Opcode_Mul] = {"MUL", 3, true, 0, 0}, [Opcode_Div] = {"DIV", 3, true, 0, 0},
+  [Opcode_Adds] = {"ADDS", 0, false, 2, 1}, [Opcode_Subs] = {"SUBS", 0, false, 2, 1},
+  [Opcode_Muls] = {"MULS", 0, false, 2, 1}, [Opcode_Divs] = {"DIVS", 0, false, 2, 1},
+  [Opcode_Lt] = {"LT", 3, true, 0, 0}, [Opcode_Gt] = {"GT", 3, true, 0, 0}, [Opcode_Eq] = {"EQ", 3, true, 0, 0},
+  [Opcode_Lts] = {"LTS", 0, false, 2, 1}, [Opcode_Gts] = {"GTS", 0, false, 2, 1}, [Opcode_Eqs] = {"EQS", 0, false, 2, 1},
+  [Opcode_And] = {"AND", 3, true, 0, 0}, [Opcode_Or] = {"OR", 3, true, 0, 0}, [Opcode_Not] = {"NOT", 2, true, 0, 0},
+  [Opcode_Ands] = {"ANDS", 0, false, 2, 1}, [Opcode_Ors] = {"ORS", 0, false, 2, 1}, [Opcode_Nots] = {"NOTS", 0, false, 1, 1},
+
+  [Opcode_Int2Float] = {"INT2FLOAT", 2, true, 0, 0}, [Opcode_Float2Int] = {"FLOAT2INT", 2, true, 0, 0},
+  [Opcode_Float2R2EInt] = {"FLOAT2R2EINT", 2, true, 0, 0}, [Opcode_Float2R2OInt] = {"FLOAT2R2OINT", 2, true, 0, 0},
+  [Opcode_Int2Char] = {"INT2CHAR", 2, true, 0, 0}, [Opcode_Stri2Int] = {"STRI2INT", 3, true, 0, 0},
+  [Opcode_Int2Floats] = {"INT2FLOATS", 0, false, 1, 1}, [Opcode_Float2Ints] = {"FLOAT2INTS", 0, false, 1, 1},
+  [Opcode_Float2R2EInts] = {"FLOAT2R2EINTS", 0, false, 1, 1}, [Opcode_Float2R2OInts] = {"FLOAT2R2OINTS", 0, false, 1, 1},
+  [Opcode_Int2Chars] = {"INT2CHARS", 0, false, 1, 1}, [Opcode_Stri2Ints] = {"STRI2INTS", 0, false, 2, 1},
+
+  [Opcode_Read] = {"READ", 2, true, 0, 0}, [Opcode_Write] = {"WRITE", 1, false, 0, 0},
+
+  [Opcode_Concat] = {"CONCAT", 3, true, 0, 0}, [Opcode_Strlen] = {"STRLEN", 2, true, 0, 0},
+  [Opcode_Getchar] = {"GETCHAR", 3, true, 0, 0}, [Opcode_Setchar] = {"SETCHAR", 3, true, 0, 0},
+
+  [Opcode_Type] = {"TYPE", 2, true, 0, 0},
+
+  [Opcode_Label] = {"LABEL", 1, false, 0, 0}, [Opcode_Jump] = {"JUMP", 1, false, 0, 0},
+  [Opcode_JumpIfEq] = {"JUMPIFEQ", 3, false, 0, 0}, [Opcode_JumpIfNeq] = {"JUMPIFNEQ", 3, false, 0, 0},
+  [Opcode_JumpIfEqs] = {"JUMPIFEQS", 1, false, 2, 0}, [Opcode_JumpIfNeqs] = {"JUMPIFNEQS", 1, false, 2, 0},
+
+  [Opcode_Break] = {"BREAK", 0, false, 0, 0}, [Opcode_Dprint] = {"DPRINT", 1, false, 0, 0},
+
+  [Opcode_Comment] = {"#", 1, false, 0, 0}
+};
+
+const char * Opcode2Str(Opcode op) { return (op < Opcode_Count) ? opcodes[op].name : "UNKNOWN"; }
+unsigned OpcodeArity(Opcode op) { return (op < Opcode_Count) ? opcodes[op].arity : 0; }
+
+bool OpcodeWrites(Opcode op) { return (op < Opcode_Count) ? opcodes[op].writes : false; }
+
+unsigned OpcodeStackPops(Opcode op) { return (op < Opcode_Count) ? opcodes[op].pops : 0; }
+
+unsigned OpcodeStackPushes(Opcode op) { return (op < Opcode_Count) ? opcodes[op].pushes : 0; }
+
+bool OpcodeIsPure(Opcode op)
+{
+  switch(op)
+  {
+    case Opcode_Move: case Opcode_Add: case Opcode_Sub: case Opcode_Mul:
+    case Opcode_Lt: case Opcode_Gt: case Opcode_Eq: case Opcode_And: case Opcode_Or: case Opcode_Not:
+    case Opcode_Int2Float: case Opcode_Concat: case Opcode_Strlen:
+    case Opcode_Adds: case Opcode_Subs: case Opcode_Muls:
+    case Opcode_Lts: case Opcode_Gts: case Opcode_Eqs: case Opcode_Ands: case Opcode_Ors: case Opcode_Nots:
+    case Opcode_Int2Floats:
+      return true;
+    default: return false;
+  }
+}
+
+Opcode OpcodeThreeAddress(Opcode op)
+{
+  switch(op)
+  {
+    case Opcode_Adds: return Opcode_Add;
+    case Opcode_Subs: return Opcode_Sub;
+    case Opcode_Muls: return Opcode_Mul;
+    case Opcode_Divs: return Opcode_Div;
+    case Opcode_Lts: return Opcode_Lt;
+    case Opcode_Gts: return Opcode_Gt;
+    case Opcode_Eqs: return Opcode_Eq;
+    case Opcode_Ands: return Opcode_And;
+    case Opcode_Ors: return Opcode_Or;
+    case Opcode_Nots: return Opcode_Not;
+    case Opcode_Int2Floats: return Opcode_Int2Float;
+    case Opcode_Float2Ints: return Opcode_Float2Int;
+    case Opcode_Float2R2EInts: return Opcode_Float2R2EInt;
+    case Opcode_Float2R2OInts: return Opcode_Float2R2OInt;
+    case Opcode_Int2Chars: return Opcode_Int2Char;
+    case Opcode_Stri2Ints: return Opcode_Stri2Int;
+    default: return op;
+  }
+}
+
+bool OpcodeIsJump(Opcode op) { return op == Opcode_Jump || OpcodeIsConditionalJump(op); }
+
+bool OpcodeIsConditionalJump(Opcode op)
+{
+  return op == Opcode_JumpIfEq || op == Opcode_JumpIfNeq || op == Opcode_JumpIfEqs || op == Opcode_JumpIfNeqs;
+}
+
+Opcode OpcodeInvertJump(Opcode op)
+{
+  switch(op)
+  {
+    case Opcode_JumpIfEq: return Opcode_JumpIfNeq;
+    case Opcode_JumpIfNeq: return Opcode_JumpIfEq;
+    case Opcode_JumpIfEqs: return Opcode_JumpIfNeqs;
+    case Opcode_JumpIfNeqs: return Opcode_JumpIfEqs;
+    default: return op;
+  }
+}
+
+/*---------------------------- OPERANDS ---------------------------------*/
+
+Operand OperandVariable(Frame frame, const char * name)
+{
+  static const char * prefix[] = {"GF@", "LF@", "TF@"};
+
+  // operand text with frame
+  size_t len = strlen(name);
+  char stackbuf[64];
+  char * text = (len + 4 <= sizeof(stackbuf)) ? stackbuf : malloc(len + 4);
+
+  Operand o = {.type = Operand_None};
+  if(text == NULL) return o;
+  memcpy(text, prefix[frame], 3);
+  memcpy(text + 3, name, len + 1);
+
+  o.type = Operand_Variable;
+  o.d.var.frame = frame;
+  o.d.var.name = atomInsert(text);
+
+  if(text != stackbuf) free(text);
+  return o;
+}
+
+Operand OperandVariableText(const char * text)
+{
+  Operand o = {.type = Operand_Variable};
+  if(text[0] == 'G') o.d.var.frame = Frame_Global;
+  else if(text[0] == 'T') o.d.var.frame = Frame_Temporary;
+  else o.d.var.frame = Frame_Local;
+  o.d.var.name = text;
+  return o;
+}
+
+Operand OperandConstant(size_t index)
+{
+  Operand o = {.type = Operand_Constant};
+  o.d.index = index;
+  return o;
+}
+
+Operand OperandInt(int i)
+{
+  DataUnion du;
+  du.ivalue = i;
+  int index = constInsert(DataType_Integer, du);
+  return OperandConstant((index < 0) ? getIntDefaultValue() : (size_t)index);
+}
+
+Operand OperandFloat(double d)
+{
+  DataUnion du;
+  du.dvalue = d;
+  int index = constInsert(DataType_Double, du);
+  return OperandConstant((index < 0) ? getDoubleDefaultValue() : (size_t)index);
+}
+
+Operand OperandString(const char * str)
+{
+  DataUnion du;
+  du.svalue = (char *)str;
+  int index = constInsert(DataType_String, du);
+  return OperandConstant((index < 0) ? getStringDefaultValue() : (size_t)index);
+}
+
+Operand OperandBool(bool b)
+{
+  Operand o = {.type = Operand_Bool};
+  o.d.b = b;
+  return o;
+}
+
+Operand OperandLabel(const char * label)
+{
+  Operand o = {.type = Operand_Label};
+  o.d.label = atomInsert(label);
+  return o;
+}
+
+Operand OperandDataType(DataType dt)
+{
+  Operand o = {.type = Operand_Type};
+  o.d.dt = dt;
+  return o;
+}
+
+Operand OperandText(const char * text)
+{
+  Operand o = {.type = Operand_Text};
+  o.d.text = atomInsert(text);
+  return o;
+}
+
+bool OperandEquals(const Operand * a, const Operand * b)
+{
+  if(a->type != b->type) return false;
+  switch(a->type)
+  {
+    case Operand_None: return true;
+    case Operand_Variable: return a->d.var.name == b->d.var.name;
+    case Operand_Constant: return a->d.index == b->d.index;
+    case Operand_Bool: return a->d.b == b->d.b;
+    case Operand_Label: return a->d.label == b->d.label;
+    case Operand_Type: return a->d.dt == b->d.dt;
+    case Operand_Text: return a->d.text == b->d.text;
+    default: return false;
+  }
+}
+
+/*------------------------------ UNITS ----------------------------------*/
+
+/*----------- DATA ------------*/
+static struct {
+  CodeUnit ** all;        //all the units (also only called ones)
+  size_t all_count;       //number of all the units
+  CodeUnit ** arr;        //started units in order of start
+  size_t count;           //number of started units
+  size_t arr_size;        //allocated units (in both arrays)
+  CodeUnit ** index;      //hash index by name (atom pointer)
+  size_t index_size;      //size of the index, power of two
+  CodeUnit * current;     //unit being generated
+} units = {NULL, 0, NULL, 0, 0, NULL, 0, NULL};
+/*-----------------------------*/
+
+/**
+ * @brief   Slot of the unit in the index.
+ *
+ * @param name    Name of the function (atom).
+ * @returns Slot (empty, or with the unit).
+ */
+static CodeUnit ** IndexSlot(const char * name)
+{
+  size_t h = ((size_t)name >> 4) * 0x9e3779b9U;
+  for(size_t i = h & (units.index_size - 1); ; i = (i + 1) & (units.index_size - 1))
+  {
+    if(units.index[i] == NULL || units.index[i]->name == name) return &units.index[i];
+  }
+}
+
+/**
+ * @brief   Returns unit of the function, creates it if needed.
+ *
+ * @param name    Name of the function (atom), NULL for prologue.
+ * @returns Unit, or NULL, if allocation fails.
+ */
+static CodeUnit * GetUnit(const char * name)
+{
+  // lookup
+  if(name != NULL && units.index_size != 0)
+  {
+    CodeUnit * u = *IndexSlot(name);
+    if(u != NULL) return u;
+  }
+
+  // resize
+  if(units.all_count == units.arr_size)
+  {
+    size_t newsize = (units.arr_size == 0) ? STARTING_CHUNK_UNITS : 2*units.arr_size;
+    CodeUnit ** all = realloc(units.all, newsize * sizeof(CodeUnit *));
+    if(all != NULL) units.all = all;
+    CodeUnit ** arr = realloc(units.arr, newsize * sizeof(CodeUnit *));
+    if(arr != NULL) units.arr = arr;
+    CodeUnit ** index = calloc(2*newsize, sizeof(CodeUnit *));
+    if(all == NULL || arr == NULL || index == NULL) { free(index); return NULL; }
+
+    free(units.index);
+    units.index = index;
+    units.index_size = 2*newsize;
+    units.arr_size = newsize;
+    for(size_t i = 0; i < units.all_count; i++)
+      if(units.all[i]->name != NULL) *IndexSlot(units.all[i]->name) = units.all[i];
+  }
+
+  // new unit
+  CodeUnit * u = calloc(1, sizeof(CodeUnit));
+  if(u == NULL) return NULL;
+  u->name = name;
+  units.all[units.all_count++] = u;
+  if(name != NULL) *IndexSlot(name) = u;
+
+  return u;
+}
+
+bool CodeBeginUnit(const char * name)
+{
+  #ifdef GENERATOR_DEBUG
+    debug("Begin unit %s.", (name != NULL)?name:"prologue");
+  #endif
+
+  const char * atom = NULL;
+  if(name != NULL && (atom = atomInsert(name)) == NULL) return false;
+
+  CodeUnit * u = GetUnit(atom);
+  if(u == NULL) return false;
+
+  // units are printed as they are started
+  if(!u->started)
+  {
+    u->started = true;
+    units.arr[units.count++] = u;
+  }
+
+  units.current = u;
+  return true;
+}
+
+bool CodeAppend(CodeUnit * u, const Instruction * ins)
+{
+  if(u->count == u->capacity)
+  {
+    size_t newsize = (u->capacity == 0) ? STARTING_CHUNK_CODE : 2*u->capacity;
+    Instruction * code = realloc(u->code, newsize * sizeof(Instruction));
+    if(code == NULL)
+    {
+      setErrorType(ErrorType_Internal);
+      setErrorMessage("Code: could not allocate memory");
+      return false;
+    }
+    u->code = code;
+    u->capacity = newsize;
+  }
+
+  u->code[u->count++] = *ins;
+  return true;
+}
+
+bool CodeInsert(CodeUnit * u, size_t index, const Instruction * ins)
+{
+  if(index > u->count) index = u->count;
+
+  // append and move into the place
+  if(!CodeAppend(u, ins)) return false;
+  memmove(&u->code[index + 1], &u->code[index], (u->count - 1 - index) * sizeof(Instruction));
+  u->code[index] = *ins;
+  return true;
+}
+
+bool Code(Opcode op, ...)
+{
+  CodeUnit * u = units.current;
+  if(u == NULL) return false;
+
+  Instruction ins;
+  ins.op = op;
+
+  va_list args;
+  va_start(args, op);
+  unsigned i = 0;
+  for(; i < OpcodeArity(op); i++) ins.arg[i] = va_arg(args, Operand);
+  for(; i < CODE_MAX_OPERANDS; i++) ins.arg[i].type = Operand_None;
+  va_end(args);
+
+  return CodeAppend(u, &ins);
+}
+
+/**
+ * @brief   Adds callee into the unit.
+ *
+ * @param u       Calling unit.
+ * @param to      Name of the called function (atom).
+ * @returns True, if success. False otherwise.
+ */
+static bool AddCall(CodeUnit * u, const char * to)
+{
+  // already recorded
+  for(size_t i = 0; i < u->calls_count; i++)
+    if(u->calls[i] == to) return true;
+
+  if(u->calls_count == u->calls_capacity)
+  {
+    size_t newsize = (u->calls_capacity == 0) ? STARTING_CHUNK_CALLS : 2*u->calls_capacity;
+    const char ** calls = realloc((void *)u->calls, newsize * sizeof(const char *));
+    if(calls == NULL) return false;
+    u->calls = calls;
+    u->calls_capacity = newsize;
+  }
+  u->calls[u->calls_count++] = to;
+
+  return true;
+}
+
+bool AddCallEdge(const char * caller, const char * callee)
+{
+  #ifdef GENERATOR_DEBUG
+    debug("Call edge %s -> %s.", caller, callee);
+  #endif
+
+  const char * from = atomInsert(caller);
+  const char * to = atomInsert(callee);
+  if(from == NULL || to == NULL) return false;
+
+  CodeUnit * u = GetUnit(from);
+  if(u == NULL) return false;
+
+  return AddCall(u, to);
+}
+
+bool CodeRebuildCalls(CodeUnit * u)
+{
+  u->calls_count = 0;
+  for(size_t i = 0; i < u->count; i++)
+  {
+    if(u->code[i].op != Opcode_Call) continue;
+    if(!AddCall(u, u->code[i].arg[0].d.label)) return false;
+  }
+  return true;
+}
+
+size_t CodeUnitCount() { return units.count; }
+CodeUnit * CodeGetUnit(size_t i) { return (i < units.count) ? units.arr[i] : NULL; }
+CodeUnit * CodeCurrentUnit() { return units.current; }
+
+CodeUnit * CodeFindUnit(const char * name)
+{
+  if(name == NULL || units.index_size == 0) return NULL;
+  const char * atom = atomInsert(name);
+  if(atom == NULL) return NULL;
+  return *IndexSlot(atom);
+}
+
+/*---------------------------- REACHABILITY -----------------------------*/
+
+/**
+ * @brief   Marks units reachable from prologue and scope.
+ *
+ * Graph of calls is walked with an explicit stack.
+ * @returns True, if success. False otherwise.
+ */
+static bool MarkReachable()
+{
+  CodeUnit ** stack = malloc((units.all_count + 1) * sizeof(CodeUnit *));
+  if(stack == NULL) return false;
+  size_t top = 0;
+
+  // roots
+  for(size_t i = 0; i < units.all_count; i++)
+  {
+    CodeUnit * u = units.all[i];
+    u->reachable = false;
+    if(u->name == NULL || !strcmp(u->name, "scope")) stack[top++] = u;
+  }
+  for(size_t i = 0; i < top; i++) stack[i]->reachable = true;
+
+  // depth first search
+  while(top > 0)
+  {
+    CodeUnit * u = stack[--top];
+    for(size_t i = 0; i < u->calls_count; i++)
+    {
+      CodeUnit * callee = *IndexSlot(u->calls[i]);
+      if(callee == NULL || callee->reachable) continue;
+      callee->reachable = true;
+      stack[top++] = callee;
+    }
+  }
+
+  free(stack);
+  return true;
+}
+
+/*------------------------------ OUTPUT ---------------------------------*/
+
+const char * Operand2Str(const Operand * o)
+{
+  switch(o->type)
+  {
+    case Operand_Variable: return o->d.var.name;
+    case Operand_Constant: return getConstOperand(o->d.index);
+    case Operand_Bool: return o->d.b ? "bool@true" : "bool@false";
+    case Operand_Label: return o->d.label;
+    case Operand_Text: return o->d.text;
+    case Operand_Type:
+      if(o->d.dt == DataType_Integer) return "int";
+      else if(o->d.dt == DataType_Double) return "float";
+      else return "string";
+    default: return "";
+  }
+}
+
+/**
+ * @brief   Prints unit.
+ *
+ * @param u       Unit.
+ */
+static void PrintUnit(const CodeUnit * u)
+{
+  if(u->name != NULL && !minify()) putchar('\n');
+
+  for(size_t i = 0; i < u->count; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    if(ins->op == Opcode_Comment && minify()) continue;
+    fputs(Opcode2Str(ins->op), stdout);
+    for(unsigned j = 0; j < OpcodeArity(ins->op); j++)
+    {
+      putchar(' ');
+      fputs(Operand2Str(&ins->arg[j]), stdout);
+    }
+    putchar('\n');
+  }
+}
+
+size_t CodeBodyStart(const CodeUnit * u)
+{
+  if(u->name == NULL) return 0;
+
+  size_t i = 0;
+  while(i < u->count && u->code[i].op == Opcode_Comment) i++;
+  if(i + 1 >= u->count) return 0;
+  if(u->code[i].op != Opcode_Label || u->code[i].arg[0].d.label != u->name) return 0;
+  if(u->code[i+1].op != Opcode_PushFrame) return 0;
+  return i + 2;
+}
+
+size_t CodeInstructionCount(const CodeUnit * u)
+{
+  size_t n = 0;
+  for(size_t i = 0; i < u->count; i++)
+    if(u->code[i].op != Opcode_Comment) n++;
+  return n;
+}
+
+void PrintCode()
+{
+  #ifdef GENERATOR_DEBUG
+    debug("Print code.");
+  #endif
+
+  if(!MarkReachable())
+  {
+    setErrorType(ErrorType_Internal);
+    setErrorMessage("PrintCode: could not allocate memory");
+    return;
+  }
+
+  // header
+  bool c = (targetLanguage() == Target_C);
+  bool binary = !c && (emitFormat() == Emit_Binary);
+  bool text = !c && !binary;
+  if(!minify() && text)
+    fputs("\n"
+          "# Generated code\n"
+          "# IFJ\n"
+          "# xbenes49 xbolsh00 xpolan09\n"
+          "# 2017\n\n", stdout);
+  if(text) fputs(".IFJcode17\n", stdout);
+
+  size_t pruned_functions = 0, pruned_instructions = 0;
+  for(size_t i = 0; i < units.count; i++)
+  {
+    const CodeUnit * u = units.arr[i];
+    if(u->reachable && text) PrintUnit(u);
+    else if(!u->reachable && u->count > 0)
+    {
+      pruned_functions++;
+      pruned_instructions += CodeInstructionCount(u);
+    }
+  }
+  if(binary && !PrintBinaryCode())
+  {
+    setErrorType(ErrorType_Internal);
+    setErrorMessage("PrintCode: could not write binary code");
+  }
+  if(c && !PrintCSource())
+  {
+    setErrorType(ErrorType_Internal);
+    setErrorMessage("PrintCode: could not translate code to C");
+  }
+  fflush(stdout);
+
+  if(report())
+  {
+    fprintf(stderr, "Pruned functions: %zu\n", pruned_functions);
+    fprintf(stderr, "Pruned instructions: %zu\n", pruned_instructions);
+  }
+}
+
+void ClearCode()
+{
+  for(size_t i = 0; i < units.all_count; i++)
+  {
+    free(units.all[i]->code);
+    free((void *)units.all[i]->calls);
+    free(units.all[i]);
+  }
+  free(units.all);
+  free(units.arr);
+  free(units.index);
+
+  units.all = NULL;
+  units.all_count = 0;
+  units.arr = NULL;
+  units.count = 0;
+  units.arr_size = 0;
+  units.index = NULL;
+  units.index_size = 0;
+  units.current = NULL;
+}
@@ -0,0 +1,409 @@
+/**
+ * @file code.h
+ * @interface code
+ * @date 18th october 2026
+ * @brief Code interface.
+ *
+ * This interface declares inner representation of generated code.
+ * Instructions of IFJcode17 are buffered in units (one per function)
+ * and printed at the end of compilation, so only the functions
+ * reachable from scope are emitted.
+ */
+
+#ifndef CODE_H
+#define CODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+/*-----------------------------------------------------------*/
+/** @addtogroup Code_types
+ * Types of the code.
+ * @{
+ */
+
+/**
+ * @brief   Instructions of IFJcode17.
+ */
+typedef enum
+{
+  // frames, calls
+  Opcode_Move, Opcode_CreateFrame, Opcode_PushFrame, Opcode_PopFrame,
+  Opcode_Defvar, Opcode_Call, Opcode_Return,
+  // data stack
+  Opcode_Pushs, Opcode_Pops, Opcode_Clears,
+  // arithmetics, relations, logic
+  Opcode_Add, Opcode_Sub, Opcode_Mul, Opcode_Div,
+  Opcode_Adds, Opcode_Subs, Opcode_Muls, Opcode_Divs,
+  Opcode_Lt, Opcode_Gt, Opcode_Eq, Opcode_Lts, Opcode_Gts, Opcode_Eqs,
+  Opcode_And, Opcode_Or, Opcode_Not, Opcode_Ands, Opcode_Ors, Opcode_Nots,
+  // conversions
+  Opcode_Int2Float, Opcode_Float2Int, Opcode_Float2R2EInt, Opcode_Float2R2OInt,
+  Opcode_Int2Char, Opcode_Stri2Int,
+  Opcode_Int2Floats, Opcode_Float2Ints, Opcode_Float2R2EInts, Opcode_Float2R2OInts,
+  Opcode_Int2Chars, Opcode_Stri2Ints,
+  // input, output
+  Opcode_Read, Opcode_Write,
+  // strings
+  Opcode_Concat, Opcode_Strlen, Opcode_Getchar, Opcode_Setchar,
+  // types
+  Opcode_Type,
+  // jumps
+  Opcode_Label, Opcode_Jump, Opcode_JumpIfEq, Opcode_JumpIfNeq,
+  Opcode_JumpIfEqs, Opcode_JumpIfNeqs,
+  // debug
+  Opcode_Break, Opcode_Dprint,
+  // comment (not an instruction)
+  Opcode_Comment,
+
+  Opcode_Count    /**< Number of opcodes. */
+} Opcode;
+
+/**
+ * @brief   Frames of IFJcode17.
+ */
+typedef enum
+{
+  Frame_Global,       /**< GF. */
+  Frame_Local,        /**< LF. */
+  Frame_Temporary     /**< TF. */
+} Frame;
+
+/**
+ * @brief   Types of operands.
+ */
+typedef enum
+{
+  Operand_None,       /**< No operand. */
+  Operand_Variable,   /**< Variable (LF@x). */
+  Operand_Constant,   /**< Constant from the table of constants. */
+  Operand_Bool,       /**< Boolean constant (bool@true). */
+  Operand_Label,      /**< Label. */
+  Operand_Type,       /**< Type (READ). */
+  Operand_Text        /**< Text of a comment. */
+} OperandType;
+
+/**
+ * @brief   Operand of an instruction.
+ *
+ * Names are atoms (see atomInsert()), so they are compared by pointers.
+ * Name of a variable contains its frame ("LF@x").
+ */
+typedef struct
+{
+  OperandType type;             /**< Type of operand. */
+  union {
+    struct {
+      Frame frame;              /**< Frame. */
+      const char * name;        /**< Operand text with frame (atom). */
+    } var;                      /**< Variable. */
+    size_t index;               /**< Index into the table of constants. */
+    bool b;                     /**< Boolean. */
+    const char * label;         /**< Label (atom). */
+    DataType dt;                /**< Type. */
+    const char * text;          /**< Comment (atom). */
+  } d;                          /**< Data. */
+} Operand;
+
+/** @brief Maximal number of operands of an instruction. */
+#define CODE_MAX_OPERANDS 3
+
+/**
+ * @brief   Instruction with operands.
+ */
+typedef struct
+{
+  Opcode op;                          /**< Instruction. */
+  Operand arg[CODE_MAX_OPERANDS];     /**< Operands. */
+} Instruction;
+
+/**
+ * @brief   Unit of code.
+ *
+ * Code of one function (or of the prologue, or of scope)
+ * together with the names of called functions.
+ */
+typedef struct
+{
+  const char * name;          /**< Name of the function (atom), NULL for prologue. */
+  Instruction * code;         /**< Instructions. */
+  size_t count;               /**< Number of instructions. */
+  size_t capacity;            /**< Allocated instructions. */
+  const char ** calls;        /**< Called functions (atoms). */
+  size_t calls_count;         /**< Number of calls. */
+  size_t calls_capacity;      /**< Allocated calls. */
+  bool started;               /**< Code of the unit was started. */
+  bool reachable;             /**< Reachable from scope. */
+  unsigned inlined;           /**< Number of call sites the function was inlined into. */
+  size_t stack_depth;         /**< Maximal depth of the data stack (verified). */
+} CodeUnit;
+
+/** @} */
+/*-----------------------------------------------------------*/
+/** @addtogroup Code_operands
+ * Operand constructors.
+ * @{
+ */
+
+/** @brief Variable of given frame and name. */
+Operand OperandVariable(Frame frame, const char * name);
+
+/** @brief Variable from its operand text ("LF@x"), which is an atom. */
+Operand OperandVariableText(const char * text);
+
+/** @brief Constant on index in the table of constants. */
+Operand OperandConstant(size_t index);
+
+/** @brief Integer constant. */
+Operand OperandInt(int i);
+
+/** @brief Float constant. */
+Operand OperandFloat(double d);
+
+/** @brief String constant (already in IFJcode17 escaped form). */
+Operand OperandString(const char * str);
+
+/** @brief Boolean constant. */
+Operand OperandBool(bool b);
+
+/** @brief Label. */
+Operand OperandLabel(const char * label);
+
+/** @brief Type. */
+Operand OperandDataType(DataType dt);
+
+/** @brief Text of a comment. */
+Operand OperandText(const char * text);
+
+/**
+ * @brief   Compares operands.
+ *
+ * @param a       First operand.
+ * @param b       Second operand.
+ * @returns True, if same. False otherwise.
+ */
+bool OperandEquals(const Operand * a, const Operand * b);
+
+/**
+ * @brief   Operand text.
+ *
+ * @param o       Operand.
+ * @returns Operand in IFJcode17.
+ */
+const char * Operand2Str(const Operand * o);
+
+/** @} */
+/*-----------------------------------------------------------*/
+/** @addtogroup Code_main
+ * Code functions.
+ * @{
+ */
+
+/**
+ * @brief   Instruction name.
+ *
+ * @param op      Opcode.
+ * @returns Name of the instruction in IFJcode17.
+ */
+const char * Opcode2Str(Opcode op);
+
+/**
+ * @brief   Number of operands of the instruction.
+ *
+ * @param op      Opcode.
+ * @returns Number of operands.
+ */
+unsigned OpcodeArity(Opcode op);
+
+/**
+ * @brief   Instruction writes its first operand.
+ *
+ * @param op      Opcode.
+ * @returns True, if the first operand is written. False otherwise.
+ */
+bool OpcodeWrites(Opcode op);
+
+/**
+ * @brief   Number of values popped from the data stack.
+ *
+ * CLEARS is not counted, it empties the whole stack.
+ * @param op      Opcode.
+ * @returns Number of popped values.
+ */
+unsigned OpcodeStackPops(Opcode op);
+
+/**
+ * @brief   Number of values pushed onto the data stack.
+ *
+ * @param op      Opcode.
+ * @returns Number of pushed values.
+ */
+unsigned OpcodeStackPushes(Opcode op);
+
+/**
+ * @brief   Pure instruction.
+ *
+ * Instruction only computes its result (into the first operand,
+ * or onto the data stack) and it cannot fail on typed operands.
+ * @param op      Opcode.
+ * @returns True, if pure. False otherwise.
+ */
+bool OpcodeIsPure(Opcode op);
+
+/**
+ * @brief   Three-address form of a stack instruction.
+ *
+ * @param op      Opcode.
+ * @returns Three-address instruction (ADDS gives ADD), or op, if none.
+ */
+Opcode OpcodeThreeAddress(Opcode op);
+
+/**
+ * @brief   Jump instruction.
+ *
+ * @param op      Opcode.
+ * @returns True, if conditional or unconditional jump. False otherwise.
+ */
+bool OpcodeIsJump(Opcode op);
+
+/**
+ * @brief   Conditional jump instruction.
+ *
+ * @param op      Opcode.
+ * @returns True, if conditional jump. False otherwise.
+ */
+bool OpcodeIsConditionalJump(Opcode op);
+
+/**
+ * @brief   Conditional jump with negated condition.
+ *
+ * @param op      Opcode.
+ * @returns Negated conditional jump, or op, if not a conditional jump.
+ */
+Opcode OpcodeInvertJump(Opcode op);
+
+/**
+ * @brief   Starts new unit.
+ *
+ * Following instructions are saved into the unit of the function.
+ * @param name    Name of the function, NULL for prologue.
+ * @returns True, if success. False otherwise.
+ */
+bool CodeBeginUnit(const char * name);
+
+/**
+ * @brief   Adds instruction.
+ *
+ * This function appends instruction into current unit. Number
+ * of operands (of type Operand) is given by the opcode.
+ * @param op      Opcode.
+ * @returns True, if success. False otherwise.
+ */
+bool Code(Opcode op, ...);
+
+/**
+ * @brief   Appends instruction into the unit.
+ *
+ * @param u       Unit.
+ * @param ins     Instruction.
+ * @returns True, if success. False otherwise.
+ */
+bool CodeAppend(CodeUnit * u, const Instruction * ins);
+
+/**
+ * @brief   Inserts instruction into the unit.
+ *
+ * @param u       Unit.
+ * @param index   Index of the new instruction.
+ * @param ins     Instruction.
+ * @returns True, if success. False otherwise.
+ */
+bool CodeInsert(CodeUnit * u, size_t index, const Instruction * ins);
+
+/**
+ * @brief   Beginning of the body of a function.
+ *
+ * Body of a function follows its label and PUSHFRAME.
+ * @param u       Unit of the function.
+ * @returns Index of the first instruction of the body, or 0, if not a function.
+ */
+size_t CodeBodyStart(const CodeUnit * u);
+
+/**
+ * @brief   Number of instructions of the unit (comments excluded).
+ *
+ * @param u       Unit.
+ * @returns Number of instructions.
+ */
+size_t CodeInstructionCount(const CodeUnit * u);
+
+/**
+ * @brief   Recomputes called functions of the unit from its CALLs.
+ *
+ * Used after the code of the unit was changed.
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+bool CodeRebuildCalls(CodeUnit * u);
+
+/**
+ * @brief   Records call edge.
+ *
+ * @param caller  Name of the calling function.
+ * @param callee  Name of the called function.
+ * @returns True, if success. False otherwise.
+ */
+bool AddCallEdge(const char * caller, const char * callee);
+
+/**
+ * @brief   Number of units.
+ *
+ * @returns Number of units.
+ */
+size_t CodeUnitCount();
+
+/**
+ * @brief   Unit on the index.
+ *
+ * Units are ordered as they were started.
+ * @param i       Index.
+ * @returns Unit.
+ */
+CodeUnit * CodeGetUnit(size_t i);
+
+/**
+ * @brief   Unit being generated.
+ *
+ * @returns Unit, or NULL.
+ */
+CodeUnit * CodeCurrentUnit();
+
+/**
+ * @brief   Finds unit of a function.
+ *
+ * @param name    Name of the function.
+ * @returns Unit, or NULL.
+ */
+CodeUnit * CodeFindUnit(const char * name);
+
+/**
+ * @brief   Prints the code.
+ *
+ * This function marks the units reachable from prologue and scope
+ * and prints them to stdout, as text or in the binary format
+ * (see emitFormat()), or translated to C (see targetLanguage()).
+ * The others are pruned.
+ */
+void PrintCode();
+
+/**
+ * @brief   Destroys the code.
+ */
+void ClearCode();
+
+/** @} */
+/*-----------------------------------------------------------*/
+
+#endif // CODE_H
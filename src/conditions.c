@@ -0,0 +1,439 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "conditions.h"
+#include "config.h"
+#include "dataflow.h"
+#include "fold.h"
+#include "io.h"
+
+/*----------- DATA ------------*/
+static unsigned foldedConditions = 0;       /**< Number of resolved conditional jumps. */
+static unsigned foldedOperations = 0;       /**< Number of folded operations. */
+static unsigned removedInstructions = 0;    /**< Number of removed unreachable instructions. */
+static unsigned mergedWrites = 0;           /**< Number of writes merged into the preceding ones. */
+
+/** @brief Opcode of an instruction removed from the output (compacted at the end of a unit). */
+#define REMOVED Opcode_Count
+
+/**
+ * @brief   References of a label.
+ */
+typedef struct
+{
+  const char * label;     /**< Label (atom). */
+  size_t count;           /**< Number of jumps and calls referring to it. */
+} Reference;
+
+/**
+ * @brief   Value on the data stack.
+ */
+typedef struct
+{
+  Operand constant;       /**< Constant, or Operand_None. */
+  size_t at;              /**< Output PUSHS of the constant. */
+} Entry;
+
+/**
+ * @brief   State of the folding.
+ */
+typedef struct
+{
+  const Variables * vars;     /**< Local variables of the unit. */
+  Operand * known;            /**< Constants held by variables. */
+  unsigned * known_stamp;     /**< Constant of a variable is known, if its stamp is current. */
+  unsigned stamp;             /**< Current stamp. */
+  Entry * stack;              /**< Abstract data stack (above the values of unknown depth). */
+  size_t top, capacity;
+  Reference * refs;           /**< References of all the labels, sorted by address. */
+  size_t refs_count;
+  CodeUnit * out;             /**< Output code. */
+  bool dead;                  /**< Following instructions are unreachable. */
+  bool ok;                    /**< No allocation failed. */
+} Folding;
+
+/*------------------------------ REFERENCES ------------------------------------*/
+
+/**
+ * @brief   Compares references by addresses of their labels.
+ */
+static int CompareReferences(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)((const Reference *)a)->label;
+  uintptr_t y = (uintptr_t)((const Reference *)b)->label;
+  return (x > y) - (x < y);
+}
+
+/** @brief Label referred to by the instruction, or NULL. */
+static const char * Target(const Instruction * ins)
+{
+  return (OpcodeIsJump(ins->op) || ins->op == Opcode_Call) ? ins->arg[0].d.label : NULL;
+}
+
+/** @brief References of the label, or NULL. */
+static Reference * FindReference(Folding * F, const char * label)
+{
+  Reference key = {label, 0};
+  return bsearch(&key, F->refs, F->refs_count, sizeof(Reference), CompareReferences);
+}
+
+/**
+ * @brief   Counts references of labels in all the units.
+ *
+ * @returns True, if success. False otherwise.
+ */
+static bool CountReferences(Folding * F)
+{
+  size_t count = 0;
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    const CodeUnit * u = CodeGetUnit(i);
+    for(size_t j = 0; j < u->count; j++)
+      if(Target(&u->code[j]) != NULL) count++;
+  }
+  F->refs = malloc((count + 1) * sizeof(Reference));
+  if(F->refs == NULL) return false;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    const CodeUnit * u = CodeGetUnit(i);
+    for(size_t j = 0; j < u->count; j++)
+      if(Target(&u->code[j]) != NULL) F->refs[F->refs_count++] = (Reference){Target(&u->code[j]), 1};
+  }
+  qsort(F->refs, F->refs_count, sizeof(Reference), CompareReferences);
+
+  // merge
+  size_t n = 0;
+  for(size_t i = 0; i < F->refs_count; i++)
+  {
+    if(n > 0 && F->refs[n-1].label == F->refs[i].label) F->refs[n-1].count++;
+    else F->refs[n++] = F->refs[i];
+  }
+  F->refs_count = n;
+  return true;
+}
+
+/** @brief Removes a reference of the instruction. */
+static void Unreference(Folding * F, const Instruction * ins)
+{
+  const char * label = Target(ins);
+  Reference * r = (label != NULL) ? FindReference(F, label) : NULL;
+  if(r != NULL && r->count > 0) r->count--;
+}
+
+/*------------------------------ FOLDING ------------------------------------*/
+
+/** @brief Appends the instruction to the output. */
+static void Emit(Folding * F, const Instruction * ins)
+{
+  if(F->ok && !CodeAppend(F->out, ins)) F->ok = false;
+}
+
+/** @brief Pushes the entry. */
+static void Push(Folding * F, Operand constant, size_t at)
+{
+  if(F->top == F->capacity)
+  {
+    size_t capacity = (F->capacity == 0) ? 32 : 2 * F->capacity;
+    Entry * grown = realloc(F->stack, capacity * sizeof(Entry));
+    if(grown == NULL)
+    {
+      F->ok = false;
+      return;
+    }
+    F->stack = grown;
+    F->capacity = capacity;
+  }
+  F->stack[F->top++] = (Entry){constant, at};
+}
+
+/** @brief Pops the entry, values of unknown depth are not constant. */
+static Entry Pop(Folding * F)
+{
+  if(F->top == 0) return (Entry){.constant = {.type = Operand_None}};
+  return F->stack[--F->top];
+}
+
+/** @brief Constant held by the operand, or Operand_None. */
+static Operand Constant(Folding * F, const Operand * o)
+{
+  if(OperandIsConstant(o)) return *o;
+  size_t v = VariableIndex(F->vars, o);
+  if(v != CFG_NONE && F->known_stamp[v] == F->stamp) return F->known[v];
+  return (Operand){.type = Operand_None};
+}
+
+/** @brief Sets the constant of the written variable (Operand_None, if unknown). */
+static void SetVariable(Folding * F, const Operand * o, Operand constant)
+{
+  size_t v = VariableIndex(F->vars, o);
+  if(v == CFG_NONE) return;
+  F->known[v] = constant;
+  F->known_stamp[v] = (constant.type != Operand_None) ? F->stamp : F->stamp - 1;
+}
+
+/** @brief Forgets constants of variables and the data stack. */
+static void Forget(Folding * F)
+{
+  F->stamp++;
+  F->top = 0;
+}
+
+/**
+ * @brief   Resolves the conditional jump.
+ *
+ * @param ins     Jump with constant operands.
+ * @param taken   Jump is always taken.
+ */
+static void Resolve(Folding * F, const Instruction * ins, bool taken)
+{
+  foldedConditions++;
+  #ifdef OPTIMIZER_DEBUG
+    debug("Condition of %s %s resolved, %s.", Opcode2Str(ins->op), ins->arg[0].d.label, taken ? "taken" : "not taken");
+  #endif
+  if(!taken)
+  {
+    Unreference(F, ins);
+    return;
+  }
+  Instruction jump = {.op = Opcode_Jump, .arg = {ins->arg[0]}};
+  Emit(F, &jump);
+  F->dead = true;
+}
+
+/**
+ * @brief   Pure stack operation.
+ */
+static void StackOperation(Folding * F, const Instruction * ins)
+{
+  unsigned n = OpcodeStackPops(ins->op);
+  Entry e[2];
+  for(unsigned k = n; k-- > 0;) e[k] = Pop(F);
+
+  Operand result;
+  bool constant = e[0].constant.type != Operand_None && (n < 2 || e[1].constant.type != Operand_None);
+  if(constant && FoldOperation(ins->op, &e[0].constant, (n > 1) ? &e[1].constant : NULL, &result))
+  {
+    // operands are pushed by single instructions, anything between them leaves the stack as it was
+    foldedOperations++;
+    for(unsigned k = 0; k < n; k++) F->out->code[e[k].at].op = REMOVED;
+    Instruction push = {.op = Opcode_Pushs, .arg = {result}};
+    Emit(F, &push);
+    Push(F, result, F->out->count - 1);
+    return;
+  }
+  Emit(F, ins);
+  Push(F, (Operand){.type = Operand_None}, 0);
+}
+
+/**
+ * @brief   Three-address instruction writing a variable.
+ */
+static void ThreeAddressOperation(Folding * F, const Instruction * ins)
+{
+  unsigned arity = OpcodeArity(ins->op);
+  Operand a = Constant(F, &ins->arg[1]);
+  Operand b = (arity > 2) ? Constant(F, &ins->arg[2]) : (Operand){.type = Operand_None};
+
+  Operand result;
+  if(a.type != Operand_None && (arity < 3 || b.type != Operand_None)
+     && FoldOperation(ins->op, &a, (arity > 2) ? &b : NULL, &result))
+  {
+    if(ins->op != Opcode_Move) foldedOperations++;
+    Instruction move = {.op = Opcode_Move, .arg = {ins->arg[0], result}};
+    Emit(F, &move);
+    SetVariable(F, &ins->arg[0], result);
+    return;
+  }
+  Emit(F, ins);
+  SetVariable(F, &ins->arg[0], (Operand){.type = Operand_None});
+}
+
+/**
+ * @brief   Folds the instruction.
+ */
+static void Step(Folding * F, const Instruction * orig)
+{
+  Instruction ins = *orig;
+
+  if(F->dead)
+  {
+    const Reference * r = (ins.op == Opcode_Label) ? FindReference(F, ins.arg[0].d.label) : NULL;
+    if(r != NULL && r->count > 0) F->dead = false;
+    else
+    {
+      // definitions are hoisted to the beginning of the unit later
+      if(ins.op == Opcode_Defvar && ins.arg[0].type == Operand_Variable && ins.arg[0].d.var.frame == Frame_Local) Emit(F, &ins);
+      else if(ins.op != Opcode_Comment)
+      {
+        removedInstructions++;
+        Unreference(F, &ins);
+      }
+      return;
+    }
+  }
+
+  Operand a, b;
+  bool taken;
+  switch(ins.op)
+  {
+    case Opcode_Label:
+      Forget(F);
+      Emit(F, &ins);
+      return;
+
+    case Opcode_Pushs:
+      a = Constant(F, &ins.arg[0]);
+      if(a.type != Operand_None) ins.arg[0] = a;
+      Emit(F, &ins);
+      Push(F, a, F->out->count - 1);
+      return;
+
+    case Opcode_Pops:
+      SetVariable(F, &ins.arg[0], Pop(F).constant);
+      Emit(F, &ins);
+      return;
+
+    case Opcode_JumpIfEqs: case Opcode_JumpIfNeqs:
+    {
+      Entry y = Pop(F), x = Pop(F);
+      if(x.constant.type != Operand_None && y.constant.type != Operand_None
+         && FoldJump(ins.op, &x.constant, &y.constant, &taken))
+      {
+        F->out->code[x.at].op = REMOVED;
+        F->out->code[y.at].op = REMOVED;
+        Resolve(F, &ins, taken);
+        return;
+      }
+      Emit(F, &ins);
+      // values below are expected by the target
+      F->top = 0;
+      return;
+    }
+
+    case Opcode_JumpIfEq: case Opcode_JumpIfNeq:
+      a = Constant(F, &ins.arg[1]);
+      b = Constant(F, &ins.arg[2]);
+      if(a.type != Operand_None && b.type != Operand_None && FoldJump(ins.op, &a, &b, &taken))
+      {
+        Resolve(F, &ins, taken);
+        return;
+      }
+      Emit(F, &ins);
+      F->top = 0;
+      return;
+
+    case Opcode_Write:
+      a = Constant(F, &ins.arg[0]);
+      if(a.type != Operand_None)
+      {
+        // constant output is merged into the preceding one
+        Instruction * last = (F->out->count > 0) ? &F->out->code[F->out->count - 1] : NULL;
+        if(last != NULL && last->op == Opcode_Write && FoldWrite(&last->arg[0], &a, &b))
+        {
+          last->arg[0] = b;
+          mergedWrites++;
+          return;
+        }
+        ins.arg[0] = a;
+      }
+      Emit(F, &ins);
+      return;
+
+    case Opcode_Jump: case Opcode_Return:
+      Emit(F, &ins);
+      F->dead = true;
+      return;
+
+    case Opcode_Call: case Opcode_PushFrame: case Opcode_PopFrame: case Opcode_Clears:
+      // another local frame, or the data stack changed
+      Forget(F);
+      Emit(F, &ins);
+      return;
+
+    default:
+      break;
+  }
+
+  if(OpcodeArity(ins.op) == 0 && OpcodeStackPushes(ins.op) == 1 && OpcodeStackPops(ins.op) <= 2) StackOperation(F, &ins);
+  else if(OpcodeWrites(ins.op) && OpcodeArity(ins.op) >= 2 && ins.op != Opcode_Read && ins.op != Opcode_Setchar
+          && ins.op != Opcode_Type) ThreeAddressOperation(F, &ins);
+  else
+  {
+    Emit(F, &ins);
+    if(OpcodeWrites(ins.op)) SetVariable(F, &ins.arg[0], (Operand){.type = Operand_None});
+  }
+}
+
+/**
+ * @brief   Eliminates constant conditions of the unit.
+ *
+ * @param F       Folding with counted references.
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool EliminateUnit(Folding * F, CodeUnit * u)
+{
+  Variables vars;
+  if(!VariablesCollect(&vars, u)) return false;
+
+  CodeUnit result = {0};
+  F->vars = &vars;
+  F->known = malloc((vars.count + 1) * sizeof(Operand));
+  F->known_stamp = calloc(vars.count + 1, sizeof(unsigned));
+  F->stamp = 1;
+  F->top = 0;
+  F->out = &result;
+  F->dead = false;
+  F->ok = (F->known != NULL && F->known_stamp != NULL);
+
+  for(size_t i = 0; F->ok && i < u->count; i++) Step(F, &u->code[i]);
+
+  bool ok = F->ok;
+  free(F->known);
+  free(F->known_stamp);
+  VariablesFree(&vars);
+  if(!ok)
+  {
+    free(result.code);
+    return false;
+  }
+
+  size_t n = 0;
+  for(size_t i = 0; i < result.count; i++)
+    if(result.code[i].op != REMOVED) result.code[n++] = result.code[i];
+  result.count = n;
+
+  free(u->code);
+  u->code = result.code;
+  u->count = result.count;
+  u->capacity = result.capacity;
+  return CodeRebuildCalls(u);
+}
+
+bool EliminateConstantConditions()
+{
+  unsigned conditions = foldedConditions, operations = foldedOperations, removed = removedInstructions;
+  unsigned writes = mergedWrites;
+
+  Folding F = {.ok = true};
+  bool ok = CountReferences(&F);
+  for(size_t i = 0; ok && i < CodeUnitCount(); i++) ok = EliminateUnit(&F, CodeGetUnit(i));
+  free(F.refs);
+  free(F.stack);
+  if(!ok) return false;
+
+  if(report())
+  {
+    fprintf(stderr, "Folded constant conditions: %u\n", foldedConditions - conditions);
+    fprintf(stderr, "Folded constant operations: %u\n", foldedOperations - operations);
+    fprintf(stderr, "Removed unreachable instructions: %u\n", removedInstructions - removed);
+    fprintf(stderr, "Merged writes: %u\n", mergedWrites - writes);
+  }
+  return true;
+}
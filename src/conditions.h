@@ -0,0 +1,29 @@
+/**
+ * @file conditions.h
+ * @interface conditions
+ * @date 19th october 2026
+ * @brief Constant condition elimination interface.
+ *
+ * This interface declares resolving of constant conditions at compile time
+ * and removal of unreachable instructions.
+ */
+
+#ifndef CONDITIONS_H
+#define CONDITIONS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Eliminates constant conditions.
+ *
+ * Operations on constants (and on variables holding constants
+ * in the same basic block) are folded. Conditional jumps with constant
+ * operands become unconditional jumps, or are removed. Writes
+ * of constants are merged. Instructions
+ * after a jump or a return are removed up to the next label
+ * something refers to.
+ * @returns True, if success. False otherwise.
+ */
+bool EliminateConstantConditions();
+
+#endif // CONDITIONS_H
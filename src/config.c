@@ -1,4 +1,6 @@
 
+#include <string.h>
+
 #include "config.h"
 #include "io.h"
 #include "types.h"
@@ -13,6 +15,16 @@ void initConfig()
 {
 	d.help = false;
 	d.bypass = false;
+	d.report = false;
+	d.inline_limit = DEFAULT_INLINE_LIMIT;
+	d.dump_cfg = NULL;
+	d.opt_level = DEFAULT_OPT_LEVEL;
+	d.disabled_count = 0;
+	d.pass_report = false;
+	d.code_stats = CodeStats_None;
+	d.minify = false;
+	d.emit = Emit_Text;
+	d.target = Target_Ifjcode;
 }
 
 void printConfig()
@@ -20,8 +32,15 @@ void printConfig()
 	out("---Config---\n"
 			"help:   %d  \n"
 			"bypass: %d  \n"
+			"report: %d  \n"
+			"inline: %u  \n"
+			"dump cfg: %s\n"
+			"opt level: %u\n"
+			"disabled passes: %u\n"
+			"pass report: %d\n"
 			"function: %s\n"
-			"------------\n", ((d.help)?1:0), ((d.bypass)?1:0), mfunction);
+			"------------\n", ((d.help)?1:0), ((d.bypass)?1:0), ((d.report)?1:0), d.inline_limit,
+			((d.dump_cfg != NULL)?d.dump_cfg:"-"), d.opt_level, d.disabled_count, ((d.pass_report)?1:0), mfunction);
 }
 
 /*---------------------*/
@@ -45,3 +64,62 @@ void setBypass() { d.bypass = true; }
 bool bypass() { return d.bypass; }
 
 /*---------------------*/
+
+void setReport() { d.report = true; }
+bool report() { return d.report; }
+
+/*---------------------*/
+
+void setInlineLimit(unsigned limit) { d.inline_limit = limit; }
+unsigned inlineLimit() { return d.inline_limit; }
+
+/*---------------------*/
+
+void setDumpCfg(const char * path) { d.dump_cfg = path; }
+const char * dumpCfg() { return d.dump_cfg; }
+
+/*---------------------*/
+
+void setOptLevel(unsigned level) { d.opt_level = level; }
+unsigned optLevel() { return d.opt_level; }
+
+bool disablePass(const char * name)
+{
+	if(d.disabled_count == MAX_DISABLED_PASSES) return false;
+	d.disabled_passes[d.disabled_count++] = name;
+	return true;
+}
+
+bool passDisabled(const char * name)
+{
+	for(unsigned i = 0; i < d.disabled_count; i++)
+		if(!strcmp(d.disabled_passes[i], name)) return true;
+	return false;
+}
+
+/*---------------------*/
+
+void setPassReport() { d.pass_report = true; }
+bool passReport() { return d.pass_report; }
+
+/*---------------------*/
+
+void setCodeStats(CodeStats format) { d.code_stats = format; }
+CodeStats codeStats() { return d.code_stats; }
+
+/*---------------------*/
+
+void setMinify() { d.minify = true; }
+bool minify() { return d.minify; }
+
+/*---------------------*/
+
+void setEmitFormat(EmitFormat format) { d.emit = format; }
+EmitFormat emitFormat() { return d.emit; }
+
+/*---------------------*/
+
+void setTargetLanguage(TargetLanguage t) { d.target = t; }
+TargetLanguage targetLanguage() { return d.target; }
+
+/*---------------------*/
@@ -14,6 +14,8 @@
 
 #include <stdbool.h>
 
+#include "types.h"
+
 /*--------------------------- CONFIGURATION ----------------------------------*/
 /** @addtogroup Configuration.
  * Configuration functions.
@@ -108,6 +110,182 @@ void setBypass();
  */
 bool bypass();
 
+/*-------------- REPORT --------------*/
+/**
+ * @brief   Sets report flag.
+ *
+ * This function sets the inner report flag to true (defaultly false).
+ */
+void setReport();
+
+/**
+ * @brief   Report flag.
+ *
+ * This function returns, wheather the report flag is '1', or '0'.
+ * When set, statistics of optimizations are printed to stderr.
+ * @returns Status of report flag.
+ */
+bool report();
+
+/*-------------- INLINE --------------*/
+/** @brief Default size threshold of inlined functions. */
+#define DEFAULT_INLINE_LIMIT 20
+
+/**
+ * @brief   Sets inline limit.
+ *
+ * This function sets the size threshold of inlined functions
+ * (defaultly DEFAULT_INLINE_LIMIT). Zero disables inlining.
+ * @param limit       Maximal number of instructions of inlined function.
+ */
+void setInlineLimit(unsigned limit);
+
+/**
+ * @brief   Inline limit.
+ *
+ * @returns Maximal number of instructions of inlined function.
+ */
+unsigned inlineLimit();
+
+/*-------------- DUMP CFG --------------*/
+/**
+ * @brief   Sets file of the dumped control flow graph.
+ *
+ * This function sets the path, where the control flow graph
+ * of the generated code is written in Graphviz format (defaultly none).
+ * @param path        Path of the file.
+ */
+void setDumpCfg(const char * path);
+
+/**
+ * @brief   File of the dumped control flow graph.
+ *
+ * @returns Path of the file, or NULL, if not dumped.
+ */
+const char * dumpCfg();
+
+/*-------------- OPTIMIZATION --------------*/
+/** @brief Default optimization level. */
+#define DEFAULT_OPT_LEVEL 2
+
+/**
+ * @brief   Sets optimization level.
+ *
+ * This function sets the level of optimizations (defaultly DEFAULT_OPT_LEVEL).
+ * Zero disables all the optimization passes.
+ * @param level       Optimization level.
+ */
+void setOptLevel(unsigned level);
+
+/**
+ * @brief   Optimization level.
+ *
+ * @returns Optimization level.
+ */
+unsigned optLevel();
+
+/**
+ * @brief   Disables optimization pass.
+ *
+ * This function disables the pass regardless of the optimization level.
+ * The name is taken as it is.
+ * @param name        Name of the pass.
+ * @returns True, if success. False, if too many passes are disabled.
+ */
+bool disablePass(const char * name);
+
+/**
+ * @brief   Optimization pass is disabled.
+ *
+ * @param name        Name of the pass.
+ * @returns True, if disabled by disablePass(). False otherwise.
+ */
+bool passDisabled(const char * name);
+
+/*-------------- PASS REPORT --------------*/
+/**
+ * @brief   Sets pass report flag.
+ *
+ * This function sets the inner pass report flag to true (defaultly false).
+ */
+void setPassReport();
+
+/**
+ * @brief   Pass report flag.
+ *
+ * This function returns, wheather the pass report flag is '1', or '0'.
+ * When set, time and code size of each optimization pass are printed to stderr.
+ * @returns Status of pass report flag.
+ */
+bool passReport();
+
+/*-------------- CODE STATS --------------*/
+/**
+ * @brief   Sets format of code statistics.
+ *
+ * This function sets the format of the statistics of the generated code
+ * (defaultly CodeStats_None, no statistics).
+ * @param format      Format.
+ */
+void setCodeStats(CodeStats format);
+
+/**
+ * @brief   Format of code statistics.
+ *
+ * @returns Format, or CodeStats_None, if not written.
+ */
+CodeStats codeStats();
+
+/*-------------- MINIFY --------------*/
+/**
+ * @brief   Sets minify flag.
+ *
+ * This function sets the inner minify flag to true (defaultly false).
+ */
+void setMinify();
+
+/**
+ * @brief   Minify flag.
+ *
+ * This function returns, wheather the minify flag is '1', or '0'.
+ * When set, variables and labels get the shortest names and the code
+ * is printed without comments and empty lines.
+ * @returns Status of minify flag.
+ */
+bool minify();
+
+/*-------------- EMIT --------------*/
+/**
+ * @brief   Sets format of the generated code.
+ *
+ * This function sets the format of the printed code (defaultly Emit_Text).
+ * @param format      Format.
+ */
+void setEmitFormat(EmitFormat format);
+
+/**
+ * @brief   Format of the generated code.
+ *
+ * @returns Format of the printed code.
+ */
+EmitFormat emitFormat();
+
+/*-------------- TARGET --------------*/
+/**
+ * @brief   Sets target language of the generated code.
+ *
+ * This function sets the language of the printed code (defaultly Target_Ifjcode).
+ * @param t           Target.
+ */
+void setTargetLanguage(TargetLanguage t);
+
+/**
+ * @brief   Target language of the generated code.
+ *
+ * @returns Language of the printed code.
+ */
+TargetLanguage targetLanguage();
+
 /** @}*/
 /*-----------------------------------------------------------------------------*/
 
@@ -0,0 +1,648 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "config.h"
+#include "cse.h"
+#include "dataflow.h"
+#include "io.h"
+
+/*----------- DATA ------------*/
+static unsigned long valueCounter = 0;    /**< Number of temporaries of values (unique names). */
+static long eliminatedInstructions = 0;   /**< Number of eliminated instructions. */
+
+/** @brief Operation of a key of a constant. */
+#define VALUE_CONSTANT Opcode_Count
+
+/**
+ * @brief   Key of a computed value.
+ *
+ * Operation (three-address form) with value numbers of its operands,
+ * or a constant (type and data of the operand).
+ */
+typedef struct
+{
+  Opcode op;          /**< Operation, VALUE_CONSTANT for constants. */
+  size_t a;           /**< First operand. */
+  size_t b;           /**< Second operand, or CFG_NONE. */
+} Key;
+
+/**
+ * @brief   Numbered value.
+ */
+typedef struct
+{
+  Key key;            /**< Key of the value. */
+  bool computed;      /**< Value was computed in the block. */
+  size_t holder;      /**< Variable holding the value, or CFG_NONE. */
+  Operand temp;       /**< Temporary holding the value, or Operand_None. */
+  unsigned epoch;     /**< Frame epoch of the temporary. */
+  long benefit;       /**< Instructions saved by keeping the value in a temporary. */
+  bool materialize;   /**< Value is kept in a temporary. */
+} Value;
+
+/**
+ * @brief   Value on the data stack.
+ */
+typedef struct
+{
+  size_t vn;          /**< Value number. */
+  size_t start;       /**< First output instruction of its computation. */
+  bool pure;          /**< Computation has no side effects, it can be removed. */
+} Entry;
+
+/**
+ * @brief   State of the numbering.
+ */
+typedef struct
+{
+  const Variables * vars;         /**< Local variables of the unit. */
+  size_t * var_vn;                /**< Values of variables. */
+  unsigned * var_stamp;           /**< Variable value is known, if its stamp is current. */
+  unsigned stamp;                 /**< Current stamp. */
+  unsigned epoch;                 /**< Frame epoch, temporaries of older epochs are lost. */
+  Value * values;                 /**< Values. */
+  size_t count, capacity;
+  size_t pass_count;              /**< Number of values in the first pass. */
+  size_t * table;                 /**< Hash table of keyed values. */
+  unsigned * table_stamp;         /**< Slot is used, if its stamp is current. */
+  size_t table_size;
+  Entry * stack;                  /**< Abstract data stack. */
+  size_t top, stack_capacity;
+  CodeUnit * out;                 /**< Output code. */
+  bool rewrite;                   /**< Second pass, values are kept in temporaries. */
+  bool ok;                        /**< No allocation failed. */
+} Numbering;
+
+/*------------------------------ VALUES ------------------------------------*/
+
+/** @brief Hash of a key. */
+static size_t Hash(const Key * k)
+{
+  size_t h = (size_t)k->op * 0x9E3779B1u;
+  h = (h ^ k->a) * 0x85EBCA6Bu;
+  h = (h ^ k->b) * 0xC2B2AE35u;
+  return h ^ (h >> 15);
+}
+
+/** @brief Compares keys. */
+static bool KeyEquals(const Key * x, const Key * y) { return x->op == y->op && x->a == y->a && x->b == y->b; }
+
+/**
+ * @brief   Finds keyed value.
+ *
+ * @returns Value number, or CFG_NONE.
+ */
+static size_t Lookup(Numbering * N, const Key * k)
+{
+  for(size_t i = Hash(k) & (N->table_size - 1);; i = (i + 1) & (N->table_size - 1))
+  {
+    if(N->table_stamp[i] != N->stamp) return CFG_NONE;
+    if(KeyEquals(&N->values[N->table[i]].key, k)) return N->table[i];
+  }
+}
+
+/**
+ * @brief   Creates value.
+ *
+ * @param k       Key, or NULL for a fresh (unknown) value.
+ * @returns Value number.
+ */
+static size_t NewValue(Numbering * N, const Key * k)
+{
+  if(N->count == N->capacity)
+  {
+    size_t capacity = (N->capacity == 0) ? 64 : 2 * N->capacity;
+    Value * grown = realloc(N->values, capacity * sizeof(Value));
+    if(grown == NULL) { N->ok = false; return 0; }
+    N->values = grown;
+    N->capacity = capacity;
+  }
+  if(N->count * 2 >= N->table_size && k != NULL) { N->ok = false; return 0; }
+
+  size_t vn = N->count++;
+  bool materialize = N->rewrite && vn < N->pass_count && N->values[vn].benefit > 0;
+  Value * v = &N->values[vn];
+  *v = (Value){.key = {Opcode_Count, CFG_NONE, vn}, .holder = CFG_NONE, .materialize = materialize};
+  if(k == NULL) return vn;
+
+  v->key = *k;
+  size_t i = Hash(k) & (N->table_size - 1);
+  while(N->table_stamp[i] == N->stamp) i = (i + 1) & (N->table_size - 1);
+  N->table_stamp[i] = N->stamp;
+  N->table[i] = vn;
+  return vn;
+}
+
+/** @brief Value of the variable is known. */
+static bool Known(const Numbering * N, size_t v) { return N->var_stamp[v] == N->stamp; }
+
+/** @brief Variable holding the value is still valid. */
+static bool HolderValid(const Numbering * N, size_t vn)
+{
+  size_t h = N->values[vn].holder;
+  return h != CFG_NONE && Known(N, h) && N->var_vn[h] == vn;
+}
+
+/**
+ * @brief   Variable holding the value.
+ *
+ * @param h       Returned variable.
+ * @returns True, if some variable holds the value. False otherwise.
+ */
+static bool Holder(const Numbering * N, size_t vn, Operand * h)
+{
+  const Value * v = &N->values[vn];
+  if(HolderValid(N, vn))
+  {
+    *h = (Operand){.type = Operand_Variable};
+    h->d.var.frame = Frame_Local;
+    h->d.var.name = N->vars->names[v->holder];
+    return true;
+  }
+  if(v->temp.type == Operand_Variable && v->epoch == N->epoch)
+  {
+    *h = v->temp;
+    return true;
+  }
+  return false;
+}
+
+/** @brief Assigns value to the variable. */
+static void SetVariable(Numbering * N, size_t v, size_t vn)
+{
+  N->var_vn[v] = vn;
+  N->var_stamp[v] = N->stamp;
+  if(!HolderValid(N, vn)) N->values[vn].holder = v;
+}
+
+/**
+ * @brief   Value of the operand.
+ *
+ * Unknown variable gets a fresh value, which it holds.
+ * @returns Value number.
+ */
+static size_t OperandValue(Numbering * N, const Operand * o)
+{
+  if(o->type == Operand_Constant || o->type == Operand_Bool)
+  {
+    Key k = {VALUE_CONSTANT, o->type, (o->type == Operand_Constant) ? o->d.index : (size_t)o->d.b};
+    size_t vn = Lookup(N, &k);
+    return (vn != CFG_NONE) ? vn : NewValue(N, &k);
+  }
+
+  size_t v = VariableIndex(N->vars, o);
+  if(v == CFG_NONE) return NewValue(N, NULL);
+  if(!Known(N, v))
+  {
+    size_t vn = NewValue(N, NULL);
+    if(!N->ok) return 0;
+    SetVariable(N, v, vn);
+  }
+  return N->var_vn[v];
+}
+
+/**
+ * @brief   Replaces read copy by the variable holding its value.
+ */
+static void Propagate(Numbering * N, Operand * o)
+{
+  if(VariableIndex(N->vars, o) == CFG_NONE) return;
+  size_t vn = OperandValue(N, o);
+  Operand h;
+  if(N->ok && Holder(N, vn, &h)) *o = h;
+}
+
+/*------------------------------ STACK ------------------------------------*/
+
+/** @brief Pushes value onto the abstract stack. */
+static void Push(Numbering * N, size_t vn, size_t start, bool pure)
+{
+  if(N->top == N->stack_capacity)
+  {
+    size_t capacity = (N->stack_capacity == 0) ? 16 : 2 * N->stack_capacity;
+    Entry * grown = realloc(N->stack, capacity * sizeof(Entry));
+    if(grown == NULL) { N->ok = false; return; }
+    N->stack = grown;
+    N->stack_capacity = capacity;
+  }
+  N->stack[N->top++] = (Entry){vn, start, pure};
+}
+
+/** @brief Pops value from the abstract stack, unknown values come from other blocks. */
+static Entry Pop(Numbering * N)
+{
+  if(N->top > 0) return N->stack[--N->top];
+  return (Entry){NewValue(N, NULL), N->out->count, false};
+}
+
+/** @brief Instruction with side effect, computations on the stack cannot be removed. */
+static void Impure(Numbering * N)
+{
+  for(size_t i = 0; i < N->top; i++) N->stack[i].pure = false;
+}
+
+/** @brief Appends instruction to the output. */
+static void Emit(Numbering * N, const Instruction * ins)
+{
+  if(N->ok && !CodeAppend(N->out, ins)) N->ok = false;
+}
+
+/*------------------------------ NUMBERING ------------------------------------*/
+
+/**
+ * @brief   Stack operation on two pushed operands.
+ *
+ * @returns True, if it can be computed by its three-address form.
+ */
+static bool Convertible(const Numbering * N, Opcode op, const Entry * e, unsigned n)
+{
+  if(OpcodeThreeAddress(op) == op || !OpcodeIsPure(OpcodeThreeAddress(op))) return false;
+  for(unsigned k = 0; k < n; k++)
+    if(!e[k].pure || e[k].start != N->out->count - n + k || N->out->code[e[k].start].op != Opcode_Pushs) return false;
+  return true;
+}
+
+/**
+ * @brief   Keeps the computed value in a new temporary.
+ */
+static void Materialize(Numbering * N, const Instruction * ins, const Entry * e, unsigned n, size_t vn)
+{
+  char name[32];
+  sprintf(name, "%%c%lu", valueCounter++);
+  Operand t = OperandVariable(Frame_Local, name);
+  if(t.type == Operand_None) { N->ok = false; return; }
+
+  size_t start = (n > 0) ? e[0].start : N->out->count;
+  Instruction def = {.op = Opcode_Defvar, .arg = {t}};
+  Instruction push = {.op = Opcode_Pushs, .arg = {t}};
+  if(Convertible(N, ins->op, e, n))
+  {
+    Instruction compute = {.op = OpcodeThreeAddress(ins->op), .arg = {t}};
+    for(unsigned k = 0; k < n; k++) compute.arg[k+1] = N->out->code[e[k].start].arg[0];
+    N->out->count = start;
+    Emit(N, &def);
+    Emit(N, &compute);
+  }
+  else
+  {
+    Instruction pop = {.op = Opcode_Pops, .arg = {t}};
+    Emit(N, &def);
+    Emit(N, ins);
+    Emit(N, &pop);
+  }
+  Emit(N, &push);
+
+  N->values[vn].temp = t;
+  N->values[vn].epoch = N->epoch;
+  Impure(N);
+  Push(N, vn, start, false);
+}
+
+/**
+ * @brief   Generic instruction.
+ *
+ * Read copies are propagated, written variable and pushed values are unknown.
+ */
+static void Generic(Numbering * N, Instruction ins)
+{
+  for(unsigned a = 0; a < OpcodeArity(ins.op); a++)
+    if(InstructionReads(&ins, a) && !(a == 0 && OpcodeWrites(ins.op))) Propagate(N, &ins.arg[a]);
+
+  for(unsigned k = 0; k < OpcodeStackPops(ins.op); k++) Pop(N);
+  if(ins.op == Opcode_Clears || ins.op == Opcode_Call) N->top = 0;
+  if(ins.op == Opcode_PushFrame || ins.op == Opcode_PopFrame)
+  {
+    // another local frame
+    N->stamp++;
+    N->epoch++;
+  }
+
+  Emit(N, &ins);
+  Impure(N);
+  for(unsigned k = 0; k < OpcodeStackPushes(ins.op); k++) Push(N, NewValue(N, NULL), N->out->count - 1, false);
+
+  size_t v = OpcodeWrites(ins.op) ? VariableIndex(N->vars, &ins.arg[0]) : CFG_NONE;
+  if(v != CFG_NONE)
+  {
+    size_t vn = NewValue(N, NULL);
+    if(N->ok) SetVariable(N, v, vn);
+  }
+}
+
+/**
+ * @brief   Pure stack operation.
+ */
+static void StackOperation(Numbering * N, const Instruction * ins)
+{
+  unsigned n = OpcodeStackPops(ins->op);
+  if(N->top < n || n > 2)
+  {
+    Generic(N, *ins);
+    return;
+  }
+
+  Entry e[2] = {{0, 0, false}, {0, 0, false}};
+  for(unsigned k = n; k-- > 0;) e[k] = Pop(N);
+  bool pure = true;
+  for(unsigned k = 0; k < n; k++) pure = pure && e[k].pure;
+  size_t start = e[0].start;
+
+  Key key = {OpcodeThreeAddress(ins->op), e[0].vn, (n > 1) ? e[1].vn : CFG_NONE};
+  size_t vn = Lookup(N, &key);
+  if(vn != CFG_NONE && N->values[vn].computed)
+  {
+    Operand h;
+    if(pure && Holder(N, vn, &h))
+    {
+      // recomputation replaced by the variable
+      N->out->count = start;
+      Instruction push = {.op = Opcode_Pushs, .arg = {h}};
+      Emit(N, &push);
+      Push(N, vn, start, true);
+      return;
+    }
+    if(pure && !N->rewrite) N->values[vn].benefit += (long)(N->out->count - start);
+  }
+
+  if(vn == CFG_NONE) vn = NewValue(N, &key);
+  if(!N->ok) return;
+  if(!N->values[vn].computed)
+  {
+    N->values[vn].computed = true;
+    // temporary costs POPS and PUSHS, three-address form replaces the pushes of operands
+    if(!N->rewrite) N->values[vn].benefit = Convertible(N, ins->op, e, n) ? (long)(N->out->count - start) - 1 : -2;
+    else if(N->values[vn].materialize)
+    {
+      Materialize(N, ins, e, n, vn);
+      return;
+    }
+  }
+
+  Emit(N, ins);
+  Push(N, vn, start, pure);
+}
+
+/**
+ * @brief   Pure three-address operation writing a local variable.
+ */
+static void ThreeAddressOperation(Numbering * N, Instruction ins, size_t v)
+{
+  unsigned arity = OpcodeArity(ins.op);
+  Key key = {ins.op, OperandValue(N, &ins.arg[1]), CFG_NONE};
+  if(arity > 2) key.b = OperandValue(N, &ins.arg[2]);
+  if(!N->ok) return;
+
+  size_t vn = (ins.op == Opcode_Move) ? key.a : Lookup(N, &key);
+  if(vn != CFG_NONE && Known(N, v) && N->var_vn[v] == vn) return;   // already there
+
+  Operand h;
+  if(ins.op != Opcode_Move && vn != CFG_NONE && N->values[vn].computed && Holder(N, vn, &h))
+  {
+    ins = (Instruction){.op = Opcode_Move, .arg = {ins.arg[0], h}};
+    arity = 2;
+  }
+  else for(unsigned a = 1; a < arity; a++) Propagate(N, &ins.arg[a]);
+
+  if(vn == CFG_NONE) vn = NewValue(N, &key);
+  if(!N->ok) return;
+  if(key.op != Opcode_Move) N->values[vn].computed = true;
+
+  Emit(N, &ins);
+  Impure(N);
+  SetVariable(N, v, vn);
+}
+
+/**
+ * @brief   Numbers the instruction.
+ */
+static void Step(Numbering * N, const Instruction * orig)
+{
+  Instruction ins = *orig;
+  size_t v = (ins.op != Opcode_Defvar && OpcodeWrites(ins.op)) ? VariableIndex(N->vars, &ins.arg[0]) : CFG_NONE;
+
+  if(ins.op == Opcode_Pushs)
+  {
+    size_t vn = OperandValue(N, &ins.arg[0]);
+    Propagate(N, &ins.arg[0]);
+    Emit(N, &ins);
+    Push(N, vn, N->out->count - 1, true);
+  }
+  else if(ins.op == Opcode_Pops && v != CFG_NONE)
+  {
+    Entry e = Pop(N);
+    if(Known(N, v) && N->var_vn[v] == e.vn && e.pure)
+    {
+      // variable already holds the value
+      N->out->count = e.start;
+      return;
+    }
+    Emit(N, &ins);
+    Impure(N);
+    SetVariable(N, v, e.vn);
+  }
+  else if(OpcodeIsPure(ins.op) && OpcodeArity(ins.op) == 0) StackOperation(N, &ins);
+  else if(OpcodeIsPure(ins.op) && v != CFG_NONE) ThreeAddressOperation(N, ins, v);
+  else Generic(N, ins);
+}
+
+/**
+ * @brief   Numbers the block.
+ *
+ * @param N       Numbering.
+ * @param u       Unit.
+ * @param block   Block.
+ */
+static void NumberBlock(Numbering * N, const CodeUnit * u, const BasicBlock * block)
+{
+  // values and variables of other blocks are unknown
+  N->stamp++;
+  N->epoch++;
+  N->count = 0;
+  N->top = 0;
+  for(size_t i = block->start; N->ok && i < block->end; i++) Step(N, &u->code[i]);
+}
+
+/*------------------------------ DEAD STORES ------------------------------------*/
+
+/**
+ * @brief   Computation of the popped value.
+ *
+ * @param out     Code.
+ * @param from    First instruction of the block.
+ * @param i       Index of POPS.
+ * @param dead    Removed instructions.
+ * @returns First instruction of the pure computation, or CFG_NONE.
+ */
+static size_t Computation(const CodeUnit * out, size_t from, size_t i, const bool * dead)
+{
+  size_t need = 1;
+  while(need > 0 && i-- > from)
+  {
+    Opcode op = out->code[i].op;
+    if(dead[i - from]) return CFG_NONE;
+    if(op == Opcode_Pushs) need--;
+    else if(OpcodeIsPure(op) && OpcodeArity(op) == 0) need += OpcodeStackPops(op) - 1;
+    else return CFG_NONE;
+  }
+  return (need == 0) ? i : CFG_NONE;
+}
+
+/**
+ * @brief   Removes stores into variables, which are not read afterwards.
+ *
+ * @param out     Code.
+ * @param from    First instruction of the block.
+ * @param vars    Variables.
+ * @param live    Variables live at the end of the block (changed).
+ * @param dead    Scratch flags.
+ */
+static void RemoveDeadStores(CodeUnit * out, size_t from, const Variables * vars, uint64_t * live, bool * dead)
+{
+  memset(dead, 0, (out->count - from) * sizeof(bool));
+  for(size_t i = out->count; i-- > from;)
+  {
+    if(dead[i - from]) continue;
+    const Instruction * ins = &out->code[i];
+    size_t v = OpcodeWrites(ins->op) ? VariableIndex(vars, &ins->arg[0]) : CFG_NONE;
+
+    if(v != CFG_NONE && !BitTest(live, v))
+    {
+      size_t start = CFG_NONE;
+      if(ins->op == Opcode_Pops) start = Computation(out, from, i, dead);
+      else if(OpcodeIsPure(ins->op)) start = i;
+      if(start != CFG_NONE)
+      {
+        for(size_t k = start; k <= i; k++) dead[k - from] = true;
+        continue;
+      }
+    }
+
+    if(v != CFG_NONE && ins->op != Opcode_Setchar) BitClear(live, v);
+    for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+    {
+      size_t r = InstructionReads(ins, a) ? VariableIndex(vars, &ins->arg[a]) : CFG_NONE;
+      if(r != CFG_NONE) BitSet(live, r);
+    }
+  }
+
+  size_t n = from;
+  for(size_t i = from; i < out->count; i++)
+    if(!dead[i - from]) out->code[n++] = out->code[i];
+  out->count = n;
+}
+
+/*------------------------------ UNITS ------------------------------------*/
+
+/** @brief Number of instructions, which are executed (comments and definitions excluded). */
+static size_t Executed(const CodeUnit * u)
+{
+  size_t n = 0;
+  for(size_t i = 0; i < u->count; i++)
+    if(u->code[i].op != Opcode_Comment && u->code[i].op != Opcode_Defvar) n++;
+  return n;
+}
+
+/**
+ * @brief   Eliminates common subexpressions of the unit.
+ *
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool EliminateUnit(CodeUnit * u)
+{
+  Cfg cfg;
+  Variables vars;
+  Dataflow live;
+  if(!CfgBuild(&cfg, u)) return false;
+  if(cfg.count == 0) return true;
+  if(!VariablesCollect(&vars, u))
+  {
+    CfgFree(&cfg);
+    return false;
+  }
+  if(!Liveness(&live, &cfg, &vars))
+  {
+    VariablesFree(&vars);
+    CfgFree(&cfg);
+    return false;
+  }
+
+  Numbering N = {.vars = &vars, .ok = true};
+  CodeUnit result = {0}, scratch = {0};
+  N.table_size = 64;
+  while(N.table_size < 8 * (u->count + 1)) N.table_size *= 2;
+  N.table = malloc(N.table_size * sizeof(size_t));
+  N.table_stamp = calloc(N.table_size, sizeof(unsigned));
+  N.var_vn = malloc((vars.count + 1) * sizeof(size_t));
+  N.var_stamp = calloc(vars.count + 1, sizeof(unsigned));
+  uint64_t * set = malloc((vars.count / 64 + 1) * sizeof(uint64_t));
+  bool * dead = malloc((u->count + 1) * sizeof(bool));
+  N.ok = (N.table != NULL && N.table_stamp != NULL && N.var_vn != NULL && N.var_stamp != NULL && set != NULL && dead != NULL);
+
+  for(size_t b = 0; N.ok && b < cfg.count; b++)
+  {
+    // the first pass estimates, which values are worth keeping in temporaries
+    N.rewrite = false;
+    N.out = &scratch;
+    scratch.count = 0;
+    NumberBlock(&N, u, &cfg.blocks[b]);
+
+    N.rewrite = true;
+    N.pass_count = N.count;
+    N.out = &result;
+    size_t from = result.count;
+    NumberBlock(&N, u, &cfg.blocks[b]);
+
+    if(N.ok && live.solved)
+    {
+      memcpy(set, DataflowSet(&live, live.out, b), live.words * sizeof(uint64_t));
+      RemoveDeadStores(&result, from, &vars, set, dead);
+    }
+  }
+
+  bool ok = N.ok;
+  free(N.table);
+  free(N.table_stamp);
+  free(N.var_vn);
+  free(N.var_stamp);
+  free(N.values);
+  free(N.stack);
+  free(set);
+  free(dead);
+  free(scratch.code);
+  DataflowFree(&live);
+  VariablesFree(&vars);
+  CfgFree(&cfg);
+  if(!ok)
+  {
+    free(result.code);
+    return false;
+  }
+
+  long eliminated = (long)Executed(u) - (long)Executed(&result);
+  #ifdef OPTIMIZER_DEBUG
+    debug("Eliminated %ld instructions of %s.", eliminated, (u->name != NULL) ? u->name : "prologue");
+  #endif
+  eliminatedInstructions += eliminated;
+
+  free(u->code);
+  u->code = result.code;
+  u->count = result.count;
+  u->capacity = result.capacity;
+  return CodeRebuildCalls(u);
+}
+
+bool EliminateCommonSubexpressions()
+{
+  long eliminated = eliminatedInstructions;
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+    if(!EliminateUnit(CodeGetUnit(i))) return false;
+
+  if(report()) fprintf(stderr, "Value numbering eliminated instructions: %ld\n", eliminatedInstructions - eliminated);
+  return true;
+}
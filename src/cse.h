@@ -0,0 +1,27 @@
+/**
+ * @file cse.h
+ * @interface cse
+ * @date 19th october 2026
+ * @brief Common subexpression elimination interface.
+ *
+ * This interface declares local value numbering over basic blocks.
+ */
+
+#ifndef CSE_H
+#define CSE_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Eliminates common subexpressions.
+ *
+ * Values computed in each basic block are numbered. Recomputation
+ * of a value, which is held in a variable, is replaced by the variable,
+ * a value recomputed often enough is kept in a new temporary, reads
+ * of copies are replaced by the original variables and stores into
+ * variables, which are not read afterwards, are removed.
+ * @returns True, if success. False otherwise.
+ */
+bool EliminateCommonSubexpressions();
+
+#endif // CSE_H
@@ -0,0 +1,1564 @@
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "csource.h"
+#include "fold.h"
+#include "io.h"
+#include "list.h"
+#include "symtable.h"
+#include "tables.h"
+
+/**
+ * @brief   Types of values, bits of a set of types.
+ */
+typedef enum
+{
+  CType_Int = 1,        /**< int */
+  CType_Float = 2,      /**< double */
+  CType_Bool = 4,       /**< bool */
+  CType_String = 8      /**< Str * */
+} CType;
+
+/** @brief Set of types (CType bits), no bit is an undefined value. */
+typedef unsigned char Types;
+
+/** @brief Depth of a block not reached yet. */
+#define UNREACHED SIZE_MAX
+
+/**
+ * @brief   Translation of a unit.
+ *
+ * Variables written with one type only have the type in the whole unit,
+ * others (polymorphic) have their types in the state of each instruction,
+ * as the values on the data stack do.
+ */
+typedef struct
+{
+  CodeUnit * unit;
+  Cfg cfg;
+  const char ** names;      /**< Variables (atoms) sorted by address. */
+  size_t count;             /**< Number of variables. */
+  Types * types;            /**< Types written to each variable. */
+  Types * reads;            /**< Types read from each variable. */
+  size_t * poly;            /**< Index among polymorphic variables, or CFG_NONE. */
+  size_t poly_count;        /**< Number of polymorphic variables. */
+  size_t width;             /**< Capacity of the data stack. */
+  size_t * depths;          /**< Depth of the stack at each block, or UNREACHED. */
+  Types * entries;          /**< Types of the stack and of polymorphic variables at each block. */
+  Types * slots;            /**< Types pushed to each place of the stack. */
+  bool * jumped;            /**< Block is a target of a jump. */
+  Parameters params;        /**< Parameters of a function. */
+  const char ** locals;     /**< Parameters as variables ("LF@x" atoms). */
+  Types result;             /**< Returned type, 0 if not a function. */
+  bool changed;             /**< Types of variables changed. */
+  bool returns;             /**< Some return was printed. */
+  const char * failure;     /**< Reason, why the unit cannot be translated. */
+  size_t failed_at;         /**< Instruction of the failure. */
+} Translation;
+
+/*----------- DATA ------------*/
+static size_t * strings = NULL;     /**< Indices of used string constants, sorted. */
+static size_t strings_count = 0;    /**< Number of used string constants. */
+/*-----------------------------*/
+
+/*------------------------------ TYPES ------------------------------------*/
+
+/** @brief Set contains exactly one type. */
+static bool Single(Types t)
+{
+  return t != 0 && (t & (t - 1)) == 0;
+}
+
+/** @brief Type of the type of the symbol table. */
+static Types DataTypeType(DataType dt)
+{
+  switch(dt)
+  {
+    case DataType_Integer: return CType_Int;
+    case DataType_Double: return CType_Float;
+    case DataType_String: return CType_String;
+    default: return 0;
+  }
+}
+
+/** @brief Letter of the type in names. */
+static char TypeLetter(Types t)
+{
+  return (t == CType_Int) ? 'i' : (t == CType_Float) ? 'f' : (t == CType_Bool) ? 'b' : 's';
+}
+
+/** @brief Declaration of the type in C. */
+static const char * TypeName(Types t)
+{
+  return (t == CType_Int) ? "int" : (t == CType_Float) ? "double" : (t == CType_Bool) ? "bool" : "Str *";
+}
+
+/** @brief Name of the type in the runtime (rt_write_<name>). */
+static const char * TypeWord(Types t)
+{
+  return (t == CType_Int) ? "int" : (t == CType_Float) ? "float" : (t == CType_Bool) ? "bool" : "string";
+}
+
+/** @brief Zero value of the type. */
+static const char * TypeDefault(Types t)
+{
+  return (t == CType_Int) ? "0" : (t == CType_Float) ? "0.0" : (t == CType_Bool) ? "false" : "rt_empty()";
+}
+
+/*------------------------------ NAMES ------------------------------------*/
+
+/** @brief Writes the name as a C identifier (characters other than alphanumeric as _XX). */
+static void PrintMangled(const char * name)
+{
+  for(const unsigned char * c = (const unsigned char *)name; *c != '\0'; c++)
+  {
+    if((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9')) putchar(*c);
+    else printf("_%02X", *c);
+  }
+}
+
+/** @brief Writes the local of the variable ("LF@x") of the type. */
+static void PrintVariable(const char * name, Types t)
+{
+  printf("%c_", (name[0] == 'L') ? 'l' : (name[0] == 'T') ? 't' : 'g');
+  PrintMangled(name + 3);
+  printf("_%c", TypeLetter(t));
+}
+
+/** @brief Writes the place of the data stack of the type. */
+static void PrintSlot(size_t k, Types t)
+{
+  printf("s%zu%c", k, TypeLetter(t));
+}
+
+/** @brief Writes the C function of the unit. */
+static void PrintFunctionName(const char * name)
+{
+  printf("f_");
+  PrintMangled(name);
+}
+
+/** @brief Index of the string constant in K[]. */
+static size_t StringIndex(size_t index)
+{
+  size_t low = 0, high = strings_count;
+  while(low < high)
+  {
+    size_t middle = (low + high) / 2;
+    if(strings[middle] < index) low = middle + 1;
+    else high = middle;
+  }
+  return low;
+}
+
+/** @brief Writes the constant, the variable (of the type) or the boolean. */
+static void PrintSymbol(const Operand * o, Types t)
+{
+  if(o->type == Operand_Variable)
+  {
+    PrintVariable(o->d.var.name, t);
+    return;
+  }
+  if(o->type == Operand_Bool)
+  {
+    printf("%s", o->d.b ? "true" : "false");
+    return;
+  }
+  switch(findConstType(o->d.index))
+  {
+    case DataType_Integer:
+    {
+      int i = getIntConstValue(o->d.index);
+      if(i == INT32_MIN) printf("(-2147483647 - 1)");
+      else if(i < 0) printf("(%d)", i);
+      else printf("%d", i);
+      break;
+    }
+    case DataType_Double:
+    {
+      double d = getDoubleConstValue(o->d.index);
+      if(isnan(d)) printf("NAN");
+      else if(isinf(d)) printf("(%sHUGE_VAL)", (d < 0) ? "-" : "");
+      else if(d < 0 || (d == 0 && signbit(d))) printf("(%a)", d);
+      else printf("%a", d);
+      break;
+    }
+    default:
+      printf("K[%zu]", StringIndex(o->d.index));
+      break;
+  }
+}
+
+/*------------------------------ ANALYSIS ------------------------------------*/
+
+/** @brief Compares atoms by address. */
+static int CompareAtoms(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)*(const char * const *)a, y = (uintptr_t)*(const char * const *)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Index of the variable, CFG_NONE if not in the unit. */
+static size_t VariableOf(const Translation * T, const char * name)
+{
+  if(T->count == 0) return CFG_NONE;
+  const char ** found = bsearch(&name, T->names, T->count, sizeof(const char *), CompareAtoms);
+  return (found != NULL) ? (size_t)(found - T->names) : CFG_NONE;
+}
+
+/** @brief Records the reason, why the unit cannot be translated, returns false. */
+static bool Unsupported(Translation * T, size_t i, const char * reason)
+{
+  if(T->failure == NULL)
+  {
+    T->failure = reason;
+    T->failed_at = i;
+  }
+  return false;
+}
+
+/** @brief Writes the runtime error (when emitting), returns false (rest of the block is dead). */
+static bool RuntimeError(bool emit, int code, const char * message)
+{
+  if(emit) printf("  rt_error(%d, \"%s\");\n", code, message);
+  return false;
+}
+
+/** @brief Types of the symbol, which may be uninitialized. */
+static Types AnyType(const Translation * T, const Types * poly, const Operand * o)
+{
+  if(o->type == Operand_Bool) return CType_Bool;
+  if(o->type == Operand_Constant) return DataTypeType(findConstType(o->d.index));
+  size_t v = VariableOf(T, o->d.var.name);
+  if(v == CFG_NONE) return 0;
+  return (T->poly[v] != CFG_NONE) ? poly[T->poly[v]] : T->types[v];
+}
+
+/** @brief Records the type read from the variable. */
+static void MarkRead(Translation * T, const Operand * o, Types t)
+{
+  if(o->type != Operand_Variable) return;
+  size_t v = VariableOf(T, o->d.var.name);
+  if(v != CFG_NONE) T->reads[v] |= t;
+}
+
+/**
+ * @brief   Type of the read symbol.
+ *
+ * @param t       Returned type.
+ * @returns True, if the symbol has a single type. False otherwise
+ *          (uninitialized variable is a runtime error).
+ */
+static bool SymbolType(Translation * T, size_t i, const Types * poly, const Operand * o, Types * t, bool emit)
+{
+  if(o->type == Operand_Variable && o->d.var.frame == Frame_Global)
+    return Unsupported(T, i, "global frame");
+  *t = AnyType(T, poly, o);
+  if(*t == 0) return RuntimeError(emit, 56, "Symbol has not been initilized!");
+  if(!Single(*t)) return Unsupported(T, i, "symbol of more types");
+  MarkRead(T, o, *t);
+  return true;
+}
+
+/** @brief Type of the value on the top of the stack minus k. */
+static bool StackType(Translation * T, size_t i, const Types * stack, size_t d, size_t k, Types * t, bool emit)
+{
+  if(d <= k) return RuntimeError(emit, 56, "Operand stack is empty");
+  *t = stack[d - 1 - k];
+  if(!Single(*t)) return Unsupported(T, i, "value of more types on the data stack");
+  return true;
+}
+
+/** @brief Records the type written to the variable. */
+static bool WriteType(Translation * T, size_t i, Types * poly, const Operand * o, Types t)
+{
+  if(o->d.var.frame == Frame_Global) return Unsupported(T, i, "global frame");
+  size_t v = VariableOf(T, o->d.var.name);
+  if((T->types[v] | t) != T->types[v])
+  {
+    T->types[v] |= t;
+    T->changed = true;
+  }
+  if(T->poly[v] != CFG_NONE) poly[T->poly[v]] = t;
+  return true;
+}
+
+/** @brief Pushes the type to the stack. */
+static bool PushType(Translation * T, size_t i, Types * stack, size_t * d, Types t)
+{
+  if(*d >= T->width) return Unsupported(T, i, "data stack deeper than verified");
+  stack[*d] = t;
+  T->slots[*d] |= t;
+  (*d)++;
+  return true;
+}
+
+/** @brief Forgets temporary polymorphic variables (new temporary frame). */
+static void ClearTemporary(const Translation * T, Types * poly)
+{
+  for(size_t v = 0; v < T->count; v++)
+    if(T->poly[v] != CFG_NONE && T->names[v][0] == 'T') poly[T->poly[v]] = 0;
+}
+
+/*------------------------------ INSTRUCTIONS ------------------------------------*/
+
+/** @brief Writes assignment of the expression to the place of the type. */
+static void PrintAssignStart(void (*place)(const void *, Types), const void * p, Types t)
+{
+  printf("  ");
+  if(t == CType_String)
+  {
+    printf("rt_set(&");
+    place(p, t);
+    printf(", ");
+  }
+  else
+  {
+    place(p, t);
+    printf(" = ");
+  }
+}
+
+/** @brief Place of a variable operand. */
+static void PlaceVariable(const void * p, Types t)
+{
+  PrintVariable(((const Operand *)p)->d.var.name, t);
+}
+
+/** @brief Place of the stack (pointer to its index). */
+static void PlaceSlot(const void * p, Types t)
+{
+  PrintSlot(*(const size_t *)p, t);
+}
+
+/** @brief Ends the assignment started by PrintAssignStart(). */
+static void PrintAssignEnd(Types t)
+{
+  printf((t == CType_String) ? ");\n" : ";\n");
+}
+
+/** @brief Writes the arithmetic of operands (already printed by the callback). */
+static const char * ArithmeticOperator(Opcode op)
+{
+  switch(OpcodeThreeAddress(op))
+  {
+    case Opcode_Add: return "+";
+    case Opcode_Sub: return "-";
+    case Opcode_Mul: return "*";
+    default: return "/";
+  }
+}
+
+/**
+ * @brief   Operands of an instruction, symbols or places of the stack.
+ */
+typedef struct
+{
+  const Operand * o;        /**< Symbol, or NULL for the stack. */
+  size_t slot;              /**< Place of the stack. */
+  Types t;                  /**< Type. */
+} Value;
+
+/** @brief Writes the value. */
+static void PrintValue(const Value * v)
+{
+  if(v->o != NULL) PrintSymbol(v->o, v->t);
+  else PrintSlot(v->slot, v->t);
+}
+
+/** @brief Writes the expression of the binary operation on values. */
+static void PrintBinary(Opcode op, const Value * a, const Value * b)
+{
+  Opcode three = OpcodeThreeAddress(op);
+  switch(three)
+  {
+    case Opcode_Add: case Opcode_Sub: case Opcode_Mul:
+      if(a->t == CType_Int)
+      {
+        printf("(int)((unsigned)");
+        PrintValue(a);
+        printf(" %s (unsigned)", ArithmeticOperator(op));
+        PrintValue(b);
+        printf(")");
+        return;
+      }
+      PrintValue(a);
+      printf(" %s ", ArithmeticOperator(op));
+      PrintValue(b);
+      return;
+    case Opcode_Div:
+      printf("rt_div(");
+      PrintValue(a);
+      printf(", ");
+      PrintValue(b);
+      printf(")");
+      return;
+    case Opcode_And: case Opcode_Or:
+      PrintValue(a);
+      printf((three == Opcode_And) ? " && " : " || ");
+      PrintValue(b);
+      return;
+    case Opcode_Stri2Int:
+      printf("rt_ord(");
+      PrintValue(a);
+      printf(", ");
+      PrintValue(b);
+      printf(")");
+      return;
+    default:
+    {
+      // relations
+      const char * relation = (three == Opcode_Lt) ? "<" : (three == Opcode_Gt) ? ">" : "==";
+      if(a->t == CType_String)
+      {
+        printf("rt_compare(");
+        PrintValue(a);
+        printf(", ");
+        PrintValue(b);
+        printf(") %s 0", relation);
+        return;
+      }
+      PrintValue(a);
+      printf(" %s ", relation);
+      PrintValue(b);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief   Type of the result of the binary operation.
+ *
+ * @returns Type, or 0 if the operands have wrong types.
+ */
+static Types BinaryType(Opcode op, Types a, Types b)
+{
+  switch(OpcodeThreeAddress(op))
+  {
+    case Opcode_Add: case Opcode_Sub: case Opcode_Mul:
+      return (a == b && (a == CType_Int || a == CType_Float)) ? a : 0;
+    case Opcode_Div:
+      return (a == CType_Float && b == CType_Float) ? CType_Float : 0;
+    case Opcode_And: case Opcode_Or:
+      return (a == CType_Bool && b == CType_Bool) ? CType_Bool : 0;
+    case Opcode_Stri2Int:
+      return (a == CType_String && b == CType_Int) ? CType_Int : 0;
+    default:
+      return (a == b) ? CType_Bool : 0;
+  }
+}
+
+/**
+ * @brief   Type of the result of the unary operation.
+ *
+ * @returns Type, or 0 if the operand has a wrong type.
+ */
+static Types UnaryType(Opcode op, Types a)
+{
+  switch(OpcodeThreeAddress(op))
+  {
+    case Opcode_Not: return (a == CType_Bool) ? CType_Bool : 0;
+    case Opcode_Int2Float: return (a == CType_Int) ? CType_Float : 0;
+    case Opcode_Int2Char: return (a == CType_Int) ? CType_String : 0;
+    default: return (a == CType_Float) ? CType_Int : 0; // float to int
+  }
+}
+
+/** @brief Writes the expression of the unary operation on the value. */
+static void PrintUnary(Opcode op, const Value * a)
+{
+  switch(OpcodeThreeAddress(op))
+  {
+    case Opcode_Not: printf("!"); PrintValue(a); return;
+    case Opcode_Int2Float: printf("(double)"); PrintValue(a); return;
+    case Opcode_Int2Char: printf("rt_chr("); PrintValue(a); printf(")"); return;
+    case Opcode_Float2Int: printf("rt_toint("); PrintValue(a); printf(")"); return;
+    case Opcode_Float2R2EInt: printf("rt_toint(nearbyint("); PrintValue(a); printf("))"); return;
+    default: printf("rt_toint(rt_round_odd("); PrintValue(a); printf("))"); return;
+  }
+}
+
+/**
+ * @brief   Writes assignment of the expression to the variable or the place of the stack.
+ *
+ * A new string (rt_chr()) is moved, not retained.
+ */
+static void PrintResult(const Operand * dest, size_t slot, Types t, bool fresh, void (*expr)(Opcode, const Value *, const Value *),
+                        Opcode op, const Value * a, const Value * b)
+{
+  if(t == CType_String)
+  {
+    printf(fresh ? "  rt_move(&" : "  rt_set(&");
+    if(dest != NULL) PrintVariable(dest->d.var.name, t);
+    else PrintSlot(slot, t);
+    printf(", ");
+    expr(op, a, b);
+    printf(");\n");
+    return;
+  }
+  printf("  ");
+  if(dest != NULL) PrintVariable(dest->d.var.name, t);
+  else PrintSlot(slot, t);
+  printf(" = ");
+  expr(op, a, b);
+  printf(";\n");
+}
+
+/** @brief Unary expression for PrintResult(). */
+static void UnaryExpression(Opcode op, const Value * a, const Value * b)
+{
+  (void)b;
+  PrintUnary(op, a);
+}
+
+/** @brief Writes the arguments of the call of the function. */
+static void PrintArguments(Parameters params, const Types * types)
+{
+  for(size_t p = 0; p < paramCount(params); p++)
+  {
+    Types t = DataTypeType(params->types[p]);
+    if(p > 0) printf(", ");
+    if(types[p] == 0) printf("%s", (t == CType_String) ? "rt_types[0]" : TypeDefault(t));
+    else PrintVariable(OperandVariable(Frame_Temporary, params->names[p]).d.var.name, t);
+  }
+}
+
+/**
+ * @brief   Translates the instruction.
+ *
+ * Computes types of its results and, if emitting, writes its C code.
+ * @param T       Translation of the unit.
+ * @param i       Index of the instruction.
+ * @param d       Depth of the data stack.
+ * @param stack   Types on the data stack.
+ * @param poly    Types of polymorphic variables.
+ * @param emit    Writes the code.
+ * @returns True, if the successors are reached. False otherwise
+ *          (a return, or a runtime error).
+ */
+static bool Step(Translation * T, size_t i, size_t * d, Types * stack, Types * poly, bool emit)
+{
+  const Instruction * ins = &T->unit->code[i];
+  Opcode op = ins->op;
+  const Operand * arg = ins->arg;
+  Types ta, tb, tc;
+
+  switch(op)
+  {
+    case Opcode_Comment:
+      return true;
+
+    /* frames and calls */
+    case Opcode_CreateFrame:
+      ClearTemporary(T, poly);
+      return true;
+    case Opcode_PushFrame:
+      if(T->result == 0 || i + 1 != CodeBodyStart(T->unit)) return Unsupported(T, i, "frame pushed out of the call");
+      return true;
+    case Opcode_PopFrame:
+      if(i == 0 || T->unit->code[i-1].op != Opcode_Call) return Unsupported(T, i, "frame popped out of the call");
+      return true;
+    case Opcode_Defvar:
+    {
+      if(arg[0].d.var.frame == Frame_Global) return Unsupported(T, i, "global frame");
+      size_t v = VariableOf(T, arg[0].d.var.name);
+      if(T->poly[v] != CFG_NONE) poly[T->poly[v]] = 0;
+      return true;
+    }
+    case Opcode_Call:
+    {
+      const char * callee = arg[0].d.label;
+      Types result = DataTypeType(findFunctionType(callee));
+      Parameters params = findFunctionParameters(callee);
+      if(result == 0 || CodeFindUnit(callee) == NULL) return Unsupported(T, i, "call of an unknown function");
+
+      Types types[paramCount(params) + 1];
+      for(size_t p = 0; p < paramCount(params); p++)
+      {
+        Operand o = OperandVariable(Frame_Temporary, params->names[p]);
+        if(o.type == Operand_None) return Unsupported(T, i, "out of memory");
+        types[p] = AnyType(T, poly, &o);
+        if(types[p] != 0 && types[p] != DataTypeType(params->types[p])) return Unsupported(T, i, "argument of other type");
+        MarkRead(T, &o, types[p]);
+      }
+      size_t slot = *d;
+      if(!PushType(T, i, stack, d, result)) return false;
+      if(emit)
+      {
+        printf((result == CType_String) ? "  rt_move(&" : "  ");
+        PrintSlot(slot, result);
+        printf((result == CType_String) ? ", " : " = ");
+        PrintFunctionName(callee);
+        printf("(");
+        PrintArguments(params, types);
+        printf((result == CType_String) ? "));\n" : ");\n");
+      }
+      ClearTemporary(T, poly);
+      return true;
+    }
+    case Opcode_Return:
+      if(T->result == 0) return Unsupported(T, i, "return out of a function");
+      if(*d != 1) return Unsupported(T, i, "unbalanced data stack");
+      if(!StackType(T, i, stack, *d, 0, &ta, emit)) return false;
+      if(ta != T->result) return Unsupported(T, i, "returned value of other type");
+      if(emit)
+      {
+        printf("  ret = ");
+        PrintSlot(0, ta);
+        printf((ta == CType_String) ? ";\n  rt_retain(ret);\n  goto leave;\n" : ";\n  goto leave;\n");
+        T->returns = true;
+      }
+      return false;
+
+    case Opcode_Move:
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit)) return false;
+      if(emit)
+      {
+        PrintAssignStart(PlaceVariable, &arg[0], ta);
+        PrintSymbol(&arg[1], ta);
+        PrintAssignEnd(ta);
+      }
+      return WriteType(T, i, poly, &arg[0], ta);
+
+    /* data stack */
+    case Opcode_Pushs:
+    {
+      if(!SymbolType(T, i, poly, &arg[0], &ta, emit)) return false;
+      size_t slot = *d;
+      if(!PushType(T, i, stack, d, ta)) return false;
+      if(emit)
+      {
+        PrintAssignStart(PlaceSlot, &slot, ta);
+        PrintSymbol(&arg[0], ta);
+        PrintAssignEnd(ta);
+      }
+      return true;
+    }
+    case Opcode_Pops:
+      if(!StackType(T, i, stack, *d, 0, &ta, emit)) return false;
+      (*d)--;
+      if(emit)
+      {
+        PrintAssignStart(PlaceVariable, &arg[0], ta);
+        PrintSlot(*d, ta);
+        PrintAssignEnd(ta);
+      }
+      return WriteType(T, i, poly, &arg[0], ta);
+    case Opcode_Clears:
+      *d = 0;
+      return true;
+
+    /* binary operations into variables */
+    case Opcode_Add: case Opcode_Sub: case Opcode_Mul: case Opcode_Div:
+    case Opcode_Lt: case Opcode_Gt: case Opcode_Eq:
+    case Opcode_And: case Opcode_Or: case Opcode_Stri2Int:
+    {
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit) || !SymbolType(T, i, poly, &arg[2], &tb, emit)) return false;
+      tc = BinaryType(op, ta, tb);
+      if(tc == 0) return RuntimeError(emit, 53, "Wrong operand type!");
+      Value a = {&arg[1], 0, ta}, b = {&arg[2], 0, tb};
+      if(emit) PrintResult(&arg[0], 0, tc, false, PrintBinary, op, &a, &b);
+      return WriteType(T, i, poly, &arg[0], tc);
+    }
+
+    /* binary operations on the stack */
+    case Opcode_Adds: case Opcode_Subs: case Opcode_Muls: case Opcode_Divs:
+    case Opcode_Lts: case Opcode_Gts: case Opcode_Eqs:
+    case Opcode_Ands: case Opcode_Ors: case Opcode_Stri2Ints:
+    {
+      if(!StackType(T, i, stack, *d, 1, &ta, emit) || !StackType(T, i, stack, *d, 0, &tb, emit)) return false;
+      tc = BinaryType(op, ta, tb);
+      if(tc == 0) return RuntimeError(emit, 53, "Wrong operand type!");
+      *d -= 2;
+      Value a = {NULL, *d, ta}, b = {NULL, *d + 1, tb};
+      if(emit) PrintResult(NULL, *d, tc, false, PrintBinary, op, &a, &b);
+      return PushType(T, i, stack, d, tc);
+    }
+
+    /* unary operations */
+    case Opcode_Not: case Opcode_Int2Float: case Opcode_Float2Int:
+    case Opcode_Float2R2EInt: case Opcode_Float2R2OInt: case Opcode_Int2Char:
+    {
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit)) return false;
+      tc = UnaryType(op, ta);
+      if(tc == 0) return RuntimeError(emit, 53, "Wrong operand type!");
+      Value a = {&arg[1], 0, ta};
+      if(emit) PrintResult(&arg[0], 0, tc, op == Opcode_Int2Char, UnaryExpression, op, &a, NULL);
+      return WriteType(T, i, poly, &arg[0], tc);
+    }
+    case Opcode_Nots: case Opcode_Int2Floats: case Opcode_Float2Ints:
+    case Opcode_Float2R2EInts: case Opcode_Float2R2OInts: case Opcode_Int2Chars:
+    {
+      if(!StackType(T, i, stack, *d, 0, &ta, emit)) return false;
+      tc = UnaryType(op, ta);
+      if(tc == 0) return RuntimeError(emit, 53, "Wrong operand type!");
+      (*d)--;
+      Value a = {NULL, *d, ta};
+      if(emit) PrintResult(NULL, *d, tc, op == Opcode_Int2Chars, UnaryExpression, op, &a, NULL);
+      return PushType(T, i, stack, d, tc);
+    }
+
+    /* input and output */
+    case Opcode_Read:
+      ta = DataTypeType(arg[1].d.dt);
+      if(ta == 0) return Unsupported(T, i, "read of an unknown type");
+      if(emit)
+      {
+        printf((ta == CType_String) ? "  rt_move(&" : "  ");
+        PrintVariable(arg[0].d.var.name, ta);
+        printf((ta == CType_String) ? ", rt_read_%s());\n" : " = rt_read_%s();\n", TypeWord(ta));
+      }
+      return WriteType(T, i, poly, &arg[0], ta);
+    case Opcode_Write:
+      if(!SymbolType(T, i, poly, &arg[0], &ta, emit)) return false;
+      if(emit)
+      {
+        printf("  rt_write_%s(", TypeWord(ta));
+        PrintSymbol(&arg[0], ta);
+        printf(");\n");
+      }
+      return true;
+
+    /* strings */
+    case Opcode_Concat:
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit) || !SymbolType(T, i, poly, &arg[2], &tb, emit)) return false;
+      if(ta != CType_String || tb != CType_String) return RuntimeError(emit, 53, "Wrong operand type!");
+      if(emit)
+      {
+        printf("  rt_concat(&");
+        PrintVariable(arg[0].d.var.name, CType_String);
+        printf(", ");
+        PrintSymbol(&arg[1], ta);
+        printf(", ");
+        PrintSymbol(&arg[2], tb);
+        printf(");\n");
+      }
+      return WriteType(T, i, poly, &arg[0], CType_String);
+    case Opcode_Strlen:
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit)) return false;
+      if(ta != CType_String) return RuntimeError(emit, 53, "Wrong operand type!");
+      if(emit)
+      {
+        printf("  ");
+        PrintVariable(arg[0].d.var.name, CType_Int);
+        printf(" = (int)");
+        PrintSymbol(&arg[1], ta);
+        printf("->length;\n");
+      }
+      return WriteType(T, i, poly, &arg[0], CType_Int);
+    case Opcode_Getchar:
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit) || !SymbolType(T, i, poly, &arg[2], &tb, emit)) return false;
+      if(ta != CType_String || tb != CType_Int) return RuntimeError(emit, 53, "Wrong operand type!");
+      if(emit)
+      {
+        printf("  rt_move(&");
+        PrintVariable(arg[0].d.var.name, CType_String);
+        printf(", rt_chr(rt_ord(");
+        PrintSymbol(&arg[1], ta);
+        printf(", ");
+        PrintSymbol(&arg[2], tb);
+        printf(")));\n");
+      }
+      return WriteType(T, i, poly, &arg[0], CType_String);
+    case Opcode_Setchar:
+      if(!SymbolType(T, i, poly, &arg[0], &tc, emit)) return false;
+      if(!SymbolType(T, i, poly, &arg[1], &ta, emit) || !SymbolType(T, i, poly, &arg[2], &tb, emit)) return false;
+      if(tc != CType_String || ta != CType_Int || tb != CType_String) return RuntimeError(emit, 53, "Wrong operand type!");
+      if(emit)
+      {
+        printf("  rt_setchar(&");
+        PrintVariable(arg[0].d.var.name, CType_String);
+        printf(", ");
+        PrintSymbol(&arg[1], ta);
+        printf(", ");
+        PrintSymbol(&arg[2], tb);
+        printf(");\n");
+      }
+      return true;
+    case Opcode_Type:
+    {
+      ta = AnyType(T, poly, &arg[1]);
+      if(ta != 0 && !Single(ta)) return Unsupported(T, i, "symbol of more types");
+      int name = (ta == CType_Int) ? 1 : (ta == CType_Float) ? 2 : (ta == CType_Bool) ? 3 : (ta == CType_String) ? 4 : 0;
+      if(emit)
+      {
+        printf("  rt_set(&");
+        PrintVariable(arg[0].d.var.name, CType_String);
+        printf(", rt_types[%d]);\n", name);
+      }
+      return WriteType(T, i, poly, &arg[0], CType_String);
+    }
+
+    /* jumps */
+    case Opcode_Label:
+      if(emit && T->jumped[CfgLabelBlock(&T->cfg, arg[0].d.label)])
+      {
+        printf("L_");
+        PrintMangled(arg[0].d.label);
+        printf(": ;\n");
+      }
+      return true;
+    case Opcode_Jump:
+      if(CfgLabelBlock(&T->cfg, arg[0].d.label) == CFG_NONE) return Unsupported(T, i, "jump out of the unit");
+      if(emit)
+      {
+        printf("  goto L_");
+        PrintMangled(arg[0].d.label);
+        printf(";\n");
+      }
+      return true;
+    case Opcode_JumpIfEq: case Opcode_JumpIfNeq:
+    case Opcode_JumpIfEqs: case Opcode_JumpIfNeqs:
+    {
+      if(CfgLabelBlock(&T->cfg, arg[0].d.label) == CFG_NONE) return Unsupported(T, i, "jump out of the unit");
+      Value a, b;
+      if(op == Opcode_JumpIfEq || op == Opcode_JumpIfNeq)
+      {
+        if(!SymbolType(T, i, poly, &arg[1], &ta, emit) || !SymbolType(T, i, poly, &arg[2], &tb, emit)) return false;
+        a = (Value){&arg[1], 0, ta};
+        b = (Value){&arg[2], 0, tb};
+      }
+      else
+      {
+        if(!StackType(T, i, stack, *d, 1, &ta, emit) || !StackType(T, i, stack, *d, 0, &tb, emit)) return false;
+        *d -= 2;
+        a = (Value){NULL, *d, ta};
+        b = (Value){NULL, *d + 1, tb};
+      }
+      if(ta != tb) return RuntimeError(emit, 53, "Wrong operand type!");
+      if(emit)
+      {
+        bool equal = (op == Opcode_JumpIfEq || op == Opcode_JumpIfEqs);
+        printf(equal ? "  if(" : "  if(!(");
+        PrintBinary(Opcode_Eq, &a, &b);
+        printf(equal ? ") goto L_" : ")) goto L_");
+        PrintMangled(arg[0].d.label);
+        printf(";\n");
+      }
+      return true;
+    }
+
+    /* debugging */
+    case Opcode_Break:
+      if(emit) printf("  rt_break();\n");
+      return true;
+    case Opcode_Dprint:
+      if(arg[0].type == Operand_Variable && arg[0].d.var.frame == Frame_Global) return Unsupported(T, i, "global frame");
+      ta = AnyType(T, poly, &arg[0]);
+      if(ta != 0 && !Single(ta)) return Unsupported(T, i, "symbol of more types");
+      MarkRead(T, &arg[0], ta);
+      if(emit)
+      {
+        const char * name = (arg[0].type == Operand_Variable) ? arg[0].d.var.name : "Const@";
+        if(ta == 0) printf("  rt_dprint_undefined(\"%s\");\n", name);
+        else
+        {
+          printf("  rt_dprint_%s(\"%s\", ", TypeWord(ta), name);
+          PrintSymbol(&arg[0], ta);
+          printf(");\n");
+        }
+      }
+      return true;
+
+    default:
+      return Unsupported(T, i, "unknown instruction");
+  }
+}
+
+/*------------------------------ UNITS ------------------------------------*/
+
+/** @brief Collects variables of the unit. */
+static bool CollectVariables(Translation * T)
+{
+  const CodeUnit * u = T->unit;
+  size_t count = paramCount(T->params);
+  for(size_t i = 0; i < u->count; i++)
+    for(unsigned a = 0; a < OpcodeArity(u->code[i].op); a++)
+      if(u->code[i].arg[a].type == Operand_Variable) count++;
+
+  T->names = malloc((count + 1) * sizeof(const char *));
+  T->locals = malloc((paramCount(T->params) + 1) * sizeof(const char *));
+  if(T->names == NULL || T->locals == NULL) return false;
+  for(size_t p = 0; p < paramCount(T->params); p++)
+  {
+    T->locals[p] = OperandVariable(Frame_Local, T->params->names[p]).d.var.name;
+    if(T->locals[p] == NULL) return false;
+    T->names[T->count++] = T->locals[p];
+  }
+  for(size_t i = 0; i < u->count; i++)
+    for(unsigned a = 0; a < OpcodeArity(u->code[i].op); a++)
+      if(u->code[i].arg[a].type == Operand_Variable) T->names[T->count++] = u->code[i].arg[a].d.var.name;
+
+  // unique
+  qsort(T->names, T->count, sizeof(const char *), CompareAtoms);
+  size_t n = 0;
+  for(size_t i = 0; i < T->count; i++)
+    if(n == 0 || T->names[n-1] != T->names[i]) T->names[n++] = T->names[i];
+  T->count = n;
+
+  T->types = calloc(T->count + 1, sizeof(Types));
+  T->reads = calloc(T->count + 1, sizeof(Types));
+  T->poly = malloc((T->count + 1) * sizeof(size_t));
+  if(T->types == NULL || T->reads == NULL || T->poly == NULL) return false;
+  for(size_t p = 0; p < paramCount(T->params); p++)
+    T->types[VariableOf(T, T->locals[p])] |= DataTypeType(T->params->types[p]);
+  return true;
+}
+
+/**
+ * @brief   Enters the block with the state.
+ *
+ * @returns True, if the state of the block changed. False otherwise.
+ */
+static bool Enter(Translation * T, size_t b, size_t d, const Types * state)
+{
+  size_t width = T->width + T->poly_count;
+  Types * entry = T->entries + b * width;
+  if(T->depths[b] == UNREACHED)
+  {
+    T->depths[b] = d;
+    memcpy(entry, state, width);
+    return true;
+  }
+  if(T->depths[b] != d)
+  {
+    Unsupported(T, T->cfg.blocks[b].start, "different depths of the data stack at a join");
+    return false;
+  }
+  bool changed = false;
+  for(size_t k = 0; k < width; k++)
+  {
+    if((entry[k] | state[k]) != entry[k]) changed = true;
+    entry[k] |= state[k];
+  }
+  return changed;
+}
+
+/**
+ * @brief   Infers types over the control flow graph.
+ *
+ * Repeated, until types of variables do not change. Variables, which
+ * get more types, become polymorphic.
+ * @returns True, if success. False otherwise.
+ */
+static bool Analyze(Translation * T)
+{
+  size_t blocks = T->cfg.count;
+  T->depths = malloc((blocks + 1) * sizeof(size_t));
+  T->jumped = calloc(blocks + 1, sizeof(bool));
+  T->slots = calloc(T->width + 1, sizeof(Types));
+  size_t * work = malloc((blocks + 1) * sizeof(size_t));
+  bool * queued = malloc((blocks + 1) * sizeof(bool));
+  if(T->depths == NULL || T->jumped == NULL || T->slots == NULL || work == NULL || queued == NULL)
+  {
+    free(work);
+    free(queued);
+    return false;
+  }
+  if(blocks == 0)
+  {
+    free(work);
+    free(queued);
+    return true;
+  }
+
+  do
+  {
+    // polymorphic variables
+    T->poly_count = 0;
+    for(size_t v = 0; v < T->count; v++)
+      T->poly[v] = Single(T->types[v]) || T->types[v] == 0 ? CFG_NONE : T->poly_count++;
+    size_t width = T->width + T->poly_count;
+    free(T->entries);
+    T->entries = calloc(blocks * width + 1, sizeof(Types));
+    Types * state = calloc(width + 1, sizeof(Types));
+    if(T->entries == NULL || state == NULL)
+    {
+      free(state);
+      free(work);
+      free(queued);
+      return false;
+    }
+    T->changed = false;
+    T->failure = NULL;
+    memset(T->slots, 0, T->width + 1);
+    memset(T->reads, 0, T->count + 1);
+    for(size_t b = 0; b < blocks; b++)
+    {
+      T->depths[b] = UNREACHED;
+      queued[b] = false;
+    }
+
+    // parameters
+    for(size_t p = 0; p < paramCount(T->params); p++)
+    {
+      size_t v = VariableOf(T, T->locals[p]);
+      if(T->poly[v] != CFG_NONE) state[T->width + T->poly[v]] = DataTypeType(T->params->types[p]);
+    }
+    size_t work_count = 0;
+    Enter(T, 0, 0, state);
+    work[work_count++] = 0;
+    queued[0] = true;
+
+    while(work_count > 0)
+    {
+      size_t b = work[--work_count];
+      const BasicBlock * block = &T->cfg.blocks[b];
+      queued[b] = false;
+      size_t d = T->depths[b];
+      memcpy(state, T->entries + b * width, width);
+
+      bool alive = true;
+      for(size_t i = block->start; alive && i < block->end; i++)
+        alive = Step(T, i, &d, state, state + T->width, false);
+      if(!alive) continue;
+
+      size_t succs[2] = {block->next, block->target};
+      for(unsigned s = 0; s < 2; s++)
+      {
+        if(succs[s] == CFG_NONE) continue;
+        if(Enter(T, succs[s], d, state) && !queued[succs[s]])
+        {
+          queued[succs[s]] = true;
+          work[work_count++] = succs[s];
+        }
+      }
+    }
+    free(state);
+  } while(T->changed);
+
+  // targets of reached jumps
+  for(size_t b = 0; b < blocks; b++)
+  {
+    const BasicBlock * block = &T->cfg.blocks[b];
+    if(T->depths[b] != UNREACHED && block->target != CFG_NONE) T->jumped[block->target] = true;
+  }
+  free(work);
+  free(queued);
+  return true;
+}
+
+/** @brief Destroys the translation. */
+static void FreeTranslation(Translation * T)
+{
+  CfgFree(&T->cfg);
+  free(T->names);
+  free(T->locals);
+  free(T->types);
+  free(T->reads);
+  free(T->poly);
+  free(T->depths);
+  free(T->entries);
+  free(T->slots);
+  free(T->jumped);
+}
+
+/** @brief Name of the unit for messages. */
+static const char * UnitName(const CodeUnit * u)
+{
+  return (u->name != NULL) ? u->name : "prologue";
+}
+
+/** @brief Unit is the scope (body of main()). */
+static bool IsScope(const CodeUnit * u)
+{
+  return u->name != NULL && strcmp(u->name, "scope") == 0;
+}
+
+/**
+ * @brief   Prepares translation of the unit.
+ *
+ * @returns True, if success. False otherwise.
+ */
+static bool InitTranslation(Translation * T, CodeUnit * u)
+{
+  memset(T, 0, sizeof(Translation));
+  T->unit = u;
+  T->width = u->stack_depth + 1;
+  if(!IsScope(u))
+  {
+    T->params = findFunctionParameters(u->name);
+    T->result = DataTypeType(findFunctionType(u->name));
+    if(T->result == 0)
+    {
+      err("csource: %s: unknown type of the function", UnitName(u));
+      return false;
+    }
+  }
+  if(!CfgBuild(&T->cfg, u) || !CollectVariables(T)) return false;
+  if(!Analyze(T)) return false;
+  if(T->failure != NULL)
+  {
+    const char * op = (T->failed_at < u->count) ? Opcode2Str(u->code[T->failed_at].op) : "end";
+    err("csource: %s: instruction %zu (%s): %s", UnitName(u), T->failed_at, op, T->failure);
+    return false;
+  }
+  return true;
+}
+
+/** @brief Prologue only creates the local frame of the scope. */
+static bool CheckPrologue(const CodeUnit * u)
+{
+  for(size_t i = 0; i < u->count; i++)
+  {
+    Opcode op = u->code[i].op;
+    if(op == Opcode_Comment || op == Opcode_CreateFrame || op == Opcode_PushFrame) continue;
+    if(op == Opcode_Jump && strcmp(u->code[i].arg[0].d.label, "$main") == 0) continue;
+    err("csource: prologue: instruction %zu (%s): unsupported", i, Opcode2Str(op));
+    return false;
+  }
+  return true;
+}
+
+/*------------------------------ OUTPUT ------------------------------------*/
+
+/** @brief Writes the declaration of the function of the unit. */
+static void PrintSignature(const Translation * T)
+{
+  if(T->result == 0)
+  {
+    printf("static void u_scope(void)");
+    return;
+  }
+  printf("static %s ", TypeName(T->result));
+  PrintFunctionName(T->unit->name);
+  printf("(");
+  for(size_t p = 0; p < paramCount(T->params); p++)
+  {
+    Types t = DataTypeType(T->params->types[p]);
+    printf("%s%s ", (p > 0) ? ", " : "", TypeName(t));
+    PrintVariable(T->locals[p], t);
+  }
+  if(paramCount(T->params) == 0) printf("void");
+  printf(")");
+}
+
+/** @brief Variable with the type is a parameter of the function. */
+static bool IsParameter(const Translation * T, const char * name, Types t)
+{
+  for(size_t p = 0; p < paramCount(T->params); p++)
+    if(T->locals[p] == name && DataTypeType(T->params->types[p]) == t) return true;
+  return false;
+}
+
+/** @brief Writes the locals of the function. */
+static void PrintLocals(const Translation * T)
+{
+  for(size_t v = 0; v < T->count; v++)
+    for(Types t = CType_Int; t <= CType_String; t <<= 1)
+    {
+      if(!(T->types[v] & t) || IsParameter(T, T->names[v], t)) continue;
+      printf("  %s%s", TypeName(t), (t == CType_String) ? "" : " ");
+      PrintVariable(T->names[v], t);
+      printf(" = %s;\n", TypeDefault(t));
+    }
+  for(size_t k = 0; k < T->width; k++)
+    for(Types t = CType_Int; t <= CType_String; t <<= 1)
+    {
+      if(!(T->slots[k] & t)) continue;
+      printf("  %s%s", TypeName(t), (t == CType_String) ? "" : " ");
+      PrintSlot(k, t);
+      printf(" = %s;\n", TypeDefault(t));
+    }
+  if(T->result != 0) printf("  %s ret = %s;\n", TypeName(T->result), (T->result == CType_String) ? "NULL" : TypeDefault(T->result));
+
+  // written only, or unused parameter
+  for(size_t v = 0; v < T->count; v++)
+    for(Types t = CType_Int; t <= CType_String; t <<= 1)
+    {
+      bool declared = (T->types[v] & t) || IsParameter(T, T->names[v], t);
+      if(!declared || (T->reads[v] & t)) continue;
+      printf("  (void)");
+      PrintVariable(T->names[v], t);
+      printf(";\n");
+    }
+  for(size_t p = 0; p < paramCount(T->params); p++)
+    if(VariableOf(T, T->locals[p]) == CFG_NONE)
+    {
+      printf("  (void)");
+      PrintVariable(T->locals[p], DataTypeType(T->params->types[p]));
+      printf(";\n");
+    }
+
+  // parameters are owned as the other locals
+  for(size_t p = 0; p < paramCount(T->params); p++)
+    if(DataTypeType(T->params->types[p]) == CType_String)
+    {
+      printf("  rt_retain(");
+      PrintVariable(T->locals[p], CType_String);
+      printf(");\n");
+    }
+}
+
+/** @brief Writes releases of the string locals. */
+static void PrintReleases(const Translation * T)
+{
+  for(size_t v = 0; v < T->count; v++)
+    if(T->types[v] & CType_String)
+    {
+      printf("  rt_release(");
+      PrintVariable(T->names[v], CType_String);
+      printf(");\n");
+    }
+  for(size_t k = 0; k < T->width; k++)
+    if(T->slots[k] & CType_String)
+    {
+      printf("  rt_release(");
+      PrintSlot(k, CType_String);
+      printf(");\n");
+    }
+}
+
+/** @brief Writes the function of the unit. */
+static bool PrintTranslation(Translation * T)
+{
+  printf("\n/* %s %s */\n", (T->result != 0) ? "function" : "scope", T->unit->name);
+  PrintSignature(T);
+  printf("\n{\n");
+  PrintLocals(T);
+
+  size_t width = T->width + T->poly_count;
+  Types * state = calloc(width + 1, sizeof(Types));
+  if(state == NULL) return false;
+  for(size_t b = 0; b < T->cfg.count; b++)
+  {
+    if(T->depths[b] == UNREACHED) continue;
+    const BasicBlock * block = &T->cfg.blocks[b];
+    size_t d = T->depths[b];
+    memcpy(state, T->entries + b * width, width);
+    bool alive = true;
+    for(size_t i = block->start; alive && i < block->end; i++)
+      alive = Step(T, i, &d, state, state + T->width, true);
+  }
+  free(state);
+
+  if(T->returns) printf("leave:\n");
+  PrintReleases(T);
+  if(T->result != 0) printf("  return ret;\n");
+  printf("}\n");
+  return true;
+}
+
+/** @brief Compares indices. */
+static int CompareIndices(const void * a, const void * b)
+{
+  size_t x = *(const size_t *)a, y = *(const size_t *)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Collects string constants of the reachable units. */
+static bool CollectStrings()
+{
+  size_t count = 0;
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+  {
+    const CodeUnit * unit = CodeGetUnit(u);
+    if(unit->reachable) count += CODE_MAX_OPERANDS * unit->count;
+  }
+  strings = malloc((count + 1) * sizeof(size_t));
+  if(strings == NULL) return false;
+  strings_count = 0;
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+  {
+    const CodeUnit * unit = CodeGetUnit(u);
+    if(!unit->reachable) continue;
+    for(size_t i = 0; i < unit->count; i++)
+      for(unsigned a = 0; a < OpcodeArity(unit->code[i].op); a++)
+      {
+        const Operand * o = &unit->code[i].arg[a];
+        if(o->type == Operand_Constant && findConstType(o->d.index) == DataType_String) strings[strings_count++] = o->d.index;
+      }
+  }
+  if(strings_count == 0) return true;
+  qsort(strings, strings_count, sizeof(size_t), CompareIndices);
+  size_t n = 1;
+  for(size_t i = 1; i < strings_count; i++)
+    if(strings[i] != strings[n-1]) strings[n++] = strings[i];
+  strings_count = n;
+  return true;
+}
+
+/** @brief Writes the decoded string as a C literal. */
+static bool PrintStringLiteral(const char * escaped, size_t * length)
+{
+  char * decoded = malloc(DecodeString(escaped, NULL) + 1);
+  if(decoded == NULL) return false;
+  *length = DecodeString(escaped, decoded);
+  putchar('"');
+  for(size_t i = 0; i < *length; i++)
+  {
+    unsigned char c = (unsigned char)decoded[i];
+    if(c == '"' || c == '\\' || c == '?' || c < 32 || c >= 127) printf("\\%03o", c);
+    else putchar(c);
+  }
+  putchar('"');
+  free(decoded);
+  return true;
+}
+
+/** @brief Runtime of the program, lines of C. */
+static const char * runtime[] = {
+  "#include <math.h>",
+  "#include <stdbool.h>",
+  "#include <stdio.h>",
+  "#include <stdlib.h>",
+  "#include <string.h>",
+  "",
+  "/* runtime */",
+  "#if defined(__GNUC__)",
+  "#  define RT_COLD __attribute__((cold, noinline))",
+  "#else",
+  "#  define RT_COLD",
+  "#endif",
+  "typedef struct { size_t refs, length; char data[]; } Str;",
+  "static Str * rt_chars[256];",
+  "static Str * rt_types[5];",
+  "static char * rt_line = NULL;",
+  "static size_t rt_line_length = 0, rt_line_size = 0;",
+  "",
+  "static RT_COLD void rt_error(int code, const char * message)",
+  "{",
+  "  fflush(stdout);",
+  "  fprintf(stderr, \"Error: %s\\n\", message);",
+  "  exit(code);",
+  "}",
+  "static inline Str * rt_new(const char * data, size_t length)",
+  "{",
+  "  Str * s = malloc(sizeof(Str) + length + 1);",
+  "  if(s == NULL) rt_error(99, \"Out of memory!\");",
+  "  s->refs = 1;",
+  "  s->length = length;",
+  "  if(data != NULL) memcpy(s->data, data, length);",
+  "  s->data[length] = '\\0';",
+  "  return s;",
+  "}",
+  "static inline Str * rt_retain(Str * s) { s->refs++; return s; }",
+  "static RT_COLD void rt_free(Str * s) { free(s); }",
+  "static inline void rt_release(Str * s) { if(--s->refs == 0) rt_free(s); }",
+  "static inline Str * rt_empty(void) { return rt_retain(rt_types[0]); }",
+  "static inline void rt_set(Str ** dst, Str * src) { Str * old = *dst; src->refs++; *dst = src; rt_release(old); }",
+  "static inline void rt_move(Str ** dst, Str * src) { rt_release(*dst); *dst = src; }",
+  "static inline void rt_concat(Str ** dst, Str * a, Str * b)",
+  "{",
+  "  if(a == *dst && a->refs == 1 && a != b)",
+  "  {",
+  "    /* the only reference is overwritten, so the string grows in place */",
+  "    Str * grown = realloc(a, sizeof(Str) + a->length + b->length + 1);",
+  "    if(grown == NULL) rt_error(99, \"Out of memory!\");",
+  "    memcpy(grown->data + grown->length, b->data, b->length + 1);",
+  "    grown->length += b->length;",
+  "    *dst = grown;",
+  "    return;",
+  "  }",
+  "  if(a->length == 0)",
+  "  {",
+  "    /* the empty string is the prefix of the concatenations of the code */",
+  "    rt_set(dst, b);",
+  "    return;",
+  "  }",
+  "  Str * s = rt_new(NULL, a->length + b->length);",
+  "  memcpy(s->data, a->data, a->length);",
+  "  memcpy(s->data + a->length, b->data, b->length + 1);",
+  "  rt_move(dst, s);",
+  "}",
+  "static inline int rt_compare(const Str * a, const Str * b)",
+  "{",
+  "  size_t length = (a->length < b->length) ? a->length : b->length;",
+  "  int c = (a == b) ? 0 : memcmp(a->data, b->data, length);",
+  "  if(c != 0) return c;",
+  "  return (a->length > b->length) - (a->length < b->length);",
+  "}",
+  "static inline int rt_toint(double f)",
+  "{",
+  "  return (f >= -2147483648.0 && f < 2147483648.0) ? (int)f : (-2147483647 - 1);",
+  "}",
+  "static inline double rt_round_odd(double f)",
+  "{",
+  "  double r = floor(f), fraction = f - r;",
+  "  if(fraction > 0.5 || (fraction == 0.5 && fmod(r, 2.0) == 0.0)) r += 1.0;",
+  "  return r;",
+  "}",
+  "static inline double rt_div(double a, double b)",
+  "{",
+  "  if(b == 0.0) rt_error(57, \"Division by zero!\");",
+  "  return a / b;",
+  "}",
+  "static inline int rt_ord(const Str * s, int i)",
+  "{",
+  "  if(i < 0 || (size_t)i >= s->length) rt_error(58, \"String index out of bounds!\");",
+  "  return (unsigned char)s->data[i];",
+  "}",
+  "static inline Str * rt_chr(int i)",
+  "{",
+  "  if(i < 0 || i > 255) rt_error(58, \"Escape sequence not in the 0-255 range!\");",
+  "  return rt_retain(rt_chars[i]);",
+  "}",
+  "static inline void rt_setchar(Str ** dst, int i, const Str * c)",
+  "{",
+  "  Str * s = *dst;",
+  "  if(i < 0 || (size_t)i >= s->length) rt_error(58, \"String index out of bounds!\");",
+  "  if(c->length == 0) rt_error(58, \"Using empty string as an substitution!\");",
+  "  char ch = c->data[0];",
+  "  if(s->refs > 1)",
+  "  {",
+  "    /* copy on write */",
+  "    Str * copy = rt_new(s->data, s->length);",
+  "    rt_release(s);",
+  "    *dst = s = copy;",
+  "  }",
+  "  s->data[i] = ch;",
+  "}",
+  "",
+  "/* input and output */",
+  "static inline void rt_read_line(void)",
+  "{",
+  "  int c;",
+  "  fflush(stdout);",
+  "  rt_line_length = 0;",
+  "  do",
+  "  {",
+  "    if(rt_line_length + 1 >= rt_line_size)",
+  "    {",
+  "      size_t size = (rt_line_size == 0) ? 128 : 2 * rt_line_size;",
+  "      char * grown = realloc(rt_line, size);",
+  "      if(grown == NULL) rt_error(99, \"Out of memory!\");",
+  "      rt_line = grown;",
+  "      rt_line_size = size;",
+  "    }",
+  "    c = getchar();",
+  "    if(c != EOF && c != '\\n') rt_line[rt_line_length++] = (char)c;",
+  "  } while(c != EOF && c != '\\n');",
+  "  rt_line[rt_line_length] = '\\0';",
+  "}",
+  "static inline int rt_read_int(void)",
+  "{",
+  "  rt_read_line();",
+  "  return (rt_line_length > 0) ? rt_toint(strtod(rt_line, NULL)) : 0;",
+  "}",
+  "static inline double rt_read_float(void)",
+  "{",
+  "  rt_read_line();",
+  "  return (rt_line_length > 0) ? strtod(rt_line, NULL) : 0.0;",
+  "}",
+  "static inline bool rt_read_bool(void)",
+  "{",
+  "  static const char word[] = \"true\";",
+  "  rt_read_line();",
+  "  if(rt_line_length != 4) return false;",
+  "  for(size_t i = 0; i < 4; i++)",
+  "    if(rt_line[i] != word[i] && rt_line[i] != word[i] - 'a' + 'A') return false;",
+  "  return true;",
+  "}",
+  "static inline Str * rt_read_string(void)",
+  "{",
+  "  rt_read_line();",
+  "  return rt_new(rt_line, rt_line_length);",
+  "}",
+  "static inline void rt_write_int(int i) { printf(\"% d\", i); }",
+  "static inline void rt_write_float(double f) { printf(\"% g\", f); }",
+  "static inline void rt_write_bool(bool b) { fputs(b ? \"true\" : \"false\", stdout); }",
+  "static inline void rt_write_string(const Str * s) { fwrite(s->data, 1, s->length, stdout); }",
+  "",
+  "/* debugging, frames do not exist */",
+  "static inline void rt_break(void) { fflush(stdout); }",
+  "static inline void rt_dprint_undefined(const char * name) { fprintf(stderr, \"%s()\\n\", name); }",
+  "static inline void rt_dprint_int(const char * name, int i) { fprintf(stderr, \"%s=%d(int)\\n\", name, i); }",
+  "static inline void rt_dprint_bool(const char * name, bool b) { fprintf(stderr, \"%s=%s(bool)\\n\", name, b ? \"true\" : \"false\"); }",
+  "static inline void rt_dprint_string(const char * name, const Str * s)",
+  "{",
+  "  fprintf(stderr, \"%s=\", name);",
+  "  fwrite(s->data, 1, s->length, stderr);",
+  "  fprintf(stderr, \"(string)\\n\");",
+  "}",
+  "static inline void rt_dprint_float(const char * name, double f)",
+  "{",
+  "  char buff[64];",
+  "  for(int precision = 6; precision <= 17; precision++)",
+  "  {",
+  "    snprintf(buff, sizeof(buff), \"%.*g\", precision, f);",
+  "    if(strtod(buff, NULL) == f) break;",
+  "  }",
+  "  fprintf(stderr, \"%s=%s(double)\\n\", name, buff);",
+  "}",
+  "",
+  "static void rt_init(void)",
+  "{",
+  "  static const char * names[] = {\"\", \"int\", \"float\", \"bool\", \"string\"};",
+  "  for(int c = 0; c < 256; c++)",
+  "  {",
+  "    char ch = (char)c;",
+  "    rt_chars[c] = rt_new(&ch, 1);",
+  "  }",
+  "  for(int t = 0; t < 5; t++) rt_types[t] = rt_new(names[t], strlen(names[t]));",
+  "}",
+  NULL
+};
+
+/*------------------------------ MAIN ------------------------------------*/
+
+bool PrintCSource()
+{
+  size_t count = 0;
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+    if(CodeGetUnit(u)->reachable && CodeGetUnit(u)->name != NULL) count++;
+  Translation * translations = calloc(count + 1, sizeof(Translation));
+  bool ok = (translations != NULL) && CollectStrings();
+
+  // types first, nothing is printed on a failure
+  size_t n = 0;
+  for(size_t u = 0; ok && u < CodeUnitCount(); u++)
+  {
+    CodeUnit * unit = CodeGetUnit(u);
+    if(!unit->reachable) continue;
+    if(unit->name == NULL) ok = CheckPrologue(unit);
+    else ok = InitTranslation(&translations[n++], unit);
+  }
+
+  if(ok)
+  {
+    fputs("/*\n"
+          " * Generated code\n"
+          " * IFJ\n"
+          " * xbenes49 xbolsh00 xpolan09\n"
+          " * 2017\n"
+          " */\n\n", stdout);
+    for(size_t l = 0; runtime[l] != NULL; l++) printf("%s\n", runtime[l]);
+
+    if(strings_count > 0) printf("\n/* constants */\nstatic Str * K[%zu];\n", strings_count);
+    printf("\n/* functions */\n");
+    for(size_t t = 0; t < n; t++)
+    {
+      PrintSignature(&translations[t]);
+      printf(";\n");
+    }
+    for(size_t t = 0; ok && t < n; t++) ok = PrintTranslation(&translations[t]);
+
+    printf("\nint main(void)\n{\n  rt_init();\n");
+    for(size_t s = 0; ok && s < strings_count; s++)
+    {
+      size_t length = 0;
+      printf("  K[%zu] = rt_new(", s);
+      ok = PrintStringLiteral(getStringConstValue(strings[s]), &length);
+      printf(", %zu);\n", length);
+    }
+    for(size_t t = 0; t < n; t++)
+      if(translations[t].result == 0) printf("  u_scope();\n");
+    printf("  fflush(stdout);\n  return 0;\n}\n");
+  }
+
+  #ifdef GENERATOR_DEBUG
+    debug("C source: %zu functions, %zu strings.", n, strings_count);
+  #endif
+  for(size_t t = 0; t < n; t++) FreeTranslation(&translations[t]);
+  free(translations);
+  free(strings);
+  strings = NULL;
+  strings_count = 0;
+  return ok;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file csource.h
+ * @interface csource
+ * @date 19th october 2026
+ * @brief C backend interface.
+ *
+ * This interface declares translation of the generated code into
+ * a portable C99 program, which is compiled natively (cc prog.c -lm).
+ *
+ * Every function becomes a C function with its parameters, the scope
+ * becomes the body of main(). Types of variables and of the values
+ * on the data stack are inferred over the control flow graph, so each
+ * of them is a typed C local (int, double, bool, or a reference counted
+ * string); a variable written with several types gets a local per type.
+ * Runtime errors, which are known at compile time (wrong types,
+ * uninitialized variables), are translated to the error at runtime.
+ * The runtime written in front of the program reproduces IFJcode17:
+ * 32-bit wrapping integers, rounding, string instructions, READ and WRITE.
+ * Errors exit with the codes of the interpreter, the message has no line.
+ */
+
+#ifndef CSOURCE_H
+#define CSOURCE_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Prints the reachable code as a C program.
+ *
+ * Nothing is printed, if the code cannot be typed statically
+ * (a value with more possible types is read); the reason
+ * is written to stderr.
+ * @returns True, if success. False otherwise.
+ */
+bool PrintCSource();
+
+#endif // CSOURCE_H
@@ -0,0 +1,587 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "dataflow.h"
+#include "io.h"
+
+/*------------------------------ SOLVER ------------------------------------*/
+
+bool DataflowInit(Dataflow * df, size_t count, size_t bits, DataflowDirection direction, DataflowMeet meet)
+{
+  memset(df, 0, sizeof(*df));
+  df->direction = direction;
+  df->meet = meet;
+  df->count = count;
+  df->bits = bits;
+  df->words = (bits + 63) / 64;
+
+  size_t total = count * df->words;
+  if(df->words > 0 && (total / df->words != count || total > DATAFLOW_MAX_WORDS / 4))
+  {
+    #ifdef OPTIMIZER_DEBUG
+      debug("Dataflow problem of %zu blocks and %zu facts is too large.", count, bits);
+    #endif
+    df->count = 0;
+    df->words = 0;
+    return true;
+  }
+  if(total == 0) total = 1;
+
+  df->gen = calloc(total, sizeof(uint64_t));
+  df->kill = calloc(total, sizeof(uint64_t));
+  df->in = calloc(total, sizeof(uint64_t));
+  df->out = calloc(total, sizeof(uint64_t));
+  if(df->gen == NULL || df->kill == NULL || df->in == NULL || df->out == NULL)
+  {
+    DataflowFree(df);
+    return false;
+  }
+  return true;
+}
+
+void DataflowFree(Dataflow * df)
+{
+  free(df->gen);
+  free(df->kill);
+  free(df->in);
+  free(df->out);
+  df->gen = df->kill = df->in = df->out = NULL;
+  df->count = 0;
+  df->solved = false;
+}
+
+/**
+ * @brief   Fills the set with the whole universe.
+ */
+static void Fill(const Dataflow * df, uint64_t * set)
+{
+  for(size_t w = 0; w < df->words; w++) set[w] = ~(uint64_t)0;
+  if(df->bits % 64 != 0) set[df->words - 1] = ((uint64_t)1 << (df->bits % 64)) - 1;
+}
+
+/**
+ * @brief   Postorder of the blocks.
+ *
+ * Depth-first search from the entry, unreachable blocks follow.
+ * @param cfg     Graph.
+ * @param order   Returned order.
+ * @returns True, if success. False otherwise.
+ */
+static bool Postorder(const Cfg * cfg, size_t * order)
+{
+  bool * visited = calloc(cfg->count, sizeof(bool));
+  size_t * stack = malloc(cfg->count * sizeof(size_t));
+  unsigned char * edge = calloc(cfg->count, 1);
+  if(visited == NULL || stack == NULL || edge == NULL)
+  {
+    free(visited);
+    free(stack);
+    free(edge);
+    return false;
+  }
+
+  size_t count = 0, top = 0;
+  stack[top++] = 0;
+  visited[0] = true;
+  while(top > 0)
+  {
+    size_t b = stack[top - 1];
+    size_t succ = CFG_NONE;
+    while(succ == CFG_NONE && edge[b] < 2)
+    {
+      succ = (edge[b]++ == 0) ? cfg->blocks[b].target : cfg->blocks[b].next;
+      if(succ != CFG_NONE && visited[succ]) succ = CFG_NONE;
+    }
+    if(succ == CFG_NONE)
+    {
+      order[count++] = b;
+      top--;
+      continue;
+    }
+    visited[succ] = true;
+    stack[top++] = succ;
+  }
+
+  for(size_t b = 0; b < cfg->count; b++)
+    if(!visited[b]) order[count++] = b;
+
+  free(visited);
+  free(stack);
+  free(edge);
+  return true;
+}
+
+/**
+ * @brief   Meet of the neighbours of the block.
+ *
+ * @param df      Problem.
+ * @param cfg     Graph.
+ * @param b       Block.
+ * @param result  Returned set.
+ */
+static void Meet(const Dataflow * df, const Cfg * cfg, size_t b, uint64_t * result)
+{
+  const BasicBlock * block = &cfg->blocks[b];
+  const size_t * neigh;
+  size_t count;
+  size_t succ[2];
+  const uint64_t * sets;
+
+  if(df->direction == Dataflow_Forward)
+  {
+    neigh = block->preds;
+    count = block->preds_count;
+    sets = df->out;
+  }
+  else
+  {
+    count = 0;
+    if(block->next != CFG_NONE) succ[count++] = block->next;
+    if(block->target != CFG_NONE && block->target != block->next) succ[count++] = block->target;
+    neigh = succ;
+    sets = df->in;
+  }
+
+  // boundary is the empty set
+  bool boundary = (df->direction == Dataflow_Forward) ? (b == 0) : (count == 0);
+  if(df->meet == Dataflow_Intersection && !boundary) Fill(df, result);
+  else memset(result, 0, df->words * sizeof(uint64_t));
+  if(df->meet == Dataflow_Intersection && boundary) return;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    const uint64_t * set = DataflowSet(df, sets, neigh[i]);
+    for(size_t w = 0; w < df->words; w++)
+    {
+      if(df->meet == Dataflow_Union) result[w] |= set[w];
+      else result[w] &= set[w];
+    }
+  }
+}
+
+bool DataflowSolve(Dataflow * df, const Cfg * cfg)
+{
+  df->solved = false;
+  df->passes = 0;
+  if(df->gen == NULL) return true;   // too large
+
+  size_t * order = malloc((cfg->count > 0 ? cfg->count : 1) * sizeof(size_t));
+  if(order == NULL || !Postorder(cfg, order))
+  {
+    free(order);
+    return false;
+  }
+
+  // initial sets: the whole universe for must problems
+  bool forward = (df->direction == Dataflow_Forward);
+  uint64_t * first = forward ? df->in : df->out;
+  uint64_t * second = forward ? df->out : df->in;
+  for(size_t b = 0; b < cfg->count; b++)
+    if(df->meet == Dataflow_Intersection)
+    {
+      Fill(df, DataflowSet(df, first, b));
+      Fill(df, DataflowSet(df, second, b));
+    }
+
+  for(bool changed = true; changed; df->passes++)
+  {
+    changed = false;
+    for(size_t k = 0; k < cfg->count; k++)
+    {
+      // reverse postorder for forward problems
+      size_t b = forward ? order[cfg->count - 1 - k] : order[k];
+      uint64_t * x = DataflowSet(df, first, b);
+      uint64_t * y = DataflowSet(df, second, b);
+      const uint64_t * gen = DataflowSet(df, df->gen, b);
+      const uint64_t * kill = DataflowSet(df, df->kill, b);
+
+      Meet(df, cfg, b, x);
+      for(size_t w = 0; w < df->words; w++)
+      {
+        uint64_t v = gen[w] | (x[w] & ~kill[w]);
+        if(v != y[w])
+        {
+          y[w] = v;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Dataflow problem of %zu blocks and %zu facts solved in %u passes.", df->count, df->bits, df->passes);
+  #endif
+
+  free(order);
+  df->solved = true;
+  return true;
+}
+
+/*------------------------------ VARIABLES ------------------------------------*/
+
+/**
+ * @brief   Compares atoms by their addresses.
+ */
+static int CompareAtoms(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)*(const char * const *)a;
+  uintptr_t y = (uintptr_t)*(const char * const *)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Local variable. */
+static bool IsLocal(const Operand * o)
+{
+  return o->type == Operand_Variable && o->d.var.frame == Frame_Local;
+}
+
+bool VariablesCollect(Variables * vars, const CodeUnit * u)
+{
+  vars->names = NULL;
+  vars->count = 0;
+
+  size_t count = 0;
+  for(size_t i = 0; i < u->count; i++)
+    for(unsigned a = 0; a < OpcodeArity(u->code[i].op); a++)
+      if(IsLocal(&u->code[i].arg[a])) count++;
+  if(count == 0) return true;
+
+  vars->names = malloc(count * sizeof(const char *));
+  if(vars->names == NULL) return false;
+  for(size_t i = 0; i < u->count; i++)
+    for(unsigned a = 0; a < OpcodeArity(u->code[i].op); a++)
+      if(IsLocal(&u->code[i].arg[a])) vars->names[vars->count++] = u->code[i].arg[a].d.var.name;
+
+  // unique
+  qsort(vars->names, vars->count, sizeof(const char *), CompareAtoms);
+  size_t n = 0;
+  for(size_t i = 0; i < vars->count; i++)
+    if(n == 0 || vars->names[n-1] != vars->names[i]) vars->names[n++] = vars->names[i];
+  vars->count = n;
+  return true;
+}
+
+size_t VariableIndex(const Variables * vars, const Operand * o)
+{
+  if(!IsLocal(o) || vars->count == 0) return CFG_NONE;
+  const char ** found = bsearch(&o->d.var.name, vars->names, vars->count, sizeof(const char *), CompareAtoms);
+  return (found != NULL) ? (size_t)(found - vars->names) : CFG_NONE;
+}
+
+void VariablesFree(Variables * vars)
+{
+  free((void *)vars->names);
+  vars->names = NULL;
+  vars->count = 0;
+}
+
+bool InstructionReads(const Instruction * ins, unsigned a)
+{
+  if(a >= OpcodeArity(ins->op) || ins->arg[a].type != Operand_Variable) return false;
+  if(ins->op == Opcode_Setchar) return true;    // modifies its first operand
+  return a > 0 || !OpcodeWrites(ins->op);
+}
+
+/**
+ * @brief   Local variable written by the instruction.
+ *
+ * @returns Index of the variable, or CFG_NONE.
+ */
+static size_t Written(const Variables * vars, const Instruction * ins)
+{
+  if(!OpcodeWrites(ins->op)) return CFG_NONE;
+  return VariableIndex(vars, &ins->arg[0]);
+}
+
+void FactsFree(Facts * facts)
+{
+  free(facts->sites);
+  free(facts->fact);
+  facts->sites = facts->fact = NULL;
+  facts->count = 0;
+}
+
+/**
+ * @brief   Groups facts by variables.
+ *
+ * @param vars      Variables.
+ * @param count     Number of (fact, variable) pairs.
+ * @param pairs     Pairs, variable of each pair is pairs[2*i+1].
+ * @param start     Returned beginning of the group of each variable (vars->count + 1 items).
+ * @param group     Returned facts ordered by variables.
+ * @returns True, if success. False otherwise.
+ */
+static bool GroupByVariable(const Variables * vars, size_t count, const size_t * pairs, size_t ** start, size_t ** group)
+{
+  *start = calloc(vars->count + 1, sizeof(size_t));
+  *group = malloc((count > 0 ? count : 1) * sizeof(size_t));
+  if(*start == NULL || *group == NULL)
+  {
+    free(*start);
+    free(*group);
+    return false;
+  }
+
+  for(size_t i = 0; i < count; i++) (*start)[pairs[2*i+1] + 1]++;
+  for(size_t v = 0; v < vars->count; v++) (*start)[v+1] += (*start)[v];
+  size_t * fill = malloc((vars->count > 0 ? vars->count : 1) * sizeof(size_t));
+  if(fill == NULL)
+  {
+    free(*start);
+    free(*group);
+    return false;
+  }
+  memcpy(fill, *start, vars->count * sizeof(size_t));
+  for(size_t i = 0; i < count; i++) (*group)[fill[pairs[2*i+1]]++] = pairs[2*i];
+  free(fill);
+  return true;
+}
+
+/*------------------------------ CLIENTS ------------------------------------*/
+
+bool Liveness(Dataflow * df, const Cfg * cfg, const Variables * vars)
+{
+  if(!DataflowInit(df, cfg->count, vars->count, Dataflow_Backward, Dataflow_Union)) return false;
+  if(df->gen == NULL) return true;
+
+  const CodeUnit * u = cfg->unit;
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    uint64_t * gen = DataflowSet(df, df->gen, b);
+    uint64_t * kill = DataflowSet(df, df->kill, b);
+    // upward exposed uses
+    for(size_t i = cfg->blocks[b].end; i-- > cfg->blocks[b].start;)
+    {
+      const Instruction * ins = &u->code[i];
+      size_t v = Written(vars, ins);
+      if(v != CFG_NONE && ins->op != Opcode_Setchar)
+      {
+        BitClear(gen, v);
+        BitSet(kill, v);
+      }
+      for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+        if(InstructionReads(ins, a) && (v = VariableIndex(vars, &ins->arg[a])) != CFG_NONE) BitSet(gen, v);
+    }
+  }
+  return DataflowSolve(df, cfg);
+}
+
+bool ReachingDefinitions(Dataflow * df, const Cfg * cfg, const Variables * vars, Facts * defs)
+{
+  const CodeUnit * u = cfg->unit;
+  memset(defs, 0, sizeof(*defs));
+  defs->fact = malloc((u->count > 0 ? u->count : 1) * sizeof(size_t));
+  defs->sites = malloc((u->count > 0 ? u->count : 1) * sizeof(size_t));
+  size_t * pairs = malloc((u->count > 0 ? 2 * u->count : 1) * sizeof(size_t));
+  size_t * last = malloc((vars->count > 0 ? vars->count : 1) * sizeof(size_t));
+  size_t * start = NULL, * group = NULL;
+  bool ok = (defs->fact != NULL && defs->sites != NULL && pairs != NULL && last != NULL);
+
+  for(size_t i = 0; ok && i < u->count; i++)
+  {
+    size_t v = Written(vars, &u->code[i]);
+    defs->fact[i] = CFG_NONE;
+    if(v == CFG_NONE) continue;
+    pairs[2 * defs->count] = defs->count;
+    pairs[2 * defs->count + 1] = v;
+    defs->fact[i] = defs->count;
+    defs->sites[defs->count++] = i;
+  }
+
+  ok = ok && GroupByVariable(vars, defs->count, pairs, &start, &group);
+  ok = ok && DataflowInit(df, cfg->count, defs->count, Dataflow_Forward, Dataflow_Union);
+
+  for(size_t v = 0; ok && v < vars->count; v++) last[v] = CFG_NONE;
+  for(size_t b = 0; ok && df->gen != NULL && b < cfg->count; b++)
+  {
+    uint64_t * gen = DataflowSet(df, df->gen, b);
+    uint64_t * kill = DataflowSet(df, df->kill, b);
+
+    // the last definition of each variable is generated, all the others are killed
+    for(size_t i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++)
+    {
+      size_t d = defs->fact[i];
+      if(d == CFG_NONE) continue;
+      size_t v = pairs[2*d+1];
+      if(last[v] == CFG_NONE)
+        for(size_t k = start[v]; k < start[v+1]; k++) BitSet(kill, group[k]);
+      last[v] = d;
+    }
+    for(size_t i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++)
+    {
+      size_t d = defs->fact[i];
+      if(d == CFG_NONE) continue;
+      size_t v = pairs[2*d+1];
+      if(last[v] == d) BitSet(gen, d);
+    }
+    for(size_t i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++)
+      if(defs->fact[i] != CFG_NONE) last[pairs[2*defs->fact[i]+1]] = CFG_NONE;
+  }
+
+  ok = ok && DataflowSolve(df, cfg);
+  free(pairs);
+  free(last);
+  free(start);
+  free(group);
+  if(!ok)
+  {
+    FactsFree(defs);
+    DataflowFree(df);
+  }
+  return ok;
+}
+
+/**
+ * @brief   Instruction computes an expression.
+ *
+ * Three-address instruction without side effects, whose operands
+ * are local variables or constants.
+ */
+static bool IsExpression(const Instruction * ins)
+{
+  Opcode op = ins->op;
+  if(!OpcodeWrites(op) || OpcodeArity(op) < 2) return false;
+  if(op == Opcode_Move || op == Opcode_Defvar || op == Opcode_Pops || op == Opcode_Read || op == Opcode_Setchar)
+    return false;
+  if(!IsLocal(&ins->arg[0])) return false;
+  for(unsigned a = 1; a < OpcodeArity(op); a++)
+  {
+    const Operand * o = &ins->arg[a];
+    if(o->type == Operand_Variable && !IsLocal(o)) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Compares operands.
+ */
+static int CompareOperands(const Operand * a, const Operand * b)
+{
+  if(a->type != b->type) return (a->type > b->type) - (a->type < b->type);
+  uintptr_t x = 0, y = 0;
+  switch(a->type)
+  {
+    case Operand_Variable: x = (uintptr_t)a->d.var.name; y = (uintptr_t)b->d.var.name; break;
+    case Operand_Constant: x = a->d.index; y = b->d.index; break;
+    case Operand_Bool: x = a->d.b; y = b->d.b; break;
+    case Operand_Type: x = a->d.dt; y = b->d.dt; break;
+    default: break;
+  }
+  return (x > y) - (x < y);
+}
+
+/** @brief Code of the unit, which is sorted. */
+static const CodeUnit * sortedUnit = NULL;
+
+/**
+ * @brief   Compares computations of instructions.
+ */
+static int CompareExpressions(const void * a, const void * b)
+{
+  const Instruction * x = &sortedUnit->code[*(const size_t *)a];
+  const Instruction * y = &sortedUnit->code[*(const size_t *)b];
+  if(x->op != y->op) return (x->op > y->op) - (x->op < y->op);
+  for(unsigned i = 1; i < OpcodeArity(x->op); i++)
+  {
+    int c = CompareOperands(&x->arg[i], &y->arg[i]);
+    if(c != 0) return c;
+  }
+  // the first computation represents the expression
+  return (*(const size_t *)a > *(const size_t *)b) - (*(const size_t *)a < *(const size_t *)b);
+}
+
+bool AvailableExpressions(Dataflow * df, const Cfg * cfg, const Variables * vars, Facts * exprs)
+{
+  const CodeUnit * u = cfg->unit;
+  memset(exprs, 0, sizeof(*exprs));
+  exprs->fact = malloc((u->count > 0 ? u->count : 1) * sizeof(size_t));
+  exprs->sites = malloc((u->count > 0 ? u->count : 1) * sizeof(size_t));
+  size_t * sorted = malloc((u->count > 0 ? u->count : 1) * sizeof(size_t));
+  size_t * pairs = malloc((u->count > 0 ? 2 * CODE_MAX_OPERANDS * u->count : 1) * sizeof(size_t));
+  size_t * start = NULL, * group = NULL;
+  bool ok = (exprs->fact != NULL && exprs->sites != NULL && sorted != NULL && pairs != NULL);
+
+  // same computations are one expression
+  size_t count = 0;
+  for(size_t i = 0; ok && i < u->count; i++)
+  {
+    exprs->fact[i] = CFG_NONE;
+    if(IsExpression(&u->code[i])) sorted[count++] = i;
+  }
+  if(ok)
+  {
+    sortedUnit = u;
+    qsort(sorted, count, sizeof(size_t), CompareExpressions);
+    sortedUnit = NULL;
+  }
+  size_t npairs = 0;
+  for(size_t k = 0; ok && k < count; k++)
+  {
+    size_t i = sorted[k];
+    bool same = false;
+    if(k > 0)
+    {
+      const Instruction * x = &u->code[sorted[k-1]], * y = &u->code[i];
+      same = (x->op == y->op);
+      for(unsigned a = 1; same && a < OpcodeArity(x->op); a++) same = (CompareOperands(&x->arg[a], &y->arg[a]) == 0);
+    }
+    if(!same)
+    {
+      exprs->sites[exprs->count++] = i;
+      // variables of the expression
+      for(unsigned a = 1; a < OpcodeArity(u->code[i].op); a++)
+      {
+        size_t v = VariableIndex(vars, &u->code[i].arg[a]);
+        if(v == CFG_NONE) continue;
+        pairs[2*npairs] = exprs->count - 1;
+        pairs[2*npairs+1] = v;
+        npairs++;
+      }
+    }
+    exprs->fact[i] = exprs->count - 1;
+  }
+
+  ok = ok && GroupByVariable(vars, npairs, pairs, &start, &group);
+  ok = ok && DataflowInit(df, cfg->count, exprs->count, Dataflow_Forward, Dataflow_Intersection);
+
+  for(size_t b = 0; ok && df->gen != NULL && b < cfg->count; b++)
+  {
+    uint64_t * gen = DataflowSet(df, df->gen, b);
+    uint64_t * kill = DataflowSet(df, df->kill, b);
+
+    for(size_t i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++)
+    {
+      const Instruction * ins = &u->code[i];
+      size_t v = Written(vars, ins);
+      if(v != CFG_NONE)
+        for(size_t k = start[v]; k < start[v+1]; k++)
+        {
+          BitClear(gen, group[k]);
+          BitSet(kill, group[k]);
+        }
+
+      // computation, which does not overwrite its own operand
+      size_t e = exprs->fact[i];
+      bool own = false;
+      for(unsigned a = 1; e != CFG_NONE && a < OpcodeArity(ins->op); a++)
+        own = own || (v != CFG_NONE && VariableIndex(vars, &ins->arg[a]) == v);
+      if(e != CFG_NONE && !own) BitSet(gen, e);
+    }
+  }
+
+  ok = ok && DataflowSolve(df, cfg);
+  free(sorted);
+  free(pairs);
+  free(start);
+  free(group);
+  if(!ok)
+  {
+    FactsFree(exprs);
+    DataflowFree(df);
+  }
+  return ok;
+}
@@ -0,0 +1,224 @@
+/**
+ * @file dataflow.h
+ * @interface dataflow
+ * @date 18th october 2026
+ * @brief Dataflow analysis interface.
+ *
+ * This interface declares a solver of bit-vector dataflow problems
+ * over the control flow graph of a unit, and its clients: liveness
+ * of variables, reaching definitions and available expressions.
+ */
+
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfg.h"
+#include "code.h"
+
+/*-----------------------------------------------------------*/
+/** @addtogroup Dataflow_types
+ * Types of the dataflow analysis.
+ * @{
+ */
+
+/** @brief Maximal number of words of all the sets of a problem, larger problems are not solved. */
+#define DATAFLOW_MAX_WORDS (1u << 22)
+
+/**
+ * @brief   Direction of a problem.
+ */
+typedef enum
+{
+  Dataflow_Forward,       /**< From the entry, over predecessors. */
+  Dataflow_Backward       /**< From the exits, over successors. */
+} DataflowDirection;
+
+/**
+ * @brief   Meet of a problem.
+ */
+typedef enum
+{
+  Dataflow_Union,         /**< May problem. */
+  Dataflow_Intersection   /**< Must problem. */
+} DataflowMeet;
+
+/**
+ * @brief   Bit-vector dataflow problem.
+ *
+ * Sets of a block are words [b * words, (b + 1) * words) of the arrays.
+ * Transfer function of a block is gen | (x & ~kill).
+ */
+typedef struct
+{
+  DataflowDirection direction;    /**< Direction. */
+  DataflowMeet meet;              /**< Meet. */
+  size_t count;                   /**< Number of blocks. */
+  size_t bits;                    /**< Size of the universe. */
+  size_t words;                   /**< Words of one set. */
+  uint64_t * gen;                 /**< Generated facts of blocks. */
+  uint64_t * kill;                /**< Killed facts of blocks. */
+  uint64_t * in;                  /**< Facts at the beginnings of blocks. */
+  uint64_t * out;                 /**< Facts at the ends of blocks. */
+  bool solved;                    /**< Problem was solved (it was not too large). */
+  unsigned passes;                /**< Passes of the solver. */
+} Dataflow;
+
+/**
+ * @brief   Local variables of a unit.
+ */
+typedef struct
+{
+  const char ** names;            /**< Names (atoms) sorted by address. */
+  size_t count;                   /**< Number of variables. */
+} Variables;
+
+/**
+ * @brief   Instructions, which are facts of a problem.
+ *
+ * Definitions, or the first computations of expressions.
+ */
+typedef struct
+{
+  size_t * sites;                 /**< Instruction of each fact. */
+  size_t count;                   /**< Number of facts. */
+  size_t * fact;                  /**< Fact of each instruction, or CFG_NONE. */
+} Facts;
+
+/** @} */
+/*-----------------------------------------------------------*/
+/** @addtogroup Dataflow_main
+ * Functions of the dataflow analysis.
+ * @{
+ */
+
+/** @brief Sets of the block. */
+#define DataflowSet(df, sets, b) ((sets) + (b) * (df)->words)
+
+/** @brief Tests bit of the set. */
+#define BitTest(set, i) (((set)[(i) / 64] >> ((i) % 64)) & 1)
+
+/** @brief Sets bit of the set. */
+#define BitSet(set, i) ((set)[(i) / 64] |= (uint64_t)1 << ((i) % 64))
+
+/** @brief Clears bit of the set. */
+#define BitClear(set, i) ((set)[(i) / 64] &= ~((uint64_t)1 << ((i) % 64)))
+
+/**
+ * @brief   Creates a problem with empty sets.
+ *
+ * If the sets would exceed DATAFLOW_MAX_WORDS, no memory is allocated
+ * and the problem stays unsolved.
+ * @param df          Problem.
+ * @param count       Number of blocks.
+ * @param bits        Size of the universe.
+ * @param direction   Direction.
+ * @param meet        Meet.
+ * @returns True, if success. False otherwise.
+ */
+bool DataflowInit(Dataflow * df, size_t count, size_t bits, DataflowDirection direction, DataflowMeet meet);
+
+/**
+ * @brief   Solves the problem.
+ *
+ * Blocks are visited in reverse postorder (postorder for backward
+ * problems) until nothing changes. The boundary (the entry, or the exits)
+ * is the empty set.
+ * @param df          Problem with gen and kill sets.
+ * @param cfg         Graph.
+ * @returns True, if success. False otherwise.
+ */
+bool DataflowSolve(Dataflow * df, const Cfg * cfg);
+
+/**
+ * @brief   Destroys the problem.
+ *
+ * @param df          Problem.
+ */
+void DataflowFree(Dataflow * df);
+
+/**
+ * @brief   Collects local variables of the unit.
+ *
+ * @param vars        Variables to fill.
+ * @param u           Unit.
+ * @returns True, if success. False otherwise.
+ */
+bool VariablesCollect(Variables * vars, const CodeUnit * u);
+
+/**
+ * @brief   Index of a variable.
+ *
+ * @param vars        Variables.
+ * @param o           Operand.
+ * @returns Index, or CFG_NONE, if not a local variable.
+ */
+size_t VariableIndex(const Variables * vars, const Operand * o);
+
+/**
+ * @brief   Destroys the variables.
+ *
+ * @param vars        Variables.
+ */
+void VariablesFree(Variables * vars);
+
+/**
+ * @brief   Operand is read by the instruction.
+ *
+ * @param ins         Instruction.
+ * @param a           Index of the operand.
+ * @returns True, if read variable. False otherwise.
+ */
+bool InstructionReads(const Instruction * ins, unsigned a);
+
+/**
+ * @brief   Liveness of variables.
+ *
+ * Backward may problem over the variables.
+ * @param df          Problem to fill and solve.
+ * @param cfg         Graph.
+ * @param vars        Variables of the unit.
+ * @returns True, if success. False otherwise.
+ */
+bool Liveness(Dataflow * df, const Cfg * cfg, const Variables * vars);
+
+/**
+ * @brief   Reaching definitions.
+ *
+ * Forward may problem over the instructions writing local variables.
+ * @param df          Problem to fill and solve.
+ * @param cfg         Graph.
+ * @param vars        Variables of the unit.
+ * @param defs        Returned definitions.
+ * @returns True, if success. False otherwise.
+ */
+bool ReachingDefinitions(Dataflow * df, const Cfg * cfg, const Variables * vars, Facts * defs);
+
+/**
+ * @brief   Available expressions.
+ *
+ * Forward must problem over the computations of three-address
+ * instructions with local or constant operands. Same computations
+ * share one fact.
+ * @param df          Problem to fill and solve.
+ * @param cfg         Graph.
+ * @param vars        Variables of the unit.
+ * @param exprs       Returned expressions.
+ * @returns True, if success. False otherwise.
+ */
+bool AvailableExpressions(Dataflow * df, const Cfg * cfg, const Variables * vars, Facts * exprs);
+
+/**
+ * @brief   Destroys the facts.
+ *
+ * @param facts       Facts.
+ */
+void FactsFree(Facts * facts);
+
+/** @} */
+/*-----------------------------------------------------------*/
+
+#endif // DATAFLOW_H
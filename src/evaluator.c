@@ -0,0 +1,320 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "evaluator.h"
+#include "fold.h"
+#include "io.h"
+#include "tables.h"
+
+/**
+ * @brief   Variable of a frame.
+ */
+typedef struct
+{
+  const char * name;      /**< Name without the frame. */
+  Operand value;          /**< Value, Operand_None if not initialized. */
+} Cell;
+
+/**
+ * @brief   Frame of variables.
+ */
+typedef struct
+{
+  Cell * cells;
+  size_t count, capacity;
+} Activation;
+
+/**
+ * @brief   Position in the code.
+ */
+typedef struct
+{
+  const Instruction * code;   /**< Instructions. */
+  size_t count;               /**< Number of instructions. */
+  size_t at;                  /**< Next instruction. */
+} Position;
+
+/**
+ * @brief   State of the evaluation.
+ */
+typedef struct
+{
+  Activation * frames;        /**< Stack of frames, the local frame is on the top. */
+  size_t frames_count, frames_capacity;
+  Activation temporary;       /**< Temporary frame. */
+  bool temporary_defined;     /**< Temporary frame exists. */
+  Operand * stack;            /**< Data stack. */
+  size_t top, stack_capacity;
+  Position * calls;           /**< Return positions. */
+  size_t depth, calls_capacity;
+  Position pc;                /**< Current position. */
+  bool failed;                /**< Evaluation failed. */
+} Machine;
+
+/**
+ * @brief   Makes room for one more item of the array.
+ *
+ * @returns True, if success. False otherwise.
+ */
+static bool Reserve(void ** array, size_t * capacity, size_t count, size_t size)
+{
+  if(count < *capacity) return true;
+  size_t grown = (*capacity == 0) ? 16 : 2 * *capacity;
+  void * p = realloc(*array, grown * size);
+  if(p == NULL) return false;
+  *array = p;
+  *capacity = grown;
+  return true;
+}
+
+/*------------------------------ VARIABLES ------------------------------------*/
+
+/**
+ * @brief   Cell of the variable.
+ *
+ * @param define  Defines the variable, if not defined yet.
+ * @returns Cell, or NULL.
+ */
+static Cell * Lookup(Machine * M, const Operand * var, bool define)
+{
+  if(var->type != Operand_Variable) return NULL;
+  Activation * a = NULL;
+  if(var->d.var.frame == Frame_Local && M->frames_count > 0) a = &M->frames[M->frames_count - 1];
+  else if(var->d.var.frame == Frame_Temporary && M->temporary_defined) a = &M->temporary;
+  if(a == NULL) return NULL;
+
+  // names of variables are compared without frames (LF@x is TF@x after PUSHFRAME)
+  const char * name = var->d.var.name + 3;
+  for(size_t i = 0; i < a->count; i++)
+    if(a->cells[i].name == name || strcmp(a->cells[i].name, name) == 0) return &a->cells[i];
+  if(!define || !Reserve((void **)&a->cells, &a->capacity, a->count, sizeof(Cell))) return NULL;
+  a->cells[a->count] = (Cell){name, {.type = Operand_None}};
+  return &a->cells[a->count++];
+}
+
+/** @brief Value of the operand, Operand_None on failure. */
+static Operand Read(Machine * M, const Operand * o)
+{
+  if(OperandIsConstant(o)) return *o;
+  Cell * c = Lookup(M, o, false);
+  if(c == NULL || c->value.type == Operand_None)
+  {
+    M->failed = true;
+    return (Operand){.type = Operand_None};
+  }
+  return c->value;
+}
+
+/** @brief Writes the defined variable. */
+static void Write(Machine * M, const Operand * var, Operand value)
+{
+  // scratch variables (*tmp) are defined after the optimizations
+  bool scratch = (var->type == Operand_Variable && var->d.var.name[3] == '*');
+  Cell * c = Lookup(M, var, scratch);
+  if(c == NULL || (value.type != Operand_Constant && value.type != Operand_Bool))
+  {
+    M->failed = true;
+    return;
+  }
+  if(value.type == Operand_Constant && findConstType(value.d.index) == DataType_String
+     && strlen(getStringConstValue(value.d.index)) > EVALUATOR_MAX_STRING) M->failed = true;
+  c->value = value;
+}
+
+/*------------------------------ STACK ------------------------------------*/
+
+/** @brief Pushes the value. */
+static void Push(Machine * M, Operand value)
+{
+  if(!Reserve((void **)&M->stack, &M->stack_capacity, M->top, sizeof(Operand))) M->failed = true;
+  else M->stack[M->top++] = value;
+}
+
+/** @brief Pops the value. */
+static Operand Pop(Machine * M)
+{
+  if(M->top > 0) return M->stack[--M->top];
+  M->failed = true;
+  return (Operand){.type = Operand_None};
+}
+
+/*------------------------------ CONTROL ------------------------------------*/
+
+/** @brief Jumps to the label of the current code. */
+static void Jump(Machine * M, const char * label)
+{
+  for(size_t i = 0; i < M->pc.count; i++)
+    if(M->pc.code[i].op == Opcode_Label && M->pc.code[i].arg[0].d.label == label)
+    {
+      M->pc.at = i + 1;
+      return;
+    }
+  M->failed = true;
+}
+
+/** @brief Calls the function. */
+static void Call(Machine * M, const char * label)
+{
+  const CodeUnit * u = CodeFindUnit(label);
+  if(u == NULL || M->depth >= EVALUATOR_MAX_DEPTH
+     || !Reserve((void **)&M->calls, &M->calls_capacity, M->depth, sizeof(Position)))
+  {
+    M->failed = true;
+    return;
+  }
+  M->calls[M->depth++] = M->pc;
+  M->pc = (Position){u->code, u->count, 0};
+}
+
+/** @brief Frees the frame. */
+static void FreeActivation(Activation * a)
+{
+  free(a->cells);
+  *a = (Activation){0};
+}
+
+/*------------------------------ INSTRUCTIONS ------------------------------------*/
+
+/**
+ * @brief   Executes the instruction.
+ */
+static void Execute(Machine * M, const Instruction * ins)
+{
+  Operand a, b, result;
+  bool taken;
+  switch(ins->op)
+  {
+    case Opcode_Comment: case Opcode_Label: return;
+    case Opcode_Defvar:
+      // definitions are hoisted later, so a repeated definition keeps the value
+      if(Lookup(M, &ins->arg[0], true) == NULL) M->failed = true;
+      return;
+
+    case Opcode_CreateFrame:
+      FreeActivation(&M->temporary);
+      M->temporary_defined = true;
+      return;
+    case Opcode_PushFrame:
+      if(!M->temporary_defined || !Reserve((void **)&M->frames, &M->frames_capacity, M->frames_count, sizeof(Activation)))
+      {
+        M->failed = true;
+        return;
+      }
+      M->frames[M->frames_count++] = M->temporary;
+      M->temporary = (Activation){0};
+      M->temporary_defined = false;
+      return;
+    case Opcode_PopFrame:
+      if(M->frames_count == 0)
+      {
+        M->failed = true;
+        return;
+      }
+      FreeActivation(&M->temporary);
+      M->temporary = M->frames[--M->frames_count];
+      M->temporary_defined = true;
+      return;
+
+    case Opcode_Call: Call(M, ins->arg[0].d.label); return;
+    case Opcode_Return:
+      if(M->depth == 0) M->failed = true;
+      else M->pc = M->calls[--M->depth];
+      return;
+    case Opcode_Jump: Jump(M, ins->arg[0].d.label); return;
+
+    case Opcode_JumpIfEq: case Opcode_JumpIfNeq:
+      a = Read(M, &ins->arg[1]);
+      b = Read(M, &ins->arg[2]);
+      if(M->failed) return;
+      if(!FoldJump(ins->op, &a, &b, &taken)) M->failed = true;
+      else if(taken) Jump(M, ins->arg[0].d.label);
+      return;
+    case Opcode_JumpIfEqs: case Opcode_JumpIfNeqs:
+      b = Pop(M);
+      a = Pop(M);
+      if(M->failed) return;
+      if(!FoldJump(ins->op, &a, &b, &taken)) M->failed = true;
+      else if(taken) Jump(M, ins->arg[0].d.label);
+      return;
+
+    case Opcode_Pushs:
+      a = Read(M, &ins->arg[0]);
+      if(!M->failed) Push(M, a);
+      return;
+    case Opcode_Pops:
+      a = Pop(M);
+      if(!M->failed) Write(M, &ins->arg[0], a);
+      return;
+    case Opcode_Clears:
+      M->top = 0;
+      return;
+
+    case Opcode_Read: case Opcode_Write: case Opcode_Setchar: case Opcode_Type:
+    case Opcode_Break: case Opcode_Dprint:
+      M->failed = true;
+      return;
+
+    default: break;
+  }
+
+  unsigned arity = OpcodeArity(ins->op);
+  if(arity == 0 && OpcodeStackPushes(ins->op) == 1 && OpcodeStackPops(ins->op) <= 2)
+  {
+    // stack operation
+    unsigned n = OpcodeStackPops(ins->op);
+    b = (n > 1) ? Pop(M) : (Operand){.type = Operand_None};
+    a = Pop(M);
+    if(M->failed || !FoldOperation(ins->op, &a, (n > 1) ? &b : NULL, &result)) M->failed = true;
+    else Push(M, result);
+  }
+  else if(OpcodeWrites(ins->op) && arity >= 2)
+  {
+    // three-address operation
+    a = Read(M, &ins->arg[1]);
+    b = (arity > 2) ? Read(M, &ins->arg[2]) : (Operand){.type = Operand_None};
+    if(M->failed || !FoldOperation(ins->op, &a, (arity > 2) ? &b : NULL, &result)) M->failed = true;
+    else Write(M, &ins->arg[0], result);
+  }
+  else M->failed = true;
+}
+
+bool EvaluateCode(const Instruction * code, size_t count, Operand * result)
+{
+  Machine M = {.pc = {code, count, 0}};
+  unsigned long steps = 0;
+
+  // local frame of the evaluated code (for its scratch variables)
+  M.temporary_defined = true;
+  Execute(&M, &(Instruction){.op = Opcode_PushFrame});
+
+  while(!M.failed)
+  {
+    if(M.pc.at == M.pc.count)
+    {
+      // the end of the evaluated code, or of a function without return
+      if(M.depth > 0) M.failed = true;
+      break;
+    }
+    if(++steps > EVALUATOR_MAX_STEPS)
+    {
+      M.failed = true;
+      break;
+    }
+    Execute(&M, &M.pc.code[M.pc.at++]);
+  }
+
+  bool ok = !M.failed && M.top == 1;
+  if(ok) *result = M.stack[0];
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Evaluation %s after %lu steps.", ok ? "succeeded" : "failed", steps);
+  #endif
+  for(size_t i = 0; i < M.frames_count; i++) FreeActivation(&M.frames[i]);
+  FreeActivation(&M.temporary);
+  free(M.frames);
+  free(M.stack);
+  free(M.calls);
+  return ok;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file evaluator.h
+ * @interface evaluator
+ * @date 19th october 2026
+ * @brief Code evaluator interface.
+ *
+ * This interface declares evaluation of generated code at compile time.
+ */
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "code.h"
+
+/** @brief Maximal number of evaluated instructions. */
+#define EVALUATOR_MAX_STEPS 100000
+
+/** @brief Maximal depth of calls. */
+#define EVALUATOR_MAX_DEPTH 100
+
+/** @brief Maximal length of a string value (escaped form). */
+#define EVALUATOR_MAX_STRING 1024
+
+/**
+ * @brief   Evaluates the code.
+ *
+ * The code runs from the first instruction to its end, called functions
+ * are taken from their units. It must not use global variables, input
+ * or output, and it must leave exactly one value on the data stack.
+ * Its local frame is empty, scratch variables (*tmp) are defined
+ * by writing them.
+ * Evaluation fails on a runtime error, or when a limit is reached.
+ * @param code    Instructions (a call with its arguments).
+ * @param count   Number of instructions.
+ * @param result  Returned constant.
+ * @returns True, if evaluated. False otherwise.
+ */
+bool EvaluateCode(const Instruction * code, size_t count, Operand * result);
+
+#endif // EVALUATOR_H
@@ -0,0 +1,324 @@
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "fold.h"
+#include "tables.h"
+
+/**
+ * @brief   Value of a constant operand.
+ */
+typedef struct
+{
+  DataType type;      /**< Type, DataType_Unknown for booleans. */
+  int i;              /**< Integer. */
+  double d;           /**< Double. */
+  const char * s;     /**< String (escaped form of IFJcode17). */
+  bool b;             /**< Boolean. */
+} Value;
+
+bool OperandIsConstant(const Operand * o)
+{
+  return o != NULL && (o->type == Operand_Constant || o->type == Operand_Bool);
+}
+
+/**
+ * @brief   Loads the value of the constant.
+ *
+ * @returns True, if constant. False otherwise.
+ */
+static bool Load(const Operand * o, Value * v)
+{
+  if(o == NULL) return false;
+  if(o->type == Operand_Bool)
+  {
+    *v = (Value){.type = DataType_Unknown, .b = o->d.b};
+    return true;
+  }
+  if(o->type != Operand_Constant) return false;
+
+  v->type = findConstType(o->d.index);
+  switch(v->type)
+  {
+    case DataType_Integer: v->i = getIntConstValue(o->d.index); return true;
+    case DataType_Double: v->d = getDoubleConstValue(o->d.index); return true;
+    case DataType_String: v->s = getStringConstValue(o->d.index); return v->s != NULL;
+    default: return false;
+  }
+}
+
+size_t DecodeString(const char * s, char * out)
+{
+  size_t n = 0;
+  while(*s != '\0')
+  {
+    char c = *s++;
+    if(c == '\\' && s[0] != '\0' && s[1] != '\0' && s[2] != '\0')
+    {
+      c = (char)((s[0] - '0') * 100 + (s[1] - '0') * 10 + (s[2] - '0'));
+      s += 3;
+    }
+    if(out != NULL) out[n] = c;
+    n++;
+  }
+  return n;
+}
+
+/**
+ * @brief   Decodes the escaped string into a new buffer.
+ *
+ * @returns Buffer, or NULL.
+ */
+static char * DecodeCopy(const char * s, size_t * length)
+{
+  *length = DecodeString(s, NULL);
+  char * out = malloc(*length + 1);
+  if(out != NULL) DecodeString(s, out);
+  return out;
+}
+
+/**
+ * @brief   Compares decoded strings.
+ *
+ * @returns True, if compared. False otherwise.
+ */
+static bool CompareStrings(const char * x, const char * y, int * cmp)
+{
+  size_t lx, ly;
+  char * dx = DecodeCopy(x, &lx);
+  char * dy = DecodeCopy(y, &ly);
+  bool ok = (dx != NULL && dy != NULL);
+  if(ok)
+  {
+    int c = memcmp(dx, dy, (lx < ly) ? lx : ly);
+    *cmp = (c != 0) ? c : (lx > ly) - (lx < ly);
+  }
+  free(dx);
+  free(dy);
+  return ok;
+}
+
+/**
+ * @brief   Compares values of the same type.
+ *
+ * @returns True, if compared. False otherwise.
+ */
+static bool Compare(const Value * x, const Value * y, int * cmp)
+{
+  if(x->type != y->type) return false;
+  switch(x->type)
+  {
+    case DataType_Integer: *cmp = (x->i > y->i) - (x->i < y->i); return true;
+    case DataType_Double:
+      if(isnan(x->d) || isnan(y->d)) return false;
+      *cmp = (x->d > y->d) - (x->d < y->d);
+      return true;
+    case DataType_String: return CompareStrings(x->s, y->s, cmp);
+    case DataType_Unknown: *cmp = (int)x->b - (int)y->b; return true;
+    default: return false;
+  }
+}
+
+/**
+ * @brief   Integer result, if it does not overflow.
+ */
+static bool Integer(long long r, Operand * result)
+{
+  if(r < INT_MIN || r > INT_MAX) return false;
+  *result = OperandInt((int)r);
+  return true;
+}
+
+/**
+ * @brief   Rounds double to integer.
+ *
+ * @param d       Double.
+ * @param mode    Opcode_Float2Int (truncation), Opcode_Float2R2EInt (half to even)
+ *                or Opcode_Float2R2OInt (half to odd).
+ */
+static bool Round(double d, Opcode mode, Operand * result)
+{
+  if(!(d > (double)INT_MIN - 1.0 && d < (double)INT_MAX + 1.0)) return false;
+  if(mode == Opcode_Float2Int) return Integer((long long)d, result);
+
+  double f = floor(d);
+  long long r = (long long)f;
+  if(d - f > 0.5) r++;
+  else if(d - f == 0.5)
+  {
+    bool even = (r % 2 == 0);
+    if(even != (mode == Opcode_Float2R2EInt)) r++;
+  }
+  return Integer(r, result);
+}
+
+/**
+ * @brief   Concatenates escaped strings.
+ */
+static bool Concat(const char * x, const char * y, Operand * result)
+{
+  size_t lx = strlen(x), ly = strlen(y);
+  char * s = malloc(lx + ly + 1);
+  if(s == NULL) return false;
+  memcpy(s, x, lx);
+  memcpy(s + lx, y, ly + 1);
+  *result = OperandString(s);
+  free(s);
+  return true;
+}
+
+/**
+ * @brief   String of one character, escaped as by the scanner.
+ */
+static Operand Character(int c)
+{
+  char s[16];
+  if(c <= 32 || c == '#' || c == '\\') sprintf(s, "\\%03d", c);
+  else
+  {
+    s[0] = (char)c;
+    s[1] = '\0';
+  }
+  return OperandString(s);
+}
+
+/**
+ * @brief   Character of the string on the index.
+ *
+ * @returns True, if the index is in range. False otherwise.
+ */
+static bool CharacterAt(const char * s, int index, int * c)
+{
+  size_t length;
+  char * d = DecodeCopy(s, &length);
+  bool ok = (d != NULL && index >= 0 && (size_t)index < length);
+  if(ok) *c = (unsigned char)d[index];
+  free(d);
+  return ok;
+}
+
+bool FoldOperation(Opcode op, const Operand * a, const Operand * b, Operand * result)
+{
+  Value x, y;
+  int cmp, c;
+  if(!Load(a, &x)) return false;
+  if(b != NULL && !Load(b, &y)) return false;
+  op = OpcodeThreeAddress(op);
+
+  // unary operations
+  if(b == NULL)
+  {
+    switch(op)
+    {
+      case Opcode_Move: *result = *a; return true;
+      case Opcode_Not:
+        if(x.type != DataType_Unknown) return false;
+        *result = OperandBool(!x.b);
+        return true;
+      case Opcode_Int2Float:
+        if(x.type != DataType_Integer) return false;
+        *result = OperandFloat((double)x.i);
+        return true;
+      case Opcode_Float2Int: case Opcode_Float2R2EInt: case Opcode_Float2R2OInt:
+        return x.type == DataType_Double && Round(x.d, op, result);
+      case Opcode_Int2Char:
+        if(x.type != DataType_Integer || x.i < 0 || x.i > 255) return false;
+        *result = Character(x.i);
+        return true;
+      case Opcode_Strlen:
+        if(x.type != DataType_String) return false;
+        return Integer((long long)DecodeString(x.s, NULL), result);
+      default: return false;
+    }
+  }
+
+  // binary operations
+  switch(op)
+  {
+    case Opcode_Add: case Opcode_Sub: case Opcode_Mul: case Opcode_Div:
+      if(x.type != y.type) return false;
+      if(x.type == DataType_Integer && op != Opcode_Div)
+      {
+        long long l = x.i, r = y.i;
+        return Integer((op == Opcode_Add) ? l + r : (op == Opcode_Sub) ? l - r : l * r, result);
+      }
+      if(x.type != DataType_Double) return false;
+      if(op == Opcode_Div && y.d == 0.0) return false;
+      {
+        double d = (op == Opcode_Add) ? x.d + y.d : (op == Opcode_Sub) ? x.d - y.d
+                 : (op == Opcode_Mul) ? x.d * y.d : x.d / y.d;
+        // inf and nan have no constant in the code
+        if(!isfinite(d)) return false;
+        *result = OperandFloat(d);
+      }
+      return true;
+    case Opcode_Lt: case Opcode_Gt: case Opcode_Eq:
+      if(!Compare(&x, &y, &cmp)) return false;
+      *result = OperandBool((op == Opcode_Lt) ? cmp < 0 : (op == Opcode_Gt) ? cmp > 0 : cmp == 0);
+      return true;
+    case Opcode_And: case Opcode_Or:
+      if(x.type != DataType_Unknown || y.type != DataType_Unknown) return false;
+      *result = OperandBool((op == Opcode_And) ? (x.b && y.b) : (x.b || y.b));
+      return true;
+    case Opcode_Concat:
+      return x.type == DataType_String && y.type == DataType_String && Concat(x.s, y.s, result);
+    case Opcode_Stri2Int:
+      if(x.type != DataType_String || y.type != DataType_Integer || !CharacterAt(x.s, y.i, &c)) return false;
+      *result = OperandInt(c);
+      return true;
+    case Opcode_Getchar:
+      if(x.type != DataType_String || y.type != DataType_Integer || !CharacterAt(x.s, y.i, &c)) return false;
+      *result = Character(c);
+      return true;
+    default: return false;
+  }
+}
+
+bool FoldJump(Opcode op, const Operand * a, const Operand * b, bool * taken)
+{
+  Operand equal;
+  if(!FoldOperation(Opcode_Eq, a, b, &equal)) return false;
+  *taken = (op == Opcode_JumpIfEq || op == Opcode_JumpIfEqs) ? equal.d.b : !equal.d.b;
+  return true;
+}
+
+/**
+ * @brief   Output of the constant (escaped).
+ *
+ * @param v       Value.
+ * @param out     Buffer of at least 64 characters, for numbers and booleans.
+ * @returns Output text.
+ */
+static const char * Render(const Value * v, char * out)
+{
+  char text[48];
+  switch(v->type)
+  {
+    case DataType_String: return v->s;
+    case DataType_Integer: sprintf(text, "% d", v->i); break;
+    case DataType_Double: sprintf(text, "% g", v->d); break;
+    default: strcpy(text, v->b ? "true" : "false"); break;
+  }
+
+  // leading space of a positive number
+  size_t n = 0;
+  for(const char * c = text; *c != '\0'; c++)
+  {
+    if(*c == ' ') n += sprintf(out + n, "\\%03d", ' ');
+    else out[n++] = *c;
+  }
+  out[n] = '\0';
+  return out;
+}
+
+bool FoldWrite(const Operand * a, const Operand * b, Operand * result)
+{
+  Value x, y;
+  char bx[64], by[64];
+  if(!Load(a, &x) || !Load(b, &y)) return false;
+  return Concat(Render(&x, bx), Render(&y, by), result);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file fold.h
+ * @interface fold
+ * @date 19th october 2026
+ * @brief Constant folding interface.
+ *
+ * This interface declares evaluation of instructions on constants
+ * at compile time.
+ */
+
+#ifndef FOLD_H
+#define FOLD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "code.h"
+
+/**
+ * @brief   Operand is a constant.
+ *
+ * @param o       Operand.
+ * @returns True, if constant of the table of constants, or boolean.
+ */
+bool OperandIsConstant(const Operand * o);
+
+/**
+ * @brief   Evaluates the operation on constants.
+ *
+ * Stack instructions are evaluated as their three-address forms.
+ * Nothing is evaluated, if the instruction would fail at runtime
+ * (wrong types, overflow, division by zero, index out of range).
+ * @param op      Operation.
+ * @param a       First operand.
+ * @param b       Second operand, or NULL for unary operations.
+ * @param result  Returned constant.
+ * @returns True, if evaluated. False otherwise.
+ */
+bool FoldOperation(Opcode op, const Operand * a, const Operand * b, Operand * result);
+
+/**
+ * @brief   Evaluates the conditional jump on constants.
+ *
+ * @param op      JUMPIFEQ(S) or JUMPIFNEQ(S).
+ * @param a       First operand.
+ * @param b       Second operand.
+ * @param taken   Returned decision.
+ * @returns True, if evaluated. False otherwise.
+ */
+bool FoldJump(Opcode op, const Operand * a, const Operand * b, bool * taken);
+
+/**
+ * @brief   Output of two constants as one string constant.
+ *
+ * Numbers are rendered as WRITE outputs them.
+ * @param a       First constant.
+ * @param b       Second constant.
+ * @param result  Returned string constant.
+ * @returns True, if both are constants. False otherwise.
+ */
+bool FoldWrite(const Operand * a, const Operand * b, Operand * result);
+
+/**
+ * @brief   Decodes the escaped string.
+ *
+ * @param s       String with \\ddd escapes.
+ * @param out     Decoded characters (not terminated), or NULL.
+ * @returns Number of characters.
+ */
+size_t DecodeString(const char * s, char * out);
+
+#endif // FOLD_H
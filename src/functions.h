@@ -37,7 +37,7 @@
  * @param op      Operator.
  * @returns True if success. False otherwise.
  */
-inline bool isOperator(Phrasem p, const char * op);
+static inline bool isOperator(Phrasem p, const char * op);
 
 /**
  * @brief   Checks phrasem if is separator.
@@ -45,9 +45,9 @@ inline bool isOperator(Phrasem p, const char * op);
  * This function will take phrasem and checks if it is separator.
  * @returns True if success. False otherwise.
  */
-inline bool isSeparator(Phrasem p);
+static inline bool isSeparator(Phrasem p);
 
-inline bool isTypeCast(Phrasem p);
+static inline bool isTypeCast(Phrasem p);
 
 /**
  * @brief   Checks phrasem if is keyword.
@@ -58,7 +58,7 @@ inline bool isTypeCast(Phrasem p);
  * @param op      Keyword.
  * @returns True if success. False otherwise.
  */
-inline bool matchesKeyword(Phrasem p, const char * kw);
+static inline bool matchesKeyword(Phrasem p, const char * kw);
 
 /**
  * @brief   Checks phrasem if is function.
@@ -69,7 +69,7 @@ inline bool matchesKeyword(Phrasem p, const char * kw);
  * @param f       Function.
  * @returns True if success. False otherwise.
  */
-inline bool matchesFunction(Phrasem p, const char * f);
+static inline bool matchesFunction(Phrasem p, const char * f);
 
 /**
  * @brief   Datatype from variable.
@@ -78,9 +78,9 @@ inline bool matchesFunction(Phrasem p, const char * f);
  * @param p       Phrasem.
  * @returns DataType of variable.
  */
-inline DataType getDataType(Phrasem p);
+static inline DataType getDataType(Phrasem p);
 
-inline const char * DataType2Str(DataType);
+static inline const char * DataType2Str(DataType);
 
 /** @}*/
 /*----------------------------------------------------*/
@@ -96,7 +96,7 @@ inline const char * DataType2Str(DataType);
  * @param p       Phrasem to be copied.
  * @returns Copied Phrasem, or NULL, if fail.
  */
-inline Phrasem duplicatePhrasem(Phrasem p);
+static inline Phrasem duplicatePhrasem(Phrasem p);
 
 /**
  * @brief    String duplicator.
@@ -105,7 +105,7 @@ inline Phrasem duplicatePhrasem(Phrasem p);
  * @param str    String to be copied.
  * @returns Copied string, or NULL, if fail.
  */
-inline char * strdup(const char * str);
+static inline char * strdup(const char * str);
 
 /**
  * @brief    Frees phrasem completely.
@@ -113,7 +113,7 @@ inline char * strdup(const char * str);
  * This function will free the phrasem and all memory bind to it.
  * @param p     Phrasem to free.
  */
-inline void freePhrasem(Phrasem p);
+static inline void freePhrasem(Phrasem p);
 
 /** @}*/
 /*----------------------------------------------------*/
@@ -126,13 +126,13 @@ inline void freePhrasem(Phrasem p);
  * @brief   Debug function to print phrasem.
  * @param p       Phrasem to be printed.
  */
-inline void PrintPhrasem(Phrasem p);
+static inline void PrintPhrasem(Phrasem p);
 
 /**
  * @brief   Debug function to print data type.
  * @param dt       DataType to be printed.
  */
-inline void PrintDataType(DataType dt);
+static inline void PrintDataType(DataType dt);
 
 /** @}*/
 /*----------------------------------------------------*/
@@ -163,32 +163,32 @@ inline void PrintDataType(DataType dt);
 /*------------------------------ DEFINITIONS --------------------------------*/
 
 /*--------------- COVERS -------------------*/
-inline bool isOperator(Phrasem p, const char * op)
+static inline bool isOperator(Phrasem p, const char * op)
 {
   return (p->table == TokenType_Operator) && (p->d.index == getOperatorId(op));
 }
 
-inline bool isSeparator(Phrasem p)
+static inline bool isSeparator(Phrasem p)
 {
   return p->table == TokenType_Separator;
 }
 
-inline bool isTypeCast(Phrasem p)
+static inline bool isTypeCast(Phrasem p)
 {
   return (p->table == TypeCast_Double2Int) || (p->table == TypeCast_Int2Double);
 }
 
-inline bool matchesKeyword(Phrasem p, const char * kw)
+static inline bool matchesKeyword(Phrasem p, const char * kw)
 {
   return (p->table == TokenType_Keyword) && (p->d.index == isKeyword(kw));
 }
 
-inline bool matchesFunction(Phrasem p, const char * f)
+static inline bool matchesFunction(Phrasem p, const char * f)
 {
   return (p->table == TokenType_Function)  && !strcmp(p->d.str, f);
 }
 
-inline DataType getDataType(Phrasem p)
+static inline DataType getDataType(Phrasem p)
 {
   if(matchesKeyword(p, "integer")) return DataType_Integer;
   else if(matchesKeyword(p, "double")) return DataType_Double;
@@ -197,7 +197,7 @@ inline DataType getDataType(Phrasem p)
 }
 
 /*------------------ TOOLS --------------------*/
-inline char * strdup(const char * str)
+static inline char * strdup(const char * str)
 {
   char * newstr = malloc(sizeof(char)*(strlen(str)+1));
   if(newstr == NULL) return NULL;
@@ -207,7 +207,7 @@ inline char * strdup(const char * str)
 }
 
 extern Phrasem allocPhrasem();
-inline Phrasem duplicatePhrasem(Phrasem p)
+static inline Phrasem duplicatePhrasem(Phrasem p)
 {
   Phrasem dup = allocPhrasem();
   if(dup == NULL) return NULL;
@@ -239,7 +239,7 @@ inline Phrasem duplicatePhrasem(Phrasem p)
   return dup;
 }
 
-inline void freePhrasem(Phrasem p)
+static inline void freePhrasem(Phrasem p)
 {
   switch(p->table)
   {
@@ -256,7 +256,7 @@ inline void freePhrasem(Phrasem p)
 
 /*----------------- PRINTERS ---------------*/
 
-inline void PrintPhrasem(Phrasem p)
+static inline void PrintPhrasem(Phrasem p)
 {
   if(p == NULL) return;
   DataType type = findConstType(p->d.index);
@@ -309,7 +309,7 @@ inline void PrintPhrasem(Phrasem p)
   }
 }
 
-inline void PrintDataType(DataType dt)
+static inline void PrintDataType(DataType dt)
 {
   switch(dt)
   {
@@ -326,7 +326,7 @@ inline void PrintDataType(DataType dt)
   }
 }
 
-inline const char * DataType2Str(DataType dt)
+static inline const char * DataType2Str(DataType dt)
 {
   switch(dt)
   {
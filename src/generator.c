@@ -1,9 +1,13 @@
 
-#include <math.h>
+#include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "code.h"
 #include "config.h"
+#include "err.h"
+#include "fold.h"
 #include "functions.h"
 #include "generator.h"
 #include "io.h"
@@ -197,6 +201,15 @@ inline bool PushLabel(const char * lbl);
  */
 inline const char * GenerateLabel();
 
+/**
+ * @brief   Generates new label, which is not pushed.
+ *
+ * This function is used for labels inside of generated
+ * built-in functions.
+ * @returns Name of the label (atom).
+ */
+const char * GenerateLocalLabel();
+
 /**
  * @brief   Returns top label.
  *
@@ -238,17 +251,31 @@ inline void ClearLabels();
  * @brief   Label name generator.
  *
  * This function generates the name of the variable for IFJcode17.
- * Do not save the given string. It is freed after next call of the function.
+ * The text is cached in the table of constants or in the symtable,
+ * the name of a variable is an atom.
  * @param p     Variable to generate.
- * @returns Name
+ * @returns Name, or NULL if the phrasem has none.
  */
-char * GenerateName(Phrasem p);
+const char * GenerateName(Phrasem p);
+
 /**
- * @brief   Clears generated name.
+ * @brief   Operand generator.
+ *
+ * This function generates operand of an instruction from
+ * the constant or the variable.
+ * @param p     Constant or variable.
+ * @returns Operand, Operand_None if the phrasem has none.
  */
-void ClearGeneratedName();
+Operand GenerateOperand(Phrasem p);
 
-char * GenerateType(Phrasem p);
+/**
+ * @brief   Operand of the phrasem for an instruction.
+ *
+ * Raises the internal error, if the phrasem has no operand.
+ * @param p     Constant or variable.
+ * @returns Operand.
+ */
+Operand GeneratePhrasemOperand(Phrasem p);
 
 char * GenerateTmpVariable();
 void ClearGeneratedTmpVariable();
@@ -268,22 +295,11 @@ void InitGenerator()
     debug("Init generator.");
   #endif
 
-  // header
-  out("\n"
-      "# Generated code\n"
-      "# IFJ\n"
-      "# xbenes49 xbolsh00 xpolan09\n"
-      "# 2017\n");
-
-
-  out(".IFJcode17");
-  out("CREATEFRAME");
-  out("PUSHFRAME");
-  out("DEFVAR LF@*tmp");
-  out("DEFVAR LF@*foo");
-  out("DEFVAR LF@*bar");
-  out("JUMP $main");
-  out("");
+  // prologue
+  CodeBeginUnit(NULL);
+  Code(Opcode_CreateFrame);
+  Code(Opcode_PushFrame);
+  Code(Opcode_Jump, OperandLabel("$main"));
 }
 
 
@@ -294,56 +310,56 @@ void GenerateLogic(Phrasem p)
     debug("Generating logic.");
   #endif
 
-  const char * aftercond = GenerateLabel();
+  Operand aftercond = OperandLabel(GenerateLabel());
 
   if(isOperator(p, "="))
   {
     // =
-    out("JUMPIFNEQS %s", aftercond);
+    Code(Opcode_JumpIfNeqs, aftercond);
   }
   else if(isOperator(p, "<>"))
   {
     // <>
-    out("JUMPIFEQS %s", aftercond);
+    Code(Opcode_JumpIfEqs, aftercond);
   }
   else if(isOperator(p, ">"))
   {
     // >
-    out("GTS");
-    out("PUSHS bool@true");
-    out("JUMPIFNEQS %s", aftercond);
+    Code(Opcode_Gts);
+    Code(Opcode_Pushs, OperandBool(true));
+    Code(Opcode_JumpIfNeqs, aftercond);
   }
 
   else if(isOperator(p, "<"))
   {
     // <
-    out("LTS");
-    out("PUSHS bool@true");
-    out("JUMPIFNEQS %s", aftercond);
+    Code(Opcode_Lts);
+    Code(Opcode_Pushs, OperandBool(true));
+    Code(Opcode_JumpIfNeqs, aftercond);
   }
   else if(isOperator(p, ">="))
   {
     // >=
-    out("LTS");
-    out("PUSHS bool@true");
-    out("JUMPIFEQS %s", aftercond);
+    Code(Opcode_Lts);
+    Code(Opcode_Pushs, OperandBool(true));
+    Code(Opcode_JumpIfEqs, aftercond);
 
   }
   else
   {
     // <=
-    out("GTS");
-    out("PUSHS bool@true");
-    out("JUMIFEQS %s", aftercond);
+    Code(Opcode_Gts);
+    Code(Opcode_Pushs, OperandBool(true));
+    Code(Opcode_JumpIfEqs, aftercond);
   }
 
 }
 
 void GenerateFunctionCall(Phrasem p)
 {
-  out("CALL %s", p->d.str);
-  out("POPFRAME");
-  out("PUSHS TF@*ret");
+  // return value is left on the data stack
+  Code(Opcode_Call, OperandLabel(p->d.str));
+  Code(Opcode_PopFrame);
 }
 
 void GenerateAssignment(Phrasem p)
@@ -352,14 +368,50 @@ void GenerateAssignment(Phrasem p)
     debug("Generating assignment.");
   #endif
 
-  out("POPS %s", GenerateName(p));
+  Code(Opcode_Pops, GeneratePhrasemOperand(p));
 }
 void GenerateVariableDeclaration(Phrasem p)
 {
   #ifdef GENERATOR_DEBUG
     debug("Generating variable declaration.");
   #endif
-  out("DEFVAR %s", GenerateName(p));
+  Code(Opcode_Defvar, GeneratePhrasemOperand(p));
+}
+
+/**
+ * @brief   Writes the operand.
+ *
+ * Constant, which follows a write of a constant, is merged into it.
+ * @param o     Operand.
+ */
+static void GenerateWrite(Operand o)
+{
+  CodeUnit * u = CodeCurrentUnit();
+  Instruction * last = (u != NULL && u->count > 0) ? &u->code[u->count - 1] : NULL;
+  Operand merged;
+  if(last != NULL && last->op == Opcode_Write && FoldWrite(&last->arg[0], &o, &merged)) last->arg[0] = merged;
+  else Code(Opcode_Write, o);
+}
+
+/**
+ * @brief   Beginning of the string expression on the end of the unit.
+ *
+ * String expression is DEFVAR t, MOVE t string@, CONCAT t t operand
+ * for each operand and PUSHS t.
+ * @param u     Unit.
+ * @returns Index of its DEFVAR, or u->count.
+ */
+static size_t StringExpression(const CodeUnit * u)
+{
+  size_t i = u->count - 1;
+  Operand t = u->code[i].arg[0];
+  if(t.type != Operand_Variable) return u->count;
+  while(i > 0 && u->code[i-1].op == Opcode_Concat && OperandEquals(&u->code[i-1].arg[0], &t)
+        && OperandEquals(&u->code[i-1].arg[1], &t)) i--;
+  if(i < 2 || u->code[i-1].op != Opcode_Move || !OperandEquals(&u->code[i-1].arg[0], &t)
+     || u->code[i-1].arg[1].type != Operand_Constant || u->code[i-1].arg[1].d.index != getStringDefaultValue()
+     || u->code[i-2].op != Opcode_Defvar || !OperandEquals(&u->code[i-2].arg[0], &t)) return u->count;
+  return i - 2;
 }
 
 void GeneratePrint()
@@ -368,8 +420,27 @@ void GeneratePrint()
     debug("Generating print.");
   #endif
 
-  out("POPS LF@*tmp");
-  out("WRITE LF@*tmp");
+  CodeUnit * u = CodeCurrentUnit();
+  if(u != NULL && u->count > 0 && u->code[u->count - 1].op == Opcode_Pushs)
+  {
+    size_t start = StringExpression(u);
+    if(start < u->count)
+    {
+      // operands of the string expression are written one by one
+      size_t end = u->count - 1;
+      u->count = start;
+      for(size_t i = start + 2; i < end; i++) GenerateWrite(u->code[i].arg[2]);
+      return;
+    }
+
+    // expression of one operand is written directly
+    Operand o = u->code[--u->count].arg[0];
+    GenerateWrite(o);
+    return;
+  }
+
+  Code(Opcode_Pops, OperandVariable(Frame_Local, "*tmp"));
+  Code(Opcode_Write, OperandVariable(Frame_Local, "*tmp"));
 }
 
 void GenerateRead(Phrasem p)
@@ -379,15 +450,8 @@ void GenerateRead(Phrasem p)
   #endif
 
   // this will go from symbol table
-  out("WRITE string@?\\032");
-  out("READ %s %s", GenerateName(p), GenerateType(p));
-}
-
-void GenerateReturn()
-{
-  #ifdef GENERATOR_DEBUG
-    debug("Generating return.");
-  #endif
+  Code(Opcode_Write, OperandString("?\\032"));
+  Code(Opcode_Read, GeneratePhrasemOperand(p), OperandDataType(findVariableType(Config_getFunction(), p->d.str)));
 }
 
 void GenerateFunctionHeader(Phrasem p)
@@ -397,13 +461,17 @@ void GenerateFunctionHeader(Phrasem p)
   #endif
 
   // function
-  out("\n# function %s", p->d.str);
-  out("LABEL %s", p->d.str);
-  out("PUSHFRAME");
-  out("DEFVAR LF@*tmp");
-  out("DEFVAR LF@*foo");
-  out("DEFVAR LF@*bar");
-  out("DEFVAR LF@*ret");
+  CodeBeginUnit(p->d.str);
+  char * comment = malloc(sizeof(char) * (9/*function */ + strlen(p->d.str) + 1));
+  if(comment != NULL)
+  {
+    sprintf(comment, "function %s", p->d.str);
+    Code(Opcode_Comment, OperandText(comment));
+    free(comment);
+  }
+  Code(Opcode_Label, OperandLabel(p->d.str));
+  Code(Opcode_PushFrame);
+  // parameters are defined by the caller, scratch variables at the end
 }
 
 void GenerateArgument();
@@ -414,11 +482,12 @@ void GenerateLength()
     debug("Generating length.");
   #endif
 
-  const char * str = GenerateTmpVariable();
-  out("DEFVAR LF@%s", str);
-  out("POPS LF@%s", str);
-  out("STRLEN LF@*tmp LF@%s", str);
-  out("PUSHS LF@*tmp", str);
+  Operand str = OperandVariable(Frame_Local, GenerateTmpVariable());
+  Operand tmp = OperandVariable(Frame_Local, "*tmp");
+  Code(Opcode_Defvar, str);
+  Code(Opcode_Pops, str);
+  Code(Opcode_Strlen, tmp, str);
+  Code(Opcode_Pushs, tmp);
 
 }
 
@@ -428,9 +497,9 @@ void GenerateInt2Str()
     debug("Generating int2str.");
   #endif
 
-  out("POPS LF@*tmp");
-  out("INT2CHAR LF@*foo LF@*tmp");
-  out("PUSHS LF@*foo");
+  Code(Opcode_Pops, OperandVariable(Frame_Local, "*tmp"));
+  Code(Opcode_Int2Char, OperandVariable(Frame_Local, "*foo"), OperandVariable(Frame_Local, "*tmp"));
+  Code(Opcode_Pushs, OperandVariable(Frame_Local, "*foo"));
 }
 
 void GenerateAsc()
@@ -438,33 +507,38 @@ void GenerateAsc()
   #ifdef GENERATOR_DEBUG
     debug("Generating asc.");
   #endif
-  out("# asc()");
-  out("\tPOPS LF@*tmp"); // index
-  out("\tPOPS LF@*foo"); // string
-  out("\tSTRLEN LF@*bar LF@*foo"); // size of
-  out("\tPUSHS LF@*tmp");
-  out("\tPUSHS LF@*bar");
-  out("\tLTS");
-  out("\tPUSHS bool@true");
-  out("\tJUMPIFNEQS $zero");
-
-  out("\tPUSHS LF@*tmp");
-  out("\tPUSHS int@0");
-  out("\tGTS");
-  out("\tPUSHS bool@true");
-  out("\tJUMPIFNEQS $zero");
-
-  out("\t\tPUSHS LF@*foo");
-  out("\t\tPUSHS LF@*tmp");
-  out("\t\tSTRI2INTS");
-  const char * lbl = GenerateLabel();
-  out("\t\tJUMP %s", lbl);
-
-  out("\tLABEL $zero");
-  out("\tPUSHS int@0");
-
-  out("LABEL %s", lbl);
-  free((void *)lbl);
+
+  Operand tmp = OperandVariable(Frame_Local, "*tmp");
+  Operand foo = OperandVariable(Frame_Local, "*foo");
+  Operand bar = OperandVariable(Frame_Local, "*bar");
+  Operand zero = OperandLabel(GenerateLocalLabel());
+  Operand lbl = OperandLabel(GenerateLocalLabel());
+
+  Code(Opcode_Comment, OperandText("asc()"));
+  Code(Opcode_Pops, tmp); // index
+  Code(Opcode_Pops, foo); // string
+  Code(Opcode_Strlen, bar, foo); // size of
+  Code(Opcode_Pushs, tmp);
+  Code(Opcode_Pushs, bar);
+  Code(Opcode_Lts);
+  Code(Opcode_Pushs, OperandBool(true));
+  Code(Opcode_JumpIfNeqs, zero);
+
+  Code(Opcode_Pushs, tmp);
+  Code(Opcode_Pushs, OperandInt(0));
+  Code(Opcode_Gts);
+  Code(Opcode_Pushs, OperandBool(true));
+  Code(Opcode_JumpIfNeqs, zero);
+
+  Code(Opcode_Pushs, foo);
+  Code(Opcode_Pushs, tmp);
+  Code(Opcode_Stri2Ints);
+  Code(Opcode_Jump, lbl);
+
+  Code(Opcode_Label, zero);
+  Code(Opcode_Pushs, OperandInt(0));
+
+  Code(Opcode_Label, lbl);
 }
 
 void GenerateSubStr()
@@ -473,77 +547,70 @@ void GenerateSubStr()
     debug("Generating substr.");
   #endif
 
-  out("CREATEFRAME");
-  const char * result = strdup(GenerateTmpVariable());
-  out("DEFVAR TF@%s", result);
-  out("MOVE TF@%s string@", result);
-  out("POPS LF@*foo"); // foo - n
-  out("POPS LF@*bar"); // bar - i
-  out("POPS LF@*tmp"); // tmp - str
-  const char * len = strdup(GenerateTmpVariable());
-  out("DEFVAR TF@%s", len);
-  out("STRLEN TF@%s LF@*tmp", len);
-
-  const char * nempty = GenerateLabel();
-  out("PUSHS LF@*tmp");
-  out("PUSHS string@");
-  out("JUMPIFNEQS %s", nempty);
-    const char * retempty = GenerateLabel();
-    out("LABEL %s", retempty);
-    const char * done = GenerateLabel();
-    out("JUMP %s", done);
-
-  out("LABEL %s", nempty);
-
-  out("PUSHS LF@*bar");
-  out("PUSHS int@1");
-  out("LTS");
-  out("PUSHS bool@true");
-  out("JUMPIFEQS %s", retempty);
-
-  out("PUSHS LF@*foo");
-  out("PUSHS int@0");
-  out("LTS");
-  out("PUSHS bool@true");
-  const char * retall = GenerateLabel();
-  out("JUMPIFEQS %s", retall);
-
-  const char * nall = GenerateLabel();
-  out("JUMP %s", nall);
-
-  out("LABEL %s", retall);
+  Operand tmp = OperandVariable(Frame_Local, "*tmp");
+  Operand foo = OperandVariable(Frame_Local, "*foo");
+  Operand bar = OperandVariable(Frame_Local, "*bar");
+
+  Code(Opcode_CreateFrame);
+  Operand result = OperandVariable(Frame_Temporary, GenerateTmpVariable());
+  Code(Opcode_Defvar, result);
+  Code(Opcode_Move, result, OperandConstant(getStringDefaultValue()));
+  Code(Opcode_Pops, foo); // foo - n
+  Code(Opcode_Pops, bar); // bar - i
+  Code(Opcode_Pops, tmp); // tmp - str
+  Operand len = OperandVariable(Frame_Temporary, GenerateTmpVariable());
+  Code(Opcode_Defvar, len);
+  Code(Opcode_Strlen, len, tmp);
+
+  Operand nempty = OperandLabel(GenerateLocalLabel());
+  Code(Opcode_Pushs, tmp);
+  Code(Opcode_Pushs, OperandConstant(getStringDefaultValue()));
+  Code(Opcode_JumpIfNeqs, nempty);
+    Operand retempty = OperandLabel(GenerateLocalLabel());
+    Code(Opcode_Label, retempty);
+    Operand done = OperandLabel(GenerateLocalLabel());
+    Code(Opcode_Jump, done);
+
+  Code(Opcode_Label, nempty);
+
+  Code(Opcode_Pushs, bar);
+  Code(Opcode_Pushs, OperandInt(1));
+  Code(Opcode_Lts);
+  Code(Opcode_Pushs, OperandBool(true));
+  Code(Opcode_JumpIfEqs, retempty);
+
+  Code(Opcode_Pushs, foo);
+  Code(Opcode_Pushs, OperandInt(0));
+  Code(Opcode_Lts);
+  Code(Opcode_Pushs, OperandBool(true));
+  Operand retall = OperandLabel(GenerateLocalLabel());
+  Code(Opcode_JumpIfEqs, retall);
+
+  Operand nall = OperandLabel(GenerateLocalLabel());
+  Code(Opcode_Jump, nall);
+
+  Code(Opcode_Label, retall);
     // n = len - 1 + 1
 
-  out("LABEL %s", nall);
-
-  const char * pom = GenerateTmpVariable();
-  out("DEFVAR TF@%s", pom);
-  out("SUB LF@*bar LF@*bar int@1");
-  const char *newchar = GenerateLabel();
-  out("LABEL %s", newchar);
-  out("GETCHAR TF@%s LF@*tmp LF@*bar", pom);
-  out("CONCAT TF@%s TF@%s TF@%s", result, result, pom);
-  out("ADD LF@*bar LF@*bar int@1");
-  out("PUSHS LF@*bar");
-  out("PUSHS TF@%s", len);
-  out("LTS");
-  out("PUSHS bool@true");
-  out("JUMPIFEQS %s", newchar);
-
-  out("LABEL %s", done);
+  Code(Opcode_Label, nall);
 
-  out("PUSHS TF@%s", result);
+  Operand pom = OperandVariable(Frame_Temporary, GenerateTmpVariable());
+  Code(Opcode_Defvar, pom);
+  Code(Opcode_Sub, bar, bar, OperandInt(1));
+  Operand newchar = OperandLabel(GenerateLocalLabel());
+  Code(Opcode_Label, newchar);
+  Code(Opcode_Getchar, pom, tmp, bar);
+  Code(Opcode_Concat, result, result, pom);
+  Code(Opcode_Add, bar, bar, OperandInt(1));
+  Code(Opcode_Pushs, bar);
+  Code(Opcode_Pushs, len);
+  Code(Opcode_Lts);
+  Code(Opcode_Pushs, OperandBool(true));
+  Code(Opcode_JumpIfEqs, newchar);
 
-  free((void *)result);
-  free((void *)len);
-  free((void *)nempty);
-  free((void *)retempty);
-  free((void *)done);
-  free((void *)retall);
-  free((void *)nall);
-  //free(pom);
-  free((void *)newchar);
+  Code(Opcode_Label, done);
 
+  Code(Opcode_Pushs, result);
 }
 
 void GenerateAritm(Stack s)
@@ -560,30 +627,30 @@ void GenerateAritm(Stack s)
     if((p->table == TokenType_Constant)
     || (p->table == TokenType_Variable))
     {
-      out("PUSHS %s", GenerateName(p) );
+      Code(Opcode_Pushs, GeneratePhrasemOperand(p));
     }
 
     // operator
     else if(p->table == TokenType_Operator)
     {
       if (isOperator(p, "+")) {
-        out("ADDS");
+        Code(Opcode_Adds);
       }
 
       else if (isOperator(p, "-")) {
-        out("SUBS");
+        Code(Opcode_Subs);
       }
 
       else if (isOperator(p, "*")) {
-        out("MULS");
+        Code(Opcode_Muls);
       }
 
       else if (isOperator(p, "/")) {
-        out("DIVS");
+        Code(Opcode_Divs);
       }
       else if (isOperator(p, "\\")) {
-        out("DIVS");
-        out("FLOAT2R2EINTS");
+        Code(Opcode_Divs);
+        Code(Opcode_Float2R2EInts);
       }
     }
 
@@ -602,19 +669,19 @@ void GenerateStringArithm(Stack s)
     debug("Generating string arithmetics.");
   #endif
 
-  const char * tmp = GenerateTmpVariable();
-  out("DEFVAR LF@%s", tmp);
-  out("MOVE LF@%s string@", tmp);
+  Operand tmp = OperandVariable(Frame_Local, GenerateTmpVariable());
+  Code(Opcode_Defvar, tmp);
+  Code(Opcode_Move, tmp, OperandConstant(getStringDefaultValue()));
 
   Phrasem p;
   while((p = PopFromStack(s)) != NULL)
   {
     if(isOperator(p, "+")) continue;
 
-    out("CONCAT LF@%s LF@%s %s", tmp, tmp, GenerateName(p));
+    Code(Opcode_Concat, tmp, tmp, GeneratePhrasemOperand(p));
   }
 
-  out("PUSHS LF@%s", tmp);
+  Code(Opcode_Pushs, tmp);
 
 }
 
@@ -640,10 +707,6 @@ bool Send(Stack s)
   {
     GeneratePrint();
   }
-  else if( below == GState_Return )
-  {
-    GenerateReturn();
-  }
   else if(below == GState_Length)
   {
     GenerateLength();
@@ -709,13 +772,8 @@ bool HandlePhrasem(Phrasem p)
 }
 
 /*---------- DATA -----------*/
-static char param_name[4]; // there can't be more, than 999 parameters
+static char param_name[12]; // argument slot *N
 /*---------------------------*/
-void AssignArgument(Phrasem p, unsigned ord)
-{
-    sprintf(param_name, "*%u", ord);
-    out("MOVE LF@%s LF@%s", p->d.str, param_name);
-}
 
 void GenerateBuiltIn()
 {
@@ -771,7 +829,7 @@ void G_ArgumentAssignment(unsigned ord)
   PushGState(GState_Argument);
 
   sprintf(param_name, "*%u", ord);
-  out("DEFVAR TF@%s", param_name);
+  Code(Opcode_Defvar, OperandVariable(Frame_Temporary, param_name));
 
 }
 void GenerateArgument()
@@ -780,7 +838,7 @@ void GenerateArgument()
     debug("Generate argument.");
   #endif
 
-  out("POPS TF@%s", param_name);
+  Code(Opcode_Pops, OperandVariable(Frame_Temporary, param_name));
   RemoveGState();
 }
 
@@ -801,7 +859,7 @@ void G_Cycle()
   #endif
 
   PushGState(GState_Cycle);
-  out("LABEL %s", GenerateLabel());
+  Code(Opcode_Label, OperandLabel(GenerateLabel()));
 
 }
 
@@ -812,8 +870,8 @@ void G_Else()
   #endif
 
   const char * els = PopLabel();
-  out("JUMP %s", GenerateLabel());
-  out("LABEL %s", els);
+  Code(Opcode_Jump, OperandLabel(GenerateLabel()));
+  Code(Opcode_Label, OperandLabel(els));
   free((void *)els);
 }
 
@@ -827,7 +885,7 @@ void G_EndBlock()
   if( up == GState_Condition )
   {
     const char * aftercond = PopLabel();
-    out("LABEL %s", aftercond);
+    Code(Opcode_Label, OperandLabel(aftercond));
     free((void *)aftercond);
   }
   else if( up == GState_Cycle )
@@ -835,20 +893,15 @@ void G_EndBlock()
     const char * aftercycle = PopLabel();
     const char * tocycle = PopLabel();
 
-    out("JUMP %s", tocycle);
-    out("LABEL %s", aftercycle);
+    Code(Opcode_Jump, OperandLabel(tocycle));
+    Code(Opcode_Label, OperandLabel(aftercycle));
     free((void *)aftercycle);
     free((void *)tocycle);
   }
   else if( up == GState_Return )
   {
-    out("POPS LF@*ret");
-    out("CLEARS");
-    out("RETURN");
-  }
-  else if( up == GState_Function )
-  {
-    out("");
+    // return value stays on the data stack
+    Code(Opcode_Return);
   }
 
   #ifdef GENERATOR_DEBUG
@@ -892,7 +945,7 @@ void G_FinalJump()
     debug("Generate final jump.");
   #endif
 
-  out("JUMP $end");
+  Code(Opcode_Jump, OperandLabel("$end"));
 }
 
 void G_FinalLabel()
@@ -901,7 +954,7 @@ void G_FinalLabel()
     debug("Generate final label.");
   #endif
 
-  out("LABEL $end");
+  Code(Opcode_Label, OperandLabel("$end"));
 }
 
 void G_Function()
@@ -920,7 +973,8 @@ void G_FunctionAssignment(Phrasem p)
     debug("Generate function assignment.");
   #endif
 
-  out("POPS LF@%s", p->d.str);
+  Code(Opcode_Pops, OperandVariable(Frame_Local, p->d.str));
+  PopGState(); // assignment
 }
 
 void G_FunctionCall()
@@ -930,7 +984,7 @@ void G_FunctionCall()
   #endif
 
   PushGState(GState_FunctionCall);
-  out("CREATEFRAME");
+  Code(Opcode_CreateFrame);
 
 }
 
@@ -988,13 +1042,23 @@ void G_Return()
   PushGState(GState_Return);
 }
 
+bool G_Returned()
+{
+  CodeUnit * u = CodeCurrentUnit();
+  if(u == NULL) return false;
+  size_t i = u->count;
+  while(i > 0 && u->code[i-1].op == Opcode_Comment) i--;
+  return i > 0 && u->code[i-1].op == Opcode_Return;
+}
+
 void G_Scope()
 {
   #ifdef GENERATOR_DEBUG
     debug("Generate scope.");
   #endif
 
-  out("LABEL $main");
+  CodeBeginUnit("scope");
+  Code(Opcode_Label, OperandLabel("$main"));
 }
 
 void G_SubStr()
@@ -1023,103 +1087,84 @@ void GenerateTypeCast(TokenType tc)
     debug("Generate typecast.");
   #endif
 
+  Opcode op;
   switch(tc)
   {
     case TypeCast_Int2Double:
-      out("INT2FLOATS");
+      op = Opcode_Int2Floats;
       break;
     case TypeCast_Double2Int:
-      out("FLOAT2R2EINTS");
+      op = Opcode_Float2R2EInts;
       break;
     default:
-      break;
+      return;
   }
-}
 
-/*------------- DATA ---------------*/
-static char * namebuff = NULL;
-/*----------------------------------*/
+  CodeUnit * u = CodeCurrentUnit();
+  Instruction * last = (u != NULL && u->count > 0) ? &u->code[u->count - 1] : NULL;
 
-char * GenerateName(Phrasem p)
+  // pushed constant is converted at compile time
+  Operand result;
+  if(last != NULL && last->op == Opcode_Pushs && FoldOperation(op, &last->arg[0], NULL, &result))
+  {
+    last->arg[0] = result;
+    return;
+  }
+  // int -> double -> int is the same integer
+  if(last != NULL && last->op == Opcode_Int2Floats && op == Opcode_Float2R2EInts)
+  {
+    u->count--;
+    return;
+  }
+  Code(op);
+}
+
+const char * GenerateName(Phrasem p)
 {
   if(p == NULL) return NULL;
 
-  if(namebuff != NULL) free(namebuff);
-
-  DataType dt;
-  int maxlen;
+  const char * name;
   switch(p->table)
   {
+    // operand text is cached in the table of constants
     case TokenType_Constant:
-      dt = findConstType(p->d.index);
-      switch(dt)
-      {
-        case DataType_Integer:
-          maxlen = 1/*sign*/ + (log10(getIntConstValue(p->d.index)) + 1) /*digits*/;
-          if(getIntConstValue(p->d.index) <= 0) maxlen = 1;
-          namebuff = malloc(sizeof(char) * (4/*int@*/ + maxlen + 1 /*end zero*/));
-          if(namebuff == NULL) return NULL;
-          sprintf(namebuff, "int@%d", getIntConstValue(p->d.index));
-          return namebuff;
-
-        case DataType_Double:
-          maxlen = 1 /*sign*/ + 53 /*mantissa - IEEE754*/ + 1 /*decimal point*/;
-          namebuff = malloc(sizeof(char) * (6 /*float@*/ + maxlen + 1 /*end zero*/));
-          if(namebuff == NULL) return NULL;
-          sprintf(namebuff, "float@%g", getDoubleConstValue(p->d.index));
-          return namebuff;
-
-        case DataType_String:
-          maxlen = strlen(getStringConstValue(p->d.index));
-          namebuff = malloc(sizeof(char) * (7/*string@*/ + maxlen + 1 /*end zero*/));
-          if(namebuff == NULL) return NULL;
-          sprintf(namebuff, "string@%s", getStringConstValue(p->d.index));
-          return namebuff;
-
-        default:
-          return "TODO";
-      }
+      return getConstOperand(p->d.index);
 
+    // operand text is cached in the symtable
     case TokenType_Variable:
-      dt = findVariableType(Config_getFunction(), p->d.str);
-
-      namebuff = malloc(sizeof(char) * (4/*LF@*/ + strlen(p->d.str) + 1 /*end zero*/));
-      if(namebuff == NULL) return NULL;
-      sprintf(namebuff, "LF@%s", p->d.str);
-      return namebuff;
+      name = findVariableOperand(Config_getFunction(), p->d.str);
+      if(name != NULL) return name;
+      // unknown to symtable
+      {
+        Operand o = OperandVariable(Frame_Local, p->d.str);
+        return (o.type == Operand_Variable) ? o.d.var.name : NULL;
+      }
 
     default:
-      // TODO
-      PrintPhrasem(p);
-      return "TODO";
+      return NULL;
   }
 }
 
-void ClearGeneratedName()
+Operand GenerateOperand(Phrasem p)
 {
-  if(namebuff != NULL)
-  {
-    free(namebuff);
-    namebuff = NULL;
-  }
+  Operand none = {.type = Operand_None};
+  if(p == NULL) return none;
+  if(p->table == TokenType_Constant) return OperandConstant(p->d.index);
+  if(p->table != TokenType_Variable) return none;
+
+  const char * name = GenerateName(p);
+  return (name != NULL) ? OperandVariableText(name) : none;
 }
 
-char * GenerateType(Phrasem p)
+Operand GeneratePhrasemOperand(Phrasem p)
 {
-  DataType dt;
-  switch(p->table)
+  Operand o = GenerateOperand(p);
+  if(o.type == Operand_None)
   {
-    case TokenType_Variable:
-      dt = findVariableType(Config_getFunction(), p->d.str);
-      switch(dt)
-      {
-        case DataType_Integer: return "int";
-        case DataType_Double: return "float";
-        case DataType_String: return "string";
-        default: return NULL;
-      }
-    default: return NULL;
+    setErrorType(ErrorType_Internal);
+    setErrorMessage("generator: phrasem without operand");
   }
+  return o;
 }
 
 
@@ -1296,6 +1341,13 @@ const char * GenerateLabel()
   return msg;
 }
 
+const char * GenerateLocalLabel()
+{
+  const char * lbl = atomInsert(form);
+  incrementForm(1);
+  return lbl;
+}
+
 const char * LookUpLabel()
 {
   // look up
@@ -1354,5 +1406,156 @@ void ClearGenerator()
 {
   ClearGStates();
   ClearLabels();
-  ClearGeneratedName();
+  ClearCode();
+}
+
+/*------------------------------ FINAL CODE ----------------------------------*/
+
+bool GenerateParameterNames()
+{
+  #ifdef GENERATOR_DEBUG
+    debug("Generating parameter names.");
+  #endif
+
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+  {
+    CodeUnit * unit = CodeGetUnit(u);
+    for(size_t i = 0; i < unit->count; i++)
+    {
+      if(unit->code[i].op != Opcode_CreateFrame) continue;
+
+      // the call, frames of builtins (substr) are not followed by one
+      size_t j = i + 1;
+      while(j < unit->count && unit->code[j].op != Opcode_Call
+            && unit->code[j].op != Opcode_CreateFrame) j++;
+      if(j == unit->count) break;
+      if(unit->code[j].op == Opcode_CreateFrame) { i = j - 1; continue; }
+      Parameters params = findFunctionParameters(unit->code[j].arg[0].d.label);
+
+      // argument slots *N to names of parameters of definition
+      for(size_t k = i + 1; k < j; k++)
+        for(unsigned a = 0; a < OpcodeArity(unit->code[k].op); a++)
+        {
+          Operand * o = &unit->code[k].arg[a];
+          if(o->type != Operand_Variable || o->d.var.frame != Frame_Temporary) continue;
+          const char * slot = o->d.var.name + 3;
+          if(slot[0] != '*' || !isdigit((unsigned char)slot[1])) continue;
+          unsigned long ord = strtoul(slot + 1, NULL, 10);
+          if(ord == 0 || ord > paramCount(params)) return false;
+          *o = OperandVariable(Frame_Temporary, params->names[ord-1]);
+          if(o->type == Operand_None) return false;
+        }
+      i = j;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief   Definition of a variable, for removal of duplicits and unused variables.
+ */
+typedef struct
+{
+  const char * name;      /**< Variable (atom). */
+  size_t order;           /**< Order in the unit, SIZE_MAX for a use. */
+} Definition;
+
+/** @brief Compares definitions by name, then by order. */
+static int CompareDefinitions(const void * a, const void * b)
+{
+  const Definition * x = a, * y = b;
+  if(x->name != y->name) return ((uintptr_t)x->name < (uintptr_t)y->name) ? -1 : 1;
+  return (x->order < y->order) ? -1 : (x->order > y->order);
+}
+
+bool GenerateDefinitions()
+{
+  #ifdef GENERATOR_DEBUG
+    debug("Generating definitions.");
+  #endif
+
+  static const char * scratch[] = {"*tmp", "*foo", "*bar"};
+  Operand vars[3];
+  for(unsigned s = 0; s < 3; s++)
+  {
+    vars[s] = OperandVariable(Frame_Local, scratch[s]);
+    if(vars[s].type == Operand_None) return false;
+  }
+
+  for(size_t u = 0; u < CodeUnitCount(); u++)
+  {
+    CodeUnit * unit = CodeGetUnit(u);
+    if(unit->name == NULL) continue; // prologue
+
+    // definitions behind label (and PUSHFRAME of function)
+    size_t at = 0;
+    while(at < unit->count && unit->code[at].op == Opcode_Comment) at++;
+    if(at < unit->count && unit->code[at].op == Opcode_Label) at++;
+    if(at < unit->count && unit->code[at].op == Opcode_PushFrame) at++;
+
+    // used scratch variables, definitions and uses (ordered last) of local variables
+    bool used[3] = {false, false, false};
+    Definition * defs = malloc(((CODE_MAX_OPERANDS + 1) * unit->count + 1) * sizeof(Definition));
+    if(defs == NULL) return false;
+    size_t count = 0;
+    for(size_t i = 0; i < unit->count; i++)
+    {
+      const Instruction * ins = &unit->code[i];
+      if(ins->op == Opcode_Defvar && ins->arg[0].d.var.frame == Frame_Local)
+      {
+        defs[count].name = ins->arg[0].d.var.name;
+        defs[count].order = i;
+        count++;
+      }
+      else for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+      {
+        for(unsigned s = 0; s < 3; s++)
+          if(OperandEquals(&ins->arg[a], &vars[s])) used[s] = true;
+        if(ins->arg[a].type == Operand_Variable && ins->arg[a].d.var.frame == Frame_Local)
+        {
+          defs[count].name = ins->arg[a].d.var.name;
+          defs[count].order = SIZE_MAX;
+          count++;
+        }
+      }
+    }
+
+    // the first definition of each used variable is kept
+    qsort(defs, count, sizeof(Definition), CompareDefinitions);
+    bool * first = calloc(unit->count + 1, sizeof(bool));
+    if(first == NULL) { free(defs); return false; }
+    for(size_t d = 0, last; d < count; d = last + 1)
+    {
+      for(last = d; last + 1 < count && defs[last+1].name == defs[d].name;) last++;
+      if(defs[d].order != SIZE_MAX && defs[last].order == SIZE_MAX) first[defs[d].order] = true;
+    }
+    free(defs);
+
+    // new code: beginning, scratch variables, definitions, the rest
+    CodeUnit result = {0};
+    bool ok = true;
+    for(size_t i = 0; ok && i < at; i++) ok = CodeAppend(&result, &unit->code[i]);
+    for(unsigned s = 0; ok && s < 3; s++)
+    {
+      if(!used[s]) continue;
+      Instruction ins = {.op = Opcode_Defvar, .arg = {vars[s]}};
+      ok = CodeAppend(&result, &ins);
+    }
+    for(size_t i = at; ok && i < unit->count; i++)
+      if(first[i]) ok = CodeAppend(&result, &unit->code[i]);
+    for(size_t i = at; ok && i < unit->count; i++)
+    {
+      const Instruction * ins = &unit->code[i];
+      if(ins->op == Opcode_Defvar && ins->arg[0].d.var.frame == Frame_Local) continue;
+      ok = CodeAppend(&result, ins);
+    }
+    free(first);
+
+    if(!ok) { free(result.code); return false; }
+    free(unit->code);
+    unit->code = result.code;
+    unit->count = result.count;
+    unit->capacity = result.capacity;
+  }
+  return true;
 }
@@ -33,6 +33,29 @@ void InitGenerator();
 
 void ClearGenerator();
 
+/**
+ * @brief   Names arguments of calls.
+ *
+ * Parameters are addressed in the frame of the called function by their
+ * names, so the caller defines them in the temporary frame. Argument
+ * slots (TF@*N) are renamed to the names from the definition of the
+ * function, which may come after the call.
+ * @returns True, if success. False otherwise.
+ */
+bool GenerateParameterNames();
+
+/**
+ * @brief   Defines variables.
+ *
+ * Definitions of local variables are moved to the beginning of their
+ * unit, so no variable is defined twice by a loop, and every unit
+ * defines only the variables and the scratch variables (*tmp, *foo, *bar),
+ * which it uses.
+ * It runs after the optimizations.
+ * @returns True, if success. False otherwise.
+ */
+bool GenerateDefinitions();
+
 /** @} */
 /*-----------------------------------------------------------*/
 /** @addtogroup Generator_handle
@@ -59,8 +82,6 @@ bool Send(Stack s);
  */
 bool HandlePhrasem(Phrasem p);
 
-void AssignArgument(Phrasem p, unsigned ord);
-
 /** @} */
 /*-----------------------------------------------------------*/
 /** @addtogroup Announcers
@@ -143,6 +164,9 @@ void G_SubStr();
 /** @brief Announces return call to generator. */
 void G_Return();
 
+/** @brief Returns true, if the code of the function ends with return. */
+bool G_Returned();
+
 /** @brief Announces variable declaration to generator. */
 void G_VariableDeclaration();
 
@@ -0,0 +1,94 @@
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hexfloat.h"
+
+#define MANTISSA_BITS 52
+#define EXPONENT_BIAS 1023
+#define EXACT_INTEGRAL 9007199254740992.0   // 2^53
+
+static const char hexdigits[] = "0123456789abcdef";
+
+// ---------------- WriteUnsigned -----------------
+/**
+ * @brief   Writes unsigned number in decimal.
+ *
+ * @param buf     Target buffer.
+ * @param u       The number.
+ * @returns Length of the text.
+ */
+static size_t WriteUnsigned(char * buf, uint64_t u)
+{
+  char tmp[20];
+  size_t len = 0;
+  do {
+    tmp[len++] = '0' + (char)(u % 10);
+    u /= 10;
+  } while(u != 0);
+
+  for(size_t i = 0; i < len; i++) buf[i] = tmp[len - 1 - i];
+  return len;
+}
+
+// ---------------- FormatDouble -----------------
+size_t FormatDouble(char * buf, double d)
+{
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+
+  bool negative = (bits >> 63) != 0;
+  int exponent = (int)((bits >> MANTISSA_BITS) & 0x7ff);
+  uint64_t mantissa = bits & ((UINT64_C(1) << MANTISSA_BITS) - 1);
+
+  size_t len = 0;
+
+  // inf, nan
+  if(exponent == 0x7ff)
+  {
+    if(mantissa != 0) { memcpy(buf, "nan", 4); return 3; }
+    if(negative) buf[len++] = '-';
+    memcpy(buf + len, "inf", 4);
+    return len + 3;
+  }
+
+  // integral fast path (negative zero goes through hex to keep its sign)
+  if(!(d == 0 && negative) && d > -EXACT_INTEGRAL && d < EXACT_INTEGRAL && d == (double)(int64_t)d)
+  {
+    int64_t i = (int64_t)d;
+    if(i < 0) { buf[len++] = '-'; i = -i; }
+    len += WriteUnsigned(buf + len, (uint64_t)i);
+    buf[len] = '\0';
+    return len;
+  }
+
+  if(negative) buf[len++] = '-';
+  buf[len++] = '0';
+  buf[len++] = 'x';
+
+  // leading digit and exponent
+  if(exponent == 0 && mantissa == 0) { buf[len++] = '0'; exponent = 0; }
+  else if(exponent == 0) { buf[len++] = '0'; exponent = 1 - EXPONENT_BIAS; }  // subnormal
+  else { buf[len++] = '1'; exponent -= EXPONENT_BIAS; }
+
+  // fraction, trailing zeros omitted
+  if(mantissa != 0)
+  {
+    buf[len++] = '.';
+    for(int shift = MANTISSA_BITS - 4; mantissa != 0; shift -= 4)
+    {
+      buf[len++] = hexdigits[(mantissa >> shift) & 0xf];
+      mantissa &= (UINT64_C(1) << shift) - 1;
+    }
+  }
+
+  // binary exponent
+  buf[len++] = 'p';
+  if(exponent < 0) { buf[len++] = '-'; exponent = -exponent; }
+  else buf[len++] = '+';
+  len += WriteUnsigned(buf + len, (uint64_t)exponent);
+
+  buf[len] = '\0';
+  return len;
+}
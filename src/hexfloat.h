@@ -0,0 +1,31 @@
+/**
+ * @file hexfloat.h
+ * @interface hexfloat
+ * @date 18th october 2026
+ * @brief Float formatter interface.
+ *
+ * This interface declares exact locale-free formatting of doubles
+ * for float@ operands of IFJcode17.
+ */
+
+#ifndef HEXFLOAT_H
+#define HEXFLOAT_H
+
+#include <stddef.h>
+
+/** Size of the buffer sufficient for any formatted double (with end zero). */
+#define HEXFLOAT_MAXLEN 32
+
+/**
+ * @brief   Formats double exactly.
+ *
+ * Integral values (|d| < 2^53) are written in decimal ("42", "-7"),
+ * the others in hexadecimal %a form ("0x1.8p+1"), which strtod()
+ * reads back to the same double.
+ * @param buf     Target buffer, at least HEXFLOAT_MAXLEN bytes.
+ * @param d       Double to format.
+ * @returns Length of the text.
+ */
+size_t FormatDouble(char * buf, double d);
+
+#endif // HEXFLOAT_H
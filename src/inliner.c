@@ -0,0 +1,297 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "err.h"
+#include "inliner.h"
+#include "io.h"
+#include "tables.h"
+
+/*----------- DATA ------------*/
+static unsigned long inlineCounter = 0;   /**< Number of inlined call sites (unique prefixes). */
+static char prefix[24];                   /**< Prefix of renamed names of current call site. */
+/*-----------------------------*/
+
+/**
+ * @brief   Scratch variable.
+ *
+ * Scratch variables (*tmp, *foo, *bar) are never live across a call,
+ * so the body can share them with the caller.
+ * @param name    Operand text of the variable.
+ * @returns True, if scratch variable. False otherwise.
+ */
+static bool IsScratch(const char * name)
+{
+  return !strcmp(name, "LF@*tmp") || !strcmp(name, "LF@*foo") || !strcmp(name, "LF@*bar");
+}
+
+/**
+ * @brief   Prefixed atom.
+ *
+ * @param head    Part before the prefix.
+ * @param tail    Part after the prefix.
+ * @returns head + prefix + tail (atom), or NULL.
+ */
+static const char * Prefixed(const char * head, const char * tail)
+{
+  size_t lh = strlen(head), lp = strlen(prefix), lt = strlen(tail);
+  char * buf = malloc(lh + lp + lt + 1);
+  if(buf == NULL) return NULL;
+  memcpy(buf, head, lh);
+  memcpy(buf + lh, prefix, lp);
+  memcpy(buf + lh + lp, tail, lt + 1);
+
+  const char * atom = atomInsert(buf);
+  free(buf);
+  return atom;
+}
+
+/**
+ * @brief   Renames operand into the caller.
+ *
+ * Local variables (except scratch ones) and parameters in temporary
+ * frame become prefixed local variables of the caller, labels are prefixed.
+ * @param o       Operand.
+ * @returns True, if success. False otherwise.
+ */
+static bool RenameOperand(Operand * o)
+{
+  if(o->type == Operand_Variable)
+  {
+    if(o->d.var.frame == Frame_Local && !IsScratch(o->d.var.name))
+      o->d.var.name = Prefixed("LF@", o->d.var.name + 3);
+    else if(o->d.var.frame == Frame_Temporary)
+    {
+      o->d.var.frame = Frame_Local;
+      o->d.var.name = Prefixed("LF@", o->d.var.name + 3);
+    }
+    else return true;
+    return o->d.var.name != NULL;
+  }
+  if(o->type == Operand_Label)
+  {
+    o->d.label = Prefixed("", o->d.label);
+    return o->d.label != NULL;
+  }
+  return true;
+}
+
+/**
+ * @brief   Number of instructions of the body.
+ *
+ * Definitions are moved to the caller, so they are not counted.
+ * @param f       Unit of the function.
+ * @param start   Beginning of the body.
+ * @returns Number of instructions.
+ */
+static size_t BodySize(const CodeUnit * f, size_t start)
+{
+  size_t size = 0;
+  for(size_t i = start; i < f->count; i++)
+    if(f->code[i].op != Opcode_Defvar && f->code[i].op != Opcode_Comment) size++;
+  return size;
+}
+
+/**
+ * @brief   Size of the function for the cost model.
+ *
+ * @param f       Unit of the function.
+ * @param limit   Size threshold.
+ * @returns Number of instructions of the body, or (size_t)-1, if not inlinable.
+ */
+static size_t InlineCost(const CodeUnit * f, unsigned limit)
+{
+  if(f == NULL || f->name == NULL || !f->started || !strcmp(f->name, "scope")) return (size_t)-1;
+
+  size_t start = CodeBodyStart(f);
+  if(start == 0) return (size_t)-1;
+
+  // leaf functions only, frames are not moved inside of the body
+  for(size_t i = start; i < f->count; i++)
+  {
+    Opcode op = f->code[i].op;
+    if(op == Opcode_Call || op == Opcode_PushFrame || op == Opcode_PopFrame) return (size_t)-1;
+  }
+
+  size_t size = BodySize(f, start);
+  return (size <= limit) ? size : (size_t)-1;
+}
+
+/**
+ * @brief   Hoisting point of the unit.
+ *
+ * Definitions of inlined variables are placed behind leading
+ * label, PUSHFRAME and definitions of the unit.
+ * @param u       Unit.
+ * @returns Index.
+ */
+static size_t HoistPoint(const CodeUnit * u)
+{
+  size_t i = 0;
+  while(i < u->count && u->code[i].op == Opcode_Comment) i++;
+  if(i < u->count && u->code[i].op == Opcode_Label) i++;
+  if(i < u->count && u->code[i].op == Opcode_PushFrame) i++;
+  while(i < u->count && (u->code[i].op == Opcode_Defvar || u->code[i].op == Opcode_Comment)) i++;
+  return i;
+}
+
+/**
+ * @brief   Appends renamed instruction.
+ *
+ * Definitions go to hoisted code, comments are dropped.
+ * @param out     Target code.
+ * @param hoisted Target of definitions.
+ * @param ins     Instruction.
+ * @param ret     Label of the end of inlined body (RETURN jumps there).
+ * @returns True, if success. False otherwise.
+ */
+static bool AppendRenamed(CodeUnit * out, CodeUnit * hoisted, Instruction ins, const Operand * ret)
+{
+  if(ins.op == Opcode_Comment) return true;
+  if(ins.op == Opcode_Return)
+  {
+    ins.op = Opcode_Jump;
+    ins.arg[0] = *ret;
+    return CodeAppend(out, &ins);
+  }
+
+  for(unsigned k = 0; k < OpcodeArity(ins.op); k++)
+    if(!RenameOperand(&ins.arg[k])) return false;
+
+  return CodeAppend((ins.op == Opcode_Defvar) ? hoisted : out, &ins);
+}
+
+/**
+ * @brief   Tries to inline call site.
+ *
+ * Call site is CREATEFRAME, arguments (parameters of f in temporary
+ * frame), CALL f, POPFRAME. Return value is passed on the data stack.
+ * @param u       Calling unit.
+ * @param i       Index of CREATEFRAME.
+ * @param limit   Size threshold.
+ * @param out     Target code.
+ * @param hoisted Target of definitions.
+ * @returns Index of the last instruction of the call site, or i, if not inlined.
+ */
+static size_t InlineCallSite(CodeUnit * u, size_t i, unsigned limit, CodeUnit * out, CodeUnit * hoisted)
+{
+  // the call
+  size_t j = i + 1;
+  while(j < u->count && u->code[j].op != Opcode_Call && u->code[j].op != Opcode_CreateFrame) j++;
+  if(j + 1 >= u->count || u->code[j].op != Opcode_Call) return i;
+  if(u->code[j+1].op != Opcode_PopFrame) return i;
+
+  CodeUnit * f = CodeFindUnit(u->code[j].arg[0].d.label);
+  if(InlineCost(f, limit) == (size_t)-1) return i;
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Inline %s into %s.", f->name, (u->name != NULL)?u->name:"prologue");
+  #endif
+
+  // unique prefix of the call site
+  sprintf(prefix, "%%%lu%%", ++inlineCounter);
+  Operand ret = OperandLabel("$ret");
+  if(!RenameOperand(&ret)) return i;
+
+  // arguments, only the parameters are renamed
+  for(size_t k = i + 1; k < j; k++)
+  {
+    Instruction arg = u->code[k];
+    for(unsigned a = 0; a < OpcodeArity(arg.op); a++)
+      if(arg.arg[a].type == Operand_Variable && arg.arg[a].d.var.frame == Frame_Temporary
+         && !RenameOperand(&arg.arg[a])) return i;
+    if(!CodeAppend((arg.op == Opcode_Defvar) ? hoisted : out, &arg)) return i;
+  }
+
+  // body, final RETURN falls through
+  size_t last = f->count;
+  while(last > 0 && f->code[last-1].op == Opcode_Comment) last--;
+  if(last > 0 && f->code[last-1].op == Opcode_Return) last--;
+  for(size_t k = CodeBodyStart(f); k < last; k++)
+    if(!AppendRenamed(out, hoisted, f->code[k], &ret)) return i;
+
+  // end of the body, return value is on the data stack
+  Instruction ins = {.op = Opcode_Label, .arg = {ret}};
+  if(!CodeAppend(out, &ins)) return i;
+
+  f->inlined++;
+  return j + 1;
+}
+
+/**
+ * @brief   Inlines call sites of the unit.
+ *
+ * @param u       Unit.
+ * @param limit   Size threshold.
+ * @returns True, if success. False otherwise.
+ */
+static bool InlineUnit(CodeUnit * u, unsigned limit)
+{
+  CodeUnit out = {0}, hoisted = {0};
+  bool changed = false;
+  bool ok = true;
+
+  for(size_t i = 0; ok && i < u->count; i++)
+  {
+    if(u->code[i].op == Opcode_CreateFrame)
+    {
+      size_t end = InlineCallSite(u, i, limit, &out, &hoisted);
+      if(getErrorType() != ErrorType_Ok) ok = false;
+      if(end != i) { changed = true; i = end; continue; }
+    }
+    ok = ok && CodeAppend(&out, &u->code[i]);
+  }
+
+  if(ok && changed)
+  {
+    // definitions on the beginning
+    size_t h = HoistPoint(u);
+    CodeUnit result = {0};
+    for(size_t i = 0; ok && i < h; i++) ok = CodeAppend(&result, &out.code[i]);
+    for(size_t i = 0; ok && i < hoisted.count; i++) ok = CodeAppend(&result, &hoisted.code[i]);
+    for(size_t i = h; ok && i < out.count; i++) ok = CodeAppend(&result, &out.code[i]);
+
+    if(ok)
+    {
+      free(u->code);
+      u->code = result.code;
+      u->count = result.count;
+      u->capacity = result.capacity;
+      ok = CodeRebuildCalls(u);
+    }
+    else free(result.code);
+  }
+
+  free(out.code);
+  free(hoisted.code);
+  return ok;
+}
+
+bool InlineFunctions(unsigned limit)
+{
+  if(limit == 0) return true;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+    if(!InlineUnit(CodeGetUnit(i), limit)) return false;
+
+  // report
+  if(report())
+  {
+    size_t functions = 0, sites = 0;
+    for(size_t i = 0; i < CodeUnitCount(); i++)
+    {
+      const CodeUnit * f = CodeGetUnit(i);
+      if(f->inlined == 0) continue;
+      fprintf(stderr, "Inlined function %s: %u call sites, %zu instructions\n",
+              f->name, f->inlined, BodySize(f, CodeBodyStart(f)));
+      functions++;
+      sites += f->inlined;
+    }
+    fprintf(stderr, "Inlined functions: %zu (%zu call sites)\n", functions, sites);
+  }
+
+  return true;
+}
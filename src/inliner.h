@@ -0,0 +1,28 @@
+/**
+ * @file inliner.h
+ * @interface inliner
+ * @date 18th october 2026
+ * @brief Inliner interface.
+ *
+ * This interface declares inlining of small functions
+ * into their call sites.
+ */
+
+#ifndef INLINER_H
+#define INLINER_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Inlines small leaf functions.
+ *
+ * Calls of functions, which call no other function and whose body
+ * has at most limit instructions, are replaced by the body with
+ * variables and labels renamed into the caller. Variables of the
+ * body are defined once, on the beginning of the caller.
+ * @param limit   Size threshold, 0 disables inlining.
+ * @returns True, if success. False otherwise.
+ */
+bool InlineFunctions(unsigned limit);
+
+#endif // INLINER_H
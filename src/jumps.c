@@ -0,0 +1,431 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "code.h"
+#include "config.h"
+#include "io.h"
+#include "jumps.h"
+
+/*----------- DATA ------------*/
+static unsigned threadedJumps = 0;    /**< Number of redirected jumps. */
+static long removedJumps = 0;         /**< Number of removed jumps (less the added ones). */
+static unsigned invertedJumps = 0;    /**< Number of inverted conditional jumps. */
+static unsigned removedBlocks = 0;    /**< Number of removed unreachable blocks. */
+static unsigned removedLabels = 0;    /**< Number of removed labels. */
+
+/**
+ * @brief   Successors of a block after threading.
+ */
+typedef struct
+{
+  size_t next;        /**< Fall-through successor, or CFG_NONE. */
+  size_t target;      /**< Jump successor, or CFG_NONE. */
+} Edges;
+
+/**
+ * @brief   Block contains only labels and comments.
+ */
+static bool IsEmptyBlock(const Cfg * cfg, size_t b)
+{
+  const BasicBlock * block = &cfg->blocks[b];
+  for(size_t i = block->start; i < block->end; i++)
+  {
+    Opcode op = cfg->unit->code[i].op;
+    if(op != Opcode_Label && op != Opcode_Comment) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Block contains only labels, comments and an unconditional jump.
+ */
+static bool IsJumpBlock(const Cfg * cfg, size_t b)
+{
+  const BasicBlock * block = &cfg->blocks[b];
+  if(cfg->unit->code[block->end - 1].op != Opcode_Jump || block->target == CFG_NONE) return false;
+  for(size_t i = block->start; i + 1 < block->end; i++)
+  {
+    Opcode op = cfg->unit->code[i].op;
+    if(op != Opcode_Label && op != Opcode_Comment) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Final block of a jump.
+ *
+ * Follows blocks, which are empty or only jump. The steps are bounded,
+ * such blocks may form a cycle.
+ * @param cfg     Graph.
+ * @param b       Block.
+ * @returns Block, where the real code continues.
+ */
+static size_t Resolve(const Cfg * cfg, size_t b)
+{
+  for(size_t steps = 0; b != CFG_NONE && steps < cfg->count; steps++)
+  {
+    size_t to;
+    if(IsEmptyBlock(cfg, b)) to = cfg->blocks[b].next;
+    else if(IsJumpBlock(cfg, b)) to = cfg->blocks[b].target;
+    else break;
+    if(to == CFG_NONE) break;
+    b = to;
+  }
+  return b;
+}
+
+/**
+ * @brief   Block falls through to the following one.
+ */
+static bool FallsThrough(const Cfg * cfg, size_t b)
+{
+  Opcode op = cfg->unit->code[cfg->blocks[b].end - 1].op;
+  return op != Opcode_Jump && op != Opcode_Return;
+}
+
+/**
+ * @brief   Marks blocks reachable from the entry.
+ */
+static void MarkReachable(const Edges * edges, bool * reachable, size_t * stack)
+{
+  size_t top = 0;
+  reachable[0] = true;
+  stack[top++] = 0;
+  while(top > 0)
+  {
+    size_t b = stack[--top];
+    size_t succ[2] = {edges[b].next, edges[b].target};
+    for(unsigned i = 0; i < 2; i++)
+      if(succ[i] != CFG_NONE && !reachable[succ[i]])
+      {
+        reachable[succ[i]] = true;
+        stack[top++] = succ[i];
+      }
+  }
+}
+
+/**
+ * @brief   Preferred successor of the block in the layout.
+ *
+ * Static heuristic: the then-branch and the loop body (fall-through
+ * successors of conditional jumps) are hot, then the jump target.
+ */
+static size_t Preferred(const Cfg * cfg, const Edges * edges, const bool * placed, size_t b)
+{
+  Opcode op = cfg->unit->code[cfg->blocks[b].end - 1].op;
+  if(op == Opcode_Return) return CFG_NONE;
+  if(op == Opcode_Jump) return edges[b].target;
+  if(OpcodeIsConditionalJump(op) && (edges[b].next == CFG_NONE || placed[edges[b].next]))
+    return edges[b].target;
+  return edges[b].next;
+}
+
+/**
+ * @brief   Lays out reachable blocks into chains.
+ *
+ * Successor is moved after its block only if no other block falls
+ * through into it. Block falling off the end of the unit stays last.
+ * @returns Number of placed blocks.
+ */
+static size_t Layout(const Cfg * cfg, const Edges * edges, const bool * reachable, bool * placed, size_t * order)
+{
+  size_t pinned = (FallsThrough(cfg, cfg->count - 1)) ? cfg->count - 1 : CFG_NONE;
+
+  size_t count = 0;
+
+  for(size_t b = 0; b < cfg->count; b++)
+  {
+    if(!reachable[b] || placed[b] || b == pinned) continue;
+
+    for(size_t cur = b;;)
+    {
+      placed[cur] = true;
+      order[count++] = cur;
+
+      size_t s = Preferred(cfg, edges, placed, cur);
+      if(s == CFG_NONE || placed[s] || s == pinned) break;
+      if(edges[cur].next != s)
+      {
+        // someone else falls through into s
+        bool fallen = false;
+        for(size_t p = 0; p < cfg->count && !fallen; p++)
+          fallen = reachable[p] && p != cur && edges[p].next == s;
+        if(fallen) break;
+      }
+      cur = s;
+    }
+  }
+
+  if(pinned != CFG_NONE && reachable[pinned]) order[count++] = pinned;
+  return count;
+}
+
+/**
+ * @brief   Appends jump to the block.
+ *
+ * @returns True, if success. False otherwise (also if the block has no label).
+ */
+static bool AppendJump(CodeUnit * out, const Cfg * cfg, Opcode op, const Instruction * orig, size_t to)
+{
+  const char * label = CfgBlockLabel(cfg, to);
+  if(label == NULL) return false;
+
+  Instruction jump = {.op = op};
+  if(orig != NULL) jump = *orig, jump.op = op;
+  jump.arg[0].type = Operand_Label;
+  jump.arg[0].d.label = label;
+  return CodeAppend(out, &jump);
+}
+
+/**
+ * @brief   Emits blocks in the order.
+ *
+ * @param cfg       Graph.
+ * @param edges     Successors of the blocks.
+ * @param order     Order of the blocks.
+ * @param count     Number of blocks in the order.
+ * @param out       Emitted code.
+ * @param jumps     Returned change of the number of jumps.
+ * @param inverted  Returned number of inverted conditional jumps.
+ * @returns True, if success. False otherwise (no label for a jump).
+ */
+static bool Emit(const Cfg * cfg, const Edges * edges, const size_t * order, size_t count,
+                 CodeUnit * out, long * jumps, unsigned * inverted)
+{
+  const CodeUnit * u = cfg->unit;
+  *jumps = 0;
+  *inverted = 0;
+
+  for(size_t k = 0; k < count; k++)
+  {
+    size_t b = order[k], after = (k + 1 < count) ? order[k+1] : CFG_NONE;
+    const BasicBlock * block = &cfg->blocks[b];
+    const Instruction * last = &u->code[block->end - 1];
+    bool jump = OpcodeIsJump(last->op);
+
+    for(size_t i = block->start; i < block->end - (jump ? 1 : 0); i++)
+      if(!CodeAppend(out, &u->code[i])) return false;
+
+    if(last->op == Opcode_Jump)
+    {
+      if(edges[b].target == CFG_NONE) { if(!CodeAppend(out, last)) return false; }
+      else if(edges[b].target == after) (*jumps)--;
+      else if(!AppendJump(out, cfg, Opcode_Jump, last, edges[b].target)) return false;
+    }
+    else if(jump)
+    {
+      size_t next = edges[b].next, target = edges[b].target;
+      if(target == CFG_NONE) { if(!CodeAppend(out, last)) return false; }
+      else if(next != after && target == after && next != CFG_NONE)
+      {
+        // condition is negated, so the target falls through
+        if(!AppendJump(out, cfg, OpcodeInvertJump(last->op), last, next)) return false;
+        (*inverted)++;
+        continue;
+      }
+      else if(!AppendJump(out, cfg, last->op, last, target)) return false;
+
+      if(next != CFG_NONE && next != after)
+      {
+        if(!AppendJump(out, cfg, Opcode_Jump, NULL, next)) return false;
+        (*jumps)++;
+      }
+    }
+    else if(FallsThrough(cfg, b) && edges[b].next != after)
+    {
+      if(edges[b].next == CFG_NONE) return false;   // falls off the end of the unit
+      if(!AppendJump(out, cfg, Opcode_Jump, NULL, edges[b].next)) return false;
+      (*jumps)++;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief   Optimizes jumps of the unit.
+ *
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool OptimizeUnit(CodeUnit * u)
+{
+  Cfg cfg;
+  if(!CfgBuild(&cfg, u)) return false;
+  if(cfg.count < 2)
+  {
+    CfgFree(&cfg);
+    return true;
+  }
+
+  Edges * edges = malloc(cfg.count * sizeof(Edges));
+  bool * reachable = calloc(cfg.count, sizeof(bool));
+  bool * placed = calloc(cfg.count, sizeof(bool));
+  size_t * order = malloc(cfg.count * sizeof(size_t));
+  CodeUnit result = {0};
+  bool ok = (edges != NULL && reachable != NULL && placed != NULL && order != NULL);
+
+  // threading
+  unsigned threaded = 0;
+  for(size_t b = 0; ok && b < cfg.count; b++)
+  {
+    edges[b].next = Resolve(&cfg, cfg.blocks[b].next);
+    edges[b].target = Resolve(&cfg, cfg.blocks[b].target);
+    if(edges[b].target != cfg.blocks[b].target) threaded++;
+  }
+
+  // layout, the original order if a jump would need a missing label
+  long jumps = 0;
+  unsigned inverted = 0, dead = 0;
+  if(ok)
+  {
+    MarkReachable(edges, reachable, order);
+    size_t count = Layout(&cfg, edges, reachable, placed, order);
+    ok = Emit(&cfg, edges, order, count, &result, &jumps, &inverted);
+    if(!ok)
+    {
+      #ifdef OPTIMIZER_DEBUG
+        debug("Layout of %s kept.", (u->name != NULL) ? u->name : "prologue");
+      #endif
+      free(result.code);
+      result = (CodeUnit){0};
+      count = 0;
+      for(size_t b = 0; b < cfg.count; b++)
+        if(reachable[b]) order[count++] = b;
+      ok = Emit(&cfg, edges, order, count, &result, &jumps, &inverted);
+    }
+
+    // definitions of unreachable blocks, moved to the beginning by GenerateDefinitions()
+    for(size_t b = 0; ok && b < cfg.count; b++)
+    {
+      if(reachable[b]) continue;
+      if(!IsEmptyBlock(&cfg, b)) dead++;
+      for(size_t i = cfg.blocks[b].start; ok && i < cfg.blocks[b].end; i++)
+      {
+        const Instruction * ins = &u->code[i];
+        if(ins->op == Opcode_Label) removedLabels++;
+        if(ins->op == Opcode_Defvar && ins->arg[0].d.var.frame == Frame_Local) ok = CodeAppend(&result, ins);
+      }
+    }
+  }
+
+  free(edges);
+  free(reachable);
+  free(placed);
+  free(order);
+  CfgFree(&cfg);
+  if(!ok)
+  {
+    free(result.code);
+    return false;
+  }
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Jumps of %s: %u threaded, %ld removed, %u inverted, %u dead blocks.",
+          (u->name != NULL) ? u->name : "prologue", threaded, -jumps, inverted, dead);
+  #endif
+
+  threadedJumps += threaded;
+  removedJumps -= jumps;
+  invertedJumps += inverted;
+  removedBlocks += dead;
+
+  free(u->code);
+  u->code = result.code;
+  u->count = result.count;
+  u->capacity = result.capacity;
+  return CodeRebuildCalls(u);
+}
+
+/**
+ * @brief   Compares atoms by their addresses.
+ */
+static int CompareAtoms(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)*(const char * const *)a;
+  uintptr_t y = (uintptr_t)*(const char * const *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief   Removes labels nothing refers to.
+ *
+ * Labels of the functions are kept, so are all the labels referred
+ * by jumps and calls of any unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool RemoveLabels()
+{
+  const char ** refs = NULL;
+  size_t count = 0, capacity = 0;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    const CodeUnit * u = CodeGetUnit(i);
+    for(size_t j = 0; j <= u->count; j++)
+    {
+      const char * label = NULL;
+      if(j == u->count) label = u->name;
+      else if(OpcodeIsJump(u->code[j].op) || u->code[j].op == Opcode_Call) label = u->code[j].arg[0].d.label;
+      if(label == NULL) continue;
+
+      if(count == capacity)
+      {
+        size_t size = (capacity == 0) ? 64 : 2 * capacity;
+        const char ** grown = realloc(refs, size * sizeof(const char *));
+        if(grown == NULL)
+        {
+          free(refs);
+          return false;
+        }
+        refs = grown;
+        capacity = size;
+      }
+      refs[count++] = label;
+    }
+  }
+  qsort(refs, count, sizeof(const char *), CompareAtoms);
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    CodeUnit * u = CodeGetUnit(i);
+    size_t n = 0;
+    for(size_t j = 0; j < u->count; j++)
+    {
+      const Instruction * ins = &u->code[j];
+      if(ins->op == Opcode_Label && bsearch(&ins->arg[0].d.label, refs, count, sizeof(const char *), CompareAtoms) == NULL)
+      {
+        removedLabels++;
+        continue;
+      }
+      u->code[n++] = *ins;
+    }
+    u->count = n;
+  }
+
+  free(refs);
+  return true;
+}
+
+bool OptimizeJumps()
+{
+  unsigned threaded = threadedJumps, inverted = invertedJumps, dead = removedBlocks, labels = removedLabels;
+  long jumps = removedJumps;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+    if(!OptimizeUnit(CodeGetUnit(i))) return false;
+  if(!RemoveLabels()) return false;
+
+  if(report())
+  {
+    fprintf(stderr, "Threaded jumps: %u\n", threadedJumps - threaded);
+    fprintf(stderr, "Removed jumps: %ld\n", removedJumps - jumps);
+    fprintf(stderr, "Inverted jumps: %u\n", invertedJumps - inverted);
+    fprintf(stderr, "Removed unreachable blocks: %u\n", removedBlocks - dead);
+    fprintf(stderr, "Removed labels: %u\n", removedLabels - labels);
+  }
+  return true;
+}
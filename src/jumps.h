@@ -0,0 +1,28 @@
+/**
+ * @file jumps.h
+ * @interface jumps
+ * @date 18th october 2026
+ * @brief Jump optimization interface.
+ *
+ * This interface declares jump threading and layout of basic blocks.
+ */
+
+#ifndef JUMPS_H
+#define JUMPS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Optimizes jumps.
+ *
+ * Jumps to blocks, which only jump further (or contain only labels),
+ * are redirected to the final block. Then the reachable blocks are laid
+ * out, so the more likely successor falls through: the then-branch
+ * or the loop body after a conditional jump, the target after
+ * an unconditional jump. Unreachable blocks, jumps to the following
+ * block and labels nothing refers to are removed.
+ * @returns True, if success. False otherwise.
+ */
+bool OptimizeJumps();
+
+#endif // JUMPS_H
@@ -1,124 +1,208 @@
-
 #include <stdlib.h>
 
+#include "err.h"
 #include "functions.h"
 #include "list.h"
+#include "tables.h"
+
+#define STARTING_CHUNK_PARAMS 4       //size of initialised arrays of parametres
+#define STARTING_CHUNK_SIGNATURES 64  //number of buckets of initialised signature table
+
+/**
+ * @brief   Table of interned signatures.
+ *
+ * Hash table with chaining, number of buckets is a power of two.
+ */
+static struct {
+  size_t arr_size;        //number of buckets
+  size_t count;           //number of signatures
+  Signature ** arr;       //buckets
+} signatures = {.arr_size = 0, .count = 0, .arr = NULL};
 
 
 Parameters paramInit() { return NULL; }
 
 bool paramAdd(Parameters * p, const char * name, DataType dt)
 {
-  struct paramFce * first = (*p);
-  struct paramFce * newparam = malloc( sizeof(struct paramFce) );
-  if(newparam == NULL) return false;
-
-  newparam->type = dt;
-  if(name == NULL) newparam->name = NULL;
-  else
+  // empty
+  if((*p) == NULL)
   {
-    newparam->name = strdup(name);
-    if(newparam->name == NULL) return false;
+    if(((*p) = calloc(1, sizeof(struct paramFce))) == NULL) return false;
   }
 
+  // full
+  if((*p)->count == (*p)->capacity)
+  {
+    size_t capacity = ((*p)->capacity == 0) ? STARTING_CHUNK_PARAMS : 2*(*p)->capacity;
+    DataType * types = realloc((*p)->types, capacity * sizeof(DataType));
+    if(types == NULL) return false;
+    (*p)->types = types;
+    const char ** names = realloc((void *)(*p)->names, capacity * sizeof(const char *));
+    if(names == NULL) return false;
+    (*p)->names = names;
+    (*p)->capacity = capacity;
+  }
 
-  // empty
-  if(first == NULL)
+  const char * atom = NULL;
+  if(name != NULL)
   {
-    newparam->next = NULL;
-    (*p) = newparam;
-    return true;
+    atom = atomInsert(name);
+    if(atom == NULL) return false;
   }
 
-  // not empty
-  // search for last
-  struct paramFce * pom = (*p);
-  while(pom->next != NULL) { pom = pom->next; }
-  // add after
-  pom->next = newparam;
-  newparam->next = NULL;
+  (*p)->types[(*p)->count] = dt;
+  (*p)->names[(*p)->count] = atom;
+  (*p)->count++;
   return true;
 }
 
+size_t paramCount(Parameters p) { return (p == NULL) ? 0 : p->count; }
+
 void PrintParameters(Parameters parameter)
 {
-  struct paramFce * pom;
+  if(paramCount(parameter) == 0) debug("---empty parameters---");
 
-  if(parameter == NULL) debug("---empty parameters---");
-
-  while(parameter != NULL)
+  for(size_t i = 0; i < paramCount(parameter); i++)
   {
-    pom = parameter;
-    parameter = parameter->next;
-    debug("%s [%s]", pom->name, DataType2Str(pom->type));
+    debug("%s [%s]", parameter->names[i], DataType2Str(parameter->types[i]));
   }
 }
 
-void paramFree(struct paramFce * parameter)
+void paramFree(Parameters parameter)
 {
-    struct paramFce * pom;
+    if(parameter == NULL) return;
 
-    while(parameter != NULL)
-    {
-        pom = parameter;
-        parameter = parameter->next;
-        free(pom->name);
-        free(pom);
-    }
+    // names are atoms, they are freed with the atom table
+    free(parameter->types);
+    free((void *)parameter->names);
+    free(parameter);
     #ifdef SYMTABLE_DEBUG
         debug("Freeing parameters.");
     #endif
 }
 
-DataType paramPop(Parameters * p)
+bool ParametersMatches(Parameters p1, Parameters p2)
 {
-  // control for NULL
-  if((*p) == NULL) return DataType_Unknown;
-
-  // first set
-  struct paramFce * pom;
-  pom = (*p);
-
-  // next
-  (*p) = (*p)->next;
-  // get datatype
-  DataType dt = pom->type;
-  // free memory
-  if(pom->name != NULL) free(pom->name);
-  free(pom);
-  // return
-  return dt;
+  // interned signatures are equal, if and only if types match
+  const Signature * s1 = paramSignature(p1), * s2 = paramSignature(p2);
+  if(s1 == NULL || s2 == NULL)
+  {
+    setErrorType(ErrorType_Internal);
+    setErrorMessage("ParametersMatches: could not allocate memory");
+    return false;
+  }
+  return s1 == s2;
 }
 
-inline bool ParametersMatches(Parameters p1, Parameters p2)
+bool findParamName(Parameters parameter, const char * name)
 {
-  struct paramFce * ptr1 = p1;
-  struct paramFce * ptr2 = p2;
-  // all parameters
-  while((ptr1 != NULL) && (ptr2 != NULL))
+  if(paramCount(parameter) == 0) return false;
+
+  // names are atoms, so pointers are compared, a name without atom is no parameter
+  const char * atom = atomFind(name);
+  if(atom == NULL) return false;
+  for(size_t i = 0; i < parameter->count; i++)
   {
-    // not matching
-    if(ptr1->type != ptr2->type) return false;
+    if(parameter->names[i] == atom) return true;
+  }
+  return false;
+}
+
+/*-------------------------- SIGNATURES ---------------------------*/
+
+/**
+ * @brief   Hash of the types of parametres.
+ *
+ * @param types     Array of types.
+ * @param count     Number of types.
+ * @returns Hash.
+ */
+static unsigned int hashTypes(const DataType * types, size_t count)
+{
+  unsigned int h = 2166136261U;
+  for(size_t i = 0; i < count; i++)
+    h = (h ^ (unsigned int)types[i]) * 16777619U;
+
+  return (h ^ (unsigned int)count) * 16777619U;
+}
 
-    // next
-    ptr1 = ptr1->next;
-    ptr2 = ptr2->next;
+/**
+ * @brief   Doubles the number of buckets of the signature table.
+ *
+ * @returns True if success. False otherwise.
+ */
+static bool signatureTableResize()
+{
+  size_t newsize = (signatures.arr_size == 0) ? STARTING_CHUNK_SIGNATURES : 2*signatures.arr_size;
+  Signature ** arr = calloc(newsize, sizeof(Signature *));
+  if(arr == NULL) return false;
+
+  // moving signatures by their hashes
+  for(size_t i = 0; i < signatures.arr_size; i++)
+  {
+    Signature * it = signatures.arr[i];
+    while(it != NULL)
+    {
+      Signature * next = it->next;
+      it->next = arr[it->hash & (newsize - 1)];
+      arr[it->hash & (newsize - 1)] = it;
+      it = next;
+    }
   }
 
-  return (ptr1 == NULL) && (ptr2 == NULL);
+  free(signatures.arr);
+  signatures.arr = arr;
+  signatures.arr_size = newsize;
+  return true;
 }
 
-bool findParamName(Parameters parameter, const char * name)
+const Signature * paramSignature(Parameters p)
 {
-  struct paramFce * pom;
+  size_t count = paramCount(p);
+  const DataType * types = (count == 0) ? NULL : p->types;
+  unsigned int hash = hashTypes(types, count);
 
-  if(parameter == NULL) return false;
+  if(signatures.count >= signatures.arr_size)
+  {
+    if(!signatureTableResize()) return NULL;
+  }
 
-  while(parameter != NULL)
+  // lookup
+  Signature ** bucket = &signatures.arr[hash & (signatures.arr_size - 1)];
+  for(Signature * it = *bucket; it != NULL; it = it->next)
   {
-    pom = parameter;
-    parameter = parameter->next;
-    if((pom->name != NULL) && (!strcmp(pom->name, name))) return true;
+    if((it->hash == hash) && (it->count == count)
+    && ((count == 0) || !memcmp(it->types, types, count * sizeof(DataType))))
+      return it;
   }
-  return false;
+
+  // insert
+  Signature * sig = malloc(sizeof(Signature) + count * sizeof(DataType));
+  if(sig == NULL) return NULL;
+  sig->count = count;
+  sig->hash = hash;
+  if(count > 0) memcpy(sig->types, types, count * sizeof(DataType));
+  sig->next = *bucket;
+  *bucket = sig;
+  signatures.count++;
+
+  return sig;
+}
+
+void signatureTableFree()
+{
+  for(size_t i = 0; i < signatures.arr_size; i++)
+  {
+    Signature * it = signatures.arr[i];
+    while(it != NULL)
+    {
+      Signature * next = it->next;
+      free(it);
+      it = next;
+    }
+  }
+  free(signatures.arr);
+  signatures.arr = NULL;
+  signatures.arr_size = 0;
+  signatures.count = 0;
 }
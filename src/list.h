@@ -1,4 +1,3 @@
-
 /**
  * @file list.h
  * @interface generator
@@ -12,17 +11,36 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 /**
- * @brief   Structure representing type and name of parametres.
+ * @brief   Structure representing interned signature of a function.
+ *
+ * Signature (number and types of parametres) is shared among all the
+ * functions with the same types of parametres, so two signatures are
+ * compatible, if and only if their pointers are equal.
+ */
+typedef struct signature{
+    size_t count;               /**< Number of parametres. */
+    unsigned int hash;          /**< Hash of the types. */
+    struct signature * next;    /**< Next signature in the same bucket. */
+    DataType types[];           /**< Types of parametres. */
+} Signature;
+
+/**
+ * @brief   Structure representing types and names of parametres.
  *          Used for sending lists of parametres.
- * List.
+ *
+ * Parametres are saved in contiguous arrays, names are atoms
+ * (interned strings, see atomInsert()). Empty list is NULL.
  */
 typedef struct paramFce{
-    DataType type;
-    char * name;
-    struct paramFce *next;
+    size_t count;               /**< Number of parametres. */
+    size_t capacity;            /**< Allocated size of arrays. */
+    DataType * types;           /**< Types of parametres. */
+    const char ** names;        /**< Names of parametres (atoms). */
 } * Parameters;
 
 /*-----------------------------------------------------------*/
@@ -42,7 +60,8 @@ Parameters paramInit();
 /**
  * @brief     Adds item to list.
  *
- * This function adds item to parameter list, with name and datatype given.
+ * This function adds item to the end of parameter list, with name
+ * and datatype given. Name is interned.
  * @param p     List to add to.
  * @param name  Name of the parameter (NULL, if declaration).
  * @param dt    DataType of the parameter.
@@ -50,6 +69,14 @@ Parameters paramInit();
  */
 bool paramAdd(Parameters * p, const char * name, DataType dt);
 
+/**
+ * @brief     Number of parameters.
+ *
+ * @param p     Parameter list.
+ * @returns Number of parameters in the list.
+ */
+size_t paramCount(Parameters p);
+
 /**
  * @brief     Prints parameters.
  *
@@ -68,15 +95,6 @@ void PrintParameters(Parameters p);
  */
 void paramFree(Parameters parameter);
 
-/**
- * @brief   Pops one item.
- *
- * This function pops one list item (parameter) and returns its type.
- * @param p     The altered list.
- * @returns DataType of the top parameter, or DataType_Unknown, if empty.
- */
-DataType paramPop(Parameters * p);
-
 /**
  * @brief   List comparison.
  *
@@ -88,8 +106,32 @@ DataType paramPop(Parameters * p);
  */
 bool ParametersMatches(Parameters p1, Parameters p2);
 
+/**
+ * @brief   Searches name in the list.
+ *
+ * @param parameter   Parameter list.
+ * @param name        Name of the parameter.
+ * @returns True if the list contains parameter of the name. False if not.
+ */
 bool findParamName(Parameters parameter, const char * name);
 
+/**
+ * @brief   Interned signature of the list.
+ *
+ * This function returns the signature shared by all the lists
+ * with the same types of parameters.
+ * @param p       Parameter list.
+ * @returns Signature, or NULL, if allocation fails.
+ */
+const Signature * paramSignature(Parameters p);
+
+/**
+ * @brief   Destroys all interned signatures.
+ *
+ * Use in the end.
+ */
+void signatureTableFree();
+
 /** @} */
 /*-----------------------------------------------------------*/
 
@@ -0,0 +1,651 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "io.h"
+#include "loops.h"
+
+#define STARTING_CHUNK_LOOPS 16     //size of initialised arrays of the analysis
+
+/**
+ * @brief   Abstract value.
+ *
+ * Value on the data stack or in a temporary variable, computed by
+ * the instructions from start to end.
+ */
+typedef struct
+{
+  bool known;       /**< Computation of the value is known. */
+  bool inv;         /**< Value is loop invariant. */
+  bool computed;    /**< Value is computed (not only pushed). */
+  size_t start;     /**< First instruction of the computation, SIZE_MAX if none. */
+  size_t end;       /**< Last instruction of the computation. */
+} Value;
+
+/**
+ * @brief   Value of a temporary variable.
+ */
+typedef struct
+{
+  const char * name;    /**< Variable (atom). */
+  Value v;              /**< Value. */
+} TempValue;
+
+/**
+ * @brief   Invariant computation to hoist.
+ */
+typedef struct
+{
+  size_t start;         /**< First instruction. */
+  size_t end;           /**< Last instruction. */
+  const char * temp;    /**< Temporary with the value, NULL if the value is on the data stack. */
+  Operand var;          /**< Variable holding the hoisted value. */
+} Candidate;
+
+/**
+ * @brief   Analysis of a loop.
+ */
+typedef struct
+{
+  Value * stack;                  /**< Abstract data stack. */
+  size_t stack_count, stack_capacity;
+  TempValue * temps;              /**< Abstract temporaries. */
+  size_t temps_count, temps_capacity;
+  Candidate * cand;               /**< Computations to hoist. */
+  size_t cand_count, cand_capacity;
+  const char ** modified;         /**< Variables modified by the loop. */
+  size_t modified_count, modified_capacity;
+  bool ok;                        /**< No allocation failed. */
+} Analysis;
+
+/*----------- DATA ------------*/
+static unsigned long invariantCounter = 0;  /**< Number of hoisted computations (unique names). */
+static unsigned rotatedLoops = 0;           /**< Number of rotated loops. */
+/*-----------------------------*/
+
+/**
+ * @brief   Makes space for one more item in array.
+ *
+ * @param arr       Array.
+ * @param count     Number of items.
+ * @param capacity  Allocated items.
+ * @param size      Size of item.
+ * @returns True, if success. False otherwise.
+ */
+static bool Grow(void ** arr, size_t count, size_t * capacity, size_t size)
+{
+  if(count < *capacity) return true;
+  size_t newsize = (*capacity == 0) ? STARTING_CHUNK_LOOPS : 2 * *capacity;
+  void * p = realloc(*arr, newsize * size);
+  if(p == NULL) return false;
+  *arr = p;
+  *capacity = newsize;
+  return true;
+}
+
+/**
+ * @brief   Temporary variable.
+ *
+ * Scratch variables and variables generated for builtins and string
+ * expressions (names with '*'), their values do not live across statements.
+ * @param o       Operand.
+ * @returns True, if temporary. False otherwise.
+ */
+static bool IsTemp(const Operand * o)
+{
+  return o->type == Operand_Variable && o->d.var.frame == Frame_Local && strchr(o->d.var.name, '*') != NULL;
+}
+
+/** @brief Pure stack instruction, which cannot fail. */
+static bool IsPureStack(Opcode op) { return OpcodeIsPure(op) && OpcodeArity(op) == 0; }
+
+/** @brief Pure three-address instruction, which cannot fail. */
+static bool IsPure(Opcode op) { return OpcodeIsPure(op) && OpcodeArity(op) > 0; }
+
+/** @brief Instruction changes control flow or frames. */
+static bool IsBarrier(Opcode op)
+{
+  return op == Opcode_Label || op == Opcode_Jump || op == Opcode_JumpIfEq || op == Opcode_JumpIfNeq
+      || op == Opcode_JumpIfEqs || op == Opcode_JumpIfNeqs || op == Opcode_Call || op == Opcode_Return
+      || op == Opcode_CreateFrame || op == Opcode_PushFrame || op == Opcode_PopFrame
+      || op == Opcode_Clears || op == Opcode_Break;
+}
+
+/*------------------------------ ANALYSIS ------------------------------------*/
+
+/** @brief Variable is modified by the loop. */
+static bool IsModified(const Analysis * A, const char * name)
+{
+  for(size_t i = 0; i < A->modified_count; i++)
+    if(A->modified[i] == name) return true;
+  return false;
+}
+
+/** @brief Unknown value. */
+static Value Unknown()
+{
+  Value v = {.known = false, .inv = false, .computed = false, .start = SIZE_MAX, .end = 0};
+  return v;
+}
+
+/** @brief Finds value of temporary. */
+static TempValue * FindTemp(Analysis * A, const char * name)
+{
+  for(size_t i = 0; i < A->temps_count; i++)
+    if(A->temps[i].name == name) return &A->temps[i];
+  return NULL;
+}
+
+/** @brief Sets value of temporary. */
+static void SetTemp(Analysis * A, const char * name, Value v)
+{
+  TempValue * t = FindTemp(A, name);
+  if(t == NULL)
+  {
+    if(!Grow((void **)&A->temps, A->temps_count, &A->temps_capacity, sizeof(TempValue))) { A->ok = false; return; }
+    t = &A->temps[A->temps_count++];
+    t->name = name;
+  }
+  t->v = v;
+}
+
+/** @brief Pushes value onto abstract stack. */
+static void Push(Analysis * A, Value v)
+{
+  if(!Grow((void **)&A->stack, A->stack_count, &A->stack_capacity, sizeof(Value))) { A->ok = false; return; }
+  A->stack[A->stack_count++] = v;
+}
+
+/** @brief Pops value from abstract stack. */
+static Value Pop(Analysis * A)
+{
+  return (A->stack_count > 0) ? A->stack[--A->stack_count] : Unknown();
+}
+
+/**
+ * @brief   Value of an operand.
+ *
+ * @param A       Analysis.
+ * @param o       Operand.
+ * @returns Value, start is SIZE_MAX, if the operand is not computed.
+ */
+static Value OperandValue(Analysis * A, const Operand * o)
+{
+  Value v = {.known = true, .inv = true, .computed = false, .start = SIZE_MAX, .end = 0};
+  if(o->type != Operand_Variable) return v;
+  if(IsTemp(o))
+  {
+    TempValue * t = FindTemp(A, o->d.var.name);
+    return (t != NULL) ? t->v : Unknown();
+  }
+  if(o->d.var.frame != Frame_Local) return Unknown();
+  v.inv = !IsModified(A, o->d.var.name);
+  return v;
+}
+
+/**
+ * @brief   Value is used by non-invariant computation.
+ *
+ * Invariant computed value becomes a candidate for hoisting.
+ * @param A       Analysis.
+ * @param v       Value.
+ * @param temp    Temporary holding the value, NULL if on the data stack.
+ */
+static void Consume(Analysis * A, Value v, const char * temp)
+{
+  if(!v.known || !v.inv || !v.computed || v.start == SIZE_MAX) return;
+  if(!Grow((void **)&A->cand, A->cand_count, &A->cand_capacity, sizeof(Candidate))) { A->ok = false; return; }
+  Candidate c = {.start = v.start, .end = v.end, .temp = temp};
+  A->cand[A->cand_count++] = c;
+}
+
+/** @brief Temporaries read by the instruction are consumed. */
+static void ConsumeTemps(Analysis * A, const Instruction * ins, unsigned from)
+{
+  for(unsigned a = from; a < OpcodeArity(ins->op); a++)
+    if(IsTemp(&ins->arg[a]))
+      Consume(A, OperandValue(A, &ins->arg[a]), ins->arg[a].d.var.name);
+}
+
+/**
+ * @brief   Finds invariant computations of the loop.
+ *
+ * The body is interpreted over abstract values. A value is invariant,
+ * if it is computed by pure instructions from constants and variables
+ * not modified by the loop. Labels and jumps forget everything.
+ * @param u       Unit.
+ * @param top     Index of the label of the loop.
+ * @param back    Index of the jump back.
+ * @param A       Analysis.
+ */
+static void Analyze(const CodeUnit * u, size_t top, size_t back, Analysis * A)
+{
+  // modified variables
+  for(size_t i = top; i <= back; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    if(!OpcodeWrites(ins->op) || ins->arg[0].type != Operand_Variable || IsTemp(&ins->arg[0])) continue;
+    if(IsModified(A, ins->arg[0].d.var.name)) continue;
+    if(!Grow((void **)&A->modified, A->modified_count, &A->modified_capacity, sizeof(const char *))) { A->ok = false; return; }
+    A->modified[A->modified_count++] = ins->arg[0].d.var.name;
+  }
+
+  for(size_t i = top + 1; A->ok && i < back; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    Opcode op = ins->op;
+
+    if(op == Opcode_Comment) continue;
+
+    // stack
+    else if(op == Opcode_Pushs)
+    {
+      Value v = OperandValue(A, &ins->arg[0]);
+      if(v.start == SIZE_MAX) v.start = i;
+      v.end = i;
+      Push(A, v);
+    }
+    else if(op == Opcode_Pops)
+    {
+      Value v = Pop(A);
+      if(IsTemp(&ins->arg[0])) { v.end = i; SetTemp(A, ins->arg[0].d.var.name, v); }
+      else Consume(A, v, NULL);
+    }
+    else if(op == Opcode_Defvar)
+    {
+      if(IsTemp(&ins->arg[0])) SetTemp(A, ins->arg[0].d.var.name, Unknown());
+    }
+
+    // control flow
+    else if(IsBarrier(op))
+    {
+      for(unsigned k = 0; k < OpcodeStackPops(op); k++) Consume(A, Pop(A), NULL);
+      ConsumeTemps(A, ins, 0);
+      A->stack_count = 0;
+      A->temps_count = 0;
+    }
+
+    // stack computation
+    else if(OpcodeStackPops(op) > 0 || OpcodeStackPushes(op) > 0)
+    {
+      unsigned n = OpcodeStackPops(op);
+      Value ops[2] = {Unknown(), Unknown()};
+      for(unsigned k = n; k-- > 0; ) ops[k] = Pop(A);
+
+      bool inv = IsPureStack(op);
+      for(unsigned k = 0; k < n; k++) inv = inv && ops[k].known && ops[k].inv;
+
+      Value r = Unknown();
+      if(inv && n > 0)
+      {
+        r = ops[0];
+        r.computed = true;
+        r.end = i;
+      }
+      else for(unsigned k = 0; k < n; k++) Consume(A, ops[k], NULL);
+
+      if(OpcodeStackPushes(op) > 0) Push(A, r);
+    }
+
+    // three-address computation
+    else if(OpcodeWrites(op))
+    {
+      bool inv = IsPure(op);
+      bool computed = (op != Opcode_Move);
+      size_t start = i;
+      for(unsigned a = 1; a < OpcodeArity(op); a++)
+      {
+        Value v = OperandValue(A, &ins->arg[a]);
+        inv = inv && v.known && v.inv;
+        computed = computed || v.computed;
+        if(v.start < start) start = v.start;
+      }
+
+      if(IsTemp(&ins->arg[0]) && inv)
+      {
+        Value r = {.known = true, .inv = true, .computed = computed, .start = start, .end = i};
+        SetTemp(A, ins->arg[0].d.var.name, r);
+      }
+      else
+      {
+        ConsumeTemps(A, ins, 1);
+        if(IsTemp(&ins->arg[0])) SetTemp(A, ins->arg[0].d.var.name, Unknown());
+      }
+    }
+
+    // output
+    else ConsumeTemps(A, ins, 0);
+  }
+}
+
+/**
+ * @brief   Checks the computation.
+ *
+ * The computation must be straight-line code of pure instructions, which
+ * reads only invariant variables and temporaries written by itself, and
+ * which leaves exactly its value on the data stack (or in the temporary).
+ * @param u       Unit.
+ * @param c       Candidate.
+ * @param A       Analysis.
+ * @returns True, if the computation can be hoisted. False otherwise.
+ */
+static bool VerifyCandidate(const CodeUnit * u, const Candidate * c, const Analysis * A)
+{
+  long depth = 0;
+  const char * written[CODE_MAX_OPERANDS * 8];
+  size_t written_count = 0;
+  bool result = false;
+
+  for(size_t i = c->start; i <= c->end; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    Opcode op = ins->op;
+    if(op == Opcode_Comment) continue;
+
+    if(op != Opcode_Pushs && op != Opcode_Pops && op != Opcode_Defvar && !IsPureStack(op) && !IsPure(op))
+      return false;
+
+    // read operands
+    for(unsigned a = OpcodeWrites(op) ? 1 : 0; a < OpcodeArity(op); a++)
+    {
+      const Operand * o = &ins->arg[a];
+      if(o->type != Operand_Variable) continue;
+      if(IsTemp(o))
+      {
+        bool found = false;
+        for(size_t w = 0; w < written_count; w++) found = found || (written[w] == o->d.var.name);
+        if(!found) return false;
+      }
+      else if(o->d.var.frame != Frame_Local || IsModified(A, o->d.var.name)) return false;
+    }
+
+    // written operand
+    if(OpcodeWrites(op))
+    {
+      if(!IsTemp(&ins->arg[0])) return false;
+      if(op != Opcode_Defvar)
+      {
+        if(written_count == sizeof(written) / sizeof(written[0])) return false;
+        written[written_count++] = ins->arg[0].d.var.name;
+        if(c->temp != NULL && ins->arg[0].d.var.name == c->temp) result = true;
+      }
+    }
+
+    depth -= OpcodeStackPops(op);
+    if(depth < 0) return false;
+    depth += OpcodeStackPushes(op);
+  }
+
+  return (c->temp == NULL) ? (depth == 1) : (depth == 0 && result);
+}
+
+/** @brief Compares candidates by start. */
+static int CompareCandidates(const void * a, const void * b)
+{
+  const Candidate * x = a, * y = b;
+  return (x->start < y->start) ? -1 : (x->start > y->start);
+}
+
+/*---------------------------- TRANSFORMATIONS -------------------------------*/
+
+/**
+ * @brief   Replaces code of the unit.
+ */
+static void ReplaceCode(CodeUnit * u, CodeUnit * result)
+{
+  free(u->code);
+  u->code = result->code;
+  u->count = result->count;
+  u->capacity = result->capacity;
+}
+
+/**
+ * @brief   Hoists invariant computations of the loop.
+ *
+ * Computation of value on the data stack is replaced by PUSHS of new
+ * variable, computation of value in a temporary by MOVE from new
+ * variable. The variables are computed in the preheader.
+ * @param u       Unit.
+ * @param top     Index of the label of the loop.
+ * @param back    Index of the jump back.
+ * @param moved   Returned number of instructions inserted before the loop.
+ * @returns True, if success. False otherwise.
+ */
+static bool HoistInvariants(CodeUnit * u, size_t top, size_t back, size_t * moved)
+{
+  *moved = 0;
+  Analysis A = {.ok = true};
+  Analyze(u, top, back, &A);
+
+  // non-overlapping verified candidates
+  size_t count = 0;
+  if(A.ok && A.cand_count > 0)
+  {
+    qsort(A.cand, A.cand_count, sizeof(Candidate), CompareCandidates);
+    for(size_t c = 0; c < A.cand_count; c++)
+    {
+      if(count > 0 && A.cand[c].start <= A.cand[count-1].end) continue;
+      if(!VerifyCandidate(u, &A.cand[c], &A)) continue;
+      A.cand[count++] = A.cand[c];
+    }
+  }
+
+  bool ok = A.ok;
+  if(ok && count > 0)
+  {
+    #ifdef OPTIMIZER_DEBUG
+      debug("Hoist %zu invariants of loop %s.", count, u->code[top].arg[0].d.label);
+    #endif
+
+    CodeUnit result = {0};
+    for(size_t i = 0; ok && i < top; i++) ok = CodeAppend(&result, &u->code[i]);
+
+    // preheader
+    for(size_t c = 0; ok && c < count; c++)
+    {
+      char name[32];
+      sprintf(name, "%%l%lu", ++invariantCounter);
+      Candidate * cand = &A.cand[c];
+      cand->var = OperandVariable(Frame_Local, name);
+      if(cand->var.type == Operand_None) { ok = false; break; }
+
+      Instruction def = {.op = Opcode_Defvar, .arg = {cand->var}};
+      ok = CodeAppend(&result, &def);
+      for(size_t i = cand->start; ok && i <= cand->end; i++) ok = CodeAppend(&result, &u->code[i]);
+
+      Instruction save = {.op = Opcode_Pops, .arg = {cand->var}};
+      if(cand->temp != NULL)
+      {
+        save.op = Opcode_Move;
+        save.arg[1] = OperandVariableText(cand->temp);
+      }
+      ok = ok && CodeAppend(&result, &save);
+    }
+    *moved = result.count - top;
+
+    // loop and the rest
+    size_t c = 0;
+    for(size_t i = top; ok && i < u->count; i++)
+    {
+      if(c < count && i == A.cand[c].start)
+      {
+        Instruction load = {.op = Opcode_Pushs, .arg = {A.cand[c].var}};
+        if(A.cand[c].temp != NULL)
+        {
+          load.op = Opcode_Move;
+          load.arg[0] = OperandVariableText(A.cand[c].temp);
+          load.arg[1] = A.cand[c].var;
+        }
+        ok = CodeAppend(&result, &load);
+        i = A.cand[c].end;
+        c++;
+        continue;
+      }
+      ok = CodeAppend(&result, &u->code[i]);
+    }
+
+    if(ok) ReplaceCode(u, &result);
+    else free(result.code);
+  }
+
+  free(A.stack);
+  free(A.temps);
+  free(A.cand);
+  free(A.modified);
+  return ok;
+}
+
+/**
+ * @brief   Rotates the loop.
+ *
+ * LABEL top; C; JUMPIF exit; B; JUMP top; LABEL exit
+ * becomes
+ * C; JUMPIF exit; LABEL top; B; C; JUMPIFNOT top; LABEL exit.
+ * Condition C must be straight-line code.
+ * @param u       Unit.
+ * @param top     Index of the label of the loop.
+ * @param back    Index of the jump back.
+ * @returns True, if success. False otherwise.
+ */
+static bool RotateLoop(CodeUnit * u, size_t top, size_t back)
+{
+  if(back + 1 >= u->count || u->code[back+1].op != Opcode_Label) return true;
+  const char * exit = u->code[back+1].arg[0].d.label;
+
+  // condition
+  size_t c = top + 1;
+  while(c < back && !IsBarrier(u->code[c].op)) c++;
+  if(c == back) return true;
+  Opcode op = u->code[c].op;
+  if(OpcodeInvertJump(op) == op || u->code[c].arg[0].d.label != exit) return true;
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Rotate loop %s.", u->code[top].arg[0].d.label);
+  #endif
+
+  CodeUnit result = {0};
+  bool ok = true;
+  for(size_t i = 0; ok && i < top; i++) ok = CodeAppend(&result, &u->code[i]);
+  for(size_t i = top + 1; ok && i <= c; i++) ok = CodeAppend(&result, &u->code[i]);   // guard
+  ok = ok && CodeAppend(&result, &u->code[top]);
+  for(size_t i = c + 1; ok && i < back; i++) ok = CodeAppend(&result, &u->code[i]);   // body
+  for(size_t i = top + 1; ok && i < c; i++) ok = CodeAppend(&result, &u->code[i]);    // bottom test
+  Instruction test = u->code[c];
+  test.op = OpcodeInvertJump(op);
+  test.arg[0] = u->code[top].arg[0];
+  ok = ok && CodeAppend(&result, &test);
+  for(size_t i = back + 1; ok && i < u->count; i++) ok = CodeAppend(&result, &u->code[i]);
+
+  if(!ok)
+  {
+    free(result.code);
+    return false;
+  }
+  ReplaceCode(u, &result);
+  rotatedLoops++;
+  return true;
+}
+
+/*-------------------------------- LOOPS -------------------------------------*/
+
+/**
+ * @brief   Reference of a label.
+ */
+typedef struct
+{
+  const char * label;     /**< Label (atom). */
+  size_t at;              /**< Index of the jump. */
+} Reference;
+
+/** @brief Compares references by labels. */
+static int CompareReferences(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)((const Reference *)a)->label, y = (uintptr_t)((const Reference *)b)->label;
+  return (x < y) ? -1 : (x > y);
+}
+
+/**
+ * @brief   Jump back to the label.
+ *
+ * @param u       Unit.
+ * @param top     Index of the label.
+ * @returns Index of following JUMP to the label, or u->count, if not found.
+ */
+static size_t BackJump(const CodeUnit * u, size_t top)
+{
+  const char * l = u->code[top].arg[0].d.label;
+  size_t back = top + 1;
+  while(back < u->count && !(u->code[back].op == Opcode_Jump && u->code[back].arg[0].d.label == l)) back++;
+  return back;
+}
+
+/**
+ * @brief   Optimizes loops of the unit.
+ *
+ * Loop is a label referenced only by one following JUMP.
+ * @param u       Unit.
+ * @returns True, if success. False otherwise.
+ */
+static bool OptimizeUnit(CodeUnit * u)
+{
+  // references of labels
+  Reference * refs = malloc((u->count + 1) * sizeof(Reference));
+  if(refs == NULL) return false;
+  size_t refs_count = 0;
+  for(size_t i = 0; i < u->count; i++)
+    if(OpcodeIsJump(u->code[i].op)) refs[refs_count++] = (Reference){u->code[i].arg[0].d.label, i};
+  qsort(refs, refs_count, sizeof(Reference), CompareReferences);
+
+  // headers of loops, labels referenced only by one following JUMP
+  size_t * tops = malloc((u->count + 1) * sizeof(size_t));
+  if(tops == NULL) { free(refs); return false; }
+  size_t tops_count = 0;
+  for(size_t i = 0; i < u->count; i++)
+  {
+    if(u->code[i].op != Opcode_Label) continue;
+    Reference key = {u->code[i].arg[0].d.label, 0};
+    const Reference * r = bsearch(&key, refs, refs_count, sizeof(Reference), CompareReferences);
+    if(r == NULL) continue;
+    if((r > refs && r[-1].label == key.label) || (r + 1 < refs + refs_count && r[1].label == key.label)) continue;
+    if(r->at < i || u->code[r->at].op != Opcode_Jump) continue;
+    tops[tops_count++] = i;
+  }
+  free(refs);
+
+  // innermost first, code before the loop is not changed
+  bool ok = true;
+  for(size_t t = tops_count; ok && t-- > 0; )
+  {
+    size_t top = tops[t];
+    size_t back = BackJump(u, top);
+    if(back == u->count) continue;    // not a loop
+
+    size_t moved;
+    ok = HoistInvariants(u, top, back, &moved);
+    top += moved;
+    ok = ok && RotateLoop(u, top, BackJump(u, top));
+  }
+
+  free(tops);
+  return ok;
+}
+
+bool OptimizeLoops()
+{
+  unsigned long hoisted = invariantCounter;
+  unsigned rotated = rotatedLoops;
+
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+    if(!OptimizeUnit(CodeGetUnit(i))) return false;
+
+  if(report())
+  {
+    fprintf(stderr, "Hoisted loop invariants: %lu\n", invariantCounter - hoisted);
+    fprintf(stderr, "Rotated loops: %u\n", rotatedLoops - rotated);
+  }
+  return true;
+}
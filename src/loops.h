@@ -0,0 +1,28 @@
+/**
+ * @file loops.h
+ * @interface loops
+ * @date 18th october 2026
+ * @brief Loop optimization interface.
+ *
+ * This interface declares optimizations of Do While loops:
+ * loop-invariant code motion and loop rotation.
+ */
+
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Optimizes loops.
+ *
+ * Loops are processed from the innermost ones. Pure computations,
+ * which read only variables not modified by the loop, are hoisted
+ * into a preheader in front of the loop. Then the loop is rotated
+ * into a guarded bottom-test form, so each iteration runs one
+ * conditional jump instead of a conditional and an unconditional one.
+ * @returns True, if success. False otherwise.
+ */
+bool OptimizeLoops();
+
+#endif // LOOPS_H
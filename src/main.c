@@ -8,6 +8,7 @@
  * This module contains the function main().
  */
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -17,6 +18,7 @@
 #include "err.h"
 #include "generator.h"
 #include "io.h"
+#include "optimizer.h"
 #include "parser.h"
 #include "types.h"
 #include "symtable.h"
@@ -116,6 +118,129 @@ bool processArguments(int argc, char *argv[])
 			break;
 		}
 
+		// report
+		else if( !strcmp(argv[i], "-r") || !strcmp(argv[i], "--report") )
+		{
+			setReport();
+			#ifdef ARGS_DEBUG
+				debug("Argument -r");
+			#endif
+		}
+
+		// inline limit
+		else if( !strncmp(argv[i], "--inline-limit=", 15) )
+		{
+			char * end;
+			unsigned long limit = strtoul(argv[i] + 15, &end, 10);
+			if(argv[i][15] == '\0' || *end != '\0' || limit > UINT_MAX)
+			{
+				err("Invalid inline limit!");
+				return false;
+			}
+			setInlineLimit((unsigned)limit);
+			#ifdef ARGS_DEBUG
+				debug("Argument --inline-limit=%lu", limit);
+			#endif
+		}
+
+		// optimization level
+		else if( !strncmp(argv[i], "-O", 2) )
+		{
+			if(argv[i][2] < '0' || argv[i][2] > '2' || argv[i][3] != '\0')
+			{
+				err("Invalid optimization level!");
+				return false;
+			}
+			setOptLevel((unsigned)(argv[i][2] - '0'));
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+
+		// disabled optimization pass
+		else if( !strncmp(argv[i], "-fno-", 5) )
+		{
+			if(!OptimizerPassExists(argv[i] + 5))
+			{
+				err("Unknown optimization pass!");
+				return false;
+			}
+			if(!disablePass(argv[i] + 5))
+			{
+				err("Too many disabled passes!");
+				return false;
+			}
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+
+		// pass report
+		else if( !strcmp(argv[i], "--pass-report") )
+		{
+			setPassReport();
+			#ifdef ARGS_DEBUG
+				debug("Argument --pass-report");
+			#endif
+		}
+
+		// code statistics
+		else if( !strcmp(argv[i], "--code-stats") || !strcmp(argv[i], "--code-stats=text") )
+		{
+			setCodeStats(CodeStats_Text);
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+		else if( !strcmp(argv[i], "--code-stats=json") )
+		{
+			setCodeStats(CodeStats_Json);
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+
+		// minified code
+		else if( !strcmp(argv[i], "--minify") )
+		{
+			setMinify();
+			#ifdef ARGS_DEBUG
+				debug("Argument --minify");
+			#endif
+		}
+
+		// format of the code
+		else if( !strcmp(argv[i], "--emit=text") || !strcmp(argv[i], "--emit=binary") )
+		{
+			setEmitFormat(strcmp(argv[i], "--emit=binary") ? Emit_Text : Emit_Binary);
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+
+		// target language
+		else if( !strcmp(argv[i], "--target=ifjcode") || !strcmp(argv[i], "--target=c") )
+		{
+			setTargetLanguage(strcmp(argv[i], "--target=c") ? Target_Ifjcode : Target_C);
+			#ifdef ARGS_DEBUG
+				debug("Argument %s", argv[i]);
+			#endif
+		}
+
+		// dump of control flow graph
+		else if( !strncmp(argv[i], "--dump-cfg=", 11) )
+		{
+			if(argv[i][11] == '\0')
+			{
+				err("Invalid file of control flow graph!");
+				return false;
+			}
+			setDumpCfg(argv[i] + 11);
+			#ifdef ARGS_DEBUG
+				debug("Argument --dump-cfg=%s", argv[i] + 11);
+			#endif
+		}
+
 		// unknown
 		else
 		{
@@ -136,6 +261,16 @@ void printHelp()
 	out("IFJ project.\n"
 					"2017/2018\n\n"
 					"Usage:\n"
-					"-h\tPrints this help."
+					"-h\tPrints this help.\n"
+					"-r\tPrints report of optimizations to stderr.\n"
+					"-O0, -O1, -O2\tOptimization level (defaultly -O2).\n"
+					"-fno-PASS\tDisables optimization pass (tailcall, pure, inline, conditions, loops, jumps, cse).\n"
+					"--pass-report\tPrints time and code size of each optimization pass to stderr.\n"
+					"--code-stats[=text|json]\tPrints statistics of the generated code to stderr.\n"
+					"--minify\tPrints the code with the shortest names and without comments.\n"
+					"--emit=text|binary\tFormat of the printed code (defaultly text).\n"
+					"--target=ifjcode|c\tLanguage of the printed code (defaultly ifjcode), C is compiled by cc -lm.\n"
+					"--inline-limit=N\tInlines functions up to N instructions (0 disables).\n"
+					"--dump-cfg=FILE\tWrites control flow graph of the code to FILE (Graphviz)."
 	);
 }
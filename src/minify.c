@@ -0,0 +1,299 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "io.h"
+#include "minify.h"
+#include "tables.h"
+
+/** @brief Characters starting a new name. */
+static const char firstChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+/** @brief Characters following the first one. */
+static const char restChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+/** @brief Temporary frame, whose owner is not known yet. */
+#define PENDING ((size_t)-1)
+/** @brief No temporary frame. */
+#define NO_FRAME ((size_t)-2)
+
+/**
+ * @brief   Renamed name.
+ */
+typedef struct
+{
+  const char * atom;      /**< Original name (atom without frame). */
+  size_t count;           /**< Number of uses. */
+  const char * renamed;   /**< New name (atom without frame). */
+} Name;
+
+/**
+ * @brief   Namespace of names.
+ */
+typedef struct
+{
+  const char ** uses;     /**< Collected uses (atoms). */
+  size_t uses_count, uses_capacity;
+  Name * names;           /**< Names sorted by address of their atoms. */
+  size_t count;
+} Space;
+
+/**
+ * @brief   State of the minification.
+ *
+ * Space 0 holds labels, unit i has its variables in space 1 + 2i
+ * and its own temporary frames in space 2 + 2i.
+ */
+typedef struct
+{
+  Space * spaces;
+  size_t spaces_count;
+  struct UnitIndex {
+    const CodeUnit * unit;
+    size_t index;
+  } * units;                  /**< Units sorted by address. */
+  Operand ** pending;         /**< Temporary operands before their CALL. */
+  size_t pending_count, pending_capacity;
+  bool rewrite;               /**< Operands are renamed, uses are collected otherwise. */
+  bool ok;                    /**< No allocation failed. */
+} Minify;
+
+/*------------------------------ NAMES ------------------------------------*/
+
+/** @brief Compares atoms by addresses. */
+static int CompareAtoms(const void * a, const void * b)
+{
+  uintptr_t x = (uintptr_t)*(const char * const *)a;
+  uintptr_t y = (uintptr_t)*(const char * const *)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Orders names by descending number of uses. */
+static int CompareCounts(const void * a, const void * b)
+{
+  const Name * x = a;
+  const Name * y = b;
+  if(x->count != y->count) return (x->count < y->count) - (x->count > y->count);
+  return strcmp(x->atom, y->atom);
+}
+
+/**
+ * @brief   K-th shortest name.
+ *
+ * @param k       Index of the name.
+ * @param buff    Returned name.
+ */
+static void ShortName(size_t k, char * buff)
+{
+  size_t len = 0;
+  buff[len++] = firstChars[k % (sizeof(firstChars) - 1)];
+  k /= sizeof(firstChars) - 1;
+  while(k > 0)
+  {
+    k--;
+    buff[len++] = restChars[k % (sizeof(restChars) - 1)];
+    k /= sizeof(restChars) - 1;
+  }
+  buff[len] = '\0';
+}
+
+/**
+ * @brief   Gives new names to the collected uses of the space.
+ *
+ * @returns True, if success. False otherwise.
+ */
+static bool NameSpace(Space * s)
+{
+  if(s->uses_count == 0) return true;
+  qsort((void *)s->uses, s->uses_count, sizeof(const char *), CompareAtoms);
+
+  s->names = malloc(s->uses_count * sizeof(Name));
+  if(s->names == NULL) return false;
+  for(size_t i = 0; i < s->uses_count; i++)
+  {
+    if(s->count > 0 && s->names[s->count-1].atom == s->uses[i]) s->names[s->count-1].count++;
+    else s->names[s->count++] = (Name){s->uses[i], 1, NULL};
+  }
+
+  // the most frequent names are the shortest
+  qsort(s->names, s->count, sizeof(Name), CompareCounts);
+  char buff[32];
+  for(size_t k = 0; k < s->count; k++)
+  {
+    ShortName(k, buff);
+    s->names[k].renamed = atomInsert(buff);
+    if(s->names[k].renamed == NULL) return false;
+  }
+  qsort(s->names, s->count, sizeof(Name), CompareAtoms);
+  return true;
+}
+
+/*------------------------------ OPERANDS ------------------------------------*/
+
+/** @brief Space of the unit called by the label (its variables), or the fallback. */
+static size_t CalleeSpace(Minify * M, const char * label, size_t fallback)
+{
+  const CodeUnit * callee = CodeFindUnit(label);
+  struct UnitIndex key = {callee, 0};
+  struct UnitIndex * found = (callee != NULL)
+    ? bsearch(&key, M->units, CodeUnitCount(), sizeof(struct UnitIndex), CompareAtoms) : NULL;
+  return (found != NULL) ? 1 + 2 * found->index : fallback;
+}
+
+/**
+ * @brief   Collects or renames the name of the operand.
+ *
+ * @param space   Space of the name.
+ * @param o       Label or variable.
+ */
+static void Visit(Minify * M, size_t space, Operand * o)
+{
+  Space * s = &M->spaces[space];
+  const char * atom = (o->type == Operand_Label) ? o->d.label : atomInsert(o->d.var.name + 3);
+  if(atom == NULL)
+  {
+    M->ok = false;
+    return;
+  }
+
+  if(!M->rewrite)
+  {
+    if(s->uses_count == s->uses_capacity)
+    {
+      size_t capacity = (s->uses_capacity == 0) ? 16 : 2 * s->uses_capacity;
+      const char ** grown = realloc((void *)s->uses, capacity * sizeof(const char *));
+      if(grown == NULL)
+      {
+        M->ok = false;
+        return;
+      }
+      s->uses = grown;
+      s->uses_capacity = capacity;
+    }
+    s->uses[s->uses_count++] = atom;
+    return;
+  }
+
+  Name key = {atom, 0, NULL};
+  const Name * name = bsearch(&key, s->names, s->count, sizeof(Name), CompareAtoms);
+  if(name == NULL) return;
+  if(o->type == Operand_Label) o->d.label = name->renamed;
+  else
+  {
+    Operand renamed = OperandVariable(o->d.var.frame, name->renamed);
+    if(renamed.type == Operand_None) M->ok = false;
+    else *o = renamed;
+  }
+}
+
+/** @brief Visits the temporary operands waiting for their frame. */
+static void Flush(Minify * M, size_t space)
+{
+  for(size_t i = 0; i < M->pending_count; i++) Visit(M, space, M->pending[i]);
+  M->pending_count = 0;
+}
+
+/** @brief Defers the temporary operand until its frame is known. */
+static void Defer(Minify * M, Operand * o)
+{
+  if(M->pending_count == M->pending_capacity)
+  {
+    size_t capacity = (M->pending_capacity == 0) ? 16 : 2 * M->pending_capacity;
+    Operand ** grown = realloc(M->pending, capacity * sizeof(Operand *));
+    if(grown == NULL)
+    {
+      M->ok = false;
+      return;
+    }
+    M->pending = grown;
+    M->pending_capacity = capacity;
+  }
+  M->pending[M->pending_count++] = o;
+}
+
+/**
+ * @brief   Visits names of the unit.
+ *
+ * The temporary frame created before a call belongs to the called function,
+ * so does the frame popped after it.
+ * @param u       Unit.
+ * @param index   Index of the unit.
+ */
+static void VisitUnit(Minify * M, CodeUnit * u, size_t index)
+{
+  size_t locals = 1 + 2 * index, temporaries = 2 + 2 * index;
+  size_t frame = NO_FRAME;
+
+  for(size_t i = 0; M->ok && i < u->count; i++)
+  {
+    Instruction * ins = &u->code[i];
+    if(ins->op == Opcode_Comment) continue;
+
+    if(ins->op == Opcode_CreateFrame || ins->op == Opcode_PushFrame)
+    {
+      Flush(M, temporaries);
+      frame = (ins->op == Opcode_CreateFrame) ? PENDING : NO_FRAME;
+    }
+    else if(ins->op == Opcode_Call)
+    {
+      frame = CalleeSpace(M, ins->arg[0].d.label, temporaries);
+      Flush(M, frame);
+    }
+
+    for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+    {
+      Operand * o = &ins->arg[a];
+      if(o->type == Operand_Label) Visit(M, 0, o);
+      else if(o->type != Operand_Variable) continue;
+      else if(o->d.var.frame == Frame_Local) Visit(M, locals, o);
+      else if(o->d.var.frame != Frame_Temporary) continue;
+      else if(frame == PENDING) Defer(M, o);
+      else Visit(M, (frame == NO_FRAME) ? temporaries : frame, o);
+    }
+  }
+  Flush(M, temporaries);
+}
+
+/** @brief Visits names of all the units. */
+static void VisitCode(Minify * M)
+{
+  for(size_t i = 0; M->ok && i < CodeUnitCount(); i++) VisitUnit(M, CodeGetUnit(i), i);
+}
+
+/*------------------------------ MAIN ------------------------------------*/
+
+bool MinifyNames()
+{
+  size_t n = CodeUnitCount();
+  Minify M = {.ok = true};
+  M.spaces_count = 1 + 2 * n;
+  M.spaces = calloc(M.spaces_count, sizeof(Space));
+  M.units = malloc((n + 1) * sizeof(struct UnitIndex));
+  if(M.spaces == NULL || M.units == NULL) M.ok = false;
+  else
+  {
+    for(size_t i = 0; i < n; i++) M.units[i] = (struct UnitIndex){CodeGetUnit(i), i};
+    qsort(M.units, n, sizeof(struct UnitIndex), CompareAtoms);
+
+    VisitCode(&M);
+    for(size_t s = 0; M.ok && s < M.spaces_count; s++) M.ok = NameSpace(&M.spaces[s]);
+    M.rewrite = true;
+    if(M.ok) VisitCode(&M);
+  }
+
+  #ifdef OPTIMIZER_DEBUG
+    if(M.ok) debug("Renamed %zu labels.", M.spaces[0].count);
+  #endif
+  for(size_t s = 0; M.spaces != NULL && s < M.spaces_count; s++)
+  {
+    free((void *)M.spaces[s].uses);
+    free(M.spaces[s].names);
+  }
+  free(M.spaces);
+  free(M.units);
+  free(M.pending);
+  return M.ok;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file minify.h
+ * @interface minify
+ * @date 19th october 2026
+ * @brief Name minification interface.
+ *
+ * This interface declares renaming of variables and labels
+ * of the generated code to the shortest names.
+ */
+
+#ifndef MINIFY_H
+#define MINIFY_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Renames variables and labels to the shortest names.
+ *
+ * Labels are renamed over the whole program, variables per function.
+ * Parameters, which a caller defines in the temporary frame, are renamed
+ * as variables of the called function, other temporary frames
+ * as variables of their own. The most frequent names get the shortest
+ * new names. No pass may run afterwards, as the names of units
+ * no longer match their labels.
+ * @returns True, if success. False otherwise.
+ */
+bool MinifyNames();
+
+#endif // MINIFY_H
@@ -0,0 +1,82 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "code.h"
+#include "conditions.h"
+#include "config.h"
+#include "cse.h"
+#include "inliner.h"
+#include "io.h"
+#include "jumps.h"
+#include "loops.h"
+#include "optimizer.h"
+#include "pure.h"
+#include "tailcall.h"
+
+/**
+ * @brief   Optimization pass.
+ */
+typedef struct
+{
+  const char * name;      /**< Name of the pass (-fno-<name>). */
+  unsigned level;         /**< Lowest optimization level running the pass. */
+  bool (*run)();          /**< Pass over all the units. */
+} Pass;
+
+/** @brief Inlining with the configured limit. */
+static bool InlinePass() { return InlineFunctions(inlineLimit()); }
+
+/*----------- DATA ------------*/
+/** @brief Passes in the order of running. */
+static const Pass passes[] = {
+  {"tailcall", 1, EliminateTailCalls},
+  {"pure", 2, EvaluatePureCalls},
+  {"inline", 2, InlinePass},
+  {"conditions", 1, EliminateConstantConditions},
+  {"loops", 2, OptimizeLoops},
+  {"jumps", 1, OptimizeJumps},
+  {"cse", 1, EliminateCommonSubexpressions},
+};
+#define PASS_COUNT (sizeof(passes) / sizeof(passes[0]))
+
+/** @brief Number of instructions of all the units. */
+static size_t CodeSize()
+{
+  size_t size = 0;
+  for(size_t i = 0; i < CodeUnitCount(); i++) size += CodeGetUnit(i)->count;
+  return size;
+}
+
+bool OptimizerPassExists(const char * name)
+{
+  for(size_t p = 0; p < PASS_COUNT; p++)
+    if(!strcmp(passes[p].name, name)) return true;
+  return false;
+}
+
+bool OptimizeCode()
+{
+  #ifdef OPTIMIZER_DEBUG
+    debug("Optimize code.");
+  #endif
+
+  for(size_t p = 0; p < PASS_COUNT; p++)
+  {
+    if(passes[p].level > optLevel() || passDisabled(passes[p].name)) continue;
+    #ifdef OPTIMIZER_DEBUG
+      debug("Pass %s.", passes[p].name);
+    #endif
+
+    size_t before = CodeSize();
+    clock_t start = clock();
+    if(!passes[p].run()) return false;
+    double ms = 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if(passReport())
+      fprintf(stderr, "Pass %-10s %9.3f ms %8zu -> %zu instructions\n", passes[p].name, ms, before, CodeSize());
+  }
+
+  return true;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file optimizer.h
+ * @interface optimizer
+ * @date 18th october 2026
+ * @brief Optimizer interface.
+ *
+ * This interface declares optimization of the buffered code,
+ * which runs before the code is printed.
+ */
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Optimizes the code.
+ *
+ * This function runs the optimization passes enabled by the optimization
+ * level (-O1 runs tailcall, conditions, jumps and cse, -O2 all of them)
+ * and not disabled by -fno-<pass>, in a fixed order over all the units
+ * of code.
+ * @returns True, if success. False otherwise.
+ */
+bool OptimizeCode();
+
+/**
+ * @brief   Optimization pass of the name exists.
+ *
+ * Passes are named tailcall, pure, inline, conditions, loops, jumps and cse.
+ * @param name    Name of the pass.
+ * @returns True, if exists. False otherwise.
+ */
+bool OptimizerPassExists(const char * name);
+
+#endif // OPTIMIZER_H
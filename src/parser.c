@@ -15,6 +15,9 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "balance.h"
+#include "cfg.h"
+#include "code.h"
 #include "collector.h"
 #include "config.h"
 #include "err.h"
@@ -22,6 +25,8 @@
 #include "generator.h"
 #include "io.h"
 #include "list.h"
+#include "minify.h"
+#include "optimizer.h"
 #include "parser.h"
 #include "pedant.h"
 #include "queue.h"
@@ -30,6 +35,7 @@
 #include "symtable.h"
 #include "tables.h"
 #include "stack.h"
+#include "stats.h"
 
 #ifdef MULTITHREAD
 pthread_t sc;
@@ -59,7 +65,6 @@ bool setFunction(const char * f)
 }
 
 bool end = false; /**< Set to true, if keyword end reached. */
-bool wasReturn = true;
 bool wasScope = false;
 
 /*-------------------------- ERROR MACROS --------------------------------*/
@@ -218,9 +223,28 @@ void EndRoutine()
     if(notdefined != NULL) EndParser("not all declared functions defined", ErrorType_Semantic1);
   }
 
+  // finishing, optimization and output of the buffered code
+  if(getErrorType() == ErrorType_Ok && !GenerateParameterNames())
+    EndParser("error generating code", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok && !OptimizeCode())
+    EndParser("error optimizing code", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok && !VerifyStackBalance())
+    EndParser("error verifying code", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok && !GenerateDefinitions())
+    EndParser("error generating code", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok && minify() && targetLanguage() != Target_C && !MinifyNames())
+    EndParser("error minifying code", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok) PrintCode();
+  if(getErrorType() == ErrorType_Ok && codeStats() != CodeStats_None && !PrintCodeStats(codeStats() == CodeStats_Json))
+    EndParser("error writing code statistics", ErrorType_Internal);
+  if(getErrorType() == ErrorType_Ok && dumpCfg() != NULL && !CfgDumpCode(dumpCfg()))
+    EndParser("error dumping control flow graph", ErrorType_Internal);
+
   // clear memory
   constTableFree();
 	functionTableEnd();
+  signatureTableFree();
+  atomTableFree();
   if(Config_getFunction() != NULL) free(Config_getFunction());
   ClearScanner();
   ClearGenerator();
@@ -457,6 +481,7 @@ bool RunParser()
     }
 
     freeCollector();
+    ClearCode();
     constTableFree();
     functionTableEnd();
     return true;
@@ -910,8 +935,8 @@ bool EndFunctionParse()
 
   G_EndBlock();
 
-  // no return
-  if(!wasReturn)
+  // the end is reachable, default return
+  if(!G_Returned())
   {
 
     Phrasem def = allocPhrasem();
@@ -937,7 +962,6 @@ bool EndFunctionParse()
 
     if(!ReturnParse()) return false;
   }
-  wasReturn = true;
   end = false;
   return true;
 }
@@ -1202,7 +1226,6 @@ bool ReturnParse()
   CheckSeparator();
 
   G_EndBlock();
-  wasReturn = true;
   return true;
 }
 
@@ -1580,15 +1603,20 @@ bool FunctionCallParse()
   // was declared/defined
   if( !P_FunctionExists(funcname) ) RaiseError("calling unknown function", ErrorType_Semantic1);
 
+  // call graph
+  if( !AddCallEdge(Config_getFunction(), funcname->d.str) )
+    RaiseError("call graph allocation error", ErrorType_Internal);
+
   // (
   CheckOperator("(");
 
   // iterate over arguments
   extraCloseBracket = true;
   Parameters params = findFunctionParameters(funcname->d.str);
-  for(unsigned ord = 1; params != NULL; ord++)
+  size_t count = paramCount(params);
+  for(unsigned ord = 1; ord <= count; ord++)
   {
-    DataType dt = params->type;
+    DataType dt = params->types[ord-1];
     G_ArgumentAssignment(ord);
     if(!ExpressionParse()) return false;
 
@@ -1596,18 +1624,15 @@ bool FunctionCallParse()
     if(!P_CheckDataType(dt)) return false;
     GenerateArgument();
 
-    if(params->next != NULL)
+    if(ord < count)
     {
       // CheckOperator(",");
       Phrasem p = CheckQueue(p);
       if( isOperator(p, ")") ) RaiseError("bad arguments count", ErrorType_Semantic2);
       else if( !isOperator(p, ",") ) RaiseError("operator \',\' expected", ErrorType_Syntax);
     }
-    params = params->next;
   }
 
-  if(params != NULL) RaiseError("too many arguments", ErrorType_Semantic1);
-
   // )
   CheckOperator(")");
   extraCloseBracket = false;
@@ -1763,7 +1788,6 @@ bool FunctionDefinitionParse()
   #endif
 
   G_Function();
-  wasReturn = false;
   if(wasScope) RaiseError("definition after scope", ErrorType_Syntax);
 
   // function name
@@ -1790,7 +1814,7 @@ bool FunctionDefinitionParse()
     ReturnToQueue(arg);
 
     // parameters
-    for(unsigned i = 1; 1; i++)
+    while(1)
     {
       // variable
       Phrasem arg = CheckQueue(arg);
@@ -1809,9 +1833,6 @@ bool FunctionDefinitionParse()
       if(!paramAdd(&params, arg->d.str, dt))
         RaiseError("list allocation error", ErrorType_Internal);
 
-      G_VariableDeclaration();
-      if(!HandlePhrasem(arg)) return false;
-      AssignArgument(arg, i);
 
       // , or )
       Phrasem op = CheckQueue(op);
@@ -1856,8 +1877,11 @@ bool FunctionDefinitionParse()
   else if(state == FUNCTION_DECLARED)
   {
     // check params in declaration
-    if(!ParametersMatches(params, findFunctionParameters(funcname->d.str)))
+    if(!functionSignatureMatches(funcname->d.str, params))
+    {
+      if(getErrorType() == ErrorType_Internal) RaiseError("error comparing parameters", ErrorType_Internal);
       RaiseError("not matching parameters in declaration and definition", ErrorType_Semantic1);
+    }
     // check return value datatype
     if(dt != findFunctionType(funcname->d.str))
       RaiseError("not matching return datatype in declaration and definition", ErrorType_Semantic1);
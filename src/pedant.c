@@ -1,7 +1,9 @@
 
+#include "code.h"
 #include "collector.h"
 #include "config.h"
 #include "err.h"
+#include "fold.h"
 #include "functions.h"
 #include "generator.h"
 #include "io.h"
@@ -164,6 +166,30 @@ void printfstack(Stack a)
         pom = pom->next;
     }
 }
+/**
+ * @brief   Converts a constant operand at compile time.
+ * The constant is replaced by the constant of the target type
+ * from the table of constants, so no retype token is needed.
+ *
+ * @param item      stackitem of the operand.
+ * @param cast      TypeCast_Int2Double or TypeCast_Double2Int.
+ * @returns True if converted. False otherwise.
+ */
+static bool PromoteConstant(StackItem * item, TokenType cast)
+{
+    if(item == NULL || item->data->table != TokenType_Constant) return false;
+
+    Operand constant = OperandConstant(item->data->d.index);
+    Operand result;
+    Opcode op = (cast == TypeCast_Int2Double) ? Opcode_Int2Float : Opcode_Float2R2EInt;
+    if(!FoldOperation(op, &constant, NULL, &result) || result.type != Operand_Constant) return false;
+
+    #ifdef PEDANT_DEBUG
+        debug("Constant retyped at compile time");
+    #endif
+    item->data->d.index = result.d.index;
+    return true;
+}
 /**
  * @brief   Inserts a retype token into stack.
  *
@@ -175,6 +201,7 @@ bool RetypeToDouble(StackItem ** where)
     #ifdef PEDANT_DEBUG
         debug("Retyping phrasem to double");
     #endif
+    if(PromoteConstant(*where, TypeCast_Int2Double)) return true;
     Phrasem token = allocPhrasem();
     if(token == NULL)
     {
@@ -207,6 +234,7 @@ bool RetypeToInt(StackItem ** where)
     #ifdef PEDANT_DEBUG
         debug("Retyping phrasem to int");
     #endif
+    if(PromoteConstant(*where, TypeCast_Double2Int)) return true;
     Phrasem token = allocPhrasem();
     if(token == NULL)
     {
@@ -0,0 +1,194 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "evaluator.h"
+#include "fold.h"
+#include "io.h"
+#include "pure.h"
+
+/*----------- DATA ------------*/
+static unsigned pureFunctions = 0;    /**< Number of pure functions. */
+static unsigned evaluatedCalls = 0;   /**< Number of calls replaced by constants. */
+
+/**
+ * @brief   Instruction has no input, output or global variables.
+ */
+static bool IsPureInstruction(const Instruction * ins)
+{
+  if(ins->op == Opcode_Read || ins->op == Opcode_Write || ins->op == Opcode_Break || ins->op == Opcode_Dprint) return false;
+  for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+    if(ins->arg[a].type == Operand_Variable && ins->arg[a].d.var.frame == Frame_Global) return false;
+  return true;
+}
+
+/** @brief Index of the unit, or CodeUnitCount(). */
+static size_t UnitIndex(const CodeUnit * u)
+{
+  size_t i = 0;
+  while(i < CodeUnitCount() && CodeGetUnit(i) != u) i++;
+  return i;
+}
+
+/**
+ * @brief   Classifies functions.
+ *
+ * @param pure    Flags of the units to fill.
+ */
+static void Classify(bool * pure)
+{
+  size_t n = CodeUnitCount();
+  for(size_t i = 0; i < n; i++)
+  {
+    const CodeUnit * u = CodeGetUnit(i);
+    pure[i] = (u->name != NULL && strcmp(u->name, "scope") != 0);
+    for(size_t j = 0; pure[i] && j < u->count; j++) pure[i] = IsPureInstruction(&u->code[j]);
+  }
+
+  // callers of impure functions are impure
+  for(bool changed = true; changed;)
+  {
+    changed = false;
+    for(size_t i = 0; i < n; i++)
+    {
+      const CodeUnit * u = CodeGetUnit(i);
+      for(size_t c = 0; pure[i] && c < u->calls_count; c++)
+      {
+        size_t callee = UnitIndex(CodeFindUnit(u->calls[c]));
+        if(callee == n || !pure[callee])
+        {
+          pure[i] = false;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  for(size_t i = 0; i < n; i++)
+  {
+    if(!pure[i]) continue;
+    pureFunctions++;
+    #ifdef OPTIMIZER_DEBUG
+      debug("Function %s is pure.", CodeGetUnit(i)->name);
+    #endif
+  }
+}
+
+/**
+ * @brief   Operand of a constant argument.
+ *
+ * @returns True, if constant, temporary or scratch variable. False otherwise.
+ */
+static bool IsArgument(const Operand * o)
+{
+  if(o->type != Operand_Variable) return o->type != Operand_Label;
+  return o->d.var.frame == Frame_Temporary || (o->d.var.frame == Frame_Local && o->d.var.name[3] == '*');
+}
+
+/**
+ * @brief   Beginning of the call with constant arguments.
+ *
+ * Arguments are computed from constants only (in the scratch variables
+ * and on the data stack) and popped into the temporary frame.
+ * @param u       Unit.
+ * @param call    Index of CALL.
+ * @returns Index of its CREATEFRAME, or u->count.
+ */
+static size_t ConstantCall(const CodeUnit * u, size_t call)
+{
+  for(size_t i = call; i-- > 0;)
+  {
+    const Instruction * ins = &u->code[i];
+    if(ins->op == Opcode_CreateFrame) return i;
+
+    bool computation = OpcodeIsPure(ins->op) || (OpcodeArity(ins->op) == 0 && OpcodeStackPushes(ins->op) == 1)
+                       || ins->op == Opcode_Defvar || ins->op == Opcode_Pushs || ins->op == Opcode_Pops
+                       || ins->op == Opcode_Comment;
+    for(unsigned a = 0; computation && ins->op != Opcode_Comment && a < OpcodeArity(ins->op); a++)
+      computation = IsArgument(&ins->arg[a]);
+    if(!computation) break;
+  }
+  return u->count;
+}
+
+/**
+ * @brief   Evaluates calls of pure functions in the unit.
+ *
+ * @param u       Unit.
+ * @param pure    Flags of the units.
+ * @returns True, if success. False otherwise.
+ */
+static bool EvaluateUnit(CodeUnit * u, const bool * pure)
+{
+  CodeUnit result = {0};
+  size_t evaluated = 0;
+
+  for(size_t i = 0; i < u->count; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    if(ins->op == Opcode_Call && i + 1 < u->count && u->code[i+1].op == Opcode_PopFrame
+       && pure[UnitIndex(CodeFindUnit(ins->arg[0].d.label))])
+    {
+      size_t start = ConstantCall(u, i);
+      Operand value;
+      if(start < u->count && EvaluateCode(&u->code[start], i + 2 - start, &value))
+      {
+        #ifdef OPTIMIZER_DEBUG
+          debug("Call of %s evaluated.", ins->arg[0].d.label);
+        #endif
+        // the call with its arguments is replaced by the returned value
+        result.count -= i - start;
+        Instruction push = {.op = Opcode_Pushs, .arg = {value}};
+        if(!CodeAppend(&result, &push))
+        {
+          free(result.code);
+          return false;
+        }
+        evaluated++;
+        i++;
+        continue;
+      }
+    }
+    if(!CodeAppend(&result, ins))
+    {
+      free(result.code);
+      return false;
+    }
+  }
+
+  if(evaluated == 0)
+  {
+    free(result.code);
+    return true;
+  }
+  evaluatedCalls += evaluated;
+  free(u->code);
+  u->code = result.code;
+  u->count = result.count;
+  u->capacity = result.capacity;
+  return CodeRebuildCalls(u);
+}
+
+bool EvaluatePureCalls()
+{
+  unsigned functions = pureFunctions, calls = evaluatedCalls;
+
+  bool * pure = calloc(CodeUnitCount() + 1, sizeof(bool));
+  if(pure == NULL) return false;
+  Classify(pure);
+
+  bool ok = true;
+  for(size_t i = 0; ok && i < CodeUnitCount(); i++) ok = EvaluateUnit(CodeGetUnit(i), pure);
+  free(pure);
+  if(!ok) return false;
+
+  if(report())
+  {
+    fprintf(stderr, "Pure functions: %u\n", pureFunctions - functions);
+    fprintf(stderr, "Evaluated calls: %u\n", evaluatedCalls - calls);
+  }
+  return true;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file pure.h
+ * @interface pure
+ * @date 19th october 2026
+ * @brief Pure function interface.
+ *
+ * This interface declares evaluation of calls of pure functions
+ * at compile time.
+ */
+
+#ifndef PURE_H
+#define PURE_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Evaluates calls of pure functions with constant arguments.
+ *
+ * Function is pure, if it has no input, no output and it calls only
+ * pure functions. Its call with constant arguments is evaluated
+ * (see EvaluateCode()) and replaced by the returned constant. Calls,
+ * which fail to evaluate, are kept.
+ * @returns True, if success. False otherwise.
+ */
+bool EvaluatePureCalls();
+
+#endif // PURE_H
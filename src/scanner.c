@@ -292,6 +292,7 @@ bool getString() {
           DataUnion du;
           du.svalue = p;
           int x = constInsert(DataType_String, du);
+          free(p);                  // string is copied into the pool
 
           if ( x == -1) RaiseError("constant table allocation error", ErrorType_Internal);
 
@@ -444,6 +444,7 @@ Phrasem getString() {
           du.svalue = p;
 
           int x = constInsert(DataType_String, du);
+          free(p);                  // string is copied into the pool
           if ( x == -1) RaiseError("constant table allocation failed", ErrorType_Internal);
 
           ALLOC_PHRASEM(phr);
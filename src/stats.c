@@ -0,0 +1,180 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "io.h"
+#include "stats.h"
+
+/**
+ * @brief   Statistics of a unit.
+ */
+typedef struct
+{
+  const char * name;                /**< Name of the unit. */
+  size_t opcodes[Opcode_Count];     /**< Instructions by opcode. */
+  size_t instructions;              /**< Number of instructions. */
+  size_t stack_depth;               /**< Maximal depth of the data stack. */
+  unsigned long long cost;          /**< Static cost. */
+} UnitStats;
+
+unsigned OpcodeCost(Opcode op)
+{
+  switch(op)
+  {
+    case Opcode_Label: case Opcode_Comment: return 0;
+    case Opcode_Read: case Opcode_Write: return 8;
+    case Opcode_Call: case Opcode_Return: return 4;
+    case Opcode_CreateFrame: case Opcode_PushFrame: case Opcode_PopFrame: return 3;
+    case Opcode_Concat: case Opcode_Strlen: case Opcode_Getchar: case Opcode_Setchar:
+    case Opcode_Stri2Int: case Opcode_Stri2Ints: case Opcode_Int2Char: case Opcode_Int2Chars: return 3;
+    case Opcode_Defvar: case Opcode_Div: case Opcode_Divs: return 2;
+    default: return 1;
+  }
+}
+
+/** @brief Collects statistics of the unit. */
+static void Collect(const CodeUnit * u, UnitStats * s)
+{
+  memset(s, 0, sizeof(UnitStats));
+  s->name = (u->name != NULL) ? u->name : "$prologue";
+  s->stack_depth = u->stack_depth;
+  for(size_t i = 0; i < u->count; i++)
+  {
+    Opcode op = u->code[i].op;
+    if(op == Opcode_Comment) continue;
+    s->opcodes[op]++;
+    s->instructions++;
+    s->cost += OpcodeCost(op);
+  }
+}
+
+/** @brief Adds statistics of a unit to the totals. */
+static void AddTotals(UnitStats * total, const UnitStats * s)
+{
+  for(size_t op = 0; op < Opcode_Count; op++) total->opcodes[op] += s->opcodes[op];
+  total->instructions += s->instructions;
+  total->cost += s->cost;
+  if(s->stack_depth > total->stack_depth) total->stack_depth = s->stack_depth;
+}
+
+/** @brief Orders units by descending cost. */
+static int CompareCosts(const void * a, const void * b)
+{
+  const UnitStats * x = *(const UnitStats * const *)a;
+  const UnitStats * y = *(const UnitStats * const *)b;
+  if(x->cost != y->cost) return (x->cost < y->cost) - (x->cost > y->cost);
+  return strcmp(x->name, y->name);
+}
+
+/*------------------------------ TEXT ------------------------------------*/
+
+/** @brief Writes a row of the table. */
+static void TextRow(const UnitStats * s)
+{
+  fprintf(stderr, "%-24s %8zu %7zu %7zu %7zu %6zu %10llu\n", s->name, s->instructions,
+          s->opcodes[Opcode_Label], s->opcodes[Opcode_Defvar], s->opcodes[Opcode_CreateFrame],
+          s->stack_depth, s->cost);
+}
+
+/** @brief Writes instructions of the unit by opcode. */
+static void TextOpcodes(const UnitStats * s)
+{
+  fprintf(stderr, "  %s:", s->name);
+  for(size_t op = 0; op < Opcode_Count; op++)
+    if(s->opcodes[op] > 0) fprintf(stderr, " %s %zu", Opcode2Str(op), s->opcodes[op]);
+  fputc('\n', stderr);
+}
+
+/** @brief Writes the table of units, their opcodes and the most expensive functions. */
+static void PrintText(const UnitStats * units, size_t count, const UnitStats * total, UnitStats ** top, size_t top_count)
+{
+  fprintf(stderr, "%-24s %8s %7s %7s %7s %6s %10s\n", "Function", "Instrs", "Labels", "Defvars", "Frames", "Stack", "Cost");
+  for(size_t i = 0; i < count; i++) TextRow(&units[i]);
+  TextRow(total);
+
+  fprintf(stderr, "Opcodes:\n");
+  for(size_t i = 0; i < count; i++) TextOpcodes(&units[i]);
+  TextOpcodes(total);
+
+  fprintf(stderr, "Most expensive functions:\n");
+  for(size_t i = 0; i < top_count; i++) fprintf(stderr, "  %zu. %s %llu\n", i + 1, top[i]->name, top[i]->cost);
+}
+
+/*------------------------------ JSON ------------------------------------*/
+
+/** @brief Writes the unit as a JSON object. */
+static void JsonUnit(const UnitStats * s)
+{
+  fprintf(stderr, "{\"name\": \"%s\", \"instructions\": %zu, \"labels\": %zu, \"defvars\": %zu, "
+                  "\"frames\": %zu, \"stack_depth\": %zu, \"cost\": %llu, \"opcodes\": {",
+          s->name, s->instructions, s->opcodes[Opcode_Label], s->opcodes[Opcode_Defvar],
+          s->opcodes[Opcode_CreateFrame], s->stack_depth, s->cost);
+  bool first = true;
+  for(size_t op = 0; op < Opcode_Count; op++)
+  {
+    if(s->opcodes[op] == 0) continue;
+    fprintf(stderr, "%s\"%s\": %zu", first ? "" : ", ", Opcode2Str(op), s->opcodes[op]);
+    first = false;
+  }
+  fprintf(stderr, "}}");
+}
+
+/** @brief Writes the units, the totals and the most expensive functions as JSON. */
+static void PrintJson(const UnitStats * units, size_t count, const UnitStats * total, UnitStats ** top, size_t top_count)
+{
+  fprintf(stderr, "{\"functions\": [");
+  for(size_t i = 0; i < count; i++)
+  {
+    fprintf(stderr, "%s\n  ", (i > 0) ? "," : "");
+    JsonUnit(&units[i]);
+  }
+  fprintf(stderr, "],\n\"total\": ");
+  JsonUnit(total);
+  fprintf(stderr, ",\n\"top\": [");
+  for(size_t i = 0; i < top_count; i++) fprintf(stderr, "%s\"%s\"", (i > 0) ? ", " : "", top[i]->name);
+  fprintf(stderr, "]}\n");
+}
+
+/*------------------------------ MAIN ------------------------------------*/
+
+bool PrintCodeStats(bool json)
+{
+  size_t count = 0;
+  UnitStats * units = malloc((CodeUnitCount() + 1) * sizeof(UnitStats));
+  UnitStats ** order = malloc((CodeUnitCount() + 1) * sizeof(UnitStats *));
+  if(units == NULL || order == NULL)
+  {
+    free(units);
+    free(order);
+    return false;
+  }
+
+  UnitStats total;
+  memset(&total, 0, sizeof(UnitStats));
+  total.name = "$total";
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    const CodeUnit * u = CodeGetUnit(i);
+    if(!u->reachable) continue;
+    Collect(u, &units[count]);
+    AddTotals(&total, &units[count]);
+    order[count] = &units[count];
+    count++;
+  }
+
+  size_t top_count = 0;
+  qsort(order, count, sizeof(UnitStats *), CompareCosts);
+  for(size_t i = 0; i < count && top_count < CODE_STATS_TOP; i++)
+    if(order[i]->name[0] != '$') order[top_count++] = order[i];
+
+  if(json) PrintJson(units, count, &total, order, top_count);
+  else PrintText(units, count, &total, order, top_count);
+  fflush(stderr);
+
+  free(units);
+  free(order);
+  return true;
+}
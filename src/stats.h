@@ -0,0 +1,42 @@
+/**
+ * @file stats.h
+ * @interface stats
+ * @date 19th october 2026
+ * @brief Code statistics interface.
+ *
+ * This interface declares statistics of the generated code
+ * and its static cost.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+
+#include "code.h"
+
+/** @brief Number of the most expensive functions listed. */
+#define CODE_STATS_TOP 5
+
+/**
+ * @brief   Static cost of the instruction.
+ *
+ * Weights estimate the relative time of the instruction in the interpreter.
+ * @param op      Opcode.
+ * @returns Weight of the opcode.
+ */
+unsigned OpcodeCost(Opcode op);
+
+/**
+ * @brief   Writes statistics of the generated code.
+ *
+ * Per reachable unit, instructions are counted by opcode, together with
+ * labels, DEFVARs, created frames, maximal depth of the data stack
+ * and the static cost. Totals and the most expensive functions follow.
+ * Statistics are written to stderr. It must be called after PrintCode().
+ * @param json    Written as JSON, text otherwise.
+ * @returns True, if success. False otherwise.
+ */
+bool PrintCodeStats(bool json);
+
+#endif // STATS_H
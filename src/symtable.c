@@ -10,6 +10,7 @@
  */
 
 #include "symtable.h"
+#include "tables.h"
 #include "types.h"
 #include "err.h"
 #include <stdio.h>
@@ -31,7 +32,8 @@
  */
 struct variable{
     DataType type;
-    char * name;
+    const char * name;      //points into operand, behind the frame prefix
+    const char * operand;   //operand text of the variable ("LF@name"), atom
 };
 
 /**
@@ -54,9 +56,11 @@ typedef struct symbolTableFrame{
 typedef struct symbolTable{
     DataType type;
     char *name;
+    unsigned int hash;              //cached hash of the name (used when resizing)
     bool defined;
     size_t numberOfParameters;
-    struct paramFce *firstParam;
+    Parameters firstParam;
+    const Signature *signature;     //interned signature (number and types of parametres)
     SymbolTableFrame *variables;
 } SymbolTable;
 
@@ -64,15 +68,22 @@ typedef struct symbolTable{
  * @brief   Structure representing hash table consisting of functions.
  *
  * This structure contains informations about declared functions.
+ * Size of the table is always a power of two. It also keeps a worklist
+ * of declared, but not yet defined functions.
  */
 typedef struct functionHashTable{
     size_t arr_size;
     size_t count;
     SymbolTable ** arr;
+    size_t undefined_size;          //size of the worklist
+    size_t undefined_count;         //number of functions in the worklist
+    SymbolTable ** undefined;       //worklist of declared functions
 } FunctionHashTable;
 
 //function hash table
-static FunctionHashTable functionTable = {.arr_size = 0, .count = 0, .arr = NULL};
+static FunctionHashTable functionTable = {.arr_size = 0, .count = 0, .arr = NULL,
+                                          .undefined_size = 0, .undefined_count = 0,
+                                          .undefined = NULL};
 
 
 
@@ -91,12 +102,15 @@ static FunctionHashTable functionTable = {.arr_size = 0, .count = 0, .arr = NULL
 #define PORTION_OF_TABLE 2  //when should table resize (count > arr_size/PORTION_OF_TABLE)
 #define RESIZE_RATE 2       //how much should it resize
 
-#define STARTING_CHUNK_FUNCTIONS 10   //size of initialised array of functions
+#define STARTING_CHUNK_FUNCTIONS 16   //size of initialised array of functions (power of two)
 #define PORTION_OF_TABLE_FUNCTIONS 2  //when should function table resize (count > arr_size/PORTION_OF_TABLE_FUNCTIONS)
 #define RESIZE_RATE_FUNCTIONS 2       //how much should it resize
+#define STARTING_CHUNK_UNDEFINED 16   //size of initialised worklist of declared functions
 
 
-unsigned int hashFunctionCentral(const char * name, SymbolTable ** array, size_t arrSize);
+unsigned int hashFunctionCentral(const char * name, unsigned int hash, SymbolTable ** array, size_t arrSize);
+
+unsigned int hashFunctionMix(unsigned int hash);
 
 unsigned int hashCentral(SymbolTableFrame * frame, const char * name);
 
@@ -147,21 +161,25 @@ void EndHash(const char * msg, ErrorType errtype)
                 /*-----HASH FUNCTIONS-----*/
 
 /**
- * @brief   Manages two hash functions. (for hash table of functions)
+ * @brief   Finds a slot in hash table of functions.
  *
  * This function returns an index into hash table.
  * Has multiple purposes:
  *      For function find finds a record or returns
  *      an empty spot (symbol is not there).
  *      For function add finds a record or an empty spot for insertion.
+ * The table size is a power of two and the table is never more than half full,
+ * so linear probing always ends on a record or on an empty spot.
  * @param name      name of the function (that will be inserted)
+ * @param hash      hash of the name (hashFunctionMix(hashFunction(name)))
  * @param array     hash table of functions
  * @param arrSize   size of the hash table
  * @returns Index into hash table.
  */
-unsigned int hashFunctionCentral(const char * name, SymbolTable ** array, size_t arrSize)
+unsigned int hashFunctionCentral(const char * name, unsigned int hash, SymbolTable ** array, size_t arrSize)
 {
-    unsigned int hashNumber;
+    size_t mask = arrSize - 1;
+    size_t index;
 
     if(name == NULL || array == NULL || arrSize == 0)
     {
@@ -169,23 +187,18 @@ unsigned int hashFunctionCentral(const char * name, SymbolTable ** array, size_t
         return 0;
     }
 
-    hashNumber = hashFunction(name) % arrSize;
+    index = hash & mask;
 
-    //maximal number of rehashes is the size of table -1
-    for(size_t i = 0; i < (arrSize - 1) ;++i)
+    //not found or found an empty spot to save function
+    while(array[index] != NULL)
     {
-        //not found or found an empty spot to save function
-        if(array[hashNumber] == NULL)
-            return hashNumber;
-        //found a record
-        else if(strcmp(array[hashNumber]->name, name) == 0)
-            return hashNumber;
+        //found a record (hashes are compared first, strings only when they match)
+        if(array[index]->hash == hash && strcmp(array[index]->name, name) == 0)
+            return index;
         //found a different record -> continues finding
-        else
-            hashNumber = rehashFunction(hashNumber) % arrSize;
+        index = (index + 1) & mask;
     }
-    //table cant be full, it hopefully resizes automatically so it should not reach this
-    return hashNumber;
+    return index;
 }
 /**
  * @brief   Manages two hash functions. (for hash table of variables)
@@ -257,6 +270,21 @@ unsigned int hashFunction(const char * name)
 
     return h;
 }
+/**
+ * @brief   Finalizer of the hash for hash table of functions.
+ *
+ * This function mixes the high bits of the hash into the low ones,
+ * which are used to index the power of two sized function table.
+ * @param hash  hash of the name
+ * @returns A mixed number.
+ */
+unsigned int hashFunctionMix(unsigned int hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bU;
+    hash ^= hash >> 16;
+    return hash;
+}
 /*----------------------------------------------------------------------------------*/
 /**
  * @brief   Initialisation of hash symbol table.
@@ -282,6 +310,7 @@ SymbolTableFrame * frameInit(size_t size)
             for(size_t i = 0; i < size ;++i)
             {
                 frame->arr[i].name = NULL;
+                frame->arr[i].operand = NULL;
                 frame->arr[i].type = DataType_Unknown;
             }
         }
@@ -305,12 +334,6 @@ void frameFree(SymbolTableFrame * frame)
 {
     if(frame == NULL) return;
 
-    //frees strings in frame
-    for(size_t i = 0;i < frame->arr_size;i++)
-    {
-        free(frame->arr[i].name);
-    }
-
     //destroys a frame
     free(frame);
 
@@ -370,8 +393,10 @@ SymbolTableFrame * frameResize(size_t newsize, SymbolTableFrame * frame2)
             /*---------------------------------------------------------------------------*/
             frame->arr[hashNumber].type = frame2->arr[i].type;
             frame->arr[hashNumber].name = frame2->arr[i].name;
+            frame->arr[hashNumber].operand = frame2->arr[i].operand;
             frame2->arr[i].type = DataType_Unknown;
             frame2->arr[i].name = NULL;
+            frame2->arr[i].operand = NULL;
         }
         //destroys old frame
         frameFree(frame2);
@@ -427,10 +452,18 @@ bool frameAddSymbol(SymbolTableFrame ** pframe, const char * name)
 
     if(frame->arr[hashNumber].name == NULL) //not found -> can be added
     {
-        if((frame->arr[hashNumber].name = malloc(sizeof(char) * strlen(name)
-                                                    + sizeof(char))) != NULL)
+        //operand text is interned together with the name
+        char * operand = malloc(sizeof(char) * (3/*LF@*/ + strlen(name)) + sizeof(char));
+        if(operand != NULL)
+        {
+            strcpy(operand, "LF@");
+            strcpy(operand + 3, name);
+            frame->arr[hashNumber].operand = atomInsert(operand);
+            free(operand);
+        }
+        if(operand != NULL && frame->arr[hashNumber].operand != NULL)
         {
-            strcpy(frame->arr[hashNumber].name, name);
+            frame->arr[hashNumber].name = frame->arr[hashNumber].operand + 3;
         }
             else
             {
@@ -488,10 +521,12 @@ void functionTableFree(size_t size);
 
 void functionFrameFree(SymbolTable * frame);
 
-void functionTableResize(size_t newsize, SymbolTable ** array2);
+void functionTableResize(size_t newsize);
 
 SymbolTable * findFunction(const char * name);
 
+bool pushUndefinedFunction(SymbolTable * function);
+
 
                     //FUNCTION TABLE FUNCTIONS
 
@@ -503,7 +538,7 @@ SymbolTable * findFunction(const char * name);
  * This function initialises a function hash table.
  * Returns NULL when unsuccessful, otherwise
  * returns pointer to the structure.
- * @param size      size of the table
+ * @param size      size of the table (power of two)
  * @returns Pointer to array of functions or NULL.
  */
 SymbolTable ** functionTableInit(size_t size)
@@ -511,11 +546,9 @@ SymbolTable ** functionTableInit(size_t size)
     SymbolTable ** array = NULL;
 
     //allocation of the table
-    if( (array = malloc(sizeof(SymbolTable *) * size)) != NULL)
+    if( (array = calloc(size, sizeof(SymbolTable *))) != NULL)
     {
         //initialisation of the table
-        for(size_t i = 0;i < size;++i)
-            array[i] = NULL;
         if(functionTable.arr_size == 0) functionTable.arr_size = size;
     }
     else
@@ -546,8 +579,10 @@ SymbolTable * functionFrameInit()
         //initialisation of the frame
         frame->firstParam = NULL;
         frame->name = NULL;
+        frame->hash = 0;
         frame->variables = frameInit(STARTING_CHUNK);
         frame->numberOfParameters = 0;
+        frame->signature = paramSignature(NULL);
         frame->defined = false;
         frame->type = DataType_Unknown;
     }
@@ -575,12 +610,16 @@ void functionTableFree(size_t size)
     for(size_t i = 0;i < size;++i)
         functionFrameFree(functionTable.arr[i]);
 
-    //destroys function table
+    //destroys function table and the worklist
     free(functionTable.arr);
+    free(functionTable.undefined);
 
     functionTable.arr_size = 0;
     functionTable.count = 0;
     functionTable.arr = NULL;
+    functionTable.undefined_size = 0;
+    functionTable.undefined_count = 0;
+    functionTable.undefined = NULL;
 
     #ifdef SYMTABLE_DEBUG
         debug("Function table was freed.");
@@ -597,13 +636,7 @@ void functionFrameFree(SymbolTable * frame)
     if(frame == NULL) return;
 
     //freeing the list of parametres
-    while(frame->firstParam != NULL)
-    {
-        struct paramFce * pom = frame->firstParam;
-        frame->firstParam = frame->firstParam->next;
-        free(pom->name);
-        free(pom);
-    }
+    paramFree(frame->firstParam);
 
     //freeing name and variable table
     free(frame->name);
@@ -620,36 +653,35 @@ void functionFrameFree(SymbolTable * frame)
 /**
  * @brief   Resizes a function hash table, deletes the old one.
 
- * Creates a new resized table from the previous one.
- * @param newsize   new size of the table
- * @param array2    pointer to a source table
+ * Creates a new resized table from the previous one. Functions are moved
+ * by their cached hashes, so no name is hashed or compared again.
+ * @param newsize   new size of the table (power of two)
 */
-void functionTableResize(size_t newsize, SymbolTable ** array2)
+void functionTableResize(size_t newsize)
 {
     SymbolTable ** array = NULL;
-    unsigned int hashNumber;
-    size_t count;
+    size_t mask = newsize - 1;
+    size_t index;
 
-    if(array2 == NULL) return;
+    if(functionTable.arr == NULL) return;
 
     if((array = functionTableInit(newsize)) != NULL)
     {
-        //going through all functions in table and copying function pointers
+        //going through all functions in table and moving function pointers
         for(size_t i=0;i < functionTable.arr_size;++i)
         {
-            /*computes a new hash in a new frame*/
-            if(array2[i] == NULL) continue;
-            hashNumber = hashFunctionCentral(array2[i]->name, array, newsize);
+            if(functionTable.arr[i] == NULL) continue;
+
+            //names are unique, so the first empty spot is the right one
+            index = functionTable.arr[i]->hash & mask;
+            while(array[index] != NULL) index = (index + 1) & mask;
 
-            array[hashNumber] = array2[i];
-            array2[i] = NULL;
+            array[index] = functionTable.arr[i];
         }
-        count = functionTable.count;
-        //destroys old table
-        functionTableFree(functionTable.arr_size);
-        functionTable.arr = array; //saves new array
+        //destroys old array, saves new one
+        free(functionTable.arr);
+        functionTable.arr = array;
         functionTable.arr_size = newsize;
-        functionTable.count = count;
     }
     else
     {
@@ -676,12 +708,10 @@ SymbolTable * findFunction(const char * name)
     size_t hashNumber;
 
     if(name == NULL) return NULL;
-    hashNumber = hashFunctionCentral(name, functionTable.arr, functionTable.arr_size);
+    hashNumber = hashFunctionCentral(name, hashFunctionMix(hashFunction(name)),
+                                     functionTable.arr, functionTable.arr_size);
 
-    if(functionTable.arr[hashNumber] == NULL) return NULL; //not found
-        else return functionTable.arr[hashNumber];         //found
-
-    return functionTable.arr[hashNumber];
+    return functionTable.arr[hashNumber];   //found or NULL
 }
 /**
  * @brief   Adds function into function hash table.
@@ -693,6 +723,7 @@ bool addFunction(const char * name)
 {
     //initialisation when used for the first time
     if(functionTable.arr_size == 0) functionTable.arr = functionTableInit(STARTING_CHUNK_FUNCTIONS);
+    if(functionTable.arr == NULL) return false;
 
     if(name == NULL)
     {
@@ -702,27 +733,32 @@ bool addFunction(const char * name)
 
     //increase the amount of symbols in table and resizes if needed
     if((functionTable.count + 1) > functionTable.arr_size/PORTION_OF_TABLE_FUNCTIONS)
-        functionTableResize(RESIZE_RATE_FUNCTIONS * functionTable.arr_size, functionTable.arr);
+        functionTableResize(RESIZE_RATE_FUNCTIONS * functionTable.arr_size);
 
 
     size_t hashNumber;
-    hashNumber = hashFunctionCentral(name, functionTable.arr, functionTable.arr_size);
+    unsigned int hash = hashFunctionMix(hashFunction(name));
+    hashNumber = hashFunctionCentral(name, hash, functionTable.arr, functionTable.arr_size);
 
     if(functionTable.arr[hashNumber] == NULL) //not found -> can be added
     {
-        functionTable.arr[hashNumber] = functionFrameInit();
+        SymbolTable * function = functionFrameInit();
+        if(function == NULL) return false;
 
-        if((functionTable.arr[hashNumber]->name = malloc(sizeof(char) * strlen(name)
+        if((function->name = malloc(sizeof(char) * strlen(name)
                                                     + sizeof(char))) != NULL)
         {
-            strcpy(functionTable.arr[hashNumber]->name, name);
+            strcpy(function->name, name);
         }
         else
         {
+            functionFrameFree(function);
             EndHash("FunctionTable: AddFunction: could not allocate memory for symbol name",
                                     ErrorType_Internal);
             return false;
         }
+        function->hash = hash;
+        functionTable.arr[hashNumber] = function;
     }
         else return false; //found -> cant be added
 
@@ -733,6 +769,31 @@ bool addFunction(const char * name)
     #endif
     return true;
 }
+/**
+ * @brief   Adds function into the worklist of declared functions.
+ *
+ * @param function    declared function
+ * @returns True if successful, false if not.
+*/
+bool pushUndefinedFunction(SymbolTable * function)
+{
+    if(functionTable.undefined_count == functionTable.undefined_size)
+    {
+        size_t newsize = (functionTable.undefined_size == 0) ? STARTING_CHUNK_UNDEFINED
+                                                             : 2 * functionTable.undefined_size;
+        SymbolTable ** array = realloc(functionTable.undefined, newsize * sizeof(SymbolTable *));
+        if(array == NULL)
+        {
+            EndHash("FunctionTable: pushUndefinedFunction: could not allocate memory", ErrorType_Internal);
+            return false;
+        }
+        functionTable.undefined = array;
+        functionTable.undefined_size = newsize;
+    }
+
+    functionTable.undefined[functionTable.undefined_count++] = function;
+    return true;
+}
 
 
 
@@ -816,7 +877,7 @@ size_t findFunctionNumberOfParametres(const char * functionName)
  * @param functionName  name of the function
  * @returns pointer or NULL.
  */
-struct paramFce * findFunctionParameters(const char * functionName)
+Parameters findFunctionParameters(const char * functionName)
 {
     #ifdef SYMTABLE_DEBUG
         debug("Looking for parametres");
@@ -832,21 +893,24 @@ struct paramFce * findFunctionParameters(const char * functionName)
     return function->firstParam;
 }
 /**
- * @brief   Counts list length.
+ * @brief   Sets signature of a function.
  *
- * @param parametres  pointer to the list of parametres
- * @returns number of parametres.
+ * This function saves interned signature of the parametres
+ * and their number into the function.
+ * @param function    the function
+ * @param parametres  list of parametres
+ * @returns True/false.
  */
-size_t listLength(struct paramFce * parametres)
+bool setFunctionSignature(SymbolTable * function, Parameters parametres)
 {
-    size_t i = 0;
-
-    while(parametres != NULL)
+    if((function->signature = paramSignature(parametres)) == NULL)
     {
-        i++;
-        parametres = parametres->next;
+        EndHash("FunctionTable: setFunctionSignature: could not allocate memory", ErrorType_Internal);
+        return false;
     }
-    return i;
+    function->numberOfParameters = function->signature->count;
+
+    return true;
 }
 /**
  * @brief   Adds a parameter of a function and saves them as variables.
@@ -857,7 +921,7 @@ size_t listLength(struct paramFce * parametres)
  * @param definition    true -> function is being defined, false -> it is only a declaration
  * @returns True/false.
  */
-bool addFunctionParameters(const char * functionName, struct paramFce * parametres, bool definition)
+bool addFunctionParameters(const char * functionName, Parameters parametres, bool definition)
 {
     SymbolTable * function;
     function = findFunction(functionName);
@@ -868,22 +932,27 @@ bool addFunctionParameters(const char * functionName, struct paramFce * parametr
     }
     else
     {
-        //inserts parametres into list
+        //inserts parametres into list (list from declaration is replaced)
+        if(function->firstParam != parametres) paramFree(function->firstParam);
         function->firstParam = parametres;
-        function->numberOfParameters = listLength(parametres);
+        if(!setFunctionSignature(function, parametres)) return false;
 
         if(definition)
         {
             function->defined = true;
             //inserts parametres into variable array
-            struct paramFce * pom = function->firstParam;
-            while(pom != NULL)
+            Parameters pom = function->firstParam;
+            for(size_t i = 0; i < paramCount(pom); ++i)
             {
-                if(!addVariable(function->name, pom->name)) return false;
-                if(!addVariableType(function->name, pom->name, pom->type)) return false;
-                pom = pom->next;
+                if(!addVariable(function->name, pom->names[i])) return false;
+                if(!addVariableType(function->name, pom->names[i], pom->types[i])) return false;
             }
         }
+        //declared functions are checked at the end of program
+        else if(!function->defined)
+        {
+            if(!pushUndefinedFunction(function)) return false;
+        }
     }
 
     #ifdef SYMTABLE_DEBUG
@@ -891,6 +960,28 @@ bool addFunctionParameters(const char * functionName, struct paramFce * parametr
     #endif
     return true;
 }
+/**
+ * @brief   Compares signature of a function with list of parametres.
+ *
+ * Signatures are interned, so only the pointers are compared.
+ * @param functionName  name of the function
+ * @param parametres    list of parametres
+ * @returns True if types of parametres match, false otherwise.
+ */
+bool functionSignatureMatches(const char * functionName, Parameters parametres)
+{
+    SymbolTable * function;
+    function = findFunction(functionName);
+    if(function == NULL) return false;
+
+    const Signature * signature = paramSignature(parametres);
+    if(signature == NULL)
+    {
+        EndHash("SymTab: functionSignatureMatches: could not allocate memory", ErrorType_Internal);
+        return false;
+    }
+    return function->signature == signature;
+}
 /**
  * @brief   Checks whether the function is defined or declared.
  *
@@ -923,17 +1014,19 @@ short int checkFunctionState(const char * functionName)
  * @brief   Finds the first undefined function, returns its name and sets it to defined
  *                     (can be called repetedly to find all undefined functions).
  *
+ * Declared functions are taken from the worklist, so all calls together
+ * take time linear to the number of declarations.
  * @returns name of the undefined function or NULL when everything is ok.
  */
-//mozno vracet nazev nedefinovane funkce nebo bool
 const char * functionDefinitionCheck()
 {
-    for(size_t i = 0;i < functionTable.arr_size;++i)
+    while(functionTable.undefined_count > 0)
     {
-        if(functionTable.arr[i] != NULL && !functionTable.arr[i]->defined)
+        SymbolTable * function = functionTable.undefined[--functionTable.undefined_count];
+        if(!function->defined)
         {
-            functionTable.arr[i]->defined = true;        //can be called repetedly
-            return functionTable.arr[i]->name;
+            function->defined = true;        //can be called repetedly
+            return function->name;
         }
     }
     return NULL;
@@ -1018,6 +1111,25 @@ DataType findVariableType(const char * functionName, const char * name)
 
     return var->type;
 }
+/**
+ * @brief   Finds operand text of a variable.
+ *
+ * @param functionName  name of the function
+ * @param name          name of the variable
+ * @returns success -> operand text ("LF@name"), an atom, failure -> NULL.
+ */
+const char * findVariableOperand(const char * functionName, const char * name)
+{
+    SymbolTable * function;
+    function = findFunction(functionName);
+    if(function == NULL) return NULL;
+
+    struct variable * var;
+    var = frameFindSymbol(function->variables, name);
+    if(var == NULL) return NULL;
+
+    return var->operand;
+}
 /**
  * @brief   Finds a variable in a function.
  *
@@ -1083,7 +1195,7 @@ void print(SymbolTableFrame * frame)
 void printfunction(void)
 {
     int pocitadlo = 1;
-    struct paramFce * pom;
+    Parameters pom;
 
     printf("\n\n------------Prochazim polem majicim %d polozek!--------------\n\n", (int)functionTable.count);
     for(size_t i = 0;i < functionTable.arr_size;++i)
@@ -1094,11 +1206,10 @@ void printfunction(void)
         printf("Typ funkce: %d\n", (int)functionTable.arr[i]->type);
         printf("Pocet parametru funkce: %d\n", (int)functionTable.arr[i]->numberOfParameters);
         pom = functionTable.arr[i]->firstParam;
-        while(pom != NULL)
+        for(size_t j = 0; j < paramCount(pom); ++j)
         {
-            printf(" - Jmeno param: %s\n", pom->name);
-            printf(" - Typ param: %d\n", (int)pom->type);
-            pom = pom->next;
+            printf(" - Jmeno param: %s\n", pom->names[j]);
+            printf(" - Typ param: %d\n", (int)pom->types[j]);
         }
         print(functionTable.arr[i]->variables);
         printf("==========================================================================\n\n");
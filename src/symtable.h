@@ -42,6 +42,15 @@ bool findVariable(const char * functionName, const char * name);
  * @returns success -> DataType, failure -> datatype_unknown.
  */
 DataType findVariableType(const char * functionName, const char * name);
+/**
+ * @brief   Finds operand text of a variable.
+ *
+ * The text is interned once, when the variable is added.
+ * @param functionName  name of the function
+ * @param name          name of the variable
+ * @returns success -> operand text ("LF@name"), an atom, failure -> NULL.
+ */
+const char * findVariableOperand(const char * functionName, const char * name);
 /**
  * @brief   Adds a variable type.
  *
@@ -73,7 +82,7 @@ bool addVariable(const char * functionName, const char * name);
  * @param definition    true -> function is being defined, false -> it is only a declaration
  * @returns True/false.
  */
-bool addFunctionParameters(const char * functionName, struct paramFce * parametres, bool definition);
+bool addFunctionParameters(const char * functionName, Parameters parametres, bool definition);
 /**
  * @brief   finds all parameters of a function.
  *
@@ -83,7 +92,7 @@ bool addFunctionParameters(const char * functionName, struct paramFce * parametr
  * @param functionName  name of the function
  * @returns pointer or NULL.
  */
-struct paramFce * findFunctionParameters(const char * functionName);
+Parameters findFunctionParameters(const char * functionName);
 /**
  * @brief   Finds number of parametres of a function.
  *
@@ -136,6 +145,14 @@ void functionTableEnd();
  * @returns -1 -> function not found, 0 -> function is declared, 1 -> function is defined.
  */
 short int checkFunctionState(const char * functionName);
+/**
+ * @brief   Compares signature of a function with list of parametres.
+ *
+ * @param functionName  name of the function
+ * @param parametres    list of parametres
+ * @returns True if number and types of parametres match, false otherwise.
+ */
+bool functionSignatureMatches(const char * functionName, Parameters parametres);
 /**
  * @brief   Finds the first undefined function, returns its name and sets it to defined
  *                     (can be called repetedly to find all undefined functions).
@@ -18,6 +18,7 @@
 #include "err.h"
 #include "io.h"
 #include "functions.h"
+#include "hexfloat.h"
 
 
 /*-----------------------------------------------------------*/
@@ -181,34 +182,50 @@ const char * Operator2Str(Phrasem p)
 //                  CONSTANT TABLE DATA
 
 
-#define STARTING_CHUNK_CONSTANTS 10   //size of initialised arrays
-#define RESIZE_RATE_CONSTANTS 30      //how much should it resize: +30
+#define STARTING_CHUNK_CONSTANTS 16   //size of initialised arrays, power of two
+#define RESIZE_RATE_CONSTANTS 2       //how much should it resize: *2
+#define STARTING_CHUNK_STRINGS 256    //size of initialised string pool
+#define NO_CONSTANT ((size_t)-1)      //end of the chain
 
 
 /**
  * @brief   Structure representing characteristics of constants.
  *
  * This structure is filled with type and value of the constant.
- * Value is represented by union.
+ * Strings are saved as offsets into the string pool.
  */
 struct constant{
     DataType type;
-    DataUnion data;
+    union {
+        int ivalue;
+        double dvalue;
+        size_t offset;      //offset of the string in the pool
+    } data;
+    size_t length;          //length of the string
+    char * operand;         //cached operand text (NULL, if not used yet)
+    unsigned int hash;      //hash of type and value
+    size_t next;            //next constant in the same bucket
 };
 
 /**
  * @brief   Structure representing table of constants.
  *
- * This structure is filled with structures representing constants.
- * It knows its own size and resizes automatically by (+10?) entities.
+ * Equal constants (type and value) share one index, they are found
+ * by hash table of chained indexes. Both arrays double their size.
+ * Strings are saved in one contiguous append-only pool.
  */
 typedef struct constantArray{
-    size_t arr_size;    //array size
+    size_t arr_size;        //array size (also number of buckets)
     size_t count;           //number of entities in array
     struct constant * arr;  //non variadic array of constants (its easier)
+    size_t * buckets;       //first constant of each bucket
+    char * pool;            //string pool
+    size_t pool_size;       //size of string pool
+    size_t pool_len;        //used bytes of string pool
 } ConstArray;
 
-static ConstArray consttable = {.arr_size = 0, .count = 0, .arr = NULL};
+static ConstArray consttable = {.arr_size = 0, .count = 0, .arr = NULL, .buckets = NULL,
+                                .pool = NULL, .pool_size = 0, .pool_len = 0};
 
 /*-----------------------------------------------------------*/
 
@@ -221,6 +238,97 @@ bool constTableResize(void);
 
                     //FUNCTION BODY
 
+/**
+ * @brief   Hash of a constant.
+ *
+ * Doubles are hashed (and compared) by their bits.
+ * @param type      type of the constant
+ * @param uni       data of the constant
+ * @param length    length of the string
+ * @returns hash.
+ */
+static unsigned int constHash(DataType type, DataUnion uni, size_t length)
+{
+    unsigned int h = (2166136261U ^ (unsigned int)type) * 16777619U;
+    const unsigned char * bytes;
+    size_t size;
+
+    if(type == DataType_Integer) { bytes = (const unsigned char *)&uni.ivalue; size = sizeof(int); }
+    else if(type == DataType_Double) { bytes = (const unsigned char *)&uni.dvalue; size = sizeof(double); }
+    else { bytes = (const unsigned char *)uni.svalue; size = length; }
+
+    for(size_t i = 0; i < size; ++i) h = (h ^ bytes[i]) * 16777619U;
+    return h;
+}
+/**
+ * @brief   Compares constant in the table with a value.
+ *
+ * @param c         constant in the table
+ * @param type      type of the value
+ * @param uni       the value
+ * @param length    length of the string
+ * @returns true if equal, false otherwise.
+ */
+static bool constEquals(const struct constant * c, DataType type, DataUnion uni, size_t length)
+{
+    if(c->type != type) return false;
+    if(type == DataType_Integer) return c->data.ivalue == uni.ivalue;
+    if(type == DataType_Double) return !memcmp(&c->data.dvalue, &uni.dvalue, sizeof(double));
+    return c->length == length && !memcmp(consttable.pool + c->data.offset, uni.svalue, length);
+}
+/**
+ * @brief   Links constant on a given index into its bucket.
+ *
+ * @param index     index into the array of constants
+ */
+static void constLink(size_t index)
+{
+    size_t bucket = consttable.arr[index].hash & (consttable.arr_size - 1);
+    consttable.arr[index].next = consttable.buckets[bucket];
+    consttable.buckets[bucket] = index;
+}
+/**
+ * @brief   Unlinks constant on a given index from its bucket.
+ *
+ * @param index     index into the array of constants
+ */
+static void constUnlink(size_t index)
+{
+    size_t * it = &consttable.buckets[consttable.arr[index].hash & (consttable.arr_size - 1)];
+    while(*it != index) it = &consttable.arr[*it].next;
+    *it = consttable.arr[index].next;
+}
+/**
+ * @brief   Appends string into the string pool.
+ *
+ * @param str       the string
+ * @param length    length of the string
+ * @returns offset of the string -> ok, NO_CONSTANT -> fail.
+ */
+static size_t constPoolAppend(const char * str, size_t length)
+{
+    if(consttable.pool_len + length + 1 > consttable.pool_size)
+    {
+        size_t newsize = (consttable.pool_size == 0) ? STARTING_CHUNK_STRINGS : consttable.pool_size;
+        while(consttable.pool_len + length + 1 > newsize) newsize *= RESIZE_RATE_CONSTANTS;
+
+        char * pool = realloc(consttable.pool, newsize);
+        if(pool == NULL)
+        {
+            setErrorType(ErrorType_Internal);
+            setErrorMessage("constantTable: string pool: could not allocate memory");
+            return NO_CONSTANT;
+        }
+        consttable.pool = pool;
+        consttable.pool_size = newsize;
+    }
+
+    size_t offset = consttable.pool_len;
+    memcpy(consttable.pool + offset, str, length);
+    consttable.pool[offset + length] = '\0';
+    consttable.pool_len += length + 1;
+    return offset;
+}
 /**
  * @brief   Initiation of table of constants.
  *
@@ -230,33 +338,26 @@ bool constTableResize(void);
 bool constTableInit(void)
 {
     //allocation of the table
-    if( (consttable.arr = malloc(STARTING_CHUNK_CONSTANTS * sizeof(struct constant)))  == NULL)
+    consttable.arr = malloc(STARTING_CHUNK_CONSTANTS * sizeof(struct constant));
+    consttable.buckets = malloc(STARTING_CHUNK_CONSTANTS * sizeof(size_t));
+    if(consttable.arr == NULL || consttable.buckets == NULL)
     {
         setErrorType(ErrorType_Internal);
         setErrorMessage("constantTableInit: could not allocate memory");
         return false;
     }
     consttable.arr_size = STARTING_CHUNK_CONSTANTS;
-    consttable.count = 3;
+    consttable.count = 0;
+    for(size_t i = 0; i < consttable.arr_size; ++i) consttable.buckets[i] = NO_CONSTANT;
 
     // setting first three constants to 0, 0.0 and "" (empty string)
-    consttable.arr[0].type = DataType_Integer;
-    consttable.arr[0].data.ivalue = 0;
-    consttable.arr[1].type = DataType_Double;
-    consttable.arr[1].data.dvalue = 0.0;
-    consttable.arr[2].type = DataType_String;
-    if((consttable.arr[2].data.svalue = calloc(1, sizeof(char))) == NULL)
-    {
-        setErrorType(ErrorType_Internal);
-        setErrorMessage("constantTableInit: could not allocate memory");
-        return false;
-    }
-
-
-    for(size_t i = 3; i < consttable.arr_size ;++i)         //not necessary
-    {
-        consttable.arr[i].type = DataType_Unknown;
-    }
+    DataUnion uni;
+    uni.ivalue = 0;
+    if(constInsert(DataType_Integer, uni) != (int)getIntDefaultValue()) return false;
+    uni.dvalue = 0.0;
+    if(constInsert(DataType_Double, uni) != (int)getDoubleDefaultValue()) return false;
+    uni.svalue = "";
+    if(constInsert(DataType_String, uni) != (int)getStringDefaultValue()) return false;
 
     return true;
 }
@@ -267,92 +368,109 @@ bool constTableInit(void)
  */
 void constTableFree(void)
 {
-    // freeing strings of the constants
-    for(size_t i = 2;i < consttable.count;++i)
-    {
-        if(consttable.arr[i].type == DataType_String)
-        {
-          free(consttable.arr[i].data.svalue);
-        }
+    //freeing operand texts, string pool and array of constants
+    for(size_t i = 0; i < consttable.count; ++i) free(consttable.arr[i].operand);
+    free(consttable.pool);
+    free(consttable.buckets);
+    free(consttable.arr);
 
-    }
     consttable.arr_size = 0;
     consttable.count = 0;
-
-    //freeing array of constants
-    free(consttable.arr);
+    consttable.arr = NULL;
+    consttable.buckets = NULL;
+    consttable.pool = NULL;
+    consttable.pool_size = 0;
+    consttable.pool_len = 0;
 }
 /**
  * @brief   Reallocs array of constants.
  *
- * This function increases size of table of constants.
+ * This function doubles size of table of constants and rehashes it.
  * @returns true -> ok, false -> fail.
  */
 bool constTableResize(void)
 {
-    if( (consttable.arr = realloc(consttable.arr, (consttable.arr_size + RESIZE_RATE_CONSTANTS)
-                                                    * sizeof(struct constant)))  == NULL)
+    size_t newsize = consttable.arr_size * RESIZE_RATE_CONSTANTS;
+    struct constant * arr = realloc(consttable.arr, newsize * sizeof(struct constant));
+    if(arr != NULL) consttable.arr = arr;
+    size_t * buckets = realloc(consttable.buckets, newsize * sizeof(size_t));
+    if(buckets != NULL) consttable.buckets = buckets;
+    if(arr == NULL || buckets == NULL)
     {
         setErrorType(ErrorType_Internal);
         setErrorMessage("constantTableResize: could not allocate memory");
         return false;
     }
-    consttable.arr_size = consttable.arr_size + RESIZE_RATE_CONSTANTS;
+    consttable.arr_size = newsize;
+
+    //rehashing by saved hashes
+    for(size_t i = 0; i < consttable.arr_size; ++i) consttable.buckets[i] = NO_CONSTANT;
+    for(size_t i = 0; i < consttable.count; ++i) constLink(i);
 
     return true;
 }
 /**
  * @brief   Inserts a constant in the array.
  *
+ * If the same constant (type and value) is already in the array,
+ * its index is returned.
  * @param type      type of the constant
  * @param uni       data of the constant
  * @returns index into the array -> ok, -1 -> fail.
  */
 int constInsert(DataType type, DataUnion uni)
 {
+    if(type != DataType_Integer && type != DataType_Double && type != DataType_String) return -1;
+
+    size_t length = (type == DataType_String) ? strlen(uni.svalue) : 0;
+    unsigned int hash = constHash(type, uni, length);
+
+    //looking for the same constant
+    for(size_t i = consttable.buckets[hash & (consttable.arr_size - 1)]; i != NO_CONSTANT; i = consttable.arr[i].next)
+    {
+        if(consttable.arr[i].hash == hash && constEquals(&consttable.arr[i], type, uni, length))
+        {
+          #ifdef CONSTANT_TABLE_DEBUG
+            debug("Constant found on index %d", (int)i);
+          #endif
+            return i;
+        }
+    }
+
+    //resizing if needed
+    if(consttable.count == consttable.arr_size)
+        if(!constTableResize()) return -1;
+
     //adding constant into array
+    struct constant * c = &consttable.arr[consttable.count];
+    c->type = type;
+    c->length = length;
+    c->hash = hash;
+    c->operand = NULL;
     if(type == DataType_Integer)
     {
       #ifdef CONSTANT_TABLE_DEBUG
         debug("Insert int %d to index %d", uni.ivalue, consttable.count);
       #endif
-        consttable.arr[consttable.count].type = DataType_Integer;
-        consttable.arr[consttable.count].data.ivalue = uni.ivalue;
+        c->data.ivalue = uni.ivalue;
     }
     else if(type == DataType_Double)
     {
       #ifdef CONSTANT_TABLE_DEBUG
         debug("Insert double %f to index %d", uni.dvalue, consttable.count);
       #endif
-        consttable.arr[consttable.count].type = DataType_Double;
-        consttable.arr[consttable.count].data.dvalue = uni.dvalue;
+        c->data.dvalue = uni.dvalue;
     }
-    else if(type == DataType_String)
+    else
     {
       #ifdef CONSTANT_TABLE_DEBUG
         debug("Insert string %s to index %d", uni.svalue, consttable.count);
       #endif
-        consttable.arr[consttable.count].type = DataType_String;
-        if((consttable.arr[consttable.count].data.svalue = malloc(strlen(uni.svalue) * sizeof(char)
-                                                                    + sizeof(char))) == NULL)
-
-        {
-            setErrorType(ErrorType_Internal);
-            setErrorMessage("constantTableInsert: could not allocate memory");
-            return false;
-        }
-        //consttable.arr[consttable.count].data.svalue = uni.svalue;
-        strcpy(consttable.arr[consttable.count].data.svalue, uni.svalue);
+        if((c->data.offset = constPoolAppend(uni.svalue, length)) == NO_CONSTANT) return -1;
     }
-    consttable.count++;
-
-
+    constLink(consttable.count);
 
-    //resizing if needed
-    if(consttable.count == consttable.arr_size)
-        if(!constTableResize()) return -1;
-
-    return consttable.count-1;     //count is an index of first empty slot
+    return consttable.count++;
 }
 /**
  * @brief   Returns type of the constant on a given index.
@@ -388,12 +506,57 @@ double getDoubleConstValue(size_t index)
 /**
  * @brief   Returns char pointer on the svalue of constant on a given index.
  *
+ * The pointer points into the string pool, it is valid
+ * until next insertion of a string.
  * @param index     index into the array of constants
  * @returns char pointer on the string -> ok, random pointer -> fail.
  */
 char * getStringConstValue(size_t index)
 {
-    return consttable.arr[index].data.svalue;
+    return consttable.pool + consttable.arr[index].data.offset;
+}
+/**
+ * @brief   Returns operand text of the constant on a given index.
+ *
+ * @param index     index into the array of constants
+ * @returns operand text -> ok, NULL -> fail.
+ */
+const char * getConstOperand(size_t index)
+{
+    if(index >= consttable.count) return NULL;
+    struct constant * c = &consttable.arr[index];
+    if(c->operand != NULL) return c->operand;
+
+    size_t maxlen;
+    switch(c->type)
+    {
+        case DataType_Integer:
+            maxlen = 4/*int@*/ + 3*sizeof(int)/*digits*/ + 1/*sign*/;
+            if((c->operand = malloc(maxlen + 1)) == NULL) break;
+            sprintf(c->operand, "int@%d", c->data.ivalue);
+            break;
+        case DataType_Double:
+            maxlen = 6/*float@*/ + HEXFLOAT_MAXLEN;
+            if((c->operand = malloc(maxlen + 1)) == NULL) break;
+            memcpy(c->operand, "float@", 6);
+            FormatDouble(c->operand + 6, c->data.dvalue);
+            break;
+        case DataType_String:
+            maxlen = 7/*string@*/ + c->length;
+            if((c->operand = malloc(maxlen + 1)) == NULL) break;
+            memcpy(c->operand, "string@", 7);
+            memcpy(c->operand + 7, consttable.pool + c->data.offset, c->length + 1);
+            break;
+        default:
+            return NULL;
+    }
+
+    if(c->operand == NULL)
+    {
+        setErrorType(ErrorType_Internal);
+        setErrorMessage("constantTable: operand: could not allocate memory");
+    }
+    return c->operand;
 }
 /**
  * @brief   Returns index to default value for integer.
@@ -425,6 +588,7 @@ size_t getStringDefaultValue()
 /**
  * @brief   Changes the value of a constant on given index.
  *          You have to know the type of constant before you use this. (constants cannot be retyped)
+ *          Constants are shared, so the value changes for all of its occurrences.
  *
  * @param index     index into the array of constants
  * @param value     data union with value
@@ -432,28 +596,190 @@ size_t getStringDefaultValue()
  */
 bool changeConstValue(size_t index, DataUnion value)
 {
-    if(consttable.arr[index].type == DataType_Integer)
+    struct constant * c = &consttable.arr[index];
+    size_t length = 0;
+
+    //cached operand text is not valid anymore
+    free(c->operand);
+    c->operand = NULL;
+
+    if(c->type == DataType_String)
     {
-        consttable.arr[index].data.ivalue = value.ivalue;
+        length = strlen(value.svalue);
+        size_t offset = constPoolAppend(value.svalue, length);
+        if(offset == NO_CONSTANT) return false;
+
+        c = &consttable.arr[index];
+        value.svalue = consttable.pool + offset;
+        constUnlink(index);
+        c->data.offset = offset;
+        c->length = length;
     }
-    else if(consttable.arr[index].type == DataType_Double)
+    else if(c->type == DataType_Integer)
     {
-        consttable.arr[index].data.dvalue = value.dvalue;
+        constUnlink(index);
+        c->data.ivalue = value.ivalue;
     }
-    else if(consttable.arr[index].type == DataType_String)
+    else if(c->type == DataType_Double)
     {
-        free(consttable.arr[index].data.svalue);
-        consttable.arr[index].data.svalue = malloc(sizeof(char) * strlen(value.svalue) + sizeof(char));
-        if(consttable.arr[index].data.svalue == NULL)
+        constUnlink(index);
+        c->data.dvalue = value.dvalue;
+    }
+    else return false;
+
+    //rehashing with the new value
+    c->hash = constHash(c->type, value, length);
+    constLink(index);
+
+    return true;
+}
+
+/*************************************************************/
+
+                    //TABLE OF ATOMS
+
+/*************************************************************/
+
+//                  ATOM TABLE DATA
+
+
+#define STARTING_CHUNK_ATOMS 64       //number of buckets, power of two
+
+/**
+ * @brief   Structure representing an atom (interned string).
+ */
+struct atom{
+    unsigned int hash;      //hash of the string
+    struct atom * next;     //next atom in the same bucket
+    char str[];             //the string
+};
+
+/**
+ * @brief   Structure representing table of atoms.
+ *
+ * Hash table with chaining, it doubles its size when full.
+ */
+typedef struct atomTable{
+    size_t arr_size;        //number of buckets
+    size_t count;           //number of atoms
+    struct atom ** arr;     //buckets
+} AtomTable;
+
+static AtomTable atomtable = {.arr_size = 0, .count = 0, .arr = NULL};
+
+/*-----------------------------------------------------------*/
+
+                    //FUNCTION BODY
+
+/**
+ * @brief   Hash of the string (FNV-1a).
+ *
+ * @param str     String.
+ * @returns hash.
+ */
+static unsigned int atomHash(const char * str)
+{
+    unsigned int h = 2166136261U;
+    for(; *str != '\0'; str++) h = (h ^ (unsigned char)*str) * 16777619U;
+    return h;
+}
+
+/**
+ * @brief   Doubles the number of buckets of the table of atoms.
+ *
+ * @returns true -> ok, false -> fail.
+ */
+static bool atomTableResize(void)
+{
+    size_t newsize = (atomtable.arr_size == 0) ? STARTING_CHUNK_ATOMS : 2*atomtable.arr_size;
+    struct atom ** arr = calloc(newsize, sizeof(struct atom *));
+    if(arr == NULL)
+    {
+        setErrorType(ErrorType_Internal);
+        setErrorMessage("atomTableResize: could not allocate memory");
+        return false;
+    }
+
+    //rehashing by saved hashes
+    for(size_t i = 0; i < atomtable.arr_size; ++i)
+    {
+        struct atom * it = atomtable.arr[i];
+        while(it != NULL)
         {
-            setErrorType(ErrorType_Internal);
-            setErrorMessage("constantTable: ChangeValue: could not allocate memory");
-            return false;
+            struct atom * next = it->next;
+            it->next = arr[it->hash & (newsize - 1)];
+            arr[it->hash & (newsize - 1)] = it;
+            it = next;
         }
-        strcpy(consttable.arr[index].data.svalue, value.svalue);
-        //consttable.arr[index].data.svalue = value.svalue;             <<-- if i should free pointers
     }
-    else return false;
 
+    free(atomtable.arr);
+    atomtable.arr = arr;
+    atomtable.arr_size = newsize;
     return true;
 }
+
+const char * atomInsert(const char * str)
+{
+    if(str == NULL) return NULL;
+    if(atomtable.count >= atomtable.arr_size)
+    {
+        if(!atomTableResize()) return NULL;
+    }
+
+    unsigned int hash = atomHash(str);
+    struct atom ** bucket = &atomtable.arr[hash & (atomtable.arr_size - 1)];
+
+    //lookup
+    for(struct atom * it = *bucket; it != NULL; it = it->next)
+    {
+        if(it->hash == hash && !strcmp(it->str, str)) return it->str;
+    }
+
+    //insert
+    size_t len = strlen(str);
+    struct atom * a = malloc(sizeof(struct atom) + len + 1);
+    if(a == NULL)
+    {
+        setErrorType(ErrorType_Internal);
+        setErrorMessage("atomInsert: could not allocate memory");
+        return NULL;
+    }
+    a->hash = hash;
+    memcpy(a->str, str, len + 1);
+    a->next = *bucket;
+    *bucket = a;
+    atomtable.count++;
+
+    return a->str;
+}
+
+const char * atomFind(const char * str)
+{
+    if(str == NULL || atomtable.arr_size == 0) return NULL;
+
+    unsigned int hash = atomHash(str);
+    for(struct atom * it = atomtable.arr[hash & (atomtable.arr_size - 1)]; it != NULL; it = it->next)
+    {
+        if(it->hash == hash && !strcmp(it->str, str)) return it->str;
+    }
+    return NULL;
+}
+
+void atomTableFree(void)
+{
+    for(size_t i = 0; i < atomtable.arr_size; ++i)
+    {
+        struct atom * it = atomtable.arr[i];
+        while(it != NULL)
+        {
+            struct atom * next = it->next;
+            free(it);
+            it = next;
+        }
+    }
+    free(atomtable.arr);
+    atomtable.arr = NULL;
+    atomtable.arr_size = 0;
+    atomtable.count = 0;
+}
@@ -111,6 +111,16 @@ double getDoubleConstValue(size_t index);
  */
 char * getStringConstValue(size_t index);
 
+/**
+ * @brief   Returns operand text of the constant on a given index.
+ *
+ * The text (int@42, float@..., string@...) is computed on the first use
+ * and cached in the table.
+ * @param index     index into the array of constants
+ * @returns operand text -> ok, NULL -> fail.
+ */
+const char * getConstOperand(size_t index);
+
 /**
  * @brief   Returns index to default value for integer.
  *
@@ -142,6 +152,36 @@ size_t getStringDefaultValue();
  */
 bool changeConstValue(size_t index, DataUnion value);
 
+/*-----------------------------------------------------------*/
+
+                //ATOM TABLE FUNCTIONS
+
+/**
+ * @brief   Interns the string.
+ *
+ * This function returns the unique copy of the given string. Two atoms
+ * are equal strings, if and only if their pointers are equal.
+ * @param str     String to intern.
+ * @returns Atom -> ok, NULL -> fail.
+ */
+const char * atomInsert(const char * str);
+
+/**
+ * @brief   Finds the atom.
+ *
+ * This function searches the table only, the string is not interned.
+ * @param str     String to find.
+ * @returns Atom -> found, NULL -> not interned.
+ */
+const char * atomFind(const char * str);
+
+/**
+ * @brief   Destroys table of atoms.
+ *
+ * This function frees all the atoms.
+ */
+void atomTableFree(void);
+
 
 
 #endif //TABLES_H
@@ -0,0 +1,195 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "config.h"
+#include "io.h"
+#include "tailcall.h"
+
+/**
+ * @brief   Finds label in the unit.
+ *
+ * @param u       Unit.
+ * @param label   Label (atom).
+ * @returns Index of the label, or u->count, if not found.
+ */
+static size_t FindLabel(const CodeUnit * u, const char * label)
+{
+  for(size_t i = 0; i < u->count; i++)
+    if(u->code[i].op == Opcode_Label && u->code[i].arg[0].d.label == label) return i;
+  return u->count;
+}
+
+/**
+ * @brief   Returns the variable right away.
+ *
+ * Follows labels and unconditional jumps from the index, until
+ * PUSHS var, RETURN is found.
+ * @param u       Unit.
+ * @param i       Index.
+ * @param var     Variable.
+ * @returns True, if the variable is returned. False otherwise.
+ */
+static bool ReturnsVariable(const CodeUnit * u, size_t i, const Operand * var)
+{
+  // bounded by the size, jumps may form a cycle
+  for(size_t steps = 0; i < u->count && steps < u->count; steps++)
+  {
+    Opcode op = u->code[i].op;
+    if(op == Opcode_Label || op == Opcode_Comment) i++;
+    else if(op == Opcode_Jump) i = FindLabel(u, u->code[i].arg[0].d.label);
+    else break;
+  }
+
+  return i + 1 < u->count
+      && u->code[i].op == Opcode_Pushs && OperandEquals(&u->code[i].arg[0], var)
+      && u->code[i+1].op == Opcode_Return;
+}
+
+/**
+ * @brief   Tail call site.
+ *
+ * Call site is CREATEFRAME, arguments, CALL f, POPFRAME, POPS var,
+ * where var is returned right away.
+ * @param u       Unit of the function.
+ * @param i       Index of CREATEFRAME.
+ * @returns Index of CALL, or 0, if not a tail call.
+ */
+static size_t TailCall(const CodeUnit * u, size_t i)
+{
+  size_t j = i + 1;
+  while(j < u->count && u->code[j].op != Opcode_Call && u->code[j].op != Opcode_CreateFrame) j++;
+  if(j + 2 >= u->count || u->code[j].op != Opcode_Call) return 0;
+  if(u->code[j].arg[0].d.label != u->name) return 0;
+  if(u->code[j+1].op != Opcode_PopFrame) return 0;
+
+  const Instruction * pops = &u->code[j+2];
+  if(pops->op != Opcode_Pops || pops->arg[0].type != Operand_Variable || pops->arg[0].d.var.frame != Frame_Local)
+    return 0;
+  if(!ReturnsVariable(u, j + 3, &pops->arg[0])) return 0;
+
+  // temporary frame only in definitions and assignments of arguments
+  for(size_t k = i + 1; k < j; k++)
+  {
+    const Instruction * ins = &u->code[k];
+    for(unsigned a = 0; a < OpcodeArity(ins->op); a++)
+      if(ins->arg[a].type == Operand_Variable && ins->arg[a].d.var.frame == Frame_Temporary
+         && ins->op != Opcode_Defvar && ins->op != Opcode_Pops) return 0;
+  }
+  return j;
+}
+
+/**
+ * @brief   Eliminates tail calls of the function.
+ *
+ * Arguments are evaluated onto the data stack first, then they are
+ * popped into the parameters (in reverse order), so arguments may use
+ * old values of any parameter.
+ * @param u       Unit of the function.
+ * @param count   Returned number of eliminated tail calls.
+ * @returns True, if success. False otherwise.
+ */
+static bool EliminateUnit(CodeUnit * u, unsigned * count)
+{
+  *count = 0;
+  size_t start = CodeBodyStart(u);
+  if(start == 0) return true;
+
+  for(size_t i = start; i < u->count; i++)
+    if(u->code[i].op == Opcode_CreateFrame && TailCall(u, i) != 0) (*count)++;
+  if(*count == 0) return true;
+
+  #ifdef OPTIMIZER_DEBUG
+    debug("Eliminate %u tail calls of %s.", *count, u->name);
+  #endif
+
+  // label of the body
+  char * name = malloc(strlen(u->name) + 7);
+  if(name == NULL) return false;
+  sprintf(name, "$%s$tail", u->name);
+  Operand body = OperandLabel(name);
+  free(name);
+  if(body.d.label == NULL) return false;
+
+  CodeUnit result = {0};
+  Instruction * params = NULL;
+  size_t params_count = 0;
+  bool ok = true;
+
+  // prologue, label of the body (definitions are moved before it by GenerateDefinitions())
+  for(size_t i = 0; ok && i < start; i++) ok = CodeAppend(&result, &u->code[i]);
+  Instruction label = {.op = Opcode_Label, .arg = {body}};
+  ok = ok && CodeAppend(&result, &label);
+
+  for(size_t i = start; ok && i < u->count; i++)
+  {
+    const Instruction * ins = &u->code[i];
+    size_t j;
+    if(ins->op != Opcode_CreateFrame || (j = TailCall(u, i)) == 0)
+    {
+      ok = CodeAppend(&result, ins);
+      continue;
+    }
+
+    // arguments stay on the data stack
+    params_count = 0;
+    Instruction * grown = realloc(params, (j - i) * sizeof(Instruction));
+    if(grown == NULL) { ok = false; break; }
+    params = grown;
+    for(size_t k = i + 1; ok && k < j; k++)
+    {
+      Instruction arg = u->code[k];
+      if(arg.op == Opcode_Defvar) continue;
+      if(arg.op == Opcode_Pops && arg.arg[0].d.var.frame == Frame_Temporary)
+      {
+        // TF@x of the new frame is LF@x of the current one
+        arg.arg[0] = OperandVariable(Frame_Local, arg.arg[0].d.var.name + 3);
+        if(arg.arg[0].type == Operand_None) { ok = false; break; }
+        params[params_count++] = arg;
+        continue;
+      }
+      ok = CodeAppend(&result, &arg);
+    }
+
+    // parameters in reverse order, jump to the body
+    while(ok && params_count > 0) ok = CodeAppend(&result, &params[--params_count]);
+    Instruction jump = {.op = Opcode_Jump, .arg = {body}};
+    ok = ok && CodeAppend(&result, &jump);
+
+    // CALL, POPFRAME and POPS of the result are left out
+    i = j + 2;
+  }
+
+  free(params);
+  if(!ok)
+  {
+    free(result.code);
+    return false;
+  }
+
+  free(u->code);
+  u->code = result.code;
+  u->count = result.count;
+  u->capacity = result.capacity;
+  return CodeRebuildCalls(u);
+}
+
+bool EliminateTailCalls()
+{
+  unsigned total = 0;
+  for(size_t i = 0; i < CodeUnitCount(); i++)
+  {
+    CodeUnit * u = CodeGetUnit(i);
+    unsigned count;
+    if(!EliminateUnit(u, &count)) return false;
+
+    if(count > 0 && report())
+      fprintf(stderr, "Eliminated tail calls of %s: %u\n", u->name, count);
+    total += count;
+  }
+
+  if(report()) fprintf(stderr, "Eliminated tail calls: %u\n", total);
+  return true;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file tailcall.h
+ * @interface tailcall
+ * @date 18th october 2026
+ * @brief Tail call interface.
+ *
+ * This interface declares elimination of self-recursive tail calls.
+ */
+
+#ifndef TAILCALL_H
+#define TAILCALL_H
+
+#include <stdbool.h>
+
+/**
+ * @brief   Eliminates self-recursive tail calls.
+ *
+ * Call of a function to itself, whose result is returned right away
+ * (r = f(...) followed by return r), is replaced by reassignment
+ * of the parameters and jump to the beginning of the body.
+ * @returns True, if success. False otherwise.
+ */
+bool EliminateTailCalls();
+
+#endif // TAILCALL_H
@@ -85,7 +85,7 @@ typedef enum{
     Table_OperatorTable,
     Table_KeywordTable
 } Table;
-inline const char * TableToString(Table tb)
+static inline const char * TableToString(Table tb)
 {
   switch(tb)
   {
@@ -123,7 +123,7 @@ typedef enum{
   TypeCast_Int2Double,
   TypeCast_Double2Int
 } TokenType;
-inline const char * TokenTypeToString(TokenType tt)
+static inline const char * TokenTypeToString(TokenType tt)
 {
   switch(tt)
   {
@@ -181,6 +181,37 @@ typedef struct exprParserStack
  * @{
  */
 
+/**
+ * @brief   Format of code statistics.
+ */
+typedef enum
+{
+  CodeStats_None, /**< No statistics. */
+  CodeStats_Text, /**< Text table. */
+  CodeStats_Json  /**< JSON. */
+} CodeStats;
+
+/**
+ * @brief   Format of the generated code.
+ */
+typedef enum
+{
+  Emit_Text,      /**< IFJcode17 text. */
+  Emit_Binary     /**< Binary format (see binary.h). */
+} EmitFormat;
+
+/**
+ * @brief   Target language of the generated code.
+ */
+typedef enum
+{
+  Target_Ifjcode,   /**< IFJcode17 (in the format of EmitFormat). */
+  Target_C          /**< C source (see csource.h). */
+} TargetLanguage;
+
+/** @brief Maximal number of optimization passes disabled by arguments. */
+#define MAX_DISABLED_PASSES 16
+
 /**
  * @brief   Structure representing arguments.
  *
@@ -191,6 +222,17 @@ typedef struct
 {
   bool help; /**< Help parameter. */
   bool bypass; /**< Bypass (only scanner). */
+  bool report; /**< Report of optimizations. */
+  unsigned inline_limit; /**< Size threshold of inlined functions. */
+  const char * dump_cfg; /**< File of the dumped control flow graph. */
+  unsigned opt_level; /**< Optimization level. */
+  const char * disabled_passes[MAX_DISABLED_PASSES]; /**< Names of the disabled optimization passes. */
+  unsigned disabled_count; /**< Number of the disabled passes. */
+  bool pass_report; /**< Report of optimization passes. */
+  CodeStats code_stats; /**< Format of statistics of the generated code. */
+  bool minify; /**< Shortest names, no comments. */
+  EmitFormat emit; /**< Format of the generated code. */
+  TargetLanguage target; /**< Target language. */
   /* will be added */
 } args_t;
 
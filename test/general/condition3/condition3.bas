@@ -0,0 +1,31 @@
+/'
+  file:     condition3.bas
+  date:     18th october 2026
+  Test of nested conditions and a loop with jumps to jumps.
+'/
+
+scope
+dim a as integer
+dim b as integer
+input a
+input b
+if a > 1 then
+  if b > 1 then
+    print !"x";
+  else
+    print !"y";
+  end if
+else
+  if b < 0 then
+    print !"z";
+  else
+  end if
+end if
+do while a > 0
+  a = a - 1
+  if a > 3 then
+    print a;
+  else
+  end if
+loop
+end scope
@@ -0,0 +1,53 @@
+/'
+  file:     condition4.bas
+  date:     18th october 2026
+  Test of constant conditions and unreachable code.
+'/
+
+function inc(n as integer) as integer
+  if 1 = 1 then
+    return n + 1
+  else
+    return n - 1
+  end if
+  print n;
+  return 0
+end function
+function count(n as integer) as integer
+  dim i as integer
+  i = 0
+  do while 0 < 1
+    i = i + 1
+    if i > n then
+      return i
+    else
+    end if
+  loop
+  return 0
+end function
+scope
+dim i as integer
+dim d as double
+i = count(3)
+if 2 > 3 then
+  print !"no";
+else
+  print !"yes";
+end if
+if 2.5 * 2 = 5 then
+  print !"five";
+else
+  print !"other";
+end if
+if !"a\032" < !"a!" then
+  print !"space";
+else
+  print !"bang";
+end if
+d = 7
+if d > 6 then
+  i = inc(i)
+  print i;
+else
+end if
+end scope
@@ -0,0 +1,24 @@
+/'
+  file:     cse1.bas
+  date:     18th october 2026
+  Test of repeated subexpressions and copies of variables.
+'/
+
+scope
+dim a as integer
+dim b as integer
+dim c as integer
+dim x as integer
+dim y as integer
+dim t as integer
+dim u as integer
+input a
+input b
+input c
+x = a * b + c
+y = a * b - c
+t = x
+u = t
+print x; y; u;
+print a * b + c;
+end scope
@@ -0,0 +1,34 @@
+/'
+  file:     function10.bas
+  date:     19th october 2026
+  Test of functions ending without return, which return
+  the default value of their type.
+'/
+
+function f(n as integer) as integer
+  do while n > 0
+    return n
+  loop
+end function
+
+function g() as double
+end function
+
+function s(n as integer) as string
+  dim t as string
+  t = !"x"
+end function
+
+scope
+  dim a as integer
+  dim b as string
+  dim c as double
+  a = f(0)
+  print a;
+  a = f(3)
+  print a;
+  b = s(1)
+  print b;
+  c = g()
+  print c;
+end scope
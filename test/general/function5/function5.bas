@@ -0,0 +1,60 @@
+/'
+  file:     function5.bas
+  date:     18th october 2026
+  Test of inlined functions (leaf functions called in loop and expressions).
+'/
+
+declare function sq(x as integer) as integer
+function maxi(a as integer, b as integer) as integer
+  if a > b then
+    return a
+  else
+    return b
+  end if
+end function
+function sq(x as integer) as integer
+  return x * x
+end function
+function half(d as double) as double
+  dim r as double
+  r = d / 2
+  return r
+end function
+function fact(n as integer) as integer
+  dim t as integer
+  if n < 2 then
+    return 1
+  else
+    t = fact(n - 1)
+    return n * t
+  end if
+end function
+function sumsq(n as integer) as integer
+  dim s as integer
+  dim i as integer
+  dim q as integer
+  i = 1
+  do while i <= n
+    q = sq(i)
+    s = s + q
+    i = i + 1
+  loop
+  return s
+end function
+scope
+  dim a as integer
+  dim b as integer
+  dim c as double
+  a = maxi(3, 7)
+  print a;
+  b = maxi(a + 10, 2)
+  print b;
+  c = half(a)
+  print c;
+  a = sq(b)
+  print a;
+  a = fact(6)
+  print a;
+  a = sumsq(10)
+  print a;
+end scope
@@ -0,0 +1,52 @@
+/'
+  file:     function6.bas
+  date:     18th october 2026
+  Test of recursive functions (parameters in callee frame, return value on stack).
+'/
+
+declare function fib(n as integer) as integer
+
+function fact(n as integer) as integer
+  dim t as integer
+  if n < 2 then
+    return 1
+  else
+    t = fact(n - 1)
+    return n * t
+  end if
+end function
+
+function fib(n as integer) as integer
+  dim a as integer
+  dim b as integer
+  if n < 2 then
+    return n
+  else
+    a = fib(n - 1)
+    b = fib(n - 2)
+    return a + b
+  end if
+end function
+
+function repeat(s as string, count as integer) as string
+  dim r as string
+  if count > 0 then
+    r = repeat(s, count - 1)
+    return s + r
+  else
+    return r
+  end if
+end function
+
+scope
+  dim n as integer
+  dim x as integer
+  dim s as string
+  input n
+  x = fact(n)
+  print x;
+  x = fib(n + 5)
+  print x;
+  s = repeat(!"ab", n)
+  print s;
+end scope
@@ -0,0 +1,35 @@
+/'
+  file:     function7.bas
+  date:     18th october 2026
+  Test of deep self-recursive tail calls (one million of recursions).
+'/
+
+function sum(n as integer, acc as integer) as integer
+  dim r as integer
+  if n = 0 then
+    return acc
+  else
+    r = sum(n - 1, acc + 3)
+  end if
+  return r
+end function
+
+function gcd(a as integer, b as integer) as integer
+  dim r as integer
+  if b = 0 then
+    return a
+  else
+    r = gcd(b, a - (a \ b) * b)
+    return r
+  end if
+end function
+
+scope
+  dim n as integer
+  dim x as integer
+  input n
+  x = sum(n, 0)
+  print x;
+  x = gcd(1071, 462)
+  print x;
+end scope
@@ -0,0 +1,86 @@
+/'
+  file:     function8.bas
+  date:     18th october 2026
+  Test of pure functions called with constant arguments.
+'/
+
+function fact(n as integer) as integer
+  dim r as integer
+  if n < 2 then
+    r = 1
+  else
+    r = n - 1
+    r = fact(r)
+    r = n * r
+  end if
+  return r
+end function
+function sum(n as integer, acc as integer) as integer
+  if n = 0 then
+    return acc
+  else
+    acc = sum(n - 1, acc + n)
+    return acc
+  end if
+end function
+function deep(n as integer) as integer
+  dim r as integer
+  if n = 0 then
+    r = 0
+  else
+    r = deep(n - 1)
+    r = r + 1
+  end if
+  return r
+end function
+function rep(s as string, n as integer) as string
+  dim r as string
+  r = !""
+  do while n > 0
+    r = r + s
+    n = n - 1
+  loop
+  return r
+end function
+function half(x as double) as double
+  return x / 2
+end function
+function inv(x as double) as double
+  return 1 / x
+end function
+function loud(n as integer) as integer
+  print n;
+  return n
+end function
+function twice(n as integer) as integer
+  dim r as integer
+  r = loud(n)
+  return r * 2
+end function
+scope
+dim i as integer
+dim s as string
+dim d as double
+i = fact(10)
+print i;
+i = sum(100, 0)
+print i;
+i = sum(20000, 0)
+print i;
+i = deep(50)
+print i;
+i = deep(500)
+print i;
+s = rep(!"ab\n", 3)
+print s;
+s = rep(!"abcdefghij", 200)
+i = length(s)
+print i;
+d = half(5)
+print d;
+i = twice(4)
+print i;
+input d
+d = inv(d)
+print d;
+end scope
@@ -0,0 +1,26 @@
+/'
+  file:     function9.bas
+  date:     19th october 2026
+  Test of a function call after substr, whose frame has no call.
+'/
+
+function twice(n as integer) as integer
+  return n * 2
+end function
+
+function tail(s as string) as string
+  dim t as string
+  t = substr(s, 2, 100)
+  return t
+end function
+
+scope
+  dim s as string
+  dim x as integer
+  s = substr(!"hello", 2, 10)
+  x = twice(5)
+  print s; x;
+  s = tail(s)
+  x = twice(x)
+  print s; x;
+end scope
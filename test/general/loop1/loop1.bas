@@ -0,0 +1,68 @@
+/'
+  file:     loop1.bas
+  date:     18th october 2026
+  Test of loops (rotation, invariant computations, strings in loops).
+'/
+
+function tri(n as integer) as integer
+  dim s as integer
+  dim i as integer
+  dim k as integer
+  k = 3
+  do while i < n
+    s = s + i * k + (k + 1) * 2
+    i = i + 1
+  loop
+  return s
+end function
+scope
+  dim i as integer
+  dim j as integer
+  dim a as integer
+  dim b as integer
+  dim d as double
+  b = 4
+  d = 1.5
+  do while i < 5
+    j = 0
+    do while j < i + b * 2
+      a = a + j * (b + 2)
+      if a > 100 then
+        a = a - b * b
+      else
+        a = a + 1
+      end if
+      j = j + 1
+    loop
+    print a;
+    d = d + b * 2
+    i = i + 1
+  loop
+  print d;
+  a = tri(10)
+  print a;
+  do while 0 > 1
+    print 99;
+  loop
+  i = 0
+  do while i <> 3
+    i = i + 1
+    print i;
+  loop
+  do while i = 3
+    i = i + 1
+  loop
+  print i;
+  dim s as string
+  dim t as string
+  dim n as integer
+  input s
+  i = 0
+  do while i < 3
+    t = t + s + !"-"
+    n = length(s)
+    print n;
+    i = i + 1
+  loop
+  print t;
+end scope
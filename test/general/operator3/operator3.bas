@@ -0,0 +1,16 @@
+/'
+  file:     operator3.bas
+  date:     19th october 2026
+  Test of constant float operations overflowing to infinity,
+  which are not folded.
+'/
+
+scope
+  dim d as double
+  print 1e300 * 1e10;
+  print (0.0 - 1e300) * 1e10;
+  print 1e308 + 1e308;
+  d = 1e300 * 1e300
+  print d;
+  print 1e300 * 1e5;
+end scope
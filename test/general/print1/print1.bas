@@ -0,0 +1,18 @@
+/'
+  file:     print1.bas
+  date:     18th october 2026
+  Test of printed lists of constants and expressions.
+'/
+
+scope
+dim x as integer
+dim d as double
+dim s as string
+x = 42
+d = 2.5
+s = !"abc"
+print !"Total: "; x; !" items"; !"\n";
+print 1; 0 - 2; 3.5; !"#\\"; 1 + 2; !"\n";
+print s + !"-" + s; !"\n";
+print d; x * 2; !"\n";
+end scope
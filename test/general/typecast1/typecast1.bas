@@ -0,0 +1,21 @@
+/'
+  file:     typecast1.bas
+  date:     18th october 2026
+  Test of implicit conversions of constants and variables.
+'/
+
+scope
+dim d as double
+dim i as integer
+dim k as integer
+input i
+d = 2
+d = i * 2
+d = d + 3
+d = 7 / 2
+k = 7 \ 2
+i = d * 1.5
+k = i
+d = k
+print d; i; k;
+end scope